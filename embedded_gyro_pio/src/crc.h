@@ -0,0 +1,25 @@
+/**
+ * @file crc.h
+ *
+ * @brief CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) used to protect
+ *        persisted records and streamed frames.
+ *
+ */
+
+#ifndef CRC_H
+#define CRC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CRC16_INIT 0xFFFF
+
+// Continues a CRC over len more bytes. Start with crc = CRC16_INIT.
+uint16_t crc16_update(uint16_t crc, const void *data, size_t len);
+
+// CRC of a single buffer.
+inline uint16_t crc16(const void *data, size_t len) {
+    return crc16_update(CRC16_INIT, data, len);
+}
+
+#endif // CRC_H
@@ -0,0 +1,77 @@
+/**
+ * @file cycle_counter.h
+ *
+ * @brief Cycle-accurate timing of short code paths.
+ *
+ * Uses the Cortex-M4 DWT cycle counter on target. On a host build the
+ * counter reads as zero, so instrumented code still compiles and runs.
+ *
+ */
+
+#ifndef CYCLE_COUNTER_H
+#define CYCLE_COUNTER_H
+
+#include <stdint.h>
+
+#if defined(__ARM_ARCH_7EM__)
+#include <cmsis.h>
+#define CYCLE_COUNTER_AVAILABLE 1
+#else
+#define CYCLE_COUNTER_AVAILABLE 0
+#endif
+
+// Enables the DWT cycle counter. Safe to call more than once.
+inline void cycle_counter_init() {
+#if CYCLE_COUNTER_AVAILABLE
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+// Current value of the free-running cycle counter.
+inline uint32_t cycle_counter_read() {
+#if CYCLE_COUNTER_AVAILABLE
+    return DWT->CYCCNT;
+#else
+    return 0;
+#endif
+}
+
+// Running statistics for one instrumented code path.
+struct CycleStats {
+    uint32_t count = 0;
+    uint32_t max = 0;
+    uint64_t total = 0;
+
+    void add(uint32_t cycles) {
+        count++;
+        total += cycles;
+        if (cycles > max) {
+            max = cycles;
+        }
+    }
+
+    uint32_t average() const {
+        return count ? (uint32_t)(total / count) : 0;
+    }
+
+    void reset() {
+        count = 0;
+        max = 0;
+        total = 0;
+    }
+};
+
+// Measures the enclosing scope and adds the result to a CycleStats.
+class CycleScope {
+public:
+    explicit CycleScope(CycleStats &stats) : stats(stats), start(cycle_counter_read()) {}
+    ~CycleScope() { stats.add(cycle_counter_read() - start); }
+
+private:
+    CycleStats &stats;
+    uint32_t start;
+};
+
+#endif // CYCLE_COUNTER_H
@@ -0,0 +1,380 @@
+/**
+ * @file digital_filter.h
+ *
+ * @brief Streaming low-pass / notch filters for 3-axis gyroscope samples.
+ *
+ *  - BiquadCascade<N>:    N second-order IIR sections, float (transposed
+ *                         direct form II).
+ *  - BiquadCascadeQ15<N>: the same in fixed point: 16-bit samples,
+ *                         Q2.14 coefficients, 64-bit accumulator (direct
+ *                         form I, as CMSIS-DSP's q15 biquad).
+ *  - FirFilter<N>, FirFilterQ15<N>: N-tap FIR, float or Q15 taps.
+ *
+ * Coefficients come from constexpr design functions (RBJ cookbook biquads,
+ * Butterworth cascades, windowed-sinc FIR), so a design for a fixed data
+ * rate is evaluated by the compiler. The sin/cos they need are computed
+ * by series here, as the <cmath> ones are not constexpr.
+ *
+ * Filter state is laid out with the three axes next to each other, so
+ * the per-axis work of one section is a tight loop over contiguous
+ * memory. Samples can be processed one at a time (process()) or in
+ * blocks (process_block()); both give the same output.
+ *
+ */
+
+#ifndef DIGITAL_FILTER_H
+#define DIGITAL_FILTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FILTER_PI 3.14159265358979323846
+
+/* START: Compile-time design */
+
+// sin(x), accurate to double precision for any x of a filter design.
+constexpr double filter_sin(double x) {
+    while (x > FILTER_PI) {
+        x -= 2.0 * FILTER_PI;
+    }
+    while (x < -FILTER_PI) {
+        x += 2.0 * FILTER_PI;
+    }
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 14; n++) {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double filter_cos(double x) {
+    return filter_sin(x + FILTER_PI / 2.0);
+}
+
+// One second-order section, normalised to a0 = 1:
+// y = b0 x + b1 x[-1] + b2 x[-2] - a1 y[-1] - a2 y[-2].
+struct BiquadCoeffs {
+    float b0, b1, b2, a1, a2;
+};
+
+// The same in Q2.14 (range [-2, 2)).
+struct BiquadCoeffsQ14 {
+    int16_t b0, b1, b2, a1, a2;
+};
+
+template <int N>
+struct BiquadDesign {
+    BiquadCoeffs section[N];
+};
+
+template <int N>
+struct BiquadDesignQ14 {
+    BiquadCoeffsQ14 section[N];
+};
+
+constexpr BiquadCoeffs biquad_normalise(double b0, double b1, double b2, double a0, double a1, double a2) {
+    return BiquadCoeffs{(float)(b0 / a0), (float)(b1 / a0), (float)(b2 / a0),
+                        (float)(a1 / a0), (float)(a2 / a0)};
+}
+
+// Low-pass with cutoff f0 (Hz) and quality factor q at sample rate fs (Hz).
+constexpr BiquadCoeffs biquad_lowpass(double f0, double q, double fs) {
+    double w0 = 2.0 * FILTER_PI * f0 / fs;
+    double c = filter_cos(w0);
+    double alpha = filter_sin(w0) / (2.0 * q);
+    return biquad_normalise((1.0 - c) / 2.0, 1.0 - c, (1.0 - c) / 2.0,
+                            1.0 + alpha, -2.0 * c, 1.0 - alpha);
+}
+
+// High-pass with cutoff f0 (Hz) and quality factor q at sample rate fs (Hz).
+constexpr BiquadCoeffs biquad_highpass(double f0, double q, double fs) {
+    double w0 = 2.0 * FILTER_PI * f0 / fs;
+    double c = filter_cos(w0);
+    double alpha = filter_sin(w0) / (2.0 * q);
+    return biquad_normalise((1.0 + c) / 2.0, -(1.0 + c), (1.0 + c) / 2.0,
+                            1.0 + alpha, -2.0 * c, 1.0 - alpha);
+}
+
+// Notch at f0 (Hz); the -3 dB width is f0 / q.
+constexpr BiquadCoeffs biquad_notch(double f0, double q, double fs) {
+    double w0 = 2.0 * FILTER_PI * f0 / fs;
+    double c = filter_cos(w0);
+    double alpha = filter_sin(w0) / (2.0 * q);
+    return biquad_normalise(1.0, -2.0 * c, 1.0,
+                            1.0 + alpha, -2.0 * c, 1.0 - alpha);
+}
+
+// Butterworth low-pass of order 2N as N sections.
+template <int N>
+constexpr BiquadDesign<N> biquad_butterworth_lowpass(double f0, double fs) {
+    BiquadDesign<N> d{};
+    for (int k = 0; k < N; k++) {
+        double q = 1.0 / (2.0 * filter_cos(FILTER_PI * (2 * k + 1) / (4.0 * N)));
+        d.section[k] = biquad_lowpass(f0, q, fs);
+    }
+    return d;
+}
+
+// Rounds to a signed 16-bit fixed-point value with frac_bits fraction
+// bits, saturating.
+constexpr int16_t filter_to_fixed(double v, int frac_bits) {
+    double scaled = v * (double)(1 << frac_bits);
+    scaled += (scaled >= 0.0) ? 0.5 : -0.5;
+    return (scaled >= 32767.0) ? (int16_t)32767 :
+           (scaled <= -32768.0) ? (int16_t)-32768 : (int16_t)scaled;
+}
+
+template <int N>
+constexpr BiquadDesignQ14<N> biquad_design_q14(const BiquadDesign<N> &d) {
+    BiquadDesignQ14<N> q{};
+    for (int k = 0; k < N; k++) {
+        const BiquadCoeffs &c = d.section[k];
+        q.section[k] = BiquadCoeffsQ14{filter_to_fixed(c.b0, 14), filter_to_fixed(c.b1, 14),
+                                       filter_to_fixed(c.b2, 14), filter_to_fixed(c.a1, 14),
+                                       filter_to_fixed(c.a2, 14)};
+    }
+    return q;
+}
+
+template <int N>
+struct FirTaps {
+    float h[N];
+};
+
+template <int N>
+struct FirTapsQ15 {
+    int16_t h[N];
+};
+
+// Windowed-sinc (Hamming) low-pass, unity gain at DC.
+template <int N>
+constexpr FirTaps<N> fir_lowpass(double f0, double fs) {
+    FirTaps<N> taps{};
+    double fc = f0 / fs;
+    double sum = 0.0;
+    double h[N] = {};
+    for (int k = 0; k < N; k++) {
+        double m = k - (N - 1) / 2.0;
+        double sinc = (m == 0.0) ? 2.0 * fc : filter_sin(2.0 * FILTER_PI * fc * m) / (FILTER_PI * m);
+        double window = (N > 1) ? 0.54 - 0.46 * filter_cos(2.0 * FILTER_PI * k / (N - 1)) : 1.0;
+        h[k] = sinc * window;
+        sum += h[k];
+    }
+    for (int k = 0; k < N; k++) {
+        taps.h[k] = (float)(h[k] / sum);
+    }
+    return taps;
+}
+
+template <int N>
+constexpr FirTapsQ15<N> fir_taps_q15(const FirTaps<N> &t) {
+    FirTapsQ15<N> q{};
+    for (int k = 0; k < N; k++) {
+        q.h[k] = filter_to_fixed(t.h[k], 15);
+    }
+    return q;
+}
+
+/* END: Compile-time design */
+
+/* START: Filters */
+
+inline int16_t filter_saturate(float v) {
+    v += (v >= 0.0f) ? 0.5f : -0.5f;
+    return (v >= 32767.0f) ? (int16_t)32767 : (v <= -32768.0f) ? (int16_t)-32768 : (int16_t)v;
+}
+
+inline int16_t filter_saturate(int64_t v) {
+    return (v > 32767) ? (int16_t)32767 : (v < -32768) ? (int16_t)-32768 : (int16_t)v;
+}
+
+template <int Sections>
+class BiquadCascade {
+public:
+    explicit BiquadCascade(const BiquadDesign<Sections> &design) : design(design) { reset(); }
+
+    void reset() {
+        for (int k = 0; k < Sections; k++) {
+            for (int a = 0; a < 3; a++) {
+                s1[k][a] = 0.0f;
+                s2[k][a] = 0.0f;
+            }
+        }
+    }
+
+    // Filters one X/Y/Z sample in place.
+    void process(int16_t xyz[3]) {
+        float v[3] = {(float)xyz[0], (float)xyz[1], (float)xyz[2]};
+        for (int k = 0; k < Sections; k++) {
+            const BiquadCoeffs &c = design.section[k];
+            for (int a = 0; a < 3; a++) {
+                float x = v[a];
+                float y = c.b0 * x + s1[k][a];
+                s1[k][a] = c.b1 * x - c.a1 * y + s2[k][a];
+                s2[k][a] = c.b2 * x - c.a2 * y;
+                v[a] = y;
+            }
+        }
+        for (int a = 0; a < 3; a++) {
+            xyz[a] = filter_saturate(v[a]);
+        }
+    }
+
+    // Filters n consecutive samples in place.
+    void process_block(int16_t (*xyz)[3], size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            process(xyz[i]);
+        }
+    }
+
+private:
+    BiquadDesign<Sections> design;
+    float s1[Sections][3];
+    float s2[Sections][3];
+};
+
+template <int Sections>
+class BiquadCascadeQ15 {
+public:
+    explicit BiquadCascadeQ15(const BiquadDesignQ14<Sections> &design) : design(design) { reset(); }
+
+    void reset() {
+        for (int k = 0; k <= Sections; k++) {
+            for (int a = 0; a < 3; a++) {
+                d1[k][a] = 0;
+                d2[k][a] = 0;
+            }
+        }
+    }
+
+    // Filters one X/Y/Z sample in place.
+    void process(int16_t xyz[3]) {
+        // d1/d2[k] hold the last two inputs of section k, which are the
+        // last two outputs of section k - 1; d1/d2[Sections] the outputs.
+        int16_t v[3] = {xyz[0], xyz[1], xyz[2]};
+        for (int k = 0; k < Sections; k++) {
+            const BiquadCoeffsQ14 &c = design.section[k];
+            for (int a = 0; a < 3; a++) {
+                int64_t acc = (int64_t)c.b0 * v[a] + (int64_t)c.b1 * d1[k][a] + (int64_t)c.b2 * d2[k][a] -
+                              (int64_t)c.a1 * d1[k + 1][a] - (int64_t)c.a2 * d2[k + 1][a];
+                d2[k][a] = d1[k][a];
+                d1[k][a] = v[a];
+                v[a] = filter_saturate((acc + (1 << 13)) >> 14);
+            }
+        }
+        for (int a = 0; a < 3; a++) {
+            d2[Sections][a] = d1[Sections][a];
+            d1[Sections][a] = v[a];
+            xyz[a] = v[a];
+        }
+    }
+
+    // Filters n consecutive samples in place.
+    void process_block(int16_t (*xyz)[3], size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            process(xyz[i]);
+        }
+    }
+
+private:
+    BiquadDesignQ14<Sections> design;
+    int16_t d1[Sections + 1][3];
+    int16_t d2[Sections + 1][3];
+};
+
+// History of the last N samples of each axis, kept twice in a row so the
+// N newest are always contiguous starting at pos.
+template <typename T, int N>
+struct FirHistory {
+    T x[3][2 * N];
+    int pos;
+
+    void reset() {
+        for (int a = 0; a < 3; a++) {
+            for (int k = 0; k < 2 * N; k++) {
+                x[a][k] = 0;
+            }
+        }
+        pos = 0;
+    }
+
+    // Adds one sample; returns where the newest N start (newest first).
+    int push(const int16_t xyz[3]) {
+        pos = (pos == 0) ? N - 1 : pos - 1;
+        for (int a = 0; a < 3; a++) {
+            x[a][pos] = (T)xyz[a];
+            x[a][pos + N] = (T)xyz[a];
+        }
+        return pos;
+    }
+};
+
+template <int N>
+class FirFilter {
+public:
+    explicit FirFilter(const FirTaps<N> &taps) : taps(taps) { reset(); }
+
+    void reset() { history.reset(); }
+
+    // Filters one X/Y/Z sample in place.
+    void process(int16_t xyz[3]) {
+        int p = history.push(xyz);
+        for (int a = 0; a < 3; a++) {
+            const float *x = &history.x[a][p];
+            float acc = 0.0f;
+            for (int k = 0; k < N; k++) {
+                acc += taps.h[k] * x[k];
+            }
+            xyz[a] = filter_saturate(acc);
+        }
+    }
+
+    // Filters n consecutive samples in place.
+    void process_block(int16_t (*xyz)[3], size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            process(xyz[i]);
+        }
+    }
+
+private:
+    FirTaps<N> taps;
+    FirHistory<float, N> history;
+};
+
+template <int N>
+class FirFilterQ15 {
+public:
+    explicit FirFilterQ15(const FirTapsQ15<N> &taps) : taps(taps) { reset(); }
+
+    void reset() { history.reset(); }
+
+    // Filters one X/Y/Z sample in place.
+    void process(int16_t xyz[3]) {
+        int p = history.push(xyz);
+        for (int a = 0; a < 3; a++) {
+            const int16_t *x = &history.x[a][p];
+            int64_t acc = 0;
+            for (int k = 0; k < N; k++) {
+                acc += (int32_t)taps.h[k] * x[k];
+            }
+            xyz[a] = filter_saturate((acc + (1 << 14)) >> 15);
+        }
+    }
+
+    // Filters n consecutive samples in place.
+    void process_block(int16_t (*xyz)[3], size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            process(xyz[i]);
+        }
+    }
+
+private:
+    FirTapsQ15<N> taps;
+    FirHistory<int16_t, N> history;
+};
+
+/* END: Filters */
+
+#endif // DIGITAL_FILTER_H
@@ -0,0 +1,50 @@
+/**
+  ******************************************************************************
+  * @file    font_draw.c
+  * @brief   Decoder for the packed fonts of font_packed.c: glyph rows of
+  *          Width bits back to back, MSB first (tools/pack_fonts.py).
+  *          No HAL, so the host tests draw with it too.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "fonts.h"
+
+/**
+  * @brief  Draws a character of a packed font into a frame buffer.
+  * @note   Reads the glyph a byte at a time, one row after the other.
+  * @param  font: packed font
+  * @param  Ascii: character ascii code
+  * @param  row: top left pixel of the character
+  * @param  xsize: pixels per frame buffer line
+  * @param  text: color of the set bits
+  * @param  back: color of the rest
+  */
+void Font_DrawPackedGlyph(const sFONT *font, uint8_t Ascii, uint32_t *row, uint32_t xsize,
+                          uint32_t text, uint32_t back)
+{
+  uint32_t width = font->Width;
+  uint32_t height = font->Height;
+  uint32_t blank = (Ascii < font->First) || (Ascii > font->Last);
+  uint32_t bit = blank ? 0 : (Ascii - font->First) * width * height;
+  const uint8_t *pbits = &font->packed[bit / 8];
+  uint32_t bits = blank ? 0 : (uint32_t)*pbits++ << (24 + bit % 8);
+  uint32_t left = 8 - bit % 8;
+  uint32_t i, j;
+
+  for(i = 0; i < height; i++)
+  {
+    for(j = 0; j < width; j++)
+    {
+      if(left == 0)
+      {
+        bits = blank ? 0 : (uint32_t)*pbits++ << 24;
+        left = 8;
+      }
+      row[j] = (bits & 0x80000000) ? text : back;
+      bits <<= 1;
+      left--;
+    }
+    row += xsize;
+  }
+}
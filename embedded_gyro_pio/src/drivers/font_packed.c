@@ -0,0 +1,147 @@
+/* Generated by tools/pack_fonts.py, do not edit.
+ *
+ * Font16: 91 glyphs, 2002 bytes (3040 padded, all 95)
+ * Tables linked: 2002 bytes, 9880 before packing (Font16, Font24); 7878 saved.
+ */
+
+#include <stddef.h>
+#include "fonts.h"
+
+/* ' ' to 'z', 11 x 16 bits each. */
+static const uint8_t Font16_Packed[2002] = {
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x80, 0x30, 0x06, 0x00, 0xC0, 0x18, 0x03, 0x00,
+  0x60, 0x0C, 0x00, 0x00, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x77,
+  0x0E, 0xE0, 0x88, 0x11, 0x02, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x01, 0xB0, 0x36, 0x06, 0xC0, 0xD8, 0x7F, 0x86, 0xC1, 0xFE, 0x1B, 0x03, 0x60,
+  0x6C, 0x0D, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x03, 0xF0, 0xC6, 0x18, 0xC3, 0x80, 0x3C,
+  0x03, 0xC0, 0x1C, 0x31, 0x86, 0x30, 0xFC, 0x02, 0x00, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03,
+  0x00, 0x90, 0x12, 0x01, 0x8C, 0x0F, 0x07, 0x81, 0x8C, 0x02, 0x40, 0x48, 0x06, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3C, 0x0C, 0x01, 0x80, 0x30, 0x03, 0x00, 0xEC, 0x37,
+  0x06, 0x60, 0x76, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1C, 0x03, 0x80,
+  0x20, 0x04, 0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x60, 0x0C, 0x03, 0x00, 0xE0, 0x18, 0x03, 0x00, 0x60, 0x0C, 0x01, 0xC0, 0x18, 0x01,
+  0x80, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x60, 0x06, 0x00, 0x60, 0x0C, 0x01, 0x80,
+  0x30, 0x06, 0x00, 0xC0, 0x30, 0x0E, 0x01, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xC0, 0x18,
+  0x1F, 0xE3, 0xFC, 0x1E, 0x07, 0xE0, 0xCC, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x40, 0x08, 0x0F, 0xE0, 0x20, 0x04, 0x00, 0x80,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0xC0, 0x10, 0x06, 0x00, 0x80, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0xE0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x01, 0x80, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xC0, 0x18, 0x06, 0x00, 0xC0,
+  0x30, 0x06, 0x01, 0x80, 0x60, 0x0C, 0x03, 0x00, 0x60, 0x18, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x01, 0xC0, 0x6C, 0x18, 0xC3, 0x18, 0x63, 0x0C, 0x61, 0x8C, 0x31, 0x83, 0x60, 0x38, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xC0, 0xF8, 0x03, 0x00, 0x60, 0x0C, 0x01, 0x80,
+  0x30, 0x06, 0x00, 0xC0, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0xE0, 0x66,
+  0x18, 0xC3, 0x18, 0x06, 0x01, 0x80, 0x60, 0x18, 0x06, 0x00, 0xFE, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x07, 0xE1, 0x86, 0x00, 0xC0, 0x30, 0x3E, 0x00, 0xE0, 0x0C, 0x01, 0x8C, 0x30,
+  0xFC, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xE0, 0x1C, 0x07, 0x80, 0xB0, 0x36,
+  0x04, 0xC1, 0x98, 0x3F, 0x80, 0x60, 0x3E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03,
+  0xF0, 0x60, 0x0C, 0x01, 0x80, 0x3E, 0x04, 0x60, 0x0C, 0x01, 0x84, 0x30, 0x7C, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF0, 0x70, 0x0C, 0x03, 0x00, 0x6E, 0x0E, 0x61, 0x8C, 0x31,
+  0x83, 0x30, 0x3C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0xE1, 0x0C, 0x01, 0x80,
+  0x60, 0x0C, 0x01, 0x80, 0x30, 0x0C, 0x01, 0x80, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x03, 0xE0, 0xC6, 0x18, 0xC3, 0x18, 0x3E, 0x0C, 0x61, 0x8C, 0x31, 0x86, 0x30, 0x7C, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0xC0, 0xCC, 0x18, 0xC3, 0x18, 0x67, 0x07, 0x60,
+  0x0C, 0x03, 0x00, 0xE0, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0xC0, 0x18, 0x00, 0x00, 0x00, 0x00, 0x01, 0x80, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x30, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0xC0,
+  0x10, 0x04, 0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x01, 0x80, 0x40, 0x30,
+  0x18, 0x00, 0xC0, 0x04, 0x00, 0x60, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0x80, 0x03, 0xFE, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x80, 0x0C, 0x00, 0x40, 0x06, 0x00, 0x30, 0x18, 0x04,
+  0x03, 0x01, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7C, 0x18, 0xC3,
+  0x18, 0x03, 0x01, 0xC0, 0x60, 0x0C, 0x00, 0x00, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x01, 0xC0, 0x44, 0x10, 0x82, 0x10, 0x4E, 0x0A, 0x41, 0x48, 0x27, 0x04, 0x00, 0x44, 0x07,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFC, 0x07, 0x80, 0x90, 0x33, 0x06, 0x60,
+  0xFC, 0x30, 0xC6, 0x19, 0xE7, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0xFC,
+  0x18, 0xC3, 0x18, 0x63, 0x0F, 0xC1, 0x8C, 0x31, 0x86, 0x31, 0xFC, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x7D, 0x18, 0x66, 0x04, 0xC0, 0x18, 0x03, 0x00, 0x60, 0x46, 0x10,
+  0x7C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0xFC, 0x18, 0xC3, 0x0C, 0x61,
+  0x8C, 0x31, 0x86, 0x30, 0xC6, 0x31, 0xFC, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x01, 0xFE, 0x18, 0x43, 0x08, 0x64, 0x0F, 0x81, 0x90, 0x30, 0x86, 0x11, 0xFE, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0xFF, 0x18, 0x23, 0x04, 0x64, 0x0F, 0x81, 0x90, 0x30,
+  0x06, 0x01, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7A, 0x18, 0xC6,
+  0x08, 0xC0, 0x18, 0x03, 0x3E, 0x61, 0x86, 0x30, 0x7C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x01, 0xEF, 0x18, 0xC3, 0x18, 0x63, 0x0F, 0xE1, 0x8C, 0x31, 0x86, 0x31, 0xEF, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0x03, 0x00, 0x60, 0x0C, 0x01, 0x80,
+  0x30, 0x06, 0x00, 0xC0, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7F,
+  0x01, 0x80, 0x30, 0x06, 0x00, 0xC3, 0x18, 0x63, 0x0C, 0x60, 0xF8, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x01, 0xEF, 0x18, 0xC3, 0x30, 0x6C, 0x0F, 0x01, 0xF0, 0x33, 0x06, 0x31,
+  0xE7, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0xF8, 0x0C, 0x01, 0x80, 0x30,
+  0x06, 0x00, 0xC2, 0x18, 0x43, 0x09, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x03, 0x83, 0xB0, 0x67, 0x1C, 0xF7, 0x9A, 0xB3, 0x76, 0x64, 0xCC, 0x1B, 0xEF, 0x80, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0xCF, 0x18, 0xC3, 0x98, 0x7B, 0x0D, 0x61, 0xBC, 0x33,
+  0x86, 0x31, 0xE6, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7C, 0x18, 0xC6,
+  0x0C, 0xC1, 0x98, 0x33, 0x06, 0x60, 0xC6, 0x30, 0x7C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x01, 0xFC, 0x18, 0xC3, 0x18, 0x63, 0x0C, 0x61, 0xF8, 0x30, 0x06, 0x01, 0xF8, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7C, 0x18, 0xC6, 0x0C, 0xC1, 0x98, 0x33,
+  0x06, 0x60, 0xC6, 0x30, 0x7C, 0x06, 0x61, 0xF8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0xFC,
+  0x18, 0xC3, 0x18, 0x63, 0x0F, 0x81, 0x98, 0x31, 0x86, 0x31, 0xF3, 0x80, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x7E, 0x18, 0xC3, 0x18, 0x70, 0x07, 0xC0, 0x1C, 0x31, 0x86, 0x30,
+  0xFC, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0xFE, 0x26, 0x44, 0xC8, 0x99,
+  0x03, 0x00, 0x60, 0x0C, 0x01, 0x80, 0xFC, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x01, 0xEF, 0x18, 0xC3, 0x18, 0x63, 0x0C, 0x61, 0x8C, 0x31, 0x86, 0x30, 0x7C, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0xEF, 0x18, 0xC3, 0x18, 0x36, 0x06, 0xC0, 0xD8, 0x0A,
+  0x01, 0xC0, 0x38, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0xEF, 0xB0, 0x66,
+  0x4C, 0xDD, 0x9B, 0xB1, 0x54, 0x3B, 0x87, 0x70, 0xC6, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x01, 0xEF, 0x18, 0xC1, 0xB0, 0x1C, 0x03, 0x80, 0x70, 0x1B, 0x06, 0x31, 0xEF, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0xE7, 0x98, 0x61, 0x98, 0x1E, 0x01, 0x80,
+  0x30, 0x06, 0x00, 0xC0, 0x7E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFE,
+  0x10, 0xC2, 0x30, 0x0C, 0x01, 0x00, 0x60, 0x18, 0x86, 0x10, 0xFE, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0xF0, 0x18, 0x03, 0x00, 0x60, 0x0C, 0x01, 0x80, 0x30, 0x06, 0x00, 0xC0,
+  0x18, 0x03, 0x00, 0x78, 0x00, 0x00, 0x00, 0x00, 0x30, 0x06, 0x00, 0x60, 0x0C, 0x00, 0xC0, 0x18,
+  0x01, 0x80, 0x18, 0x03, 0x00, 0x30, 0x06, 0x00, 0x60, 0x0C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03,
+  0xC0, 0x18, 0x03, 0x00, 0x60, 0x0C, 0x01, 0x80, 0x30, 0x06, 0x00, 0xC0, 0x18, 0x03, 0x01, 0xE0,
+  0x00, 0x00, 0x00, 0x00, 0x04, 0x01, 0x40, 0x28, 0x08, 0x82, 0x08, 0x41, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0xFF,
+  0x08, 0x00, 0x80, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0xF0, 0x03, 0x00, 0x60,
+  0xFC, 0x31, 0x86, 0x70, 0x77, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0E, 0x00, 0xC0,
+  0x18, 0x03, 0x70, 0x73, 0x0C, 0x31, 0x86, 0x30, 0xC7, 0x31, 0xDC, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0xE8, 0x63, 0x18, 0x23, 0x00, 0x60, 0x86, 0x30,
+  0x7C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x70, 0x06, 0x00, 0xC1, 0xD8, 0x67,
+  0x18, 0x63, 0x0C, 0x61, 0x86, 0x70, 0x77, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x01, 0xF0, 0x63, 0x18, 0x33, 0xFE, 0x60, 0x06, 0x18, 0x7E, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFC, 0x30, 0x06, 0x03, 0xF8, 0x18, 0x03, 0x00, 0x60, 0x0C,
+  0x01, 0x80, 0xFE, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+  0xDC, 0x67, 0x18, 0x63, 0x0C, 0x61, 0x86, 0x70, 0x76, 0x00, 0xC0, 0x18, 0x3E, 0x00, 0x00, 0x00,
+  0x00, 0x0E, 0x00, 0xC0, 0x18, 0x03, 0x70, 0x73, 0x0C, 0x61, 0x8C, 0x31, 0x86, 0x31, 0xEF, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xC0, 0x18, 0x00, 0x01, 0xE0, 0x0C, 0x01, 0x80,
+  0x30, 0x06, 0x00, 0xC0, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xC0, 0x18,
+  0x00, 0x03, 0xF0, 0x06, 0x00, 0xC0, 0x18, 0x03, 0x00, 0x60, 0x0C, 0x01, 0x80, 0x30, 0x7C, 0x00,
+  0x00, 0x00, 0x00, 0x0E, 0x00, 0xC0, 0x18, 0x03, 0x78, 0x6C, 0x0F, 0x01, 0xE0, 0x36, 0x06, 0x61,
+  0xDF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0xC0, 0x18, 0x03, 0x00, 0x60, 0x0C,
+  0x01, 0x80, 0x30, 0x06, 0x00, 0xC0, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x07, 0xF8, 0x6D, 0x8D, 0xB1, 0xB6, 0x36, 0xC6, 0xD9, 0xDB, 0x80, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0x70, 0x73, 0x0C, 0x61, 0x8C, 0x31,
+  0x86, 0x31, 0xEF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+  0xF0, 0x63, 0x18, 0x33, 0x06, 0x60, 0xC6, 0x30, 0x7C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0x70, 0x73, 0x0C, 0x31, 0x86, 0x30, 0xC7, 0x30, 0xDC, 0x18,
+  0x03, 0x00, 0xF8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0xDC, 0x67, 0x18, 0x63,
+  0x0C, 0x61, 0x86, 0x70, 0x76, 0x00, 0xC0, 0x18, 0x0F, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x07, 0xB8, 0x39, 0x86, 0x00, 0xC0, 0x18, 0x03, 0x01, 0xFC, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0xF8, 0x63, 0x0F, 0x00, 0xF8, 0x03, 0x86, 0x30,
+  0xFC, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x60, 0x0C, 0x07, 0xF0, 0x30,
+  0x06, 0x00, 0xC0, 0x18, 0x03, 0x10, 0x3C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x07, 0x38, 0x63, 0x0C, 0x61, 0x8C, 0x31, 0x86, 0x70, 0x77, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0xBC, 0x63, 0x0C, 0x60, 0xD8, 0x1B,
+  0x01, 0xC0, 0x38, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0F,
+  0x1E, 0xC1, 0x99, 0x33, 0x76, 0x3B, 0x87, 0x70, 0xC6, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0xBC, 0x36, 0x03, 0x80, 0x70, 0x0E, 0x03, 0x61, 0xEF, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0x9E, 0x61, 0x86, 0x60,
+  0xCC, 0x0B, 0x01, 0xE0, 0x18, 0x03, 0x00, 0xC0, 0x7C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x03, 0xF8, 0x43, 0x00, 0xC0, 0x70, 0x18, 0x06, 0x10, 0xFE, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00,
+};
+
+sFONT Font16 = {
+  NULL,
+  11, /* Width */
+  16, /* Height */
+  Font16_Packed,
+  32, /* First */
+  122, /* Last */
+};
@@ -0,0 +1,12 @@
+/* Generated by tools/pack_fonts.py, do not edit.
+ *
+ * Font16: 91 glyphs, 2002 bytes (3040 padded, all 95)
+ * Tables linked: 2002 bytes, 9880 before packing (Font16, Font24); 7878 saved.
+ */
+
+#ifndef __FONT_PACKED_H
+#define __FONT_PACKED_H
+
+extern sFONT Font16;
+
+#endif /* __FONT_PACKED_H */
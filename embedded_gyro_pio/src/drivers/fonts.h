@@ -67,17 +67,25 @@
   */ 
 typedef struct _tFont
 {    
-  const uint8_t *table;
+  const uint8_t *table;   /* Rows padded to whole bytes, ' ' to '~', or NULL */
   uint16_t Width;
   uint16_t Height;
+  const uint8_t *packed;  /* Rows of Width bits back to back, First to Last */
+  uint8_t First;
+  uint8_t Last;
   
 } sFONT;
 
-extern sFONT Font24;
-extern sFONT Font20;
-extern sFONT Font16;
-extern sFONT Font12;
-extern sFONT Font8;
+/* The fonts linked in: packed by tools/pack_fonts.py from the ST tables
+   in tools/fonts/. */
+#include "font_packed.h"
+
+/* Draws glyph Ascii of a packed font into an ARGB8888 frame buffer, xsize
+   pixels per line, from its top left pixel at row: text where a bit is
+   set, back elsewhere. Characters outside First to Last are drawn blank.
+   Reads the glyph a byte at a time (font_draw.c). */
+void Font_DrawPackedGlyph(const sFONT *font, uint8_t Ascii, uint32_t *row, uint32_t xsize,
+                          uint32_t text, uint32_t back);
 /**
   * @}
   */ 
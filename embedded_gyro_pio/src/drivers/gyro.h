@@ -116,6 +116,9 @@ typedef struct
   uint8_t Interrupt_ActiveEdge;               /* Interrupt Active edge */
 }GYRO_InterruptConfigTypeDef;  
 
+/* GYRO IO block transfer completion callback (Status: 0 on success) */
+typedef void (*GYRO_IO_CallbackTypeDef)(uint8_t Status);
+
 /**
   * @}
   */
@@ -94,6 +94,9 @@ GYRO_DrvTypeDef L3gd20Drv =
   L3GD20_ReadXYZAngRate
 };
 
+/* Shadow of the device configuration */
+static L3GD20_StateTypeDef L3gd20State;
+
 /**
   * @}
   */
@@ -101,6 +104,8 @@ GYRO_DrvTypeDef L3gd20Drv =
 /** @defgroup L3GD20_Private_FunctionPrototypes
   * @{
   */
+static void L3GD20_UpdateSensitivity(void);
+static void L3GD20_EnsureState(void);
 
 /**
   * @}
@@ -118,18 +123,17 @@ GYRO_DrvTypeDef L3gd20Drv =
   */
 void L3GD20_Init(uint16_t InitStruct)
 {  
-  uint8_t ctrl = 0x00;
-  
   /* Configure the low level interface */
   GYRO_IO_Init();
+
+  /* Pick up the registers this function does not set */
+  L3GD20_SyncState();
   
   /* Write value to MEMS CTRL_REG1 register */
-  ctrl = (uint8_t) InitStruct;
-  GYRO_IO_Write(&ctrl, L3GD20_CTRL_REG1_ADDR, 1);
+  L3GD20_WriteReg(L3GD20_CTRL_REG1_ADDR, (uint8_t) InitStruct);
   
   /* Write value to MEMS CTRL_REG4 register */  
-  ctrl = (uint8_t) (InitStruct >> 8);
-  GYRO_IO_Write(&ctrl, L3GD20_CTRL_REG4_ADDR, 1);
+  L3GD20_WriteReg(L3GD20_CTRL_REG4_ADDR, (uint8_t) (InitStruct >> 8));
 }
 
 
@@ -171,14 +175,16 @@ void L3GD20_RebootCmd(void)
 {
   uint8_t tmpreg;
   
-  /* Read CTRL_REG5 register */
-  GYRO_IO_Read(&tmpreg, L3GD20_CTRL_REG5_ADDR, 1);
+  L3GD20_EnsureState();
   
   /* Enable or Disable the reboot memory */
-  tmpreg |= L3GD20_BOOT_REBOOTMEMORY;
+  tmpreg = L3gd20State.CtrlReg[4] | L3GD20_BOOT_REBOOTMEMORY;
   
   /* Write value to MEMS CTRL_REG5 register */
   GYRO_IO_Write(&tmpreg, L3GD20_CTRL_REG5_ADDR, 1);
+
+  /* The reboot reloads the device, read it back on next use */
+  L3gd20State.Valid = 0;
 }
 
 /**
@@ -188,11 +194,8 @@ void L3GD20_RebootCmd(void)
   */
 void L3GD20_LowPower(uint16_t InitStruct)
 {  
-  uint8_t ctrl = 0x00;
-
   /* Write value to MEMS CTRL_REG1 register */
-  ctrl = (uint8_t) InitStruct;
-  GYRO_IO_Write(&ctrl, L3GD20_CTRL_REG1_ADDR, 1);
+  L3GD20_WriteReg(L3GD20_CTRL_REG1_ADDR, (uint8_t) InitStruct);
 }
 
 /**
@@ -204,23 +207,21 @@ void L3GD20_INT1InterruptConfig(uint16_t Int1Config)
 {
   uint8_t ctrl_cfr = 0x00, ctrl3 = 0x00;
   
-  /* Read INT1_CFG register */
-  GYRO_IO_Read(&ctrl_cfr, L3GD20_INT1_CFG_ADDR, 1);
-  
-  /* Read CTRL_REG3 register */
-  GYRO_IO_Read(&ctrl3, L3GD20_CTRL_REG3_ADDR, 1);
+  L3GD20_EnsureState();
+  ctrl_cfr = L3gd20State.Int1Cfg;
+  ctrl3 = L3gd20State.CtrlReg[2];
   
   ctrl_cfr &= 0x80;
-  ctrl_cfr |= ((uint8_t) Int1Config >> 8);
+  ctrl_cfr |= (uint8_t)(Int1Config >> 8);
   
   ctrl3 &= 0xDF;
   ctrl3 |= ((uint8_t) Int1Config);   
   
   /* Write value to MEMS INT1_CFG register */
-  GYRO_IO_Write(&ctrl_cfr, L3GD20_INT1_CFG_ADDR, 1);
+  L3GD20_WriteReg(L3GD20_INT1_CFG_ADDR, ctrl_cfr);
   
   /* Write value to MEMS CTRL_REG3 register */
-  GYRO_IO_Write(&ctrl3, L3GD20_CTRL_REG3_ADDR, 1);
+  L3GD20_WriteReg(L3GD20_CTRL_REG3_ADDR, ctrl3);
 }
 
 /**
@@ -235,8 +236,8 @@ void L3GD20_EnableIT(uint8_t IntSel)
 {  
   uint8_t tmpreg;
   
-  /* Read CTRL_REG3 register */
-  GYRO_IO_Read(&tmpreg, L3GD20_CTRL_REG3_ADDR, 1);
+  L3GD20_EnsureState();
+  tmpreg = L3gd20State.CtrlReg[2];
   
   if(IntSel == L3GD20_INT1)
   {
@@ -250,7 +251,7 @@ void L3GD20_EnableIT(uint8_t IntSel)
   }
   
   /* Write value to MEMS CTRL_REG3 register */
-  GYRO_IO_Write(&tmpreg, L3GD20_CTRL_REG3_ADDR, 1);
+  L3GD20_WriteReg(L3GD20_CTRL_REG3_ADDR, tmpreg);
 }
 
 /**
@@ -265,8 +266,8 @@ void L3GD20_DisableIT(uint8_t IntSel)
 {  
   uint8_t tmpreg;
   
-  /* Read CTRL_REG3 register */
-  GYRO_IO_Read(&tmpreg, L3GD20_CTRL_REG3_ADDR, 1);
+  L3GD20_EnsureState();
+  tmpreg = L3gd20State.CtrlReg[2];
   
   if(IntSel == L3GD20_INT1)
   {
@@ -280,7 +281,103 @@ void L3GD20_DisableIT(uint8_t IntSel)
   }
   
   /* Write value to MEMS CTRL_REG3 register */
-  GYRO_IO_Write(&tmpreg, L3GD20_CTRL_REG3_ADDR, 1);
+  L3GD20_WriteReg(L3GD20_CTRL_REG3_ADDR, tmpreg);
+}
+
+/**
+  * @brief  Set the INT1 angular rate threshold and duration.
+  * @param  Threshold: Threshold for all three axes, in raw LSB (15 bits).
+  * @param  Duration: Samples the rate must stay beyond the threshold before
+  *         INT1 asserts (7 bits), optionally ORed with L3GD20_INT1_DURATION_WAIT.
+  * @retval None
+  */
+void L3GD20_INT1ThresholdConfig(uint16_t Threshold, uint8_t Duration)
+{
+  uint8_t ths[6];
+  uint8_t i;
+  
+  for(i = 0; i < 6; i += 2)
+  {
+    ths[i] = (uint8_t)((Threshold >> 8) & 0x7F);
+    ths[i + 1] = (uint8_t)Threshold;
+  }
+  
+  /* Write INT1_TSH_XH .. INT1_TSH_ZL in one auto-increment transfer */
+  GYRO_IO_Write(ths, L3GD20_INT1_TSH_XH_ADDR, 6);
+  
+  /* Write value to MEMS INT1_DURATION register */
+  GYRO_IO_Write(&Duration, L3GD20_INT1_DURATION_ADDR, 1);
+}
+
+/**
+  * @brief  Set the FIFO mode and watermark level.
+  * @param  Mode: FIFO mode, one of L3GD20_FIFO_MODE_x.
+  *         L3GD20_FIFO_MODE_BYPASS also turns the FIFO off (FIFO_EN).
+  * @param  Watermark: Watermark level (0 to 31).
+  * @retval None
+  */
+void L3GD20_FIFOConfig(uint8_t Mode, uint8_t Watermark)
+{
+  uint8_t tmpreg;
+  
+  L3GD20_EnsureState();
+  
+  /* Write value to MEMS FIFO_CTRL_REG register */
+  L3GD20_WriteReg(L3GD20_FIFO_CTRL_REG_ADDR, (uint8_t)(Mode | (Watermark & L3GD20_FIFO_SRC_FSS)));
+  
+  tmpreg = L3gd20State.CtrlReg[4] & (uint8_t)~L3GD20_FIFO_ENABLE;
+  if(Mode != L3GD20_FIFO_MODE_BYPASS)
+  {
+    tmpreg |= L3GD20_FIFO_ENABLE;
+  }
+  
+  /* Write value to MEMS CTRL_REG5 register */
+  if(tmpreg != L3gd20State.CtrlReg[4])
+  {
+    L3GD20_WriteReg(L3GD20_CTRL_REG5_ADDR, tmpreg);
+  }
+}
+
+/**
+  * @brief  Number of samples currently held by the FIFO.
+  * @retval 0 to L3GD20_FIFO_DEPTH.
+  */
+uint8_t L3GD20_GetFIFOLevel(void)
+{
+  return L3GD20_FIFOLevel(L3GD20_GetFIFOStatus());
+}
+
+/**
+  * @brief  Reads the FIFO source register.
+  * @retval FIFO_SRC_REG: L3GD20_FIFO_SRC_WTM, _OVRN, _EMPTY flags and the
+  *         FSS level bits.
+  */
+uint8_t L3GD20_GetFIFOStatus(void)
+{
+  uint8_t tmpreg;
+  
+  GYRO_IO_Read(&tmpreg, L3GD20_FIFO_SRC_REG_ADDR, 1);
+  
+  return tmpreg;
+}
+
+/**
+  * @brief  Number of samples held by the FIFO, from a FIFO_SRC_REG value.
+  * @param  FifoSrc: value read by L3GD20_GetFIFOStatus().
+  * @retval 0 to L3GD20_FIFO_DEPTH.
+  */
+uint8_t L3GD20_FIFOLevel(uint8_t FifoSrc)
+{
+  if(FifoSrc & L3GD20_FIFO_SRC_EMPTY)
+  {
+    return 0;
+  }
+  /* FSS only counts to 31, a full FIFO is flagged as overrun */
+  if(FifoSrc & L3GD20_FIFO_SRC_OVRN)
+  {
+    return L3GD20_FIFO_DEPTH;
+  }
+  return FifoSrc & L3GD20_FIFO_SRC_FSS;
 }
 
 /**
@@ -292,8 +389,8 @@ void L3GD20_FilterConfig(uint8_t FilterStruct)
 {
   uint8_t tmpreg;
   
-  /* Read CTRL_REG2 register */
-  GYRO_IO_Read(&tmpreg, L3GD20_CTRL_REG2_ADDR, 1);
+  L3GD20_EnsureState();
+  tmpreg = L3gd20State.CtrlReg[1];
   
   tmpreg &= 0xC0;
   
@@ -301,7 +398,7 @@ void L3GD20_FilterConfig(uint8_t FilterStruct)
   tmpreg |= FilterStruct;
   
   /* Write value to MEMS CTRL_REG2 register */
-  GYRO_IO_Write(&tmpreg, L3GD20_CTRL_REG2_ADDR, 1);
+  L3GD20_WriteReg(L3GD20_CTRL_REG2_ADDR, tmpreg);
 }
 
 /**
@@ -316,15 +413,15 @@ void L3GD20_FilterCmd(uint8_t HighPassFilterState)
 {
   uint8_t tmpreg;
   
-  /* Read CTRL_REG5 register */
-  GYRO_IO_Read(&tmpreg, L3GD20_CTRL_REG5_ADDR, 1);
+  L3GD20_EnsureState();
+  tmpreg = L3gd20State.CtrlReg[4];
   
   tmpreg &= 0xEF;
   
   tmpreg |= HighPassFilterState;
   
   /* Write value to MEMS CTRL_REG5 register */
-  GYRO_IO_Write(&tmpreg, L3GD20_CTRL_REG5_ADDR, 1);
+  L3GD20_WriteReg(L3GD20_CTRL_REG5_ADDR, tmpreg);
 }
 
 /**
@@ -343,57 +440,253 @@ uint8_t L3GD20_GetDataStatus(void)
 }
 
 /**
-* @brief  Calculate the L3GD20 angular data.
-* @param  pfData: Data out pointer
-* @retval None
-*/
-void L3GD20_ReadXYZAngRate(float *pfData)
+  * @brief  Starts a DMA read of the X, Y and Z output registers.
+  * @param  pBuffer: Receives the 6 output bytes (OUT_X_L .. OUT_Z_H).
+  * @param  Callback: Called from interrupt context once pBuffer is filled.
+  * @retval 0 if the transfer was started, else 1 (bus busy).
+  */
+uint8_t L3GD20_ReadXYZRawDMA(uint8_t *pBuffer, GYRO_IO_CallbackTypeDef Callback)
 {
-  uint8_t tmpbuffer[6] ={0};
-  int16_t RawData[3] = {0};
-  uint8_t tmpreg = 0;
-  float sensitivity = 0;
-  int i =0;
-  
-  GYRO_IO_Read(&tmpreg,L3GD20_CTRL_REG4_ADDR,1);
-  
-  GYRO_IO_Read(tmpbuffer,L3GD20_OUT_X_L_ADDR,6);
-  
-  /* check in the control register 4 the data alignment (Big Endian or Little Endian)*/
-  if(!(tmpreg & L3GD20_BLE_MSB))
+  return GYRO_IO_ReadDMA(pBuffer, L3GD20_OUT_X_L_ADDR, 6, Callback);
+}
+
+/**
+  * @brief  Starts a DMA read of STATUS_REG and the X, Y and Z output
+  *         registers that follow it, in one burst.
+  * @note   The status comes with the sample at no extra transfer, so
+  *         every read can check for overruns (L3GD20_STATUS_ZYXOR).
+  * @param  pBuffer: Receives 7 bytes: STATUS_REG, then OUT_X_L .. OUT_Z_H.
+  * @param  Callback: Called from interrupt context once pBuffer is filled.
+  * @retval 0 if the transfer was started, else 1 (bus busy).
+  */
+uint8_t L3GD20_ReadStatusXYZRawDMA(uint8_t *pBuffer, GYRO_IO_CallbackTypeDef Callback)
+{
+  return GYRO_IO_ReadDMA(pBuffer, L3GD20_STATUS_REG_ADDR, 7, Callback);
+}
+
+/**
+  * @brief  Starts a DMA read of several samples from the FIFO.
+  * @note   With the FIFO enabled, an auto-incremented read wraps from
+  *         OUT_Z_H back to OUT_X_L, so one burst drains several samples.
+  * @param  pBuffer: Receives Samples * 6 bytes.
+  * @param  Samples: Number of samples to read (1 to 32).
+  * @param  Callback: Called from interrupt context once pBuffer is filled.
+  * @retval 0 if the transfer was started, else 1.
+  */
+uint8_t L3GD20_ReadFIFODMA(uint8_t *pBuffer, uint8_t Samples, GYRO_IO_CallbackTypeDef Callback)
+{
+  if((Samples == 0) || (Samples > 32))
+  {
+    return 1;
+  }
+  return GYRO_IO_ReadDMA(pBuffer, L3GD20_OUT_X_L_ADDR, (uint16_t)Samples * 6, Callback);
+}
+
+/**
+  * @brief  Writes a configuration register and keeps the driver copy in step.
+  * @param  Reg: Register address (CTRL_REG1..5, FIFO_CTRL_REG, INT1_CFG or any other).
+  * @param  Value: Value to write.
+  * @retval None
+  */
+void L3GD20_WriteReg(uint8_t Reg, uint8_t Value)
+{
+  GYRO_IO_Write(&Value, Reg, 1);
+
+  if((Reg >= L3GD20_CTRL_REG1_ADDR) && (Reg <= L3GD20_CTRL_REG5_ADDR))
+  {
+    L3gd20State.CtrlReg[Reg - L3GD20_CTRL_REG1_ADDR] = Value;
+    if(Reg == L3GD20_CTRL_REG4_ADDR)
+    {
+      L3GD20_UpdateSensitivity();
+    }
+  }
+  else if(Reg == L3GD20_FIFO_CTRL_REG_ADDR)
   {
-    for(i=0; i<3; i++)
+    L3gd20State.FifoCtrl = Value;
+  }
+  else if(Reg == L3GD20_INT1_CFG_ADDR)
+  {
+    L3gd20State.Int1Cfg = Value;
+  }
+}
+
+/**
+  * @brief  Reads the configuration registers into the driver copy.
+  * @note   Only needed at start-up or if the device was configured behind the
+  *         driver's back; everything written through the driver is tracked.
+  * @retval None
+  */
+void L3GD20_SyncState(void)
+{
+  GYRO_IO_Read(L3gd20State.CtrlReg, L3GD20_CTRL_REG1_ADDR, 5);
+  GYRO_IO_Read(&L3gd20State.FifoCtrl, L3GD20_FIFO_CTRL_REG_ADDR, 1);
+  GYRO_IO_Read(&L3gd20State.Int1Cfg, L3GD20_INT1_CFG_ADDR, 1);
+  L3GD20_UpdateSensitivity();
+  L3gd20State.Valid = 1;
+}
+
+/**
+  * @brief  Gives access to the driver copy of the device configuration.
+  * @retval Pointer to the driver state.
+  */
+const L3GD20_StateTypeDef *L3GD20_GetState(void)
+{
+  L3GD20_EnsureState();
+  return &L3gd20State;
+}
+
+/**
+  * @brief  Decodes X/Y/Z samples to raw signed values.
+  * @param  pBuffer: Samples * 6 bytes as read from OUT_X_L onwards.
+  * @param  pRaw: Receives Samples * 3 values (X, Y, Z per sample).
+  * @param  Samples: Number of samples.
+  * @retval None
+  */
+void L3GD20_DecodeXYZ(const uint8_t *pBuffer, int16_t *pRaw, uint16_t Samples)
+{
+  uint16_t i, n = Samples * 3;
+
+  L3GD20_EnsureState();
+
+  /* Data alignment (Big Endian or Little Endian) from the cached CTRL_REG4 */
+  if(!(L3gd20State.CtrlReg[3] & L3GD20_BLE_MSB))
+  {
+    for(i = 0; i < n; i++)
     {
-      RawData[i]=(int16_t)(((uint16_t)tmpbuffer[2*i+1] << 8) + tmpbuffer[2*i]);
+      pRaw[i] = (int16_t)(((uint16_t)pBuffer[2*i+1] << 8) | pBuffer[2*i]);
     }
   }
   else
   {
-    for(i=0; i<3; i++)
+    for(i = 0; i < n; i++)
+    {
+      pRaw[i] = (int16_t)(((uint16_t)pBuffer[2*i] << 8) | pBuffer[2*i+1]);
+    }
+  }
+}
+
+/**
+  * @brief  Decodes X/Y/Z samples to angular rates in integer mdps.
+  * @param  pBuffer: Samples * 6 bytes as read from OUT_X_L onwards.
+  * @param  pData: Receives Samples * 3 rates [mdps].
+  * @param  Samples: Number of samples.
+  * @retval None
+  */
+void L3GD20_DecodeXYZmdps(const uint8_t *pBuffer, int32_t *pData, uint16_t Samples)
+{
+  int16_t raw[L3GD20_FIFO_DEPTH * 3];
+  uint16_t i, n;
+
+  while(Samples > 0)
+  {
+    n = (Samples > L3GD20_FIFO_DEPTH) ? L3GD20_FIFO_DEPTH : Samples;
+    L3GD20_DecodeXYZ(pBuffer, raw, n);
+    for(i = 0; i < n * 3; i++)
+    {
+      /* |raw| * 7000 stays well inside 32 bits */
+      pData[i] = ((int32_t)raw[i] * L3gd20State.SensitivityCenti) / 100;
+    }
+    pBuffer += n * L3GD20_SAMPLE_SIZE;
+    pData += n * 3;
+    Samples -= n;
+  }
+}
+
+/**
+  * @brief  Decodes X/Y/Z samples to angular rates in mdps.
+  * @param  pBuffer: Samples * 6 bytes as read from OUT_X_L onwards.
+  * @param  pfData: Receives Samples * 3 rates [mdps].
+  * @param  Samples: Number of samples.
+  * @retval None
+  */
+void L3GD20_DecodeXYZAngRate(const uint8_t *pBuffer, float *pfData, uint16_t Samples)
+{
+  int16_t raw[L3GD20_FIFO_DEPTH * 3];
+  uint16_t i, n;
+
+  while(Samples > 0)
+  {
+    n = (Samples > L3GD20_FIFO_DEPTH) ? L3GD20_FIFO_DEPTH : Samples;
+    L3GD20_DecodeXYZ(pBuffer, raw, n);
+    for(i = 0; i < n * 3; i++)
     {
-      RawData[i]=(int16_t)(((uint16_t)tmpbuffer[2*i] << 8) + tmpbuffer[2*i+1]);
+      pfData[i] = (float)raw[i] * L3gd20State.Sensitivity;
     }
+    pBuffer += n * L3GD20_SAMPLE_SIZE;
+    pfData += n * 3;
+    Samples -= n;
+  }
+}
+
+/**
+  * @brief  Reads a batch of samples (from the FIFO when enabled) in one transfer.
+  * @param  pRaw: Receives Samples * 3 raw values.
+  * @param  Samples: Number of samples (1 to L3GD20_FIFO_DEPTH).
+  * @retval None
+  */
+void L3GD20_ReadXYZRaw(int16_t *pRaw, uint8_t Samples)
+{
+  uint8_t tmpbuffer[L3GD20_FIFO_DEPTH * L3GD20_SAMPLE_SIZE];
+
+  if(Samples > L3GD20_FIFO_DEPTH)
+  {
+    Samples = L3GD20_FIFO_DEPTH;
   }
+
+  GYRO_IO_Read(tmpbuffer, L3GD20_OUT_X_L_ADDR, (uint16_t)Samples * L3GD20_SAMPLE_SIZE);
+  L3GD20_DecodeXYZ(tmpbuffer, pRaw, Samples);
+}
+
+/**
+* @brief  Calculate the L3GD20 angular data.
+* @param  pfData: Data out pointer
+* @retval None
+*/
+void L3GD20_ReadXYZAngRate(float *pfData)
+{
+  uint8_t tmpbuffer[L3GD20_SAMPLE_SIZE] = {0};
+  
+  /* Endianness and full scale come from the driver copy of CTRL_REG4 */
+  GYRO_IO_Read(tmpbuffer, L3GD20_OUT_X_L_ADDR, L3GD20_SAMPLE_SIZE);
   
-  /* Switch the sensitivity value set in the CRTL4 */
-  switch(tmpreg & L3GD20_FULLSCALE_SELECTION)
+  L3GD20_DecodeXYZAngRate(tmpbuffer, pfData, 1);
+}
+
+/**
+  * @brief  Derives the sensitivity from the cached full scale selection.
+  * @retval None
+  */
+static void L3GD20_UpdateSensitivity(void)
+{
+  switch(L3gd20State.CtrlReg[3] & L3GD20_FULLSCALE_SELECTION)
   {
-  case L3GD20_FULLSCALE_250:
-    sensitivity=L3GD20_SENSITIVITY_250DPS;
-    break;
-    
   case L3GD20_FULLSCALE_500:
-    sensitivity=L3GD20_SENSITIVITY_500DPS;
+    L3gd20State.Sensitivity = L3GD20_SENSITIVITY_500DPS;
+    L3gd20State.SensitivityCenti = 1750;
     break;
     
-  case L3GD20_FULLSCALE_2000:
-    sensitivity=L3GD20_SENSITIVITY_2000DPS;
+  case L3GD20_FULLSCALE_250:
+    L3gd20State.Sensitivity = L3GD20_SENSITIVITY_250DPS;
+    L3gd20State.SensitivityCenti = 875;
+    break;
+
+  default:
+    /* 0x20 and 0x30 both select 2000 dps */
+    L3gd20State.Sensitivity = L3GD20_SENSITIVITY_2000DPS;
+    L3gd20State.SensitivityCenti = 7000;
     break;
   }
-  /* Divide by sensitivity */
-  for(i=0; i<3; i++)
+}
+
+/**
+  * @brief  Reads the device configuration once if the driver copy is not valid.
+  * @retval None
+  */
+static void L3GD20_EnsureState(void)
+{
+  if(!L3gd20State.Valid)
   {
-    pfData[i]=(float)(RawData[i] * sensitivity);
+    L3GD20_SyncState();
   }
 }
 
@@ -58,6 +58,25 @@
 /** @addtogroup L3GD20
   * @{
   */
+
+/** @defgroup L3GD20_Exported_Types
+  * @{
+  */
+
+/* Driver copy of the configuration written to the device, so that
+   read-modify-write updates and sample decoding need no register reads. */
+typedef struct
+{
+  uint8_t  CtrlReg[5];                        /* CTRL_REG1 .. CTRL_REG5 */
+  uint8_t  FifoCtrl;                          /* FIFO_CTRL_REG */
+  uint8_t  Int1Cfg;                           /* INT1_CFG */
+  uint8_t  Valid;                             /* Non-zero once in step with the device */
+  float    Sensitivity;                       /* Full scale sensitivity [mdps/LSB] */
+  uint16_t SensitivityCenti;                  /* Same, in 1/100 mdps per LSB */
+}L3GD20_StateTypeDef;
+/**
+  * @}
+  */
   
 /** @defgroup L3GD20_Exported_Constants
   * @{
@@ -165,6 +184,70 @@
   * @}
   */
 
+/** @defgroup FIFO_Size
+  * @{
+  */
+#define L3GD20_FIFO_DEPTH          ((uint8_t)32)           /*!< samples held by the FIFO */
+#define L3GD20_SAMPLE_SIZE         ((uint8_t)6)            /*!< bytes per X/Y/Z sample */
+/**
+  * @}
+  */
+
+/** @defgroup FIFO_Mode_Selection
+  * @{
+  */
+#define L3GD20_FIFO_MODE_BYPASS            ((uint8_t)0x00)
+#define L3GD20_FIFO_MODE_FIFO              ((uint8_t)0x20)
+#define L3GD20_FIFO_MODE_STREAM            ((uint8_t)0x40)
+#define L3GD20_FIFO_MODE_STREAM_TO_FIFO    ((uint8_t)0x60)
+#define L3GD20_FIFO_MODE_BYPASS_TO_STREAM  ((uint8_t)0x80)
+#define L3GD20_FIFO_ENABLE                 ((uint8_t)0x40)  /*!< FIFO_EN bit of CTRL_REG5 */
+/**
+  * @}
+  */
+
+/** @defgroup FIFO_Source_Flags
+  * @{
+  */
+#define L3GD20_FIFO_SRC_WTM                ((uint8_t)0x80)
+#define L3GD20_FIFO_SRC_OVRN               ((uint8_t)0x40)
+#define L3GD20_FIFO_SRC_EMPTY              ((uint8_t)0x20)
+#define L3GD20_FIFO_SRC_FSS                ((uint8_t)0x1F)
+/**
+  * @}
+  */
+
+/** @defgroup Status_Register_Flags
+  * @{
+  */
+#define L3GD20_STATUS_ZYXOR                ((uint8_t)0x80)  /*!< X, Y or Z sample overwritten before it was read */
+#define L3GD20_STATUS_ZOR                  ((uint8_t)0x40)
+#define L3GD20_STATUS_YOR                  ((uint8_t)0x20)
+#define L3GD20_STATUS_XOR                  ((uint8_t)0x10)
+#define L3GD20_STATUS_ZYXDA                ((uint8_t)0x08)  /*!< New X, Y and Z sample available */
+#define L3GD20_STATUS_ZDA                  ((uint8_t)0x04)
+#define L3GD20_STATUS_YDA                  ((uint8_t)0x02)
+#define L3GD20_STATUS_XDA                  ((uint8_t)0x01)
+/**
+  * @}
+  */
+
+/** @defgroup INT1_Config_Bits
+  * @{
+  */
+#define L3GD20_INT1_CFG_AND_OR             ((uint8_t)0x80)
+#define L3GD20_INT1_CFG_LIR                ((uint8_t)0x40)
+#define L3GD20_INT1_CFG_ZHIE               ((uint8_t)0x20)
+#define L3GD20_INT1_CFG_ZLIE               ((uint8_t)0x10)
+#define L3GD20_INT1_CFG_YHIE               ((uint8_t)0x08)
+#define L3GD20_INT1_CFG_YLIE               ((uint8_t)0x04)
+#define L3GD20_INT1_CFG_XHIE               ((uint8_t)0x02)
+#define L3GD20_INT1_CFG_XLIE               ((uint8_t)0x01)
+#define L3GD20_INT1_DURATION_WAIT          ((uint8_t)0x80)
+/**
+  * @}
+  */
+
   
 /** @defgroup Block_Data_Update 
   * @{
@@ -283,6 +366,13 @@ void    L3GD20_RebootCmd(void);
 void    L3GD20_INT1InterruptConfig(uint16_t Int1Config);
 void    L3GD20_EnableIT(uint8_t IntSel);
 void    L3GD20_DisableIT(uint8_t IntSel);
+void    L3GD20_INT1ThresholdConfig(uint16_t Threshold, uint8_t Duration);
+
+/* FIFO Functions */
+void    L3GD20_FIFOConfig(uint8_t Mode, uint8_t Watermark);
+uint8_t L3GD20_GetFIFOLevel(void);
+uint8_t L3GD20_GetFIFOStatus(void);
+uint8_t L3GD20_FIFOLevel(uint8_t FifoSrc);
 
 /* High Pass Filter Configuration Functions */
 void    L3GD20_FilterConfig(uint8_t FilterStruct);
@@ -290,11 +380,31 @@ void    L3GD20_FilterCmd(uint8_t HighPassFilterState);
 void    L3GD20_ReadXYZAngRate(float *pfData);
 uint8_t L3GD20_GetDataStatus(void);
 
+/* Driver State Functions */
+void    L3GD20_WriteReg(uint8_t Reg, uint8_t Value);
+void    L3GD20_SyncState(void);
+const L3GD20_StateTypeDef *L3GD20_GetState(void);
+
+/* Sample Decoding Functions (use the cached configuration) */
+void    L3GD20_DecodeXYZ(const uint8_t *pBuffer, int16_t *pRaw, uint16_t Samples);
+void    L3GD20_DecodeXYZmdps(const uint8_t *pBuffer, int32_t *pData, uint16_t Samples);
+void    L3GD20_DecodeXYZAngRate(const uint8_t *pBuffer, float *pfData, uint16_t Samples);
+void    L3GD20_ReadXYZRaw(int16_t *pRaw, uint8_t Samples);
+
+/* Block Data Read Functions (DMA, completion through Callback) */
+uint8_t L3GD20_ReadXYZRawDMA(uint8_t *pBuffer, GYRO_IO_CallbackTypeDef Callback);
+uint8_t L3GD20_ReadStatusXYZRawDMA(uint8_t *pBuffer, GYRO_IO_CallbackTypeDef Callback);
+uint8_t L3GD20_ReadFIFODMA(uint8_t *pBuffer, uint8_t Samples, GYRO_IO_CallbackTypeDef Callback);
+
 /* Gyroscope IO functions */
 void    GYRO_IO_Init(void);
 void    GYRO_IO_DeInit(void);
 void    GYRO_IO_Write(uint8_t *pBuffer, uint8_t WriteAddr, uint16_t NumByteToWrite);
 void    GYRO_IO_Read(uint8_t *pBuffer, uint8_t ReadAddr, uint16_t NumByteToRead);
+uint8_t GYRO_IO_ReadDMA(uint8_t *pBuffer, uint8_t ReadAddr, uint16_t NumByteToRead, GYRO_IO_CallbackTypeDef Callback);
+uint8_t GYRO_IO_IsBusy(void);
+uint8_t GYRO_IO_SetClockDiv(uint16_t Div);
+uint16_t GYRO_IO_GetClockDiv(void);
 
 /* Gyroscope driver structure */
 extern GYRO_DrvTypeDef L3gd20Drv;
@@ -36,6 +36,7 @@
   
 /* Includes ------------------------------------------------------------------*/
 #include "stm32f429i_discovery.h"
+#include "gyro.h"
 #include "cmsis_nvic.h" // // Added for mbed
 
 // Added for mbed. This function replaces HAL_Delay()
@@ -110,6 +111,16 @@ I2C_HandleTypeDef EEP_I2cHandle;
 static SPI_HandleTypeDef SpiHandle;
 static uint8_t Is_LCD_IO_Initialized = 0;
 
+/* Gyroscope block transfers: command byte followed by the data bytes */
+static uint8_t GyroTxBuffer[GYRO_IO_MAX_BLOCK + 1];
+static uint8_t GyroRxBuffer[GYRO_IO_MAX_BLOCK + 1];
+static uint8_t Is_SPIx_DMA_Initialized = 0;
+static __IO uint8_t GyroDmaBusy = 0;
+static uint8_t* GyroDmaDest;
+static uint16_t GyroDmaLength;
+static GYRO_IO_CallbackTypeDef GyroDmaCallback;
+static uint32_t GyroPrescaler = DISCOVERY_SPIx_LCD_PRESCALER;
+
 /**
   * @}
   */ 
@@ -140,7 +151,12 @@ static void               SPIx_Write(uint16_t Value);
 static uint32_t           SPIx_Read(uint8_t ReadSize);
 static uint8_t            SPIx_WriteRead(uint8_t Byte);
 static void               SPIx_Error(void);
+static void               SPIx_SetPrescaler(uint32_t Prescaler);
 static void               SPIx_MspInit(SPI_HandleTypeDef *hspi);
+static void               SPIx_DMA_Init(void);
+static void               DISCOVERY_SPIx_DMA_TX_IRQHandler(void);
+static void               DISCOVERY_SPIx_DMA_RX_IRQHandler(void);
+static void               DISCOVERY_SPIx_IRQHandler(void);
 
 /* Link function for LCD peripheral */
 void                      LCD_IO_Init(void);
@@ -162,6 +178,10 @@ void                      IOE_WriteMultiple(uint8_t Addr, uint8_t Reg, uint8_t *
 void                      GYRO_IO_Init(void);
 void                      GYRO_IO_Write(uint8_t* pBuffer, uint8_t WriteAddr, uint16_t NumByteToWrite);
 void                      GYRO_IO_Read(uint8_t* pBuffer, uint8_t ReadAddr, uint16_t NumByteToRead);
+uint8_t                   GYRO_IO_ReadDMA(uint8_t* pBuffer, uint8_t ReadAddr, uint16_t NumByteToRead, GYRO_IO_CallbackTypeDef Callback);
+uint8_t                   GYRO_IO_IsBusy(void);
+uint8_t                   GYRO_IO_SetClockDiv(uint16_t Div);
+uint16_t                  GYRO_IO_GetClockDiv(void);
 
 #ifdef EE_M24LR64
 /* Link function for I2C EEPROM peripheral */
@@ -666,7 +686,7 @@ static void SPIx_Init(void)
        - l3gd20 SPI interface max baudrate is 10MHz for write/read
        - PCLK2 frequency is set to 90 MHz 
     */  
-    SpiHandle.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_16;
+    SpiHandle.Init.BaudRatePrescaler = DISCOVERY_SPIx_LCD_PRESCALER;
 
     /* On STM32F429I-Discovery, LCD ID cannot be read then keep a common configuration */
     /* for LCD and GYRO (SPI_DIRECTION_2LINES) */
@@ -759,6 +779,25 @@ static void SPIx_Error(void)
   SPIx_Init();
 }
 
+/**
+  * @brief  Changes the SPIx clock divider between transfers.
+  * @note   The LCD and the gyroscope share the bus but not the same speed
+  *         limits, so each device link selects its own prescaler before
+  *         asserting its chip select. Must not be called mid-transfer.
+  * @param  Prescaler: SPI_BAUDRATEPRESCALER_x value.
+  */
+static void SPIx_SetPrescaler(uint32_t Prescaler)
+{
+  if(SpiHandle.Init.BaudRatePrescaler != Prescaler)
+  {
+    /* BR may only change while the peripheral is disabled; the next HAL
+       transfer enables it again */
+    __HAL_SPI_DISABLE(&SpiHandle);
+    MODIFY_REG(SpiHandle.Instance->CR1, SPI_CR1_BR, Prescaler);
+    SpiHandle.Init.BaudRatePrescaler = Prescaler;
+  }
+}
+
 /**
   * @brief  SPI MSP Init.
   * @param  hspi: SPI handle
@@ -777,11 +816,160 @@ static void SPIx_MspInit(SPI_HandleTypeDef *hspi)
   GPIO_InitStructure.Pin    = (DISCOVERY_SPIx_SCK_PIN | DISCOVERY_SPIx_MOSI_PIN | DISCOVERY_SPIx_MISO_PIN);
   GPIO_InitStructure.Mode   = GPIO_MODE_AF_PP;
   GPIO_InitStructure.Pull   = GPIO_PULLDOWN;
-  GPIO_InitStructure.Speed  = GPIO_SPEED_MEDIUM;
+  /* Fast edges: the gyroscope link may be tuned above the LCD clock */
+  GPIO_InitStructure.Speed  = GPIO_SPEED_FAST;
   GPIO_InitStructure.Alternate = DISCOVERY_SPIx_AF;
   HAL_GPIO_Init(DISCOVERY_SPIx_GPIO_PORT, &GPIO_InitStructure);      
 }
 
+/**
+  * @brief  SPIx DMA initialization, for the gyroscope block transfers.
+  */
+static void SPIx_DMA_Init(void)
+{
+  static DMA_HandleTypeDef hdma_tx;
+  static DMA_HandleTypeDef hdma_rx;
+  IRQn_Type irqn;
+
+  if(Is_SPIx_DMA_Initialized)
+  {
+    return;
+  }
+  Is_SPIx_DMA_Initialized = 1;
+
+  DISCOVERY_SPIx_DMA_CLK_ENABLE();
+
+  /* Configure the DMA stream for the SPI TX direction */
+  hdma_tx.Instance                  = DISCOVERY_SPIx_DMA_STREAM_TX;
+  hdma_tx.Init.Channel              = DISCOVERY_SPIx_DMA_CHANNEL;
+  hdma_tx.Init.Direction            = DMA_MEMORY_TO_PERIPH;
+  hdma_tx.Init.PeriphInc            = DMA_PINC_DISABLE;
+  hdma_tx.Init.MemInc               = DMA_MINC_ENABLE;
+  hdma_tx.Init.PeriphDataAlignment  = DMA_PDATAALIGN_BYTE;
+  hdma_tx.Init.MemDataAlignment     = DMA_MDATAALIGN_BYTE;
+  hdma_tx.Init.Mode                 = DMA_NORMAL;
+  hdma_tx.Init.Priority             = DMA_PRIORITY_HIGH;
+  hdma_tx.Init.FIFOMode             = DMA_FIFOMODE_DISABLE;
+  hdma_tx.Init.FIFOThreshold        = DMA_FIFO_THRESHOLD_FULL;
+  hdma_tx.Init.MemBurst             = DMA_MBURST_SINGLE;
+  hdma_tx.Init.PeriphBurst          = DMA_PBURST_SINGLE;
+  __HAL_LINKDMA(&SpiHandle, hdmatx, hdma_tx);
+  HAL_DMA_Init(&hdma_tx);
+
+  /* Configure the DMA stream for the SPI RX direction */
+  hdma_rx.Instance                  = DISCOVERY_SPIx_DMA_STREAM_RX;
+  hdma_rx.Init.Channel              = DISCOVERY_SPIx_DMA_CHANNEL;
+  hdma_rx.Init.Direction            = DMA_PERIPH_TO_MEMORY;
+  hdma_rx.Init.PeriphInc            = DMA_PINC_DISABLE;
+  hdma_rx.Init.MemInc               = DMA_MINC_ENABLE;
+  hdma_rx.Init.PeriphDataAlignment  = DMA_PDATAALIGN_BYTE;
+  hdma_rx.Init.MemDataAlignment     = DMA_MDATAALIGN_BYTE;
+  hdma_rx.Init.Mode                 = DMA_NORMAL;
+  hdma_rx.Init.Priority             = DMA_PRIORITY_VERY_HIGH;
+  hdma_rx.Init.FIFOMode             = DMA_FIFOMODE_DISABLE;
+  hdma_rx.Init.FIFOThreshold        = DMA_FIFO_THRESHOLD_FULL;
+  hdma_rx.Init.MemBurst             = DMA_MBURST_SINGLE;
+  hdma_rx.Init.PeriphBurst          = DMA_PBURST_SINGLE;
+  __HAL_LINKDMA(&SpiHandle, hdmarx, hdma_rx);
+  HAL_DMA_Init(&hdma_rx);
+
+  // Added for mbed
+  /* Configure and enable the DMA and SPI error interrupts */
+  irqn = (IRQn_Type)(DISCOVERY_SPIx_DMA_TX_IRQn);
+  NVIC_ClearPendingIRQ(irqn);
+  NVIC_DisableIRQ(irqn);
+  NVIC_SetPriority(irqn, DISCOVERY_SPIx_DMA_PREPRIO);
+  NVIC_SetVector(irqn, (uint32_t)DISCOVERY_SPIx_DMA_TX_IRQHandler);
+  NVIC_EnableIRQ(irqn);
+
+  irqn = (IRQn_Type)(DISCOVERY_SPIx_DMA_RX_IRQn);
+  NVIC_ClearPendingIRQ(irqn);
+  NVIC_DisableIRQ(irqn);
+  NVIC_SetPriority(irqn, DISCOVERY_SPIx_DMA_PREPRIO);
+  NVIC_SetVector(irqn, (uint32_t)DISCOVERY_SPIx_DMA_RX_IRQHandler);
+  NVIC_EnableIRQ(irqn);
+
+  irqn = (IRQn_Type)(DISCOVERY_SPIx_IRQn);
+  NVIC_ClearPendingIRQ(irqn);
+  NVIC_DisableIRQ(irqn);
+  NVIC_SetPriority(irqn, DISCOVERY_SPIx_DMA_PREPRIO);
+  NVIC_SetVector(irqn, (uint32_t)DISCOVERY_SPIx_IRQHandler);
+  NVIC_EnableIRQ(irqn);
+}
+
+// Added for mbed
+/**
+  * @brief  This function handles SPIx DMA TX interrupt request.
+  */
+static void DISCOVERY_SPIx_DMA_TX_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(SpiHandle.hdmatx);
+}
+
+/**
+  * @brief  This function handles SPIx DMA RX interrupt request.
+  */
+static void DISCOVERY_SPIx_DMA_RX_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(SpiHandle.hdmarx);
+}
+
+/**
+  * @brief  This function handles SPIx interrupt request (transfer errors).
+  */
+static void DISCOVERY_SPIx_IRQHandler(void)
+{
+  HAL_SPI_IRQHandler(&SpiHandle);
+}
+
+/**
+  * @brief  Ends a gyroscope DMA block transfer.
+  * @param  Status: 0 if the transfer completed, 1 on error.
+  */
+static void GYRO_IO_DMADone(uint8_t Status)
+{
+  GYRO_IO_CallbackTypeDef callback = GyroDmaCallback;
+  uint16_t i;
+
+  GYRO_CS_HIGH();
+
+  /* Drop the byte clocked in while the command was sent */
+  for(i = 0; i < GyroDmaLength; i++)
+  {
+    GyroDmaDest[i] = GyroRxBuffer[i + 1];
+  }
+
+  GyroDmaBusy = 0;
+  if(callback != 0)
+  {
+    callback(Status);
+  }
+}
+
+/**
+  * @brief  SPI Tx/Rx transfer completed callback.
+  * @param  hspi: SPI handle
+  */
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+  if((hspi == &SpiHandle) && GyroDmaBusy)
+  {
+    GYRO_IO_DMADone(0);
+  }
+}
+
+/**
+  * @brief  SPI error callback.
+  * @param  hspi: SPI handle
+  */
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
+{
+  if((hspi == &SpiHandle) && GyroDmaBusy)
+  {
+    GYRO_IO_DMADone(1);
+  }
+}
+
 /********************************* LINK LCD ***********************************/
 
 /**
@@ -833,6 +1021,8 @@ void LCD_IO_Init(void)
   */
 void LCD_IO_WriteData(uint16_t RegValue) 
 {
+  SPIx_SetPrescaler(DISCOVERY_SPIx_LCD_PRESCALER);
+
   /* Set WRX to send data */
   LCD_WRX_HIGH();
   
@@ -849,6 +1039,8 @@ void LCD_IO_WriteData(uint16_t RegValue)
   */
 void LCD_IO_WriteReg(uint8_t Reg) 
 {
+  SPIx_SetPrescaler(DISCOVERY_SPIx_LCD_PRESCALER);
+
   /* Reset WRX to send command */
   LCD_WRX_LOW();
   
@@ -870,6 +1062,8 @@ uint32_t LCD_IO_ReadData(uint16_t RegValue, uint8_t ReadSize)
 {
   uint32_t readvalue = 0;
 
+  SPIx_SetPrescaler(DISCOVERY_SPIx_LCD_PRESCALER);
+
   /* Select: Chip Select low */
   LCD_CS_LOW();
 
@@ -1010,14 +1204,43 @@ void GYRO_IO_Init(void)
   SPIx_Init();
 }
 
+/**
+  * @brief  Waits for a gyroscope DMA block transfer to end, so a blocking
+  *         transfer neither cuts into it on the bus nor reuses GyroTxBuffer
+  *         and GyroRxBuffer under it.
+  * @note   From an interrupt that masks the SPI DMA interrupt, the transfer
+  *         cannot end and the wait runs out.
+  * @retval 0 once the bus is free, 1 if the transfer did not end within SpixTimeout.
+  */
+static uint8_t GYRO_IO_WaitIdle(void)
+{
+  uint32_t start = HAL_GetTick();
+
+  while(GyroDmaBusy)
+  {
+    if((HAL_GetTick() - start) > SpixTimeout)
+    {
+      return 1;
+    }
+  }
+  return 0;
+}
+
 /**
   * @brief  Writes one byte to the Gyroscope.
   * @param  pBuffer: Pointer to the buffer containing the data to be written to the Gyroscope.
   * @param  WriteAddr: Gyroscope's internal address to write to.
   * @param  NumByteToWrite: Number of bytes to write.
+  * @note   Waits for a DMA block read in progress to end; if it does not,
+  *         nothing is written.
   */
 void GYRO_IO_Write(uint8_t* pBuffer, uint8_t WriteAddr, uint16_t NumByteToWrite)
 {
+  if(GYRO_IO_WaitIdle() != 0)
+  {
+    return;
+  }
+
   /* Configure the MS bit: 
        - When 0, the address will remain unchanged in multiple read/write commands.
        - When 1, the address will be auto incremented in multiple read/write commands.
@@ -1026,6 +1249,8 @@ void GYRO_IO_Write(uint8_t* pBuffer, uint8_t WriteAddr, uint16_t NumByteToWrite)
   {
     WriteAddr |= (uint8_t)MULTIPLEBYTE_CMD;
   }
+  SPIx_SetPrescaler(GyroPrescaler);
+
   /* Set chip select Low at the start of the transmission */
   GYRO_CS_LOW();
   
@@ -1049,9 +1274,21 @@ void GYRO_IO_Write(uint8_t* pBuffer, uint8_t WriteAddr, uint16_t NumByteToWrite)
   * @param  pBuffer: Pointer to the buffer that receives the data read from the Gyroscope.
   * @param  ReadAddr: Gyroscope's internal address to read from.
   * @param  NumByteToRead: Number of bytes to read from the Gyroscope.
+  * @note   Waits for a DMA block read in progress to end; if it does not,
+  *         pBuffer is left as it was.
   */
 void GYRO_IO_Read(uint8_t* pBuffer, uint8_t ReadAddr, uint16_t NumByteToRead)
 {  
+  uint16_t i;
+
+  if(GYRO_IO_WaitIdle() != 0)
+  {
+    return;
+  }
+  if(NumByteToRead > GYRO_IO_MAX_BLOCK)
+  {
+    NumByteToRead = GYRO_IO_MAX_BLOCK;
+  }
   if(NumByteToRead > 0x01)
   {
     ReadAddr |= (uint8_t)(READWRITE_CMD | MULTIPLEBYTE_CMD);
@@ -1060,25 +1297,132 @@ void GYRO_IO_Read(uint8_t* pBuffer, uint8_t ReadAddr, uint16_t NumByteToRead)
   {
     ReadAddr |= (uint8_t)READWRITE_CMD;
   }
+
+  /* Address byte followed by dummy bytes (0x00) to clock the data out */
+  GyroTxBuffer[0] = ReadAddr;
+  for(i = 1; i <= NumByteToRead; i++)
+  {
+    GyroTxBuffer[i] = DUMMY_BYTE;
+  }
+
+  SPIx_SetPrescaler(GyroPrescaler);
+
   /* Set chip select Low at the start of the transmission */
   GYRO_CS_LOW();
   
-  /* Send the Address of the indexed register */
-  SPIx_WriteRead(ReadAddr);
-  
-  /* Receive the data that will be read from the device (MSB First) */
-  while(NumByteToRead > 0x00)
+  /* Move the whole register block in one transaction */
+  if(HAL_SPI_TransmitReceive(&SpiHandle, GyroTxBuffer, GyroRxBuffer, NumByteToRead + 1, SpixTimeout) != HAL_OK)
   {
-    /* Send dummy byte (0x00) to generate the SPI clock to Gyroscope (Slave device) */
-    *pBuffer = SPIx_WriteRead(DUMMY_BYTE);
-    NumByteToRead--;
-    pBuffer++;
+    SPIx_Error();
   }
   
   /* Set chip select High at the end of the transmission */ 
   GYRO_CS_HIGH();
+
+  for(i = 0; i < NumByteToRead; i++)
+  {
+    pBuffer[i] = GyroRxBuffer[i + 1];
+  }
 }  
 
+/**
+  * @brief  Starts reading a block of data from the Gyroscope through DMA.
+  * @note   Returns immediately. The chip select is released and Callback is
+  *         called (from interrupt context) once pBuffer holds the data, so
+  *         pBuffer must stay valid until then.
+  * @param  pBuffer: Pointer to the buffer that receives the data read from the Gyroscope.
+  * @param  ReadAddr: Gyroscope's internal address to read from.
+  * @param  NumByteToRead: Number of bytes to read (at most GYRO_IO_MAX_BLOCK).
+  * @param  Callback: Completion callback, called with 0 on success. May be 0.
+  * @retval 0 if the transfer was started, 1 if the bus is busy or the request is invalid.
+  */
+uint8_t GYRO_IO_ReadDMA(uint8_t* pBuffer, uint8_t ReadAddr, uint16_t NumByteToRead, GYRO_IO_CallbackTypeDef Callback)
+{
+  uint16_t i;
+
+  if((NumByteToRead == 0) || (NumByteToRead > GYRO_IO_MAX_BLOCK) || GyroDmaBusy)
+  {
+    return 1;
+  }
+
+  SPIx_DMA_Init();
+
+  if(NumByteToRead > 0x01)
+  {
+    ReadAddr |= (uint8_t)(READWRITE_CMD | MULTIPLEBYTE_CMD);
+  }
+  else
+  {
+    ReadAddr |= (uint8_t)READWRITE_CMD;
+  }
+
+  GyroTxBuffer[0] = ReadAddr;
+  for(i = 1; i <= NumByteToRead; i++)
+  {
+    GyroTxBuffer[i] = DUMMY_BYTE;
+  }
+
+  GyroDmaDest = pBuffer;
+  GyroDmaLength = NumByteToRead;
+  GyroDmaCallback = Callback;
+  GyroDmaBusy = 1;
+
+  SPIx_SetPrescaler(GyroPrescaler);
+  GYRO_CS_LOW();
+  if(HAL_SPI_TransmitReceive_DMA(&SpiHandle, GyroTxBuffer, GyroRxBuffer, NumByteToRead + 1) != HAL_OK)
+  {
+    GYRO_CS_HIGH();
+    GyroDmaBusy = 0;
+    return 1;
+  }
+  return 0;
+}
+
+/**
+  * @brief  Tells whether a gyroscope DMA block transfer is in progress.
+  * @retval 1 if busy, else 0.
+  */
+uint8_t GYRO_IO_IsBusy(void)
+{
+  return GyroDmaBusy;
+}
+
+/**
+  * @brief  Selects the SPI clock used for gyroscope transfers (PCLK2 / Div).
+  * @note   Takes effect from the next transfer. LCD transfers keep running
+  *         at DISCOVERY_SPIx_LCD_PRESCALER.
+  * @param  Div: Clock divider, a power of two from 2 to 256.
+  * @retval 0 if the divider was accepted, 1 if it is not supported.
+  */
+uint8_t GYRO_IO_SetClockDiv(uint16_t Div)
+{
+  uint32_t br = 0;
+  uint16_t div = 2;
+
+  while((div < Div) && (br < 7))
+  {
+    div <<= 1;
+    br++;
+  }
+  if(div != Div)
+  {
+    return 1;
+  }
+
+  /* SPI_BAUDRATEPRESCALER_x: BR[2:0] = log2(Div) - 1 in CR1 bits 5:3 */
+  GyroPrescaler = br << 3;
+  return 0;
+}
+
+/**
+  * @brief  Returns the SPI clock divider used for gyroscope transfers.
+  * @retval Divider (PCLK2 / Div is the SPI clock).
+  */
+uint16_t GYRO_IO_GetClockDiv(void)
+{
+  return (uint16_t)(2 << (GyroPrescaler >> 3));
+}
+
 
 #ifdef EE_M24LR64
 
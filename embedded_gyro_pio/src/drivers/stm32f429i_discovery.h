@@ -202,6 +202,25 @@ typedef enum
    conditions (interrupts routines ...). */   
 #define SPIx_TIMEOUT_MAX              ((uint32_t)0x1000)
 
+/* SPIx clock for the LCD: PCLK2/16 = 5.6 MHz keeps within the ILI9341 read
+   (6.66 MHz) and write (10 MHz) limits. The gyroscope link selects its own
+   divider through GYRO_IO_SetClockDiv(). */
+#define DISCOVERY_SPIx_LCD_PRESCALER            SPI_BAUDRATEPRESCALER_16
+
+/* Definition for SPIx DMA (gyroscope block transfers) */
+#define DISCOVERY_SPIx_DMA_CHANNEL              DMA_CHANNEL_2
+#define DISCOVERY_SPIx_DMA_STREAM_TX            DMA2_Stream4
+#define DISCOVERY_SPIx_DMA_STREAM_RX            DMA2_Stream3
+#define DISCOVERY_SPIx_DMA_CLK_ENABLE()         __HAL_RCC_DMA2_CLK_ENABLE()
+
+#define DISCOVERY_SPIx_DMA_TX_IRQn              DMA2_Stream4_IRQn
+#define DISCOVERY_SPIx_DMA_RX_IRQn              DMA2_Stream3_IRQn
+#define DISCOVERY_SPIx_DMA_TX_IRQHandler        DMA2_Stream4_IRQHandler
+#define DISCOVERY_SPIx_DMA_RX_IRQHandler        DMA2_Stream3_IRQHandler
+#define DISCOVERY_SPIx_IRQn                     SPI5_IRQn
+#define DISCOVERY_SPIx_IRQHandler               SPI5_IRQHandler
+#define DISCOVERY_SPIx_DMA_PREPRIO              0x0E
+
 
 /*################################ IOE #######################################*/
 /** 
@@ -258,6 +277,8 @@ typedef enum
 #define MULTIPLEBYTE_CMD           ((uint8_t)0x40)
 /* Dummy Byte Send by the SPI Master device in order to generate the Clock to the Slave device */
 #define DUMMY_BYTE                 ((uint8_t)0x00)
+/* Largest block moved by one GYRO_IO_Read()/GYRO_IO_ReadDMA() (a full 32-level FIFO) */
+#define GYRO_IO_MAX_BLOCK          ((uint16_t)(32 * 6))
 
 /* Chip Select macro definition */
 #define GYRO_CS_LOW()       HAL_GPIO_WritePin(GYRO_CS_GPIO_PORT, GYRO_CS_PIN, GPIO_PIN_RESET)
@@ -457,6 +457,48 @@ uint32_t BSP_EEPROM_WaitEepromStandbyState(void)
   return EEPROM_OK;
 }
 
+/**
+  * @brief  Starts writing one page to the EEPROM and returns without waiting.
+  *
+  * @note   Same page boundary rules as BSP_EEPROM_WritePage(). The DMA transfer
+  *         ends with BSP_EEPROM_WriteCplt_UserCallback(), after which the EEPROM
+  *         runs its internal write cycle; poll BSP_EEPROM_PollStandbyState()
+  *         until it answers again before the next access.
+  *
+  * @param  pBuffer : pointer to the data, which must stay valid until the
+  *         completion callback.
+  * @param  WriteAddr : EEPROM's internal address to write to.
+  * @param  NumByteToWrite : number of bytes to write (at most one page).
+  * @retval EEPROM_OK (0) if the transfer was started, else EEPROM_FAIL.
+  */
+uint32_t BSP_EEPROM_StartWritePage(uint8_t *pBuffer, uint16_t WriteAddr, uint8_t NumByteToWrite)
+{
+  EEPROMDataWrite = NumByteToWrite;
+
+  if (EEPROM_IO_WriteData(EEPROMAddress, WriteAddr, pBuffer, NumByteToWrite) != HAL_OK)
+  {
+    EEPROMDataWrite = 0;
+    return EEPROM_FAIL;
+  }
+  return EEPROM_OK;
+}
+
+/**
+  * @brief  Checks once whether the EEPROM has finished its internal write cycle.
+  * @note   Sends a single address probe instead of the EEPROM_MAX_TRIALS loop
+  *         of BSP_EEPROM_WaitEepromStandbyState(), so it can be called from a
+  *         periodic timer.
+  * @retval EEPROM_OK (0) if the EEPROM acknowledged, else EEPROM_FAIL.
+  */
+uint32_t BSP_EEPROM_PollStandbyState(void)
+{
+  if (EEPROM_IO_IsDeviceReady(EEPROMAddress, 1) != HAL_OK)
+  {
+    return EEPROM_FAIL;
+  }
+  return EEPROM_OK;
+}
+
 /**
   * @brief  Memory Tx Transfer completed callbacks.
   * @param  hi2c: I2C handle
@@ -464,6 +506,7 @@ uint32_t BSP_EEPROM_WaitEepromStandbyState(void)
 void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c)
 {
   EEPROMDataWrite = 0;  
+  BSP_EEPROM_WriteCplt_UserCallback();
 }
 
 /**
@@ -482,6 +525,13 @@ __weak void BSP_EEPROM_TIMEOUT_UserCallback(void)
 {
 }
 
+/**
+  * @brief  Called from interrupt context when a page write DMA transfer is done.
+  */
+__weak void BSP_EEPROM_WriteCplt_UserCallback(void)
+{
+}
+
 #endif /* EE_M24LR64 */
 
 /**
@@ -105,6 +105,8 @@ uint32_t BSP_EEPROM_ReadBuffer(uint8_t *pBuffer, uint16_t ReadAddr, uint16_t *Nu
 uint32_t BSP_EEPROM_WritePage(uint8_t *pBuffer, uint16_t WriteAddr, uint8_t *NumByteToWrite);
 uint32_t BSP_EEPROM_WriteBuffer(uint8_t *pBuffer, uint16_t WriteAddr, uint16_t NumByteToWrite);
 uint32_t BSP_EEPROM_WaitEepromStandbyState(void);
+uint32_t BSP_EEPROM_StartWritePage(uint8_t *pBuffer, uint16_t WriteAddr, uint8_t NumByteToWrite);
+uint32_t BSP_EEPROM_PollStandbyState(void);
 
 /* USER Callbacks: This function is declared as __weak in EEPROM driver and 
    should be implemented into user application.  
@@ -113,6 +115,10 @@ uint32_t BSP_EEPROM_WaitEepromStandbyState(void);
    errors, busy devices ...). */
 void     BSP_EEPROM_TIMEOUT_UserCallback(void);
 
+/* BSP_EEPROM_WriteCplt_UserCallback() is called from interrupt context when a
+   transfer started by BSP_EEPROM_StartWritePage() has been sent. */
+void     BSP_EEPROM_WriteCplt_UserCallback(void);
+
 
 /* Link function for I2C EEPROM peripheral */
 void              EEPROM_IO_Init(void);
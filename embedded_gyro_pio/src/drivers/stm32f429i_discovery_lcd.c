@@ -136,6 +136,7 @@ LCD_DrvTypeDef  *LcdDrv;
   * @{
   */ 
 static void DrawChar(uint16_t Xpos, uint16_t Ypos, const uint8_t *c);
+static void DrawPackedChar(uint16_t Xpos, uint16_t Ypos, uint8_t Ascii);
 static void FillBuffer(uint32_t LayerIndex, void *pDst, uint32_t xSize, uint32_t ySize, uint32_t OffLine, uint32_t ColorIndex);
 static void ConvertLineToARGB8888(void *pSrc, void *pDst, uint32_t xSize, uint32_t ColorMode);
 /**
@@ -276,7 +277,7 @@ void BSP_LCD_LayerDefaultInit(uint16_t LayerIndex, uint32_t FB_Address)
   HAL_LTDC_ConfigLayer(&LtdcHandler, &Layercfg, LayerIndex); 
 
   DrawProp[LayerIndex].BackColor = LCD_COLOR_WHITE;
-  DrawProp[LayerIndex].pFont     = &Font24;
+  DrawProp[LayerIndex].pFont     = &LCD_DEFAULT_FONT;
   DrawProp[LayerIndex].TextColor = LCD_COLOR_BLACK; 
 
   /* Dithering activation */
@@ -594,6 +595,11 @@ void BSP_LCD_ClearStringLine(uint32_t Line)
   */
 void BSP_LCD_DisplayChar(uint16_t Xpos, uint16_t Ypos, uint8_t Ascii)
 {
+  if(DrawProp[ActiveLayer].pFont->packed != NULL)
+  {
+    DrawPackedChar(Xpos, Ypos, Ascii);
+    return;
+  }
   DrawChar(Xpos, Ypos, &DrawProp[ActiveLayer].pFont->table[(Ascii-' ') *\
               DrawProp[ActiveLayer].pFont->Height * ((DrawProp[ActiveLayer].pFont->Width + 7) / 8)]);
 }
@@ -1365,6 +1371,23 @@ static void DrawChar(uint16_t Xpos, uint16_t Ypos, const uint8_t *c)
   }
 }
 
+/**
+  * @brief  Draws a character of a packed font on LCD.
+  * @note   Writes the frame buffer directly (Font_DrawPackedGlyph()).
+  *         Characters outside the font's range are drawn blank.
+  * @param  Xpos: start column address
+  * @param  Ypos: the Line where to display the character shape
+  * @param  Ascii: character ascii code
+  */
+static void DrawPackedChar(uint16_t Xpos, uint16_t Ypos, uint8_t Ascii)
+{
+  uint32_t xsize = BSP_LCD_GetXSize();
+  uint32_t *row = (uint32_t *)LtdcHandler.LayerCfg[ActiveLayer].FBStartAdress + Ypos * xsize + Xpos;
+
+  Font_DrawPackedGlyph(DrawProp[ActiveLayer].pFont, Ascii, row, xsize,
+                       DrawProp[ActiveLayer].TextColor, DrawProp[ActiveLayer].BackColor);
+}
+
 /**
   * @brief  Fills buffer.
   * @param  LayerIndex: layer index
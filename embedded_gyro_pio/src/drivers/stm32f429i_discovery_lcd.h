@@ -142,7 +142,7 @@ typedef enum
 /** 
   * @brief LCD default font 
   */ 
-#define LCD_DEFAULT_FONT         Font24
+#define LCD_DEFAULT_FONT         Font16
 
 /** 
   * @brief  LCD Reload Types
@@ -0,0 +1,90 @@
+/**
+ * @file drop_detector.cpp
+ *
+ * @brief Accounting of gyroscope samples lost or read late.
+ *
+ */
+
+#include "drop_detector.h"
+#include "drivers/l3gd20.h"
+
+void DropDetector::reset() {
+    for (int i = 0; i < DROP_CAUSE_COUNT; i++) {
+        counts[i] = 0;
+    }
+    sample_count = 0;
+    lost_total = 0;
+    latency_max = 0;
+    have_last = false;
+    log_count = 0;
+}
+
+void DropDetector::on_sample(uint8_t status, uint32_t timestamp_us, uint32_t read_us, uint8_t state) {
+    sample_count++;
+
+    uint32_t latency_us = read_us - timestamp_us;
+    if (latency_us > latency_max) {
+        latency_max = latency_us;
+    }
+    if (latency_us > period_us) {
+        log(DROP_DEADLINE_MISS, 0, timestamp_us, state);
+    }
+
+    if (status & L3GD20_STATUS_ZYXOR) {
+        // At least one sample was overwritten. While the data-ready line
+        // stayed high no edges came, so the gap says how many.
+        uint32_t lost = 1;
+        if (have_last && period_us != 0) {
+            uint32_t periods = (timestamp_us - last_timestamp_us + period_us / 2) / period_us;
+            if (periods > 1) {
+                lost = periods - 1;
+            }
+        }
+        log(DROP_SENSOR_OVERRUN, (uint16_t)(lost > 0xFFFF ? 0xFFFF : lost), timestamp_us, state);
+    }
+
+    last_timestamp_us = timestamp_us;
+    have_last = true;
+}
+
+void DropDetector::on_fifo(uint8_t fifo_src, uint8_t fifo_mode, uint32_t time_us, uint8_t state) {
+    // Only FIFO mode (also after a stream-to-FIFO switch) stops storing
+    // when full; stream mode drops its oldest entries on purpose.
+    bool stops_when_full = (fifo_mode == L3GD20_FIFO_MODE_FIFO) ||
+                           (fifo_mode == L3GD20_FIFO_MODE_STREAM_TO_FIFO);
+    if ((fifo_src & L3GD20_FIFO_SRC_OVRN) && stops_when_full) {
+        // How long it has been full is unknown; count the overflow itself.
+        log(DROP_FIFO_OVERFLOW, 1, time_us, state);
+    }
+}
+
+void DropDetector::on_dropped(DropCause cause, uint16_t lost, uint32_t time_us, uint8_t state) {
+    if (cause < DROP_CAUSE_COUNT && lost > 0) {
+        log(cause, lost, time_us, state);
+    }
+}
+
+void DropDetector::log(DropCause cause, uint16_t lost, uint32_t time_us, uint8_t state) {
+    counts[cause]++;
+    lost_total += lost;
+
+    DropEvent &e = log_entries[log_count % DROP_LOG_SIZE];
+    e.time_us = time_us;
+    e.cause = cause;
+    e.state = state;
+    e.lost = lost;
+    log_count++;
+}
+
+size_t DropDetector::events(DropEvent *out, size_t max) const {
+    uint32_t kept = (log_count < DROP_LOG_SIZE) ? log_count : DROP_LOG_SIZE;
+    if (max > kept) {
+        max = kept;
+    }
+    // The newest max entries, oldest first.
+    uint32_t first = log_count - (uint32_t)max;
+    for (size_t i = 0; i < max; i++) {
+        out[i] = log_entries[(first + i) % DROP_LOG_SIZE];
+    }
+    return max;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file drop_detector.h
+ *
+ * @brief Accounting of gyroscope samples lost or read late.
+ *
+ * Every sample read comes with the STATUS_REG byte read in the same
+ * burst. ZYXOR there means the sensor overwrote a sample nobody had read;
+ * the gap to the previous data-ready time-stamp then tells how many went
+ * missing. FIFO_SRC reads are checked for OVRN, which loses data in FIFO
+ * mode (stream mode overwrites the oldest entries by design). Samples
+ * that did not fit an inter-thread queue, and reads that finished after
+ * the next sample was due, are reported by the caller.
+ *
+ * Each event is counted per cause and kept, with its time and the
+ * application state it happened in, in a small log of the latest events.
+ *
+ * Updates must come from one context at a time (the acquisition thread
+ * while recording); read the results while it is idle.
+ *
+ */
+
+#ifndef DROP_DETECTOR_H
+#define DROP_DETECTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Latest events kept in the log.
+#define DROP_LOG_SIZE 8
+
+enum DropCause : uint8_t {
+    DROP_SENSOR_OVERRUN = 0,    // STATUS_REG ZYXOR: an unread sample was overwritten.
+    DROP_FIFO_OVERFLOW  = 1,    // FIFO_SRC OVRN in FIFO mode: the FIFO filled up and stopped.
+    DROP_QUEUE_FULL     = 2,    // A data-ready edge or sample did not fit a thread queue.
+    DROP_DEADLINE_MISS  = 3,    // Read finished after the next sample was due.
+    DROP_CAUSE_COUNT
+};
+
+// One logged event. Laid out without padding so it can be exported as is.
+struct DropEvent {
+    uint32_t time_us;           // Data-ready time-stamp of the sample concerned.
+    uint8_t cause;              // DropCause
+    uint8_t state;              // Application state at the time.
+    uint16_t lost;              // Samples lost (0 for a deadline miss).
+};
+
+class DropDetector {
+public:
+    // period_us: nominal spacing of the data-ready events.
+    explicit DropDetector(uint32_t period_us) : period_us(period_us) {}
+
+    // Clears counters and log, e.g. at the start of a session.
+    void reset();
+
+    // One sample read: the STATUS_REG byte read with it, its data-ready
+    // time-stamp and the time the read completed (same clock).
+    void on_sample(uint8_t status, uint32_t timestamp_us, uint32_t read_us, uint8_t state);
+
+    // One FIFO_SRC read, with the FIFO mode it was configured for.
+    void on_fifo(uint8_t fifo_src, uint8_t fifo_mode, uint32_t time_us, uint8_t state);
+
+    // Samples lost for a reason only the caller can see (e.g. DROP_QUEUE_FULL).
+    void on_dropped(DropCause cause, uint16_t lost, uint32_t time_us, uint8_t state);
+
+    // Events of one cause, samples read, and the estimated samples lost
+    // (all causes), since reset().
+    uint32_t count(DropCause cause) const { return counts[cause]; }
+    uint32_t samples() const { return sample_count; }
+    uint32_t lost() const { return lost_total; }
+
+    // Longest data-ready to read-complete time seen.
+    uint32_t max_latency_us() const { return latency_max; }
+
+    // Copies up to max logged events, oldest first. Returns how many.
+    size_t events(DropEvent *out, size_t max) const;
+
+private:
+    void log(DropCause cause, uint16_t lost, uint32_t time_us, uint8_t state);
+
+    uint32_t period_us;
+    uint32_t counts[DROP_CAUSE_COUNT] = {};
+    uint32_t sample_count = 0;
+    uint32_t lost_total = 0;
+    uint32_t latency_max = 0;
+    uint32_t last_timestamp_us = 0;
+    bool have_last = false;
+
+    DropEvent log_entries[DROP_LOG_SIZE];
+    uint32_t log_count = 0;     // Events ever logged; the newest is at (log_count - 1) % size.
+};
+
+#endif // DROP_DETECTOR_H
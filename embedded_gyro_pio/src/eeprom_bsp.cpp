@@ -0,0 +1,35 @@
+/**
+ * @file eeprom_bsp.cpp
+ *
+ * @brief EepromDevice backed by the BSP M24LR64 I2C EEPROM driver.
+ *
+ */
+
+#include "eeprom_bsp.h"
+#include "drivers/stm32f429i_discovery_eeprom.h"
+
+bool BspEeprom::init() {
+    ready = (BSP_EEPROM_Init() == EEPROM_OK);
+    return ready;
+}
+
+bool BspEeprom::read(uint16_t addr, uint8_t *buf, uint16_t len) {
+    if (!ready || addr + len > EEPROM_MAX_SIZE) {
+        return false;
+    }
+    // The driver counts this down to 0 from the DMA completion interrupt.
+    uint16_t remaining = len;
+    return BSP_EEPROM_ReadBuffer(buf, addr, &remaining) == EEPROM_OK;
+}
+
+bool BspEeprom::write(uint16_t addr, const uint8_t *buf, uint16_t len, EepromWriteDone done, void *context) {
+    if (!ready || addr + len > EEPROM_MAX_SIZE) {
+        return false;
+    }
+    // Splits the buffer on page boundaries and waits out each page write.
+    bool ok = BSP_EEPROM_WriteBuffer((uint8_t *)buf, addr, len) == EEPROM_OK;
+    if (done) {
+        done(context, ok);
+    }
+    return true;
+}
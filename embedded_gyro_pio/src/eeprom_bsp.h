@@ -0,0 +1,32 @@
+/**
+ * @file eeprom_bsp.h
+ *
+ * @brief EepromDevice backed by the BSP M24LR64 I2C EEPROM driver.
+ *
+ * The M24LR64 sits on the ANT7-M24LR-A daughter board, so it may not be
+ * fitted. init() reports that, and every access fails cleanly afterwards.
+ *
+ */
+
+#ifndef EEPROM_BSP_H
+#define EEPROM_BSP_H
+
+#include "record_store.h"
+
+class BspEeprom : public EepromDevice {
+public:
+    // Brings up I2C and probes both M24LR64 addresses.
+    // Returns false if no EEPROM answers.
+    bool init();
+
+    bool present() const { return ready; }
+
+    bool read(uint16_t addr, uint8_t *buf, uint16_t len) override;
+    // Writes before returning, then calls done.
+    bool write(uint16_t addr, const uint8_t *buf, uint16_t len, EepromWriteDone done, void *context) override;
+
+private:
+    bool ready = false;
+};
+
+#endif // EEPROM_BSP_H
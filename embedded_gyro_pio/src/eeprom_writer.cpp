@@ -0,0 +1,206 @@
+/**
+ * @file eeprom_writer.cpp
+ *
+ * @brief Background EEPROM writes on a thread of their own.
+ *
+ */
+
+#include "eeprom_writer.h"
+#include "drivers/stm32f429i_discovery_eeprom.h"
+#include <string.h>
+
+using namespace std::chrono_literals;
+
+// done_flags bit set whenever a write finishes.
+#define WRITE_DONE_FLAG 1
+
+// Events the writer queue holds at once: a job start or transfer
+// completion, and a watchdog or ACK probe.
+#define WRITER_QUEUE_EVENTS 4
+
+// Writer the BSP completion callback is routed to.
+static EepromWriter *active_writer = nullptr;
+
+extern "C" void BSP_EEPROM_WriteCplt_UserCallback(void) {
+    if (active_writer) {
+        active_writer->on_transfer_complete();
+    }
+}
+
+bool EepromFuture::ready() const {
+    return writer && writer->is_done(ticket);
+}
+
+bool EepromFuture::ok() const {
+    return writer && writer->is_ok(ticket);
+}
+
+bool EepromFuture::wait() const {
+    if (!writer) {
+        return false;
+    }
+    while (!writer->is_done(ticket)) {
+        writer->done_flags.wait_any(WRITE_DONE_FLAG);
+    }
+    return writer->is_ok(ticket);
+}
+
+EepromWriter::EepromWriter(BspEeprom &device)
+    : device(device), worker(EEPROM_WRITER_PRIORITY, EEPROM_WRITER_STACK_SIZE, nullptr, "eeprom"),
+      queue(WRITER_QUEUE_EVENTS * EVENTS_EVENT_SIZE) {
+    for (int i = 0; i < EEPROM_WRITER_HISTORY; i++) {
+        results[i] = false;
+    }
+    active_writer = this;
+}
+
+void EepromWriter::start() {
+    worker.start(callback(&queue, &EventQueue::dispatch_forever));
+}
+
+EepromFuture EepromWriter::write_async(uint16_t addr, const uint8_t *buf, uint16_t len,
+                                       EepromWriteDone done, void *context) {
+    if (!device.present() || len == 0 || len > EEPROM_WRITER_MAX_LEN || addr + len > EEPROM_MAX_SIZE) {
+        return EepromFuture();
+    }
+
+    CriticalSectionLock lock;
+    if (pending == EEPROM_WRITER_DEPTH) {
+        return EepromFuture();
+    }
+
+    Job &job = jobs[(head + pending) % EEPROM_WRITER_DEPTH];
+    job.ticket = next_ticket++;
+    job.addr = addr;
+    job.len = len;
+    job.done = done;
+    job.context = context;
+    memcpy(job.data, buf, len);
+    results[job.ticket % EEPROM_WRITER_HISTORY] = false;
+
+    // An idle writer has to be kicked off; otherwise the writer thread
+    // picks the job up when the current one finishes.
+    if (pending == 0 && queue.call(callback(this, &EepromWriter::start_job)) == 0) {
+        return EepromFuture();
+    }
+    pending++;
+
+    last = EepromFuture(this, job.ticket);
+    return last;
+}
+
+bool EepromWriter::write(uint16_t addr, const uint8_t *buf, uint16_t len, EepromWriteDone done, void *context) {
+    return write_async(addr, buf, len, done, context).valid();
+}
+
+void EepromWriter::sync() {
+    while (pending != 0) {
+        done_flags.wait_any(WRITE_DONE_FLAG);
+    }
+}
+
+bool EepromWriter::read(uint16_t addr, uint8_t *buf, uint16_t len) {
+    sync();
+    return device.read(addr, buf, len);
+}
+
+void EepromWriter::start_job() {
+    offset = 0;
+    start_page();
+}
+
+void EepromWriter::start_page() {
+    Job &job = jobs[head];
+    if (offset >= job.len) {
+        finish_job(true);
+        return;
+    }
+
+    // Never cross an EEPROM page boundary in one transfer.
+    uint16_t addr = job.addr + offset;
+    uint16_t len = EEPROM_PAGESIZE - (addr % EEPROM_PAGESIZE);
+    if (len > job.len - offset) {
+        len = job.len - offset;
+    }
+    page_len = (uint8_t)len;
+    polls = 0;
+
+    transferring = true;
+    if (BSP_EEPROM_StartWritePage(job.data + offset, addr, page_len) != EEPROM_OK) {
+        transferring = false;
+        finish_job(false);
+        return;
+    }
+
+    // Watchdog in case the transfer never completes (e.g. a bus error).
+    timer_event = queue.call_in(EEPROM_WRITER_POLL_PERIOD * EEPROM_WRITER_POLL_LIMIT,
+                                callback(this, &EepromWriter::transfer_timeout));
+}
+
+void EepromWriter::on_transfer_complete() {
+    queue.call(callback(this, &EepromWriter::transfer_done));
+}
+
+void EepromWriter::transfer_done() {
+    if (!transferring) {
+        return;
+    }
+    transferring = false;
+    queue.cancel(timer_event);
+    timer_event = queue.call_in(EEPROM_WRITER_POLL_PERIOD, callback(this, &EepromWriter::poll_ack));
+}
+
+void EepromWriter::transfer_timeout() {
+    timer_event = 0;
+    if (transferring) {
+        transferring = false;
+        finish_job(false);
+    }
+}
+
+void EepromWriter::poll_ack() {
+    timer_event = 0;
+    if (BSP_EEPROM_PollStandbyState() == EEPROM_OK) {
+        offset += page_len;
+        start_page();
+    } else if (++polls >= EEPROM_WRITER_POLL_LIMIT) {
+        finish_job(false);
+    } else {
+        timer_event = queue.call_in(EEPROM_WRITER_POLL_PERIOD, callback(this, &EepromWriter::poll_ack));
+    }
+}
+
+void EepromWriter::finish_job(bool ok) {
+    // The owner hears of the write before sync() and read() stop waiting
+    // for it, so whatever it updates on completion is settled by then.
+    Job &job = jobs[head];
+    if (job.done) {
+        job.done(job.context, ok);
+    }
+
+    bool more;
+    {
+        CriticalSectionLock lock;
+        results[job.ticket % EEPROM_WRITER_HISTORY] = ok;
+        completed = job.ticket;
+        head = (head + 1) % EEPROM_WRITER_DEPTH;
+        pending--;
+        more = pending != 0;
+    }
+    done_flags.set(WRITE_DONE_FLAG);
+
+    if (more) {
+        start_job();
+    }
+}
+
+bool EepromWriter::is_done(uint32_t ticket) const {
+    return ticket <= completed;
+}
+
+bool EepromWriter::is_ok(uint32_t ticket) const {
+    if (ticket > completed || completed - ticket >= EEPROM_WRITER_HISTORY) {
+        return false;
+    }
+    return results[ticket % EEPROM_WRITER_HISTORY];
+}
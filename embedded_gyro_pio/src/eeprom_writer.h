@@ -0,0 +1,172 @@
+/**
+ * @file eeprom_writer.h
+ *
+ * @brief Background EEPROM writes on a thread of their own.
+ *
+ * The blocking BSP write path spins on the DMA transfer and then on up to
+ * EEPROM_MAX_TRIALS address probes for every 4-byte page, which stalls
+ * the caller for ~5 ms per page. EepromWriter instead queues each write
+ * and walks it page by page on its own thread and EventQueue:
+ *
+ *   start page DMA -> HAL_I2C_MemTxCpltCallback posts to the queue ->
+ *   one ACK probe every EEPROM_WRITER_POLL_PERIOD -> next page (or next
+ *   queued write)
+ *
+ * Both the start of a page and the ACK probe poll the I2C peripheral
+ * for a few tens of microseconds (address phase, NACK), so neither runs
+ * in interrupt context; the only interrupt work is the post. The writer
+ * thread runs below acquisition and processing, which keep sampling
+ * while a write is under way.
+ *
+ * The thread that queued the write returns immediately and gets an
+ * EepromFuture for the result, and optionally a callback on the writer
+ * thread when the write has landed (EepromDevice::write()).
+ *
+ * Reads go straight to the device, but first wait (sleeping, not spinning)
+ * for queued writes to land, since the EEPROM does not answer during a
+ * write cycle. Reads must therefore come from thread context.
+ *
+ */
+
+#ifndef EEPROM_WRITER_H
+#define EEPROM_WRITER_H
+
+#include <mbed.h>
+#include "eeprom_bsp.h"
+
+// Writes that may be queued at once.
+#define EEPROM_WRITER_DEPTH 4
+
+// Largest single write (one record slot).
+#define EEPROM_WRITER_MAX_LEN 32
+
+// Spacing of the ACK probes while the EEPROM runs its write cycle.
+#define EEPROM_WRITER_POLL_PERIOD 1ms
+
+// Probes before a page is given up on (the M24LR64 needs ~5 ms).
+#define EEPROM_WRITER_POLL_LIMIT 20
+
+// Number of past writes whose outcome is remembered for futures.
+#define EEPROM_WRITER_HISTORY 16
+
+// Writer thread stack and priority (below processing, above the UI).
+#define EEPROM_WRITER_STACK_SIZE 1024
+#define EEPROM_WRITER_PRIORITY osPriorityNormal
+
+class EepromWriter;
+
+// Result of one queued write.
+class EepromFuture {
+public:
+    EepromFuture() {}
+
+    // False if the write was never queued (queue full or bad arguments).
+    bool valid() const { return writer != nullptr; }
+
+    // True once the write has finished, successfully or not.
+    bool ready() const;
+
+    // True if the write finished and every page was acknowledged. Only the
+    // last EEPROM_WRITER_HISTORY writes are remembered; older ones read false.
+    bool ok() const;
+
+    // Sleeps until ready() and returns ok(). Not for ISR context.
+    bool wait() const;
+
+private:
+    friend class EepromWriter;
+    EepromFuture(EepromWriter *writer, uint32_t ticket) : writer(writer), ticket(ticket) {}
+
+    EepromWriter *writer = nullptr;
+    uint32_t ticket = 0;
+};
+
+class EepromWriter : public EepromDevice {
+public:
+    explicit EepromWriter(BspEeprom &device);
+
+    // Starts the writer thread. Call once, before the first write.
+    void start();
+
+    // Queues a write of up to EEPROM_WRITER_MAX_LEN bytes. The data is
+    // copied. done, if given, is called on the writer thread once the
+    // write has finished; it must not read or sync the writer.
+    EepromFuture write_async(uint16_t addr, const uint8_t *buf, uint16_t len,
+                             EepromWriteDone done = nullptr, void *context = nullptr);
+
+    // Future of the most recently queued write.
+    EepromFuture last_write() const { return last; }
+
+    // True while any write is queued or in progress.
+    bool busy() const { return pending != 0; }
+
+    // EepromDevice: write() queues and returns whether the write was
+    // accepted; sync() sleeps until every queued write has finished.
+    bool read(uint16_t addr, uint8_t *buf, uint16_t len) override;
+    bool write(uint16_t addr, const uint8_t *buf, uint16_t len, EepromWriteDone done, void *context) override;
+    void sync() override;
+
+    // Interrupt hook for BSP_EEPROM_WriteCplt_UserCallback(): hands the
+    // completion to the writer thread.
+    void on_transfer_complete();
+
+private:
+    friend class EepromFuture;
+
+    struct Job {
+        uint32_t ticket;
+        uint16_t addr;
+        uint16_t len;
+        EepromWriteDone done;
+        void *context;
+        uint8_t data[EEPROM_WRITER_MAX_LEN];
+    };
+
+    // The rest run on the writer thread.
+
+    // Starts the head job from its first page.
+    void start_job();
+
+    // Starts the page at the current job offset, or finishes the job.
+    void start_page();
+
+    // The page DMA has completed; start probing for the ACK.
+    void transfer_done();
+
+    // The page DMA never completed (e.g. a bus error).
+    void transfer_timeout();
+
+    // One ACK probe.
+    void poll_ack();
+
+    // Marks the head job done and moves on to the next one.
+    void finish_job(bool ok);
+
+    // Status lookup for futures.
+    bool is_done(uint32_t ticket) const;
+    bool is_ok(uint32_t ticket) const;
+
+    BspEeprom &device;
+    Thread worker;
+    EventQueue queue;
+    EventFlags done_flags;
+    int timer_event = 0;                // Pending watchdog or ACK probe.
+
+    Job jobs[EEPROM_WRITER_DEPTH];
+    volatile uint8_t head = 0;          // Job in progress.
+    volatile uint8_t pending = 0;       // Jobs queued, including the one in progress.
+    uint16_t offset = 0;                // Bytes of the head job already written.
+    uint8_t page_len = 0;               // Bytes in the page being written.
+    uint8_t polls = 0;                  // ACK probes for the current page.
+    bool transferring = false;          // Page DMA started but not yet complete.
+
+    uint32_t next_ticket = 1;
+    volatile uint32_t completed = 0;    // Tickets complete up to and including this one.
+
+    // Outcome of recent tickets, indexed by ticket % EEPROM_WRITER_HISTORY.
+    volatile bool results[EEPROM_WRITER_HISTORY];
+
+    EepromFuture last;
+};
+
+#endif // EEPROM_WRITER_H
@@ -0,0 +1,53 @@
+/**
+ * @file event_loop.cpp
+ *
+ * @brief Event-driven main loop for the embedded gyrometer.
+ *
+ */
+
+#include "event_loop.h"
+#include "number_format.h"
+
+using namespace std::chrono_literals;
+
+EventLoop::EventLoop() : queue(EVENT_LOOP_DEPTH * EVENTS_EVENT_SIZE) {
+    // Refresh the instrumentation snapshot once per second.
+    post_every(1s, [this]() { sample_stats(); });
+}
+
+void EventLoop::cancel(int &id) {
+    if (id != 0) {
+        queue.cancel(id);
+        id = 0;
+    }
+}
+
+void EventLoop::run() {
+    queue.dispatch_forever();
+}
+
+void EventLoop::sample_stats() {
+    // Idle time is accumulated by the RTOS idle thread
+    // (requires platform.cpu-stats-enabled in mbed_app.json).
+    mbed_stats_cpu_t cpu;
+    mbed_stats_cpu_get(&cpu);
+
+    uint64_t idle_delta = cpu.idle_time - idle_time_last;
+    uint64_t uptime_delta = cpu.uptime - uptime_last;
+    idle_time_last = cpu.idle_time;
+    uptime_last = cpu.uptime;
+
+    current.wakeups_per_sec = wakeups - wakeups_last;
+    current.wakeups_total = wakeups;
+    current.dropped_total = dropped;
+    current.idle_percent = (uptime_delta != 0) ? (100.0f * idle_delta) / uptime_delta : 0.0f;
+    wakeups_last = wakeups;
+}
+
+void EventLoop::report() const {
+    printf("Loop: %lu wakeups/s, %lu total, %lu dropped, %s%% idle\n",
+           (unsigned long)current.wakeups_per_sec,
+           (unsigned long)current.wakeups_total,
+           (unsigned long)current.dropped_total,
+           FixedText(current.idle_percent, 6).c_str());
+}
@@ -0,0 +1,108 @@
+/**
+ * @file event_loop.h
+ *
+ * @brief Event-driven main loop for the embedded gyrometer.
+ *
+ * Wraps an mbed EventQueue so the thread running it only wakes up to
+ * service its events (button, timer, touch and UI-tick events on the main
+ * thread, session export on the export thread) and sleeps in between.
+ * Every dispatched event is counted so idle CPU load and wake-ups per
+ * second can be reported, and timed as busy time of the thread running
+ * the loop (see thread_monitor.h).
+ *
+ */
+
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <mbed.h>
+#include "thread_monitor.h"
+
+// Maximum number of events that may be pending at any one time.
+#define EVENT_LOOP_DEPTH 32
+
+// Snapshot of the loop instrumentation counters (refreshed once per second).
+struct LoopStats {
+    uint32_t wakeups_per_sec;   // Events dispatched during the last second.
+    uint32_t wakeups_total;     // Events dispatched since boot.
+    uint32_t dropped_total;     // Posts rejected because the queue was full.
+    float idle_percent;         // Share of the last second spent in the idle thread.
+};
+
+class EventLoop {
+public:
+    EventLoop();
+
+    // Queue a handler to run on the loop thread. Safe to call from an ISR.
+    // Returns the event id, or 0 if the queue was full.
+    template <typename F>
+    int post(F f) {
+        return track(queue.call(Counted<F>{this, f}));
+    }
+
+    // Queue a handler to run once after the given delay.
+    template <typename F>
+    int post_in(std::chrono::milliseconds delay, F f) {
+        return track(queue.call_in(delay, Counted<F>{this, f}));
+    }
+
+    // Queue a handler to run periodically until cancelled.
+    template <typename F>
+    int post_every(std::chrono::milliseconds period, F f) {
+        return track(queue.call_every(period, Counted<F>{this, f}));
+    }
+
+    // Cancel a pending or periodic event. Ignores id 0.
+    void cancel(int &id);
+
+    // Dispatch events forever. The thread sleeps whenever the queue is empty.
+    void run();
+
+    // Latest instrumentation snapshot.
+    LoopStats stats() const { return current; }
+
+    // Print the instrumentation snapshot over serial.
+    void report() const;
+
+    // Time spent in handlers, for the ThreadMonitor.
+    const ThreadLoad &load() const { return busy; }
+
+private:
+    // Wraps every handler so the dispatch is counted as a wake-up.
+    template <typename F>
+    struct Counted {
+        EventLoop *loop;
+        F f;
+        void operator()() {
+            BusyScope scope(loop->busy);
+            loop->wakeups++;
+            f();
+        }
+    };
+
+    int track(int id) {
+        if (id == 0) {
+            dropped++;
+        }
+        return id;
+    }
+
+    // Once-per-second refresh of the instrumentation snapshot.
+    void sample_stats();
+
+    EventQueue queue;
+
+    // Only touched from the loop thread.
+    uint32_t wakeups = 0;
+    uint32_t wakeups_last = 0;
+    uint64_t idle_time_last = 0;
+    uint64_t uptime_last = 0;
+    ThreadLoad busy;
+
+    // May be bumped from ISR context when a post fails.
+    volatile uint32_t dropped = 0;
+
+    LoopStats current = {};
+};
+
+#endif // EVENT_LOOP_H
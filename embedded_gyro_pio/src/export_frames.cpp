@@ -0,0 +1,65 @@
+/**
+ * @file export_frames.cpp
+ *
+ * @brief Framed binary export of sessions over the serial port.
+ *
+ */
+
+#include "export_frames.h"
+#include "crc.h"
+#include <string.h>
+
+size_t frame_encode(uint8_t *out, uint8_t type, uint16_t seq, const void *payload, uint8_t len) {
+    out[0] = FRAME_SOF;
+    out[1] = type;
+    out[2] = (uint8_t)(seq & 0xFF);
+    out[3] = (uint8_t)(seq >> 8);
+    out[4] = len;
+    memcpy(&out[FRAME_HEADER_SIZE], payload, len);
+
+    uint16_t crc = crc16(&out[1], FRAME_HEADER_SIZE - 1 + len);
+    out[FRAME_HEADER_SIZE + len] = (uint8_t)(crc & 0xFF);
+    out[FRAME_HEADER_SIZE + len + 1] = (uint8_t)(crc >> 8);
+    return FRAME_HEADER_SIZE + len + FRAME_TRAILER_SIZE;
+}
+
+bool FrameExporter::send(FrameType type, const void *payload, size_t len) {
+    if (len > FRAME_MAX_PAYLOAD) {
+        return false;
+    }
+
+    uint8_t frame[FRAME_MAX_SIZE];
+    size_t size = frame_encode(frame, type, seq, payload, (uint8_t)len);
+
+    // The sequence number advances even for dropped frames, so the gap
+    // shows up on the host.
+    seq++;
+    if (!tx.write(frame, size)) {
+        dropped++;
+        return false;
+    }
+    frames++;
+    return true;
+}
+
+bool FrameExporter::add_sample(uint32_t timestamp_us, const int16_t raw[3]) {
+    ExportSample &s = batch[batch_count++];
+    s.timestamp_us = timestamp_us;
+    s.raw[0] = raw[0];
+    s.raw[1] = raw[1];
+    s.raw[2] = raw[2];
+
+    if (batch_count == FRAME_SAMPLES_PER_FRAME) {
+        return flush_samples();
+    }
+    return true;
+}
+
+bool FrameExporter::flush_samples() {
+    if (batch_count == 0) {
+        return true;
+    }
+    size_t len = batch_count * sizeof(ExportSample);
+    batch_count = 0;
+    return send(FRAME_SAMPLES, batch, len);
+}
@@ -0,0 +1,138 @@
+/**
+ * @file export_frames.h
+ *
+ * @brief Framed binary export of sessions over the serial port.
+ *
+ * Frame layout (multi-byte fields little endian):
+ *
+ *   +------+------+-----+-----+-------------+--------+
+ *   | SOF  | type | seq | len | payload     | CRC16  |
+ *   | 0xA5 | u8   | u16 | u8  | len bytes   | u16    |
+ *   +------+------+-----+-----+-------------+--------+
+ *
+ * The CRC (CRC-16/CCITT-FALSE) covers type through payload. seq grows by
+ * one per frame, so the receiver can count frames lost to a full ring or
+ * to line noise. A receiver that loses sync scans for the next SOF whose
+ * frame checks out. tools/decode_export.py is the matching host decoder.
+ *
+ * FrameExporter writes to a FrameSink: the DMA UART ring (uart_dma_tx.h)
+ * on the board, any byte buffer in the native tests.
+ *
+ */
+
+#ifndef EXPORT_FRAMES_H
+#define EXPORT_FRAMES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "drop_detector.h"
+
+#define FRAME_SOF 0xA5
+
+// Header (SOF, type, seq, len) and trailer (CRC) sizes.
+#define FRAME_HEADER_SIZE  5
+#define FRAME_TRAILER_SIZE 2
+
+#define FRAME_MAX_PAYLOAD 240
+#define FRAME_MAX_SIZE (FRAME_HEADER_SIZE + FRAME_MAX_PAYLOAD + FRAME_TRAILER_SIZE)
+
+enum FrameType : uint8_t {
+    FRAME_SESSION_START = 1,    // SessionStartFrame
+    FRAME_SAMPLES       = 2,    // Up to FRAME_SAMPLES_PER_FRAME ExportSample
+    FRAME_SESSION_END   = 3,    // SessionSummary (see record_store.h)
+    FRAME_DIAGNOSTICS   = 4,    // DiagnosticsFrame, sent just before FRAME_SESSION_END
+    FRAME_WINDOW        = 5,    // WindowFrame, live export only
+};
+
+struct __attribute__((packed)) SessionStartFrame {
+    uint32_t odr_hz;            // Configured output data rate.
+    float scale;                // Raw LSB to rad/s.
+    uint8_t live;               // 1: streamed while recording, 0: replayed afterwards.
+    uint8_t filtered;           // 1: samples are after the gait low-pass.
+};
+
+struct __attribute__((packed)) ExportSample {
+    uint32_t timestamp_us;      // Since the start of the recording.
+    int16_t raw[3];             // X, Y, Z.
+};
+
+// Sample loss accounting of a session (see drop_detector.h).
+struct __attribute__((packed)) DiagnosticsFrame {
+    uint32_t samples;                   // Samples read.
+    uint32_t lost;                      // Estimated samples lost, all causes.
+    uint32_t max_latency_us;            // Longest data-ready to read-complete time.
+    uint32_t counts[DROP_CAUSE_COUNT];  // Events per DropCause.
+    uint8_t events;                     // Valid entries in log.
+    DropEvent log[DROP_LOG_SIZE];       // Latest events, oldest first.
+};
+
+// Aggregates of one summary window (see window_aggregator.h), per axis
+// X, Y, Z, in raw LSB; the integrals in LSB * s.
+struct __attribute__((packed)) WindowFrame {
+    uint32_t first_us;          // Time-stamps of the first and last sample.
+    uint32_t last_us;
+    uint16_t count;             // Samples in the window.
+    float mean[3];
+    float rms[3];
+    int16_t min[3];
+    int16_t max[3];
+    float integral[3];          // Of the rate: net angle.
+    float swept[3];             // Of |rate|: angle swept.
+};
+
+static_assert(sizeof(DropEvent) == 8, "DropEvent is exported as is");
+static_assert(sizeof(DiagnosticsFrame) <= FRAME_MAX_PAYLOAD, "diagnostics must fit one frame");
+static_assert(sizeof(WindowFrame) <= FRAME_MAX_PAYLOAD, "a window must fit one frame");
+
+#define FRAME_SAMPLES_PER_FRAME (FRAME_MAX_PAYLOAD / sizeof(ExportSample))
+
+// Where encoded frames are queued.
+class FrameSink {
+public:
+    virtual ~FrameSink() {}
+
+    // Queues len bytes. All or nothing: returns false if they do not fit.
+    virtual bool write(const uint8_t *data, size_t len) = 0;
+
+    // Bytes that can be queued now.
+    virtual size_t space() const = 0;
+};
+
+// Encodes one frame into out (at least FRAME_MAX_SIZE bytes). Returns its size.
+size_t frame_encode(uint8_t *out, uint8_t type, uint16_t seq, const void *payload, uint8_t len);
+
+class FrameExporter {
+public:
+    explicit FrameExporter(FrameSink &tx) : tx(tx) {}
+
+    // Frames one payload and queues it. Returns false if the ring was full.
+    bool send(FrameType type, const void *payload, size_t len);
+
+    // Adds one sample to the pending FRAME_SAMPLES batch and sends the
+    // batch once it is full.
+    bool add_sample(uint32_t timestamp_us, const int16_t raw[3]);
+
+    // Sends a partially filled sample batch.
+    bool flush_samples();
+
+    // Ring space needed to send a full sample batch.
+    static constexpr size_t batch_frame_size() {
+        return FRAME_HEADER_SIZE + FRAME_SAMPLES_PER_FRAME * sizeof(ExportSample) + FRAME_TRAILER_SIZE;
+    }
+
+    bool has_room_for_batch() const { return tx.space() >= batch_frame_size(); }
+
+    uint32_t frames_sent() const { return frames; }
+    uint32_t frames_dropped() const { return dropped; }
+
+private:
+    FrameSink &tx;
+    uint16_t seq = 0;
+    uint32_t frames = 0;
+    uint32_t dropped = 0;
+
+    ExportSample batch[FRAME_SAMPLES_PER_FRAME];
+    size_t batch_count = 0;
+};
+
+#endif // EXPORT_FRAMES_H
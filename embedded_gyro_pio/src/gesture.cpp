@@ -0,0 +1,61 @@
+/**
+ * @file gesture.cpp
+ *
+ * @brief Turns touch-screen contacts into tap, long-press and swipe events.
+ *
+ */
+
+#include "gesture.h"
+#include <stdlib.h>
+
+GestureEvent GestureDetector::sample(int16_t x, int16_t y, uint32_t time_ms) {
+    if (samples == 0) {
+        start_x = x;
+        start_y = y;
+        start_ms = time_ms;
+        moved = false;
+        long_pressed = false;
+    }
+    if (samples < UINT16_MAX) {
+        samples++;
+    }
+    last_x = x;
+    last_y = y;
+
+    if (abs(x - start_x) > GESTURE_MOVE_SLOP || abs(y - start_y) > GESTURE_MOVE_SLOP) {
+        moved = true;
+    }
+    return poll(time_ms);
+}
+
+GestureEvent GestureDetector::poll(uint32_t time_ms) {
+    if (samples >= GESTURE_MIN_SAMPLES && !moved && !long_pressed &&
+        time_ms - start_ms >= GESTURE_LONG_PRESS_MS) {
+        long_pressed = true;
+        return event(Gesture::LongPress);
+    }
+    return event(Gesture::None);
+}
+
+GestureEvent GestureDetector::release(uint32_t time_ms) {
+    uint16_t count = samples;
+    samples = 0;
+
+    if (count < GESTURE_MIN_SAMPLES || long_pressed) {
+        return event(Gesture::None);
+    }
+
+    int dx = last_x - start_x;
+    int dy = last_y - start_y;
+    if (abs(dx) >= GESTURE_SWIPE_MIN || abs(dy) >= GESTURE_SWIPE_MIN) {
+        if (abs(dx) >= abs(dy)) {
+            return event(dx > 0 ? Gesture::SwipeRight : Gesture::SwipeLeft);
+        }
+        return event(dy > 0 ? Gesture::SwipeDown : Gesture::SwipeUp);
+    }
+
+    if (!moved && time_ms - start_ms <= GESTURE_TAP_MAX_MS) {
+        return event(Gesture::Tap);
+    }
+    return event(Gesture::None);
+}
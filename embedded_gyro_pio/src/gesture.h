@@ -0,0 +1,76 @@
+/**
+ * @file gesture.h
+ *
+ * @brief Turns touch-screen contacts into tap, long-press and swipe events.
+ *
+ * Fed with the screen position of every touch sample and the time the
+ * contact is lifted. A contact only counts once it has produced
+ * GESTURE_MIN_SAMPLES samples, which drops the single stray samples a
+ * resistive panel gives on a light brush or a bounce.
+ *
+ */
+
+#ifndef GESTURE_H
+#define GESTURE_H
+
+#include <stdint.h>
+
+// Samples a contact needs before it counts (debounce).
+#define GESTURE_MIN_SAMPLES 2
+
+// Longest contact that still counts as a tap (ms).
+#define GESTURE_TAP_MAX_MS 400
+
+// Hold time that turns a stationary contact into a long press (ms).
+#define GESTURE_LONG_PRESS_MS 700
+
+// Travel (px) a contact may wander and still count as stationary.
+#define GESTURE_MOVE_SLOP 12
+
+// Travel (px) along the dominant axis that makes a swipe.
+#define GESTURE_SWIPE_MIN 40
+
+enum class Gesture : uint8_t {
+    None,
+    Tap,
+    LongPress,
+    SwipeLeft,
+    SwipeRight,
+    SwipeUp,
+    SwipeDown
+};
+
+struct GestureEvent {
+    Gesture gesture;
+    int16_t x, y;           // Where the contact started (px).
+};
+
+class GestureDetector {
+public:
+    // Adds one sample of the current contact. May report a long press.
+    GestureEvent sample(int16_t x, int16_t y, uint32_t time_ms);
+
+    // Checks a held contact for a long press when no samples arrive.
+    GestureEvent poll(uint32_t time_ms);
+
+    // The contact was lifted. Reports a tap or swipe, if it was one.
+    GestureEvent release(uint32_t time_ms);
+
+    // True while a contact is in progress.
+    bool active() const { return samples > 0; }
+
+private:
+    GestureEvent event(Gesture gesture) const {
+        GestureEvent e = {gesture, start_x, start_y};
+        return e;
+    }
+
+    uint16_t samples = 0;
+    int16_t start_x = 0, start_y = 0;
+    int16_t last_x = 0, last_y = 0;
+    uint32_t start_ms = 0;
+    bool moved = false;         // Wandered beyond GESTURE_MOVE_SLOP at some point.
+    bool long_pressed = false;  // Already reported as a long press.
+};
+
+#endif // GESTURE_H
@@ -0,0 +1,28 @@
+/**
+ * @file gyro_config.cpp
+ *
+ * @brief L3GD20 configuration as one value instead of hand-built registers.
+ *
+ */
+
+#include "gyro_config.h"
+
+void gyro_config_write(const GyroRegisters &r, bool write_reference) {
+    const L3GD20_StateTypeDef *state = L3GD20_GetState();
+
+    if (write_reference) {
+        uint8_t reference = r.reference;
+        GYRO_IO_Write(&reference, L3GD20_REFERENCE_REG_ADDR, 1);
+    }
+    for (int i = 1; i < 5; i++) {
+        if (state->CtrlReg[i] != r.ctrl[i]) {
+            L3GD20_WriteReg(L3GD20_CTRL_REG1_ADDR + i, r.ctrl[i]);
+        }
+    }
+    if (state->FifoCtrl != r.fifo_ctrl) {
+        L3GD20_WriteReg(L3GD20_FIFO_CTRL_REG_ADDR, r.fifo_ctrl);
+    }
+    if (state->CtrlReg[0] != r.ctrl[0]) {
+        L3GD20_WriteReg(L3GD20_CTRL_REG1_ADDR, r.ctrl[0]);
+    }
+}
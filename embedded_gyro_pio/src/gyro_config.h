@@ -0,0 +1,165 @@
+/**
+ * @file gyro_config.h
+ *
+ * @brief L3GD20 configuration as one value instead of hand-built registers.
+ *
+ * A GyroConfig describes the data rate, bandwidth, full scale, on-chip
+ * high-pass filter, FIFO and interrupt routing. gyro_config_registers()
+ * turns it into the CTRL_REG1..5 / FIFO_CTRL / REFERENCE values. It is
+ * constexpr, so a configuration known at compile time becomes a constant
+ * register image (and the programming can still be checked off target).
+ * gyro_config_write() writes whatever differs from the driver's register
+ * copy.
+ *
+ * The high-pass filter takes the DC bias out of the output data inside
+ * the sensor, at no CPU cost. Its cutoff is given in Hz and mapped to the
+ * nearest HPCF setting for the selected data rate, so switching data rate
+ * keeps the cutoff.
+ *
+ */
+
+#ifndef GYRO_CONFIG_H
+#define GYRO_CONFIG_H
+
+#include <stdint.h>
+#include "drivers/l3gd20.h"
+
+// Output data rate (CTRL_REG1 DR[1:0]).
+enum GyroOdr : uint8_t {
+    GYRO_ODR_95  = 0,
+    GYRO_ODR_190 = 1,
+    GYRO_ODR_380 = 2,
+    GYRO_ODR_760 = 3
+};
+
+// Full scale (CTRL_REG4 FS[1:0]).
+enum GyroFullScale : uint8_t {
+    GYRO_FS_250DPS  = 0,
+    GYRO_FS_500DPS  = 1,
+    GYRO_FS_2000DPS = 2
+};
+
+// On-chip high-pass filter (CTRL_REG2 HPM[1:0], CTRL_REG5 HPen/Out_Sel).
+enum GyroHpfMode : uint8_t {
+    GYRO_HPF_OFF,           // Output data straight from the low-pass filter.
+    GYRO_HPF_NORMAL,        // Continuous high-pass filtering.
+    GYRO_HPF_REFERENCE,     // Output is the rate minus hpf_reference.
+    GYRO_HPF_AUTORESET      // Filter reset on each INT1 event.
+};
+
+struct GyroConfig {
+    GyroOdr odr;
+    uint8_t bandwidth;      // BW[1:0], low-pass cutoff step for the data rate (0..3).
+    GyroFullScale full_scale;
+    GyroHpfMode hpf_mode;
+    float hpf_cutoff_hz;    // Nearest available cutoff for odr is used.
+    int8_t hpf_reference;   // REFERENCE value for GYRO_HPF_REFERENCE.
+    uint8_t fifo_mode;      // L3GD20_FIFO_MODE_x (bypass turns the FIFO off).
+    uint8_t fifo_watermark; // 0..31.
+    bool drdy_int2;         // Data-ready on INT2.
+    bool int1_enable;       // Threshold interrupt on INT1.
+};
+
+// Register image of a configuration.
+struct GyroRegisters {
+    uint8_t ctrl[5];        // CTRL_REG1..CTRL_REG5.
+    uint8_t fifo_ctrl;
+    uint8_t reference;
+};
+
+// Output data rate in Hz.
+constexpr uint32_t gyro_odr_hz(GyroOdr odr) {
+    return 95u << odr;
+}
+
+// Raw LSB to rad/s for a full scale setting.
+constexpr float gyro_scale_rad_s(GyroFullScale fs) {
+    return (fs == GYRO_FS_250DPS ? 8.75f : fs == GYRO_FS_500DPS ? 17.5f : 70.0f) *
+           0.017453292519943295769236907684886f / 1000.0f;
+}
+
+// CTRL_REG1 bits below DR/BW: normal mode, X/Y/Z enabled.
+#define GYRO_CTRL1_ACTIVE (L3GD20_MODE_ACTIVE | L3GD20_AXES_ENABLE)
+
+// CTRL_REG3 data-ready on INT2.
+#define GYRO_CTRL3_I2_DRDY 0x08
+
+// CTRL_REG5 Out_Sel: data after the high-pass filter.
+#define GYRO_CTRL5_OUT_SEL_HPF 0x01
+
+// Number of HPCF settings.
+#define GYRO_HPCF_COUNT 10
+
+// HPCF cutoffs (Hz) at 760 Hz. Each halving of the data rate shifts the
+// table by one step, so rate r reads it from index 3 - r on.
+constexpr float GYRO_HPF_CUTOFFS[] = {
+    51.4f, 27.0f, 13.5f, 7.2f, 3.5f, 1.8f, 0.9f, 0.45f, 0.18f, 0.09f, 0.045f, 0.018f, 0.009f
+};
+
+// High-pass cutoff (Hz) of HPCF setting hpcf (0..9) at the given data rate.
+constexpr float gyro_hpf_cutoff_hz(GyroOdr odr, uint8_t hpcf) {
+    return GYRO_HPF_CUTOFFS[(hpcf < GYRO_HPCF_COUNT ? hpcf : GYRO_HPCF_COUNT - 1) + (GYRO_ODR_760 - odr)];
+}
+
+// HPCF setting whose cutoff is closest (by ratio) to cutoff_hz.
+constexpr uint8_t gyro_hpf_select(GyroOdr odr, float cutoff_hz) {
+    // max(r, 1/r) orders candidates like |log r| does, without logf.
+    uint8_t best = 0;
+    float best_error = 0.0f;
+    for (uint8_t hpcf = 0; hpcf < GYRO_HPCF_COUNT; hpcf++) {
+        float ratio = gyro_hpf_cutoff_hz(odr, hpcf) / cutoff_hz;
+        float error = (ratio >= 1.0f) ? ratio : 1.0f / ratio;
+        if (hpcf == 0 || error < best_error) {
+            best_error = error;
+            best = hpcf;
+        }
+    }
+    return best;
+}
+
+// Register values for cfg.
+constexpr GyroRegisters gyro_config_registers(const GyroConfig &cfg) {
+    GyroRegisters r = {};
+
+    r.ctrl[0] = (uint8_t)((cfg.odr << 6) | ((cfg.bandwidth & 0x03) << 4) | GYRO_CTRL1_ACTIVE);
+
+    if (cfg.hpf_mode != GYRO_HPF_OFF) {
+        uint8_t hpm = (cfg.hpf_mode == GYRO_HPF_NORMAL)    ? L3GD20_HPM_NORMAL_MODE :
+                      (cfg.hpf_mode == GYRO_HPF_REFERENCE) ? L3GD20_HPM_REF_SIGNAL :
+                                                             L3GD20_HPM_AUTORESET_INT;
+        r.ctrl[1] = (uint8_t)(hpm | gyro_hpf_select(cfg.odr, cfg.hpf_cutoff_hz));
+        r.ctrl[4] |= L3GD20_HIGHPASSFILTER_ENABLE | GYRO_CTRL5_OUT_SEL_HPF;
+        if (cfg.hpf_mode == GYRO_HPF_REFERENCE) {
+            r.reference = (uint8_t)cfg.hpf_reference;
+        }
+    }
+
+    if (cfg.int1_enable) {
+        r.ctrl[2] |= L3GD20_INT1INTERRUPT_ENABLE;
+    }
+    if (cfg.drdy_int2) {
+        r.ctrl[2] |= GYRO_CTRL3_I2_DRDY;
+    }
+
+    // Little endian, continuous update.
+    r.ctrl[3] = (uint8_t)(cfg.full_scale << 4);
+
+    r.fifo_ctrl = (uint8_t)(cfg.fifo_mode | (cfg.fifo_watermark & L3GD20_FIFO_SRC_FSS));
+    if (cfg.fifo_mode != L3GD20_FIFO_MODE_BYPASS) {
+        r.ctrl[4] |= L3GD20_FIFO_ENABLE;
+    }
+
+    return r;
+}
+
+// Programs the sensor with a register image, writing only the registers
+// that change. REFERENCE is written when write_reference is set.
+// CTRL_REG1 goes last so the new data rate starts with everything else set.
+void gyro_config_write(const GyroRegisters &r, bool write_reference);
+
+// Programs the sensor with cfg (see gyro_config_write()).
+inline void gyro_config_apply(const GyroConfig &cfg) {
+    gyro_config_write(gyro_config_registers(cfg), cfg.hpf_mode == GYRO_HPF_REFERENCE);
+}
+
+#endif // GYRO_CONFIG_H
@@ -0,0 +1,56 @@
+/**
+ * @file gyro_spi_bus.cpp
+ *
+ * @brief TunableBus for the L3GD20 link on the shared SPI5 bus.
+ *
+ */
+
+#include "gyro_spi_bus.h"
+#include "cycle_counter.h"
+#include "drivers/l3gd20.h"
+#include <mbed.h>
+#include <string.h>
+
+bool GyroSpiBus::set_clock_div(uint16_t div) {
+    return GYRO_IO_SetClockDiv(div) == 0;
+}
+
+bool GyroSpiBus::self_test(uint32_t round) {
+    uint8_t id;
+    GYRO_IO_Read(&id, L3GD20_WHO_AM_I_ADDR, 1);
+    if (id != expected_id) {
+        return false;
+    }
+
+    // Alternating and solid bit patterns, shifted per round so every
+    // register sees each of them. Bit 7 of the *H registers reads as 0.
+    static const uint8_t base[4] = {0x55, 0xAA, 0x00, 0xFF};
+    uint8_t pattern[6];
+    for (int i = 0; i < 6; i++) {
+        uint8_t b = base[(round + i) % 4] ^ (uint8_t)(round >> 2);
+        pattern[i] = (i & 1) ? b : (uint8_t)(b & 0x7F);
+    }
+
+    uint8_t back[6];
+    GYRO_IO_Write(pattern, L3GD20_INT1_TSH_XH_ADDR, sizeof(pattern));
+    GYRO_IO_Read(back, L3GD20_INT1_TSH_XH_ADDR, sizeof(back));
+    bool ok = memcmp(pattern, back, sizeof(back)) == 0;
+
+    memset(pattern, 0, sizeof(pattern));
+    GYRO_IO_Write(pattern, L3GD20_INT1_TSH_XH_ADDR, sizeof(pattern));
+    return ok;
+}
+
+uint32_t GyroSpiBus::clock_hz(uint16_t div) {
+    return div ? HAL_RCC_GetPCLK2Freq() / div : 0;
+}
+
+float GyroSpiBus::sample_read_us(int reads) {
+    uint8_t block[6];
+    uint32_t start = cycle_counter_read();
+    for (int i = 0; i < reads; i++) {
+        GYRO_IO_Read(block, L3GD20_OUT_X_L_ADDR, sizeof(block));
+    }
+    uint32_t cycles = cycle_counter_read() - start;
+    return (float)cycles / (float)reads / (float)(SystemCoreClock / 1000000);
+}
@@ -0,0 +1,36 @@
+/**
+ * @file gyro_spi_bus.h
+ *
+ * @brief TunableBus for the L3GD20 link on the shared SPI5 bus.
+ *
+ * A self-test round reads WHO_AM_I and writes a pattern to the six INT1
+ * threshold registers, then reads it back in one auto-increment burst,
+ * so both directions and multi-byte transfers are exercised. The
+ * registers are left cleared: tune before configuring INT1.
+ *
+ */
+
+#ifndef GYRO_SPI_BUS_H
+#define GYRO_SPI_BUS_H
+
+#include "spi_tune.h"
+
+class GyroSpiBus : public TunableBus {
+public:
+    // expected_id: WHO_AM_I value read at a known-safe clock.
+    explicit GyroSpiBus(uint8_t expected_id) : expected_id(expected_id) {}
+
+    bool set_clock_div(uint16_t div) override;
+    bool self_test(uint32_t round) override;
+
+    // SPI clock (Hz) for divider div.
+    static uint32_t clock_hz(uint16_t div);
+
+    // Average time (us) one blocking X/Y/Z sample read takes on the bus.
+    static float sample_read_us(int reads = 64);
+
+private:
+    uint8_t expected_id;
+};
+
+#endif // GYRO_SPI_BUS_H
@@ -10,7 +10,33 @@
 
 #include <mbed.h>                       // MBED Library.
 #include "drivers/LCD_DISCO_F429ZI.h"   // LCD Library.
+#include "drivers/l3gd20.h"             // Gyroscope driver (BSP SPI link).
 #include <float.h>
+#include "event_loop.h"              // Event-driven main loop.
+#include "orientation.h"             // Quaternion orientation integration.
+#include "cycle_counter.h"           // Cycle-count instrumentation.
+#include "eeprom_bsp.h"              // I2C EEPROM (BSP driver).
+#include "eeprom_writer.h"           // Background EEPROM writes.
+#include "record_store.h"            // Persistent session records.
+#include "session_history.h"          // Past sessions and their totals.
+#include "export_frames.h"           // Binary session export.
+#include "uart_dma_tx.h"             // DMA UART the export goes out on.
+#include "gyro_spi_bus.h"            // Gyroscope SPI clock tuning.
+#include "gyro_config.h"             // Gyroscope register configuration.
+#include "sensor_pipeline.h"         // Compile-time sample processing chain.
+#include "digital_filter.h"           // Gyroscope low-pass filters.
+#include "stride_model.h"             // Stride detection and length model.
+#include "touch_input.h"             // Touch-screen gestures.
+#include "spsc_queue.h"              // Lock-free inter-thread queues.
+#include "thread_monitor.h"          // Per-thread stack and CPU reports.
+#include "drop_detector.h"           // Sample loss accounting.
+#include "sample_buffer.h"            // Recording buffer and views.
+#include "sample_kernels.h"           // Computations over recorded samples.
+#include "window_aggregator.h"        // Windowed aggregates of the samples.
+#include "spectrum.h"                 // Spectrum of the gait signal.
+#include "screen_assets.h"            // Pre-rendered static screens.
+#include "number_format.h"            // Float to text, printf has no %f.
+#include "numeric_display.h"          // Digit atlas readouts.
 
 /* START: LCD Configuration */
 
@@ -23,6 +49,42 @@ LCD_DISCO_F429ZI lcd;
 // Buffer for holding displayed text strings.
 char display_buf[22][60];
 
+// SDRAM past the two layers and the BSP's bitmap conversion buffer, to
+// the end of the device: the cache of pre-rendered static screens.
+#define SCREEN_ASSET_BASE (LCD_FRAME_BUFFER + 0x300000)
+#define SCREEN_ASSET_SIZE (0x800000 - 0x300000)
+
+ScreenAssets assets(lcd, SCREEN_ASSET_BASE, SCREEN_ASSET_SIZE);
+
+// Foreground layer assets, rendered at boot (render_screen_assets()).
+// One not rendered is drawn the slow way instead.
+ScreenAsset title_screen;           // Cleared screen with the title and revision.
+ScreenAsset countdown_asset[4];     // LINE(5): "GO!", "1..", "2..", "3..".
+ScreenAsset idle_prompt;            // LINE(5) to LINE(7): how to start.
+ScreenAsset processing_label;       // LINE(5): "Processing..".
+
+// Digits in the LCD font, and big seven-segment ones.
+DigitAtlas small_digits;
+DigitAtlas big_digits;
+#define BIG_DIGIT_WIDTH 26
+#define BIG_DIGIT_HEIGHT 44
+#define BIG_DIGIT_THICKNESS 5
+
+// Live readings: RATE_CELLS cells on LINE(5) to LINE(7), left of a unit
+// of up to five characters and a space.
+#define RATE_CELLS 8
+#define RATE_DECIMALS 5
+#define RATE_X (lcd.GetXSize() - (RATE_CELLS + 6) * Font16.Width)
+NumericReadout rate_readout[3] = {
+    NumericReadout(assets, small_digits, FOREGROUND, RATE_X, LINE(5), RATE_CELLS),
+    NumericReadout(assets, small_digits, FOREGROUND, RATE_X, LINE(6), RATE_CELLS),
+    NumericReadout(assets, small_digits, FOREGROUND, RATE_X, LINE(7), RATE_CELLS),
+};
+
+// Distance on the result screen, in big digits from LINE(6).
+#define DISTANCE_CELLS 7
+NumericReadout distance_readout(assets, big_digits, FOREGROUND, GRAPH_PADDING, LINE(6), DISTANCE_CELLS);
+
 // Sets the background layer 
 // to be visible, transparent, and
 // resets its colors to all black.
@@ -48,11 +110,9 @@ void setup_foreground_layer(){
 
 /* START: Gyroscope Register Addresses */
 
-// Control Registers
-#define CTRL_REG1 0x20
-#define CTRL_REG2 0x21
-#define CTRL_REG3 0x22
-#define CTRL_REG4 0x23
+// Status register, directly followed by the output registers, so one
+// burst from here returns the overrun flags along with the sample.
+#define STATUS_REG 0x27
 
 // Output Registers
 // (Only start of output registers shown,
@@ -63,45 +123,73 @@ void setup_foreground_layer(){
 /* END: Gyroscope Register Addresses */
 
 
-/* START: Gyroscope Control Register Configurations */
-
-// CTRL_REG1
-// +-----+-----+-----+-----+----+-----+-----+-----+
-// | DR1 | DR0 | BW1 | BW0 | PD | Zen | Yen | Xen |
-// +-----+-----+-----+-----+----+-----+-----+-----+
-// | 0   | 1   | 1   | 0   | 1  | 1   | 1   | 1   |
-// +-----+-----+-----+-----+----+-----+-----+-----+
-// Sets output data rate (ODR) = 200 Hz, Cutoff = 50.
-// Gyroscope set to normal operating mode (power down mode disabled).
-// All axes enabled.
-#define CTRL_REG1_CONFIG 0b01'10'1'1'1'1
-
-// CTRL_REG3
-// +---------+---------+-----------+-------+---------+--------+---------+----------+
-// | I1_Int1 | I1_Boot | H_Lactive | PP_OD | I2_DRDY | I2_WTM | I2_ORun | I2_Empty |
-// +---------+---------+-----------+-------+---------+--------+---------+----------+
-// | 0       | 0       | 0         | 0     | 1       | 0      | 0       | 0        |
-// +---------+---------+-----------+-------+---------+--------+---------+----------+
-// Enable interrupt 2 to assert when data is ready.
-#define CTRL_REG3_CONFIG 0b0'0'0'0'1'000
-
-// CTRL_REG4
-// +---+-----+-----+-----+---+-----+-----+-----+
-// | 0 | BLE | FS1 | FS0 | - | ST1 | ST0 | SIM |
-// +---+-----+-----+-----+---+-----+-----+-----+
-// | 0 | 0   | 0   | 1   | 0 | 0   | 0   | 0   |
-// +---+-----+-----+-----+---+-----+-----+-----+
-// Little endian mode. LSB @ lower address.
-// Set full scale selection to 500 dps.
-#define CTRL_REG4_CONFIG 0b0'0'01'0'00'0
-
-/* END: Gyroscope Control Register Configurations */
-
-// Button pressed flag.
-volatile bool button_pressed = false;
-
-// Helper flag for countdown sequence text.
-volatile bool countdown = false;
+/* START: Gyroscope Configuration */
+
+// Acquisition setup, turned into CTRL_REG1..5 by gyro_config_registers().
+//  - 190 Hz output data rate, low-pass cutoff 50 Hz (BW = 2).
+//  - 500 dps full scale, little endian.
+//  - On-chip high-pass filter at ~0.1 Hz: removes the zero-rate bias
+//    before integration while leaving the ~1 Hz gait untouched.
+//  - Data-ready on INT2, FIFO bypassed.
+struct AcquisitionSensor {
+    static constexpr GyroConfig config() {
+        return GyroConfig{
+            GYRO_ODR_190, 2, GYRO_FS_500DPS,
+            GYRO_HPF_NORMAL, 0.1f, 0,
+            L3GD20_FIFO_MODE_BYPASS, 0,
+            true, false
+        };
+    }
+};
+
+// Waiting for motion (see MOTION_TRIGGER): lowest data rate (95 Hz,
+// cutoff 12.5 Hz), FIFO streaming the latest samples, INT1 threshold
+// interrupt on and data-ready off. All axes stay enabled, the INT1
+// threshold logic needs them.
+struct ArmedSensor {
+    static constexpr GyroConfig config() {
+        return GyroConfig{
+            GYRO_ODR_95, 0, AcquisitionSensor::config().full_scale,
+            AcquisitionSensor::config().hpf_mode, AcquisitionSensor::config().hpf_cutoff_hz, 0,
+            L3GD20_FIFO_MODE_STREAM, 0,
+            false, true
+        };
+    }
+};
+
+// Register images, rates and scale factors of both setups, all computed
+// at compile time.
+typedef SensorTraits<AcquisitionSensor> Acquisition;
+typedef SensorTraits<ArmedSensor> Armed;
+
+/* END: Gyroscope Configuration */
+
+/* START: Application State */
+
+// Operating states of the gyrometer. Every transition happens on the
+// event loop thread; ISRs only read the current state.
+enum class AppState {
+    Idle,           // Startup text shown, waiting for a button press.
+    Countdown,      // "3.. 2.. 1.. GO!" sequence.
+    Recording,      // Capturing gyroscope samples on data-ready events.
+    Processing,     // Integrating the recorded samples.
+    Result,         // Showing the total distance traveled.
+    Calibrating,    // Collecting touch-screen calibration targets.
+    Diagnostics     // Showing the sample loss counters.
+};
+
+volatile AppState state = AppState::Idle;
+
+// Event loop driving the whole application. The main thread sleeps
+// inside it whenever no event is pending.
+EventLoop loop;
+
+// Ids of pending timer events so they can be cancelled on a state change.
+int ui_tick_id = 0;
+int record_end_id = 0;
+int result_timeout_id = 0;
+
+/* END: Application State */
 
 // EventFlags object construction.
 EventFlags flags;
@@ -112,62 +200,416 @@ DigitalOut led1(LED1);
 // Global constructor for timer.
 Timer t;
 
-// Statically allocated location in memory for recorded z gyroscope values. 
-// In my testing, the max recorded values for my capture settings was around 150 values;
-// however, I've allocated extra just in case. 
-volatile int16_t recorded_gyro_values_z[300];
+// The gyroscope sits on SPI5 (PF_7/PF_8/PF_9, CS on PC_1), which the BSP
+// already drives for the LCD. Register access goes through the BSP
+// GYRO_IO link, sample reads through its DMA block transfers.
+
+// PA_2 --> Gyroscope INT2 Pin
+InterruptIn int2(PA_2, PullDown);
 
-// Provides a track of the outer bound of recorded_gyro_values within a given 0.5s interval.
-// Again, statically allocated to a little bit above the 40 values. 
-volatile int value_index_track[45];
+// PA_1 --> Gyroscope INT1 Pin (motion trigger)
+InterruptIn int1(PA_1, PullDown);
 
-// Keeps track of how many values have been captured.
-// Also, provides an index for the values in the preceding array. 
-volatile int value_index = 0;
+// PA_0 --> User (blue) button
+InterruptIn int_button(PA_0);
 
-// Helper iterator for populating value_index_track array.
-volatile int vit_count = 0;
+// Receives STATUS_REG and the X/Y/Z output registers from the DMA read.
+uint8_t gyro_block[7];
 
-// Helper iterator for interval.
-volatile float curr_interval = 0.5;
+// Outcome of the last DMA read (0: ok).
+volatile uint8_t gyro_read_status = 0;
+
+// Gyroscope SPI clock dividers (PCLK2 = 90 MHz) tried at start-up, slowest
+// first: 2.8, 5.6 and 11.25 MHz. The L3GD20 is rated for 10 MHz, so the
+// last step is only kept if the self-test passes on this board.
+const uint16_t GYRO_SPI_DIVS[] = {32, 16, 8};
+
+// Time (seconds) to record values for.
+constexpr int RECORD_TIME = 20;
+
+// Output data rate while recording (Hz).
+constexpr int GYRO_ODR = (int)Acquisition::odr_hz();
+
+// Output data rate while armed for motion, and the resulting sample
+// spacing of the pre-trigger samples.
+constexpr uint32_t ARMED_ODR = Armed::odr_hz();
+constexpr uint32_t ARMED_SAMPLE_US = Armed::period_us();
+
+// Capacity of the sample buffer. Every data-ready event is captured now,
+// so size it for the full recording plus some margin.
+constexpr int MAX_SAMPLES = RECORD_TIME * GYRO_ODR + GYRO_ODR;
+
+// Axis indices into the recorded sample rows.
+#define AXIS_X 0
+#define AXIS_Y 1
+#define AXIS_Z 2
+
+// Statically allocated recorded X, Y and Z gyroscope values, each with its
+// data-ready time-stamp (microseconds since recording started). Filled by
+// the processing thread, read by everyone else through views.
+SampleBuffer<MAX_SAMPLES> recording;
+
+// Windows the recording is summarized over (see window_aggregator.h):
+// 0.5 s back to back. For 2 s windows every 0.5 s use
+// {WindowBasis::Time, 2000000, 500000}; for 100-sample windows,
+// {WindowBasis::Samples, 100, 100}.
+constexpr WindowConfig SUMMARY_WINDOW = {WindowBasis::Time, 500000, 500000};
+
+// Longest window the aggregator can slide, in hops.
+#define WINDOW_MAX_HOPS 8
+
+static_assert(SUMMARY_WINDOW.hop > 0 && SUMMARY_WINDOW.length % SUMMARY_WINDOW.hop == 0 &&
+              SUMMARY_WINDOW.length / SUMMARY_WINDOW.hop <= WINDOW_MAX_HOPS, "bad SUMMARY_WINDOW");
 
 // Keeps a global log of previously run total distance measure.
 volatile float total_distance_traveled = 0.0;
 
-// Time (seconds) to record values for.
-#define RECORD_TIME 20
+// Length of the last recording (seconds).
+float record_duration_s = 0.0;
+
+// Latest raw reading and orientation, published by the processing
+// thread for the UI tick.
+struct LiveSnapshot {
+    int16_t raw[3];
+    Quaternion q;
+};
+
+LiveSnapshot live_snapshot = {};
 
 // SPI flag. Used for SPI transfers.
 #define SPI_FLAG 1
 
-// Data ready flag. Used for gyroscope data ready interrupt.
-#define DATA_RDY_FLAG 2
-
 // Scaling factor (Convert to radians per second)
-#define SCALING_FACTOR (17.5f * 0.017453292519943295769236907684886f / 1000.0f)
+constexpr float SCALING_FACTOR = Acquisition::scale();
+
+// Windows kept per recording: one per hop, plus margin.
+constexpr int MAX_WINDOWS = (SUMMARY_WINDOW.basis == WindowBasis::Time)
+                                ? (int)(RECORD_TIME * 1000000ull / SUMMARY_WINDOW.hop) + 4
+                                : (int)(MAX_SAMPLES / SUMMARY_WINDOW.hop) + 4;
+
+// Z-axis angle swept (rad) per window of the recording, oldest first.
+// The processing thread fills it and publishes each entry with a release
+// store of window_count, like the recording buffer.
+float window_angle[MAX_WINDOWS];
+std::atomic<uint32_t> window_count{0};
+
+// Latest window, for the UI tick.
+struct WindowSnapshot {
+    uint32_t windows;           // Windows so far (0: none yet).
+    float angle;                // Z-axis angle swept (rad).
+    float rms;                  // Z-axis RMS rate (rad/s).
+};
+
+WindowSnapshot window_snapshot = {};
+
+// Spectrum of the last SPECTRUM_SIZE samples of each axis (1.35 s at
+// 190 Hz), every SPECTRUM_HOP samples while recording.
+#define SPECTRUM_SIZE 256
+#define SPECTRUM_HOP 128
+
+// Bands the spectral energy is split into (Hz): gait, faster limb
+// movement, and the rest up to the Nyquist frequency.
+#define SPECTRUM_BANDS 3
+constexpr float SPECTRUM_EDGES[SPECTRUM_BANDS + 1] = {0.3f, 3.0f, 12.0f, GYRO_ODR / 2.0f};
+
+// Bins shown as bars, from the first above DC (0.74 to 23.7 Hz at 190 Hz).
+#define SPECTRUM_BARS 32
+
+// Block handed from the processing thread to the UI thread, oldest
+// sample first. The processing thread only fills it while
+// spectrum_block_busy is false; the UI thread clears the flag once done.
+int16_t spectrum_block[3][SPECTRUM_SIZE];
+std::atomic<bool> spectrum_block_busy{false};
+
+// UI thread only.
+SpectrumAnalyzer<SPECTRUM_SIZE, SPECTRUM_BANDS> spectrum(GYRO_ODR, SPECTRUM_EDGES);
+SpectrumResult<SPECTRUM_SIZE, SPECTRUM_BANDS> spectrum_result[3];
+CycleStats spectrum_cycles;
+
+// Stride model used until calibrated: the radius from gyroscope placement
+// to axis of rotation for me in meters (i.e., hip leg socket), no cadence term.
+constexpr StrideParams STRIDE_DEFAULTS = {0.25f, 0.0f};
+
+// Calibration walks so far, and fewest strides a walk needs to count.
+StrideCalibration stride_cal = {};
+#define STRIDE_CAL_MIN_STRIDES 5
+
+// The last walk was added to stride_cal already.
+bool stride_cal_taken = false;
+
+// Set to 1 to integrate orientation in Q2.30 fixed point instead of float.
+#define ORIENTATION_FIXED_POINT 0
+
+// Integrator of the 3D orientation of the sensor.
+#if ORIENTATION_FIXED_POINT
+typedef OrientationIntegratorQ30 Integrator;
+#else
+typedef OrientationIntegrator Integrator;
+#endif
+
+// Orientation stage of the processing pipeline; it also counts the
+// cycles spent per update (reported after each session).
+typedef OrientationStage<Integrator, AcquisitionSensor> OrientationUpdate;
+
+// Set to 1 to filter in Q15 fixed point instead of float.
+#define FILTER_FIXED_POINT 0
+
+// Low-pass ahead of the orientation and distance integrals: 4th-order
+// Butterworth at 15 Hz, designed for the recording data rate. Walking
+// (steps at 1-3 Hz, harmonics up to ~10 Hz) passes, foot-strike
+// vibration and sensor noise above it do not. The few pre-trigger
+// samples, taken at ARMED_ODR, see a cutoff half as high.
+#define GAIT_FILTER_CUTOFF_HZ 15.0
+
+struct GaitFilter {
+    static constexpr BiquadDesign<2> design() {
+        return biquad_butterworth_lowpass<2>(GAIT_FILTER_CUTOFF_HZ, GYRO_ODR);
+    }
+};
+
+struct GaitFilterQ14 {
+    static constexpr BiquadDesignQ14<2> design() { return biquad_design_q14(GaitFilter::design()); }
+};
+
+#if FILTER_FIXED_POINT
+typedef FilterStage<BiquadCascadeQ15<2>, GaitFilterQ14> GaitFilterStage;
+#else
+typedef FilterStage<BiquadCascade<2>, GaitFilter> GaitFilterStage;
+#endif
+
+// Added to the recording timer for the time-stamps of live samples, so
+// they follow on from any pre-trigger samples.
+volatile uint32_t record_offset_us = 0;
+
+/* START: Motion Trigger */
+
+// 1: while idle, the gyroscope runs at its lowest data rate with an INT1
+// angular rate threshold and the MCU sleeps; recording starts as soon as
+// walking begins. The button still starts a counted-down session.
+#define MOTION_TRIGGER 1
+
+// Rate on any axis that counts as walking, and how many consecutive
+// samples (at ARMED_ODR) it has to last, so a knock does not trigger.
+#define MOTION_THRESHOLD_RAD_S 1.5f
+#define MOTION_THRESHOLD_LSB ((uint16_t)(MOTION_THRESHOLD_RAD_S / SCALING_FACTOR))
+#define MOTION_DURATION_SAMPLES 4
+
+// True while the gyroscope is configured for the motion trigger.
+bool motion_armed = false;
+
+// Samples leading up to the trigger, drained from the gyroscope FIFO
+// (which runs in stream mode while armed), oldest first.
+int16_t pretrigger_raw[L3GD20_FIFO_DEPTH][3];
+
+/* END: Motion Trigger */
+
+/* START: Persistent Storage */
+
+// EEPROM region used by the record store (first half of the M24LR64).
+#define RECORD_STORE_BASE 0x0000
+#define RECORD_STORE_SIZE 0x1000
+
+// EEPROM region holding the session history (second half, 256 sessions).
+#define SESSION_HISTORY_BASE 0x1000
+#define SESSION_HISTORY_SIZE 0x1000
+
+BspEeprom eeprom;
+
+// Record writes run page by page in the background, so persisting a
+// session never holds up the event loop.
+EepromWriter eeprom_writer(eeprom);
+RecordStore records(eeprom_writer, RECORD_STORE_BASE, RECORD_STORE_SIZE);
+SessionHistory history(eeprom_writer, SESSION_HISTORY_BASE, SESSION_HISTORY_SIZE);
+
+// Completion of the last session summary write.
+EepromFuture session_saved;
+
+// Device clock (time()) at the start of the current session.
+uint32_t session_start_s = 0;
+
+// False when the EEPROM board is not fitted; sessions are then kept in RAM only.
+bool records_ok = false;
+
+/* END: Persistent Storage */
+
+/* START: Session Export */
+
+// Samples go out as framed binary packets, drained by DMA, on UART5: TX
+// on PC12 (RX, PD2, unused), to a 3.3 V USB-serial adapter. printf keeps
+// the STLink port to itself, so the two never interleave.
+#define EXPORT_TX_PIN PC_12
+#define EXPORT_RX_PIN PD_2
 
-// Total Samples (20 seconds / 0.5 seconds).
-#define SAMPLES 40
+// 300 kB/s on the wire; exact on the 45 MHz APB1 clock with 8x oversampling.
+#define EXPORT_BAUD 3000000
 
-// Sampling Interval.
-#define SAMPLE_INTERVAL 0.5
+UartDmaTx export_uart(EXPORT_TX_PIN, EXPORT_RX_PIN, EXPORT_BAUD);
+FrameExporter exporter(export_uart);
 
-// Radius from gyroscope placement to axis of rotation for me in meters (i.e., hip leg socket).
-#define RADIUS_ROT 0.25
+// 1: stream samples as they are recorded.
+// 0: replay the recorded buffer once the session has been processed.
+#define EXPORT_LIVE 1
 
-// SPI callback function to service ISR.
-void spi_cb(int event) {
+// Retry delay while the TX ring is too full for the next batch.
+#define EXPORT_RETRY_DELAY 5ms
+
+/* END: Session Export */
+
+/* START: Threads */
+
+// Samples flow down a chain of threads, highest priority first. Each one
+// sleeps on a thread flag (or its event queue) until there is work:
+//  - acq (realtime):          data-ready time-stamps from the ISR, SPI DMA
+//                             read of the sample.
+//  - proc (above normal):     filtering, orientation update and the recording buffers.
+//  - ui, the main thread (below normal): event loop with the state machine,
+//                             button, touch, LCD, EEPROM and printf.
+//  - export (low):            its own event loop, framing samples for the host.
+// The hand-offs are SpscQueues, so none of them takes a lock. The LCD is
+// fed by LTDC, not SPI5, so while recording the acquisition thread has
+// the gyroscope's SPI bus to itself.
+
+// Stack budgets (bytes), checked against the high-water marks in the
+// thread report printed after each recording.
+#define ACQ_STACK_SIZE    1024
+#define PROC_STACK_SIZE   1536
+#define EXPORT_STACK_SIZE 2048
+
+// Thread flags.
+#define ACQ_FLAG_DRDY  0x1
+#define PROC_FLAG_DATA 0x1
+
+// Time between data-ready events while recording. A sample not read
+// within it counts as a missed deadline.
+constexpr uint32_t SAMPLE_PERIOD_US = Acquisition::period_us();
+
+// What a GyroSample on the sample queue asks of the processing thread.
+enum SampleCommand : uint8_t {
+    SAMPLE_DATA,        // Run it through the pipeline.
+    SAMPLE_RESET,       // No sample: reset the pipeline for a new session.
+};
+
+// One gyroscope sample on its way through the threads.
+struct GyroSample {
+    uint32_t timestamp_us;
+    int16_t raw[3];
+    uint8_t command = SAMPLE_DATA;
+};
+
+Thread acq_thread(osPriorityRealtime, ACQ_STACK_SIZE, nullptr, "acq");
+Thread proc_thread(osPriorityAboveNormal, PROC_STACK_SIZE, nullptr, "proc");
+Thread export_thread(osPriorityLow, EXPORT_STACK_SIZE, nullptr, "export");
+
+// Event loop of the export thread. Everything that sends through the
+// exporter runs on it.
+EventLoop export_loop;
+
+// Data-ready time-stamps (ISR -> acq).
+SpscQueue<uint32_t, 16> drdy_queue;
+
+// Samples read (acq -> proc). Also carries the pre-trigger samples, so it
+// holds at least a full gyroscope FIFO.
+SpscQueue<GyroSample, 64> sample_queue;
+
+// Samples to stream (proc -> export): ~0.6 s at 190 Hz.
+SpscQueue<GyroSample, 128> export_queue;
+
+// Window summaries to stream (proc -> export).
+SpscQueue<WindowFrame, 8> window_queue;
+
+// True while an export_drain() is queued on the export loop.
+volatile bool export_drain_queued = false;
+
+// Samples lost or read late during the current session. Written by the
+// acquisition thread while recording, by the UI thread otherwise.
+DropDetector drops(SAMPLE_PERIOD_US);
+
+// drdy_queue.drops() already reported to drops (acq only).
+uint32_t drdy_drops_seen = 0;
+
+ThreadLoad acq_load;
+ThreadLoad proc_load;
+ThreadMonitor threads;
+
+static_assert(L3GD20_FIFO_DEPTH <= 64, "sample_queue must hold the pre-trigger samples");
+
+/* END: Threads */
+
+// Period of the live readout refresh while recording.
+#define UI_TICK_PERIOD 100ms
+
+// Readout shown while recording; a horizontal swipe switches it.
+enum class LiveView {
+    Rates,          // Angular rate of each axis.
+    Orientation     // Roll, pitch and yaw since the recording started.
+};
+
+LiveView live_view = LiveView::Rates;
+
+// Touch-screen gestures, read from the STMPE811 FIFO on its interrupt.
+TouchInput touch(loop);
+
+/* START: Touch Calibration */
+
+// Targets touched during calibration: near three corners of a triangle
+// covering most of the screen, so the solve is well conditioned.
+const TouchPoint CAL_TARGETS[3] = {{24, 32}, {216, 160}, {120, 288}};
+
+// Crosshair half-length (px).
+#define CAL_MARK_SIZE 10
+
+// Raw panel readings of the targets touched so far.
+TouchPoint cal_raw[3];
+
+/* END: Touch Calibration */
+
+// How long the total distance stays on screen before returning to idle.
+#define RESULT_HOLD_TIME 30s
+
+using namespace std::chrono_literals;
+
+void on_button();
+void on_motion();
+void on_touch(GestureEvent event);
+void calibrate_stride();
+void show_distance(float meters);
+void calibration_step(int step);
+void arm_motion_trigger();
+void export_session_start();
+
+// SPI DMA completion callback (ISR context).
+void gyro_read_done(uint8_t status) {
+    gyro_read_status = status;
     flags.set(SPI_FLAG);
 }
 
 // Data ready callback function to service ISR.
+// Samples are only read while recording. Outside of that the data-ready
+// line stays high and no further edges (or wake-ups) are generated.
+// The sample is time-stamped here, so dispatch latency does not skew dt.
+// A full queue drops the edge (counted by the queue).
 void data_rdy_cb() {
-    flags.set(DATA_RDY_FLAG);
+    if (state == AppState::Recording) {
+        uint32_t timestamp_us = record_offset_us + t.elapsed_time().count();
+        drdy_queue.push(timestamp_us);
+        acq_thread.flags_set(ACQ_FLAG_DRDY);
+    }
 }
 
-// Resets screen back to gyroscope boot.
-void reset_screen() {
-    setup_background_layer();
+// Motion threshold callback function to service ISR.
+void motion_cb() {
+    if (state == AppState::Idle) {
+        loop.post(on_motion);
+    }
+}
+
+// Start recording data callback function to service ISR.
+void start_cb() {
+    loop.post(on_button);
+}
+
+// Clears the foreground layer and draws the title, glyph by glyph.
+void draw_title_screen() {
     setup_foreground_layer();
 
     // Creates c-strings in the display buffers, in preparation
@@ -175,290 +617,1188 @@ void reset_screen() {
     snprintf(display_buf[0],60,"The Embedded");
     snprintf(display_buf[1],60,"Gyrometer");
     snprintf(display_buf[9],60,"Rev_C_12222023");
-    lcd.SelectLayer(FOREGROUND);
 
     // Display the buffered string on the screen.
     lcd.DisplayStringAt(0, LINE(0), (uint8_t *)display_buf[0], LEFT_MODE);
     lcd.DisplayStringAt(0, LINE(1), (uint8_t *)display_buf[1], LEFT_MODE);
     lcd.DisplayStringAt(0, LINE(19), (uint8_t *)display_buf[9], RIGHT_MODE);
+}
 
-    lcd.SelectLayer(FOREGROUND); 
+// Shows a pre-rendered static text, or draws it if there is no asset.
+void show_label(const ScreenAsset &asset, uint16_t line, const char *text) {
+    if (!assets.show(FOREGROUND, asset)) {
+        lcd.DisplayStringAt(0, LINE(line), (uint8_t *)text, LEFT_MODE);
+    }
 }
 
-// Start recording data callback function to service ISR.
-void start_cb() {
-    button_pressed = true;
-    led1 = 1;
+// Renders the static screens into the asset cache. Boot only, before
+// anything else is drawn. The background layer is never drawn on after
+// setup_background_layer().
+void render_screen_assets() {
+    const uint16_t width = lcd.GetXSize();
+    if (!assets.begin_render(FOREGROUND, LCD_COLOR_BLACK)) {
+        printf("No SDRAM for screen assets, drawing every screen.\n");
+        return;
+    }
+
+    draw_title_screen();
+    bool ok = assets.capture(title_screen, 0, 0, width, lcd.GetYSize());
+
+    static const char *const COUNTDOWN_TEXT[4] = {"GO!", "1..", "2..", "3.."};
+    for (int k = 0; k < 4; k++) {
+        lcd.ClearStringLine(5);
+        lcd.DisplayStringAt(0, LINE(5), (uint8_t *)COUNTDOWN_TEXT[k], LEFT_MODE);
+        ok = assets.capture(countdown_asset[k], 0, LINE(5), width, LINE(1)) && ok;
+    }
+
+    lcd.ClearStringLine(5);
+    lcd.DisplayStringAt(0, LINE(5), (uint8_t *)"Processing..", LEFT_MODE);
+    ok = assets.capture(processing_label, 0, LINE(5), width, LINE(1)) && ok;
+
+    lcd.ClearStringLine(5);
+    lcd.DisplayStringAt(0, LINE(5), (uint8_t *)"Press Blue Button", LEFT_MODE);
+    lcd.DisplayStringAt(0, LINE(6), (uint8_t *)"To Start..", LEFT_MODE);
+#if MOTION_TRIGGER
+    lcd.DisplayStringAt(0, LINE(7), (uint8_t *)"(or start walking)", LEFT_MODE);
+#endif
+    ok = assets.capture(idle_prompt, 0, LINE(5), width, LINE(3)) && ok;
+
+    ok = small_digits.render(assets, lcd, 0, LINE(10), Font16.Width, Font16.Height,
+                             [](char c, uint16_t x, uint16_t y) { lcd.DisplayChar(x, y, c); }) && ok;
+    ok = big_digits.render(assets, lcd, 0, LINE(10), BIG_DIGIT_WIDTH, BIG_DIGIT_HEIGHT,
+                           [](char c, uint16_t x, uint16_t y) {
+                               seven_segment_draw(lcd, c, x, y, BIG_DIGIT_WIDTH, BIG_DIGIT_HEIGHT,
+                                                  BIG_DIGIT_THICKNESS);
+                           }) && ok;
+
+    assets.end_render();
+    lcd.SelectLayer(FOREGROUND);
+
+    assets.show(FOREGROUND, title_screen);
+    if (!ok) {
+        printf("Some screen assets not rendered, drawing those screens.\n");
+    }
+}
+
+// Resets screen back to gyroscope boot: one DMA2D copy of the title
+// screen, which also clears the rest of the foreground.
+void reset_screen() {
+    lcd.SelectLayer(FOREGROUND);
+    lcd.SetBackColor(LCD_COLOR_BLACK);
+    lcd.SetTextColor(LCD_COLOR_LIGHTGREEN);
+    if (!assets.show(FOREGROUND, title_screen)) {
+        draw_title_screen();
+    }
 }
 
 // Display UI helper text on LCD on how to start use of the system.
+// Drawn once on entering the idle state; the screen keeps it from there.
 void startup_text() {
-    snprintf(display_buf[2],60,"Press Blue Button");
-    snprintf(display_buf[3],60,"To Start..");
-    lcd.DisplayStringAt(0, LINE(5), (uint8_t *)display_buf[2], LEFT_MODE);
-    lcd.DisplayStringAt(0, LINE(6), (uint8_t *)display_buf[3], LEFT_MODE);
+    if (!assets.show(FOREGROUND, idle_prompt)) {
+        lcd.DisplayStringAt(0, LINE(5), (uint8_t *)"Press Blue Button", LEFT_MODE);
+        lcd.DisplayStringAt(0, LINE(6), (uint8_t *)"To Start..", LEFT_MODE);
+#if MOTION_TRIGGER
+        lcd.DisplayStringAt(0, LINE(7), (uint8_t *)"(or start walking)", LEFT_MODE);
+#endif
+    }
+
+    // Result of the previous session, possibly from before a reset, and
+    // the last seven days.
+    if (total_distance_traveled > 0.0f) {
+        snprintf(display_buf[4],60,"Last: %s m", FixedText(total_distance_traveled, 2).c_str());
+        lcd.DisplayStringAt(0, LINE(8), (uint8_t *)display_buf[4], LEFT_MODE);
+    }
+    HistoryTotals week = history.last_days((uint32_t)time(NULL) / HISTORY_SECONDS_PER_DAY, 7);
+    if (week.sessions > 0) {
+        snprintf(display_buf[8],60,"7 days: %s m (%lu)", FixedText(week.distance_m, 1).c_str(),
+                 (unsigned long)week.sessions);
+        lcd.DisplayStringAt(0, LINE(9), (uint8_t *)display_buf[8], LEFT_MODE);
+    }
+
+    if (touch.present()) {
+        snprintf(display_buf[6],60,"Hold: calibrate");
+        snprintf(display_buf[7],60,"Swipe up: diagnostics");
+        lcd.DisplayStringAt(0, LINE(17), (uint8_t *)display_buf[6], LEFT_MODE);
+        lcd.DisplayStringAt(0, LINE(18), (uint8_t *)display_buf[7], LEFT_MODE);
+    }
 }
 
-// Helper text to give user time to prepare before starting walk for more accurate readings
-// (i.e., reduce human error).
-void countdown_text() {
+// Returns to the boot screen and waits for the next button press.
+void enter_idle() {
+    state = AppState::Idle;
+    result_timeout_id = 0;
     reset_screen();
-    snprintf(display_buf[2],60,"3..");
-    lcd.DisplayStringAt(0, LINE(5), (uint8_t *)display_buf[2], LEFT_MODE);
-    thread_sleep_for(1000);
+    startup_text();
+    loop.report();
 
-    snprintf(display_buf[2],60,"2..");
-    lcd.DisplayStringAt(0, LINE(5), (uint8_t *)display_buf[2], LEFT_MODE);
-    thread_sleep_for(1000);
-    reset_screen();
+    if (session_saved.valid()) {
+        printf("Session summary %s.\n", !session_saved.ready() ? "still being written" :
+                                          session_saved.ok() ? "saved" : "could not be saved");
+        session_saved = EepromFuture();
+    }
 
-    snprintf(display_buf[2],60,"1..");
-    lcd.DisplayStringAt(0, LINE(5), (uint8_t *)display_buf[2], LEFT_MODE);
-    thread_sleep_for(1000);
-    reset_screen();
+    printf("Export: %lu frames sent, %lu dropped.\n",
+           (unsigned long)exporter.frames_sent(), (unsigned long)exporter.frames_dropped());
 
-    snprintf(display_buf[2],60,"GO!");
-    lcd.DisplayStringAt(0, LINE(5), (uint8_t *)display_buf[2], LEFT_MODE);
-    thread_sleep_for(200);
-    reset_screen();
+    if (touch.present()) {
+        printf("Touch: %lu samples in %lu bursts, %lu cycles per sample mapped.\n",
+               (unsigned long)touch.samples_read(), (unsigned long)touch.bursts(),
+               (unsigned long)touch.map_cycles().average());
+    }
 
-    // After user has been given the "GO!" signal, we'll start timer to start recording values.
-    t.start();
+#if MOTION_TRIGGER
+    arm_motion_trigger();
+#endif
 }
 
-// Processes data (i.e., convert measured data to forward movement velocity and then distance).
-void processing() {
-    snprintf(display_buf[2],60,"Processing..");
-    lcd.DisplayStringAt(0, LINE(5), (uint8_t *)display_buf[2], LEFT_MODE);
-    thread_sleep_for(1000);
+// Slows the gyroscope down, keeps its latest samples in the FIFO and
+// lets INT1 wake us up once the angular rate crosses the threshold.
+void arm_motion_trigger() {
+    L3GD20_INT1ThresholdConfig(MOTION_THRESHOLD_LSB, MOTION_DURATION_SAMPLES);
+    L3GD20_INT1InterruptConfig((uint16_t)(L3GD20_INT1_CFG_XHIE | L3GD20_INT1_CFG_YHIE | L3GD20_INT1_CFG_ZHIE) << 8 |
+                               L3GD20_INT1INTERRUPT_HIGH_EDGE);
+    Armed::apply();
+    motion_armed = true;
+
+    // Already moving: no rising edge will come.
+    if (int1.read() == 1) {
+        loop.post(on_motion);
+    }
+}
 
-    // Store distance traveled and linear velocity.
-    float distance_traveled = 0.0;
-    float linear_velocity = 0.0;
+// Back to the full-rate, data-ready driven configuration.
+void disarm_motion_trigger() {
+    if (!motion_armed) {
+        return;
+    }
+    motion_armed = false;
+    Acquisition::apply();
+}
 
-    // Apply trapezoidal rule for numeric integration:
-    // v = (delta_time / 2) * (z_0 + 2*z_1 + 2*z_2 + 2*z_n-1 + z_n)
-    // Note, since we are attaching the gyroscope to one leg only and we have two legs,
-    // while the other leg is moving forward, the leg that has the gyroscope will be moving slightly
-    // backwards resulting in negative values. However, we need to count the absolute value of these
-    // negative values to account for the total distance traveled. Otherwise, we will only get half. 
-    //
-    // The trapezoidal rule is done in two parts.
-    // 1. (z_0 + 2*z_1 + 2*z_2 + ... + 2*z_n-1 + z_n) -- this gives us angular displacement.
-    // 2. (delta_time / 2) -- this, multiplied by angular displacement, gives us linear velocity.
-    int lower_bound = 0;
-    for (int i = 0; i < SAMPLES - 1; i++) {
-        float change_in_angle = 0.0;
-        for (int j = lower_bound; j <= value_index_track[i]; j++) {
-            if (j == lower_bound || j == value_index_track[i]) {
-                change_in_angle += fabs((recorded_gyro_values_z[j] * SCALING_FACTOR));
+// Reads one X/Y/Z sample from the gyroscope output registers.
+// Returns STATUS_REG as read along with the sample.
+uint8_t read_gyro(int16_t raw[3]) {
+    // Read in gyro values: one DMA transfer for the whole STATUS_REG..OUT_Z_H block.
+    bool ok = (L3GD20_ReadStatusXYZRawDMA(gyro_block, gyro_read_done) == 0);
+    if (ok) {
+        flags.wait_all(SPI_FLAG);
+        ok = (gyro_read_status == 0);
+    }
+
+    // Fall back to a blocking read so the data-ready line still gets cleared.
+    if (!ok) {
+        GYRO_IO_Read(gyro_block, STATUS_REG, sizeof(gyro_block));
+    }
+
+    // Real-time pre-processing of raw data (byte order from the driver's
+    // copy of CTRL_REG4, no register read per sample).
+    L3GD20_DecodeXYZ(&gyro_block[1], raw, 1);
+    return gyro_block[0];
+}
+
+// Export thread: frames the samples queued for streaming.
+void export_drain() {
+    export_drain_queued = false;
+    GyroSample s;
+    while (export_queue.pop(s)) {
+        exporter.add_sample(s.timestamp_us, s.raw);
+    }
+    WindowFrame w;
+    while (window_queue.pop(w)) {
+        exporter.send(FRAME_WINDOW, &w, sizeof(w));
+    }
+}
+
+// Processing thread: queues an export_drain() unless one is queued
+// already. One drain event covers everything queued until it runs.
+void request_export_drain() {
+    if (!export_drain_queued) {
+        export_drain_queued = true;
+        if (export_loop.post(export_drain) == 0) {
+            export_drain_queued = false;
+        }
+    }
+}
+
+// Sinks of the processing pipeline (see pipeline below). Each one takes
+// its share of the sample.
+
+// Streams the sample after the gait filter, as it is recorded, so live
+// and replayed exports carry the same data (see SessionStartFrame).
+struct ExportSink {
+    void reset() {}
+
+    void process(PipelineSample &s) {
+#if EXPORT_LIVE
+        GyroSample sample = {s.timestamp_us, {s.raw[AXIS_X], s.raw[AXIS_Y], s.raw[AXIS_Z]}};
+        if (export_queue.push(sample)) {
+            request_export_drain();
+        }
+#else
+        (void)s;
+#endif
+    }
+};
+
+// Publishes the latest reading and orientation for the UI tick.
+struct LiveSink {
+    void reset() {
+        CriticalSectionLock lock;
+        live_snapshot = LiveSnapshot{{0, 0, 0}, Quaternion{1.0f, 0.0f, 0.0f, 0.0f}};
+    }
+
+    void process(PipelineSample &s) {
+        CriticalSectionLock lock;
+        live_snapshot.raw[AXIS_X] = s.raw[AXIS_X];
+        live_snapshot.raw[AXIS_Y] = s.raw[AXIS_Y];
+        live_snapshot.raw[AXIS_Z] = s.raw[AXIS_Z];
+        live_snapshot.q = s.attitude;
+    }
+};
+
+// Adds the sample to the recording buffers.
+struct RecordSink {
+    void reset() { recording.clear(); }
+
+    void process(PipelineSample &s) {
+        // Store recorded RAW gyro values for every axis, along with the sample time.
+        recording.push(s.timestamp_us, s.raw);
+    }
+};
+
+// Summarizes the filtered samples over SUMMARY_WINDOW windows, as they
+// arrive: keeps each window's swept angle for processing(), shows the
+// latest one and streams them all to the host.
+struct WindowSink {
+    WindowAggregator<3, WINDOW_MAX_HOPS> windows;
+
+    WindowSink() { windows.configure(SUMMARY_WINDOW); }
+
+    void reset() {
+        windows.reset();
+        window_count.store(0, std::memory_order_relaxed);
+        CriticalSectionLock lock;
+        window_snapshot = WindowSnapshot{};
+    }
+
+    void process(PipelineSample &s) {
+        windows.update(s.timestamp_us, s.raw, [](const WindowResult<3> &w) { on_window(w); });
+    }
+
+    static void on_window(const WindowResult<3> &w) {
+        // Angle swept, counting the backward swing too (see processing()).
+        float angle = w.abs_integral(AXIS_Z) * SCALING_FACTOR;
+
+        uint32_t n = window_count.load(std::memory_order_relaxed);
+        if (n < (uint32_t)MAX_WINDOWS) {
+            window_angle[n] = angle;
+            window_count.store(n + 1, std::memory_order_release);
+        }
+
+        {
+            CriticalSectionLock lock;
+            window_snapshot.windows++;
+            window_snapshot.angle = angle;
+            window_snapshot.rms = w.rms(AXIS_Z) * SCALING_FACTOR;
+        }
+
+#if EXPORT_LIVE
+        WindowFrame frame;
+        frame.first_us = w.first_us;
+        frame.last_us = w.last_us;
+        frame.count = (w.count > 65535) ? 65535 : (uint16_t)w.count;
+        for (int a = 0; a < 3; a++) {
+            frame.mean[a] = w.mean(a);
+            frame.rms[a] = w.rms(a);
+            frame.min[a] = w.ch[a].min;
+            frame.max[a] = w.ch[a].max;
+            frame.integral[a] = w.integral(a);
+            frame.swept[a] = w.abs_integral(a);
+        }
+        if (window_queue.push(frame)) {
+            request_export_drain();
+        }
+#endif
+    }
+};
+
+// Splits the walk into strides and adds up their lengths.
+struct StrideSink {
+    StrideDetector detector{STRIDE_DEFAULTS};
+
+    void reset() { detector.reset(); }
+
+    void process(PipelineSample &s) {
+        detector.update(s.raw[AXIS_Z] * SCALING_FACTOR, s.dt_us * 1e-6f);
+    }
+};
+
+void spectrum_update();
+
+// Keeps the last SPECTRUM_SIZE filtered samples and hands them to the UI
+// thread every SPECTRUM_HOP samples. The FFTs run there, below the
+// acquisition and processing threads; a block is skipped if the last one
+// is still being analyzed.
+struct SpectrumSink {
+    int16_t history[3][SPECTRUM_SIZE];
+    uint32_t count = 0;
+
+    void reset() { count = 0; }
+
+    void process(PipelineSample &s) {
+        uint32_t slot = count % SPECTRUM_SIZE;
+        history[AXIS_X][slot] = s.raw[AXIS_X];
+        history[AXIS_Y][slot] = s.raw[AXIS_Y];
+        history[AXIS_Z][slot] = s.raw[AXIS_Z];
+        count++;
+
+        if (count < SPECTRUM_SIZE || count % SPECTRUM_HOP != 0 ||
+            spectrum_block_busy.load(std::memory_order_acquire)) {
+            return;
+        }
+        // The oldest sample is the one the next sample overwrites.
+        uint32_t oldest = count % SPECTRUM_SIZE;
+        for (int a = 0; a < 3; a++) {
+            memcpy(&spectrum_block[a][0], &history[a][oldest], (SPECTRUM_SIZE - oldest) * sizeof(int16_t));
+            memcpy(&spectrum_block[a][SPECTRUM_SIZE - oldest], &history[a][0], oldest * sizeof(int16_t));
+        }
+        spectrum_block_busy.store(true, std::memory_order_release);
+        if (loop.post(spectrum_update) == 0) {
+            spectrum_block_busy.store(false, std::memory_order_relaxed);
+        }
+    }
+};
+
+// Everything the processing thread does with a sample, in order.
+SensorPipeline<AcquisitionSensor, GaitFilterStage, ExportSink, OrientationUpdate, LiveSink, RecordSink, WindowSink,
+               StrideSink, SpectrumSink>
+    pipeline;
+
+// Acquisition thread: reads one sample per queued data-ready time-stamp
+// and accounts for every sample lost or read late on the way.
+void acquisition_main() {
+    for (;;) {
+        ThisThread::flags_wait_any(ACQ_FLAG_DRDY);
+        uint32_t timestamp_us;
+        while (drdy_queue.pop(timestamp_us)) {
+            BusyScope busy(acq_load);
+            GyroSample sample;
+            sample.timestamp_us = timestamp_us;
+            uint8_t status = read_gyro(sample.raw);
+
+            // The recording timer stops with the recording; samples still
+            // queued then are not timed.
+            AppState now = state;
+            uint32_t read_us = (now == AppState::Recording) ? record_offset_us + t.elapsed_time().count()
+                                                            : timestamp_us;
+            drops.on_sample(status, timestamp_us, read_us, (uint8_t)now);
+
+            uint32_t drdy_drops = drdy_queue.drops();
+            if (drdy_drops != drdy_drops_seen) {
+                drops.on_dropped(DROP_QUEUE_FULL, (uint16_t)(drdy_drops - drdy_drops_seen), timestamp_us, (uint8_t)now);
+                drdy_drops_seen = drdy_drops;
+            }
+
+            if (!sample_queue.push(sample)) {
+                drops.on_dropped(DROP_QUEUE_FULL, 1, timestamp_us, (uint8_t)now);
+            }
+            proc_thread.flags_set(PROC_FLAG_DATA);
+        }
+    }
+}
+
+// Processing thread: records every sample handed over by acquisition.
+// The pipeline is only touched here; a reset comes in order with the
+// samples, so the ones queued before it still finish the old session.
+void processing_main() {
+    for (;;) {
+        ThisThread::flags_wait_any(PROC_FLAG_DATA);
+        GyroSample sample;
+        while (sample_queue.pop(sample)) {
+            BusyScope busy(proc_load);
+            if (sample.command == SAMPLE_RESET) {
+                pipeline.reset();
             } else {
-                change_in_angle += 2 * fabs((recorded_gyro_values_z[j] * SCALING_FACTOR));
+                pipeline.process(sample.timestamp_us, sample.raw);
             }
         }
+    }
+}
+
+// Labels of the current live view.
+void draw_live_labels() {
+    if (live_view == LiveView::Rates) {
+        snprintf(display_buf[5],60,"X-AXIS: ");
+        snprintf(display_buf[6],60,"Y-AXIS: ");
+        snprintf(display_buf[7],60,"Z-AXIS: ");
+    } else {
+        snprintf(display_buf[5],60,"ROLL: ");
+        snprintf(display_buf[6],60,"PITCH: ");
+        snprintf(display_buf[7],60,"YAW: ");
+    }
 
-        // The multiplicative term in the trapezoidal rule (delta_time / 2) gets
-        // multiplied by the change in angle (or angular displacement) to give us the 
-        // approximated linear velocity.
-        linear_velocity = change_in_angle * (SAMPLE_INTERVAL / 2);
+    const char *unit = (live_view == LiveView::Rates) ? "rad/s" : "rad";
 
-        // Multiplying linear velocity by radius to axis of rotation (v = omega * r)
-        // gives us the distance traveled.
-        distance_traveled += (linear_velocity * RADIUS_ROT);
-        printf("Distance Traveled: %f\n", distance_traveled);
-        lower_bound = value_index_track[i] + 1;
+    lcd.ClearStringLine(5);
+    lcd.ClearStringLine(6);
+    lcd.ClearStringLine(7);
+    for (int a = 0; a < 3; a++) {
+        lcd.DisplayStringAt(0, LINE(5 + a), (uint8_t *)display_buf[5 + a], LEFT_MODE);
+        lcd.DisplayStringAt(0, LINE(5 + a), (uint8_t *)unit, RIGHT_MODE);
+        rate_readout[a].invalidate();
     }
+}
 
-    // After 40 samples have been processed, display distance traveled to user for 30 seconds.
-    printf("Total Distance Traveled: %f meters.\n", distance_traveled);
-    total_distance_traveled = distance_traveled;
-    snprintf(display_buf[2],60,"Total Distance:");
-    snprintf(display_buf[3],60, "%f meters.", distance_traveled);
-    lcd.DisplayStringAt(0, LINE(5), (uint8_t *)display_buf[2], LEFT_MODE);
-    lcd.DisplayStringAt(0, LINE(6), (uint8_t *)display_buf[3], LEFT_MODE);
-    thread_sleep_for(30000);
+// Display Live rad/s Readings from each Axis (or the orientation) on LCD.
+void ui_tick() {
+    LiveSnapshot live;
+    WindowSnapshot window;
+    {
+        CriticalSectionLock lock;
+        live = live_snapshot;
+        window = window_snapshot;
+    }
+
+    float value[3] = {((float)live.raw[AXIS_X]) * SCALING_FACTOR, ((float)live.raw[AXIS_Y]) * SCALING_FACTOR,
+                      ((float)live.raw[AXIS_Z]) * SCALING_FACTOR};
 
+    if (live_view == LiveView::Orientation) {
+        EulerAngles euler = quaternion_to_euler(live.q);
+        value[0] = euler.roll;
+        value[1] = euler.pitch;
+        value[2] = euler.yaw;
+    }
+
+    // Fixed width, so only the digits that changed are redrawn.
+    for (int a = 0; a < 3; a++) {
+        format_fit(display_buf[2 + a], RATE_CELLS, value[a], RATE_DECIMALS);
+        rate_readout[a].set(display_buf[2 + a]);
+    }
+
+    // Latest summary window (fixed width, so no blanking needed).
+    if (window.windows > 0) {
+        snprintf(display_buf[8],60,"Window: %s rad  ", FixedText(window.angle, 2, 7).c_str());
+        snprintf(display_buf[10],60,"RMS Z:  %s rad/s", FixedText(window.rms, 2, 7).c_str());
+        lcd.DisplayStringAt(0, LINE(9), (uint8_t *)display_buf[8], LEFT_MODE);
+        lcd.DisplayStringAt(0, LINE(10), (uint8_t *)display_buf[10], LEFT_MODE);
+    }
 }
 
-int main() {
-    // Write (TX) and Read (RX) buffers for SPI communication.
-    uint8_t write_buffer[32], read_buffer[32];
+// Z-axis spectrum as a bar chart under the live readings, one bar per bin
+// on a 40 dB scale below the strongest bar (the peak in yellow). Bars are
+// solid rectangles, which the LCD driver fills with the DMA2D.
+void draw_spectrum() {
+    const SpectrumResult<SPECTRUM_SIZE, SPECTRUM_BANDS> &z = spectrum_result[AXIS_Z];
+
+    snprintf(display_buf[11],60,"Peak %sHz gait%s%%", FixedText(z.peak_hz, 2, 5).c_str(),
+             FixedText(100.0f * z.band_share(0), 0, 3).c_str());
+    lcd.DisplayStringAt(0, LINE(11), (uint8_t *)display_buf[11], LEFT_MODE);
+
+    const int top = LINE(12);
+    const int height = LINE(18) - LINE(12);
+    const int pitch = (lcd.GetXSize() - 2 * GRAPH_PADDING) / SPECTRUM_BARS;
+
+    float max = 0.0f;
+    int peak = 1;
+    for (int k = 1; k <= SPECTRUM_BARS; k++) {
+        if (z.power[k] > max) {
+            max = z.power[k];
+            peak = k;
+        }
+    }
 
-    /* START: SPI Initialization and Setup */
+    for (int k = 1; k <= SPECTRUM_BARS; k++) {
+        int h = 0;
+        if (max > 0.0f && z.power[k] > 0.0f) {
+            float db = 10.0f * log10f(z.power[k] / max);
+            h = (db <= -40.0f) ? 0 : (int)(height * (db + 40.0f) / 40.0f);
+        }
+        int x = GRAPH_PADDING + (k - 1) * pitch;
+        lcd.SetTextColor(LCD_COLOR_BLACK);
+        if (h < height) {
+            lcd.FillRect(x, top, pitch - 1, height - h);
+        }
+        lcd.SetTextColor((k == peak) ? LCD_COLOR_YELLOW : LCD_COLOR_CYAN);
+        if (h > 0) {
+            lcd.FillRect(x, top + height - h, pitch - 1, h);
+        }
+    }
+    lcd.SetTextColor(LCD_COLOR_LIGHTGREEN);
+}
 
-    // PF_9 --> Gyroscope SPI MOSI Pin
-    // PF_8 --> Gyroscope SPI MISO Pin
-    // PF_7 --> Gyroscope SPI Clock Pin
-    // Using GPIO SSEL Line.
-    SPI spi(PF_9, PF_8, PF_7, PC_1, use_gpio_ssel);
+// UI thread: analyzes the block queued by SpectrumSink.
+void spectrum_update() {
+    if (state == AppState::Recording) {
+        {
+            CycleScope scope(spectrum_cycles);
+            for (int a = 0; a < 3; a++) {
+                spectrum.analyze(spectrum_block[a], spectrum_result[a]);
+            }
+        }
+        draw_spectrum();
+    }
+    spectrum_block_busy.store(false, std::memory_order_release);
+}
 
-    // 8-bits per SPI frame.
-    // Clock polarity and phase mode, both 1.
-    spi.format(8, 3);
+void stop_recording();
 
-    // Default SPI bus clock frequency (1 MHz).
-    spi.frequency(1'000'000);
+// After user has been given the "GO!" signal (or walking has been detected),
+// we'll start timer to start recording values. The first pretrigger_samples
+// of pretrigger_raw are recorded ahead of the live samples.
+void start_recording(int pretrigger_samples) {
+    reset_screen();
 
-    /* END: SPI Initialization and Setup */
+    record_offset_us = 0;
+    session_start_s = (uint32_t)time(NULL);
+    threads.reset_peaks();
+    spectrum_cycles.reset();
+    memset(spectrum_result, 0, sizeof(spectrum_result));
+
+    draw_live_labels();
+
+#if EXPORT_LIVE
+    export_loop.post(export_session_start);
+#endif
+
+    // The pipeline reset, then the pre-trigger samples (taken at the armed
+    // data rate, ending where the live samples begin), go through the
+    // processing thread like live samples; acquisition is not producing
+    // yet, so the queue still has a single producer. The reset must not
+    // be lost: while the queue is full, wait for processing to drain it.
+    GyroSample reset = {};
+    reset.command = SAMPLE_RESET;
+    while (!sample_queue.push(reset)) {
+        proc_thread.flags_set(PROC_FLAG_DATA);
+        ThisThread::sleep_for(1ms);
+    }
+    for (int k = 0; k < pretrigger_samples; k++) {
+        GyroSample sample = {(uint32_t)k * ARMED_SAMPLE_US,
+                             {pretrigger_raw[k][AXIS_X], pretrigger_raw[k][AXIS_Y], pretrigger_raw[k][AXIS_Z]}};
+        sample_queue.push(sample);
+    }
+    proc_thread.flags_set(PROC_FLAG_DATA);
+    record_offset_us = (uint32_t)pretrigger_samples * ARMED_SAMPLE_US;
 
+    t.reset();
+    t.start();
+    state = AppState::Recording;
 
-    /* START: Interrupt Initialization and Setup */
+    ui_tick_id = loop.post_every(UI_TICK_PERIOD, ui_tick);
+    record_end_id = loop.post_in(std::chrono::seconds(RECORD_TIME), stop_recording);
 
-    // PA_2 --> Gyroscope INT2 Pin
-    InterruptIn int2(PA_2, PullDown);
+    // The data-ready line may already be high from an unread sample,
+    // in which case no rising edge will come. Read it to re-arm the interrupt.
+    // (Locked, since the ISR is the queue's only other producer.)
+    if (int2.read() == 1) {
+        CriticalSectionLock lock;
+        data_rdy_cb();
+    }
+}
 
-    // Set interrupt 2 to trigger routine on rising edge.
-    int2.rise(&data_rdy_cb);
+// Helper text to give user time to prepare before starting walk for more accurate readings
+// (i.e., reduce human error). Each step is a timer event rather than a blocking sleep.
+void countdown_step(int remaining) {
+    if (state != AppState::Countdown) {
+        return;
+    }
 
-    /* END: Interrupt Initialization and Setup */
+    reset_screen();
 
-    // Establish communicating device (read WHOAMI register).
-    write_buffer[0] = 0x8f;
-    spi.transfer(write_buffer, 2, read_buffer, 2, spi_cb);
-    flags.wait_all(SPI_FLAG);
-    printf("Gyroscope Identifier (WHOAMI) = 0x%X\n", read_buffer[1]);
+    if (remaining > 0) {
+        snprintf(display_buf[2],60,"%d..", remaining);
+        show_label(countdown_asset[remaining], 5, display_buf[2]);
+        loop.post_in(1s, [remaining]() { countdown_step(remaining - 1); });
+    } else {
+        show_label(countdown_asset[0], 5, "GO!");
+        loop.post_in(200ms, []() { start_recording(0); });
+    }
+}
 
-    /* START: Write configurations to control registers. */
+// Button press: start a new session from idle, or skip the result screen.
+// Abandons a touch calibration, keeping the previous one, and leaves the
+// diagnostics screen.
+void on_button() {
+    if (state == AppState::Calibrating) {
+        touch.cancel_capture();
+        enter_idle();
+        return;
+    }
+    if (state == AppState::Diagnostics) {
+        enter_idle();
+        return;
+    }
+    if (state != AppState::Idle && state != AppState::Result) {
+        return;
+    }
 
-    // CTRL_REG1
-    write_buffer[0] = CTRL_REG1;
-    write_buffer[1] = CTRL_REG1_CONFIG;
-    spi.transfer(write_buffer, 2, read_buffer, 2, spi_cb);
-    flags.wait_all(SPI_FLAG);
+    loop.cancel(result_timeout_id);
+    disarm_motion_trigger();
+    drops.reset();
+    state = AppState::Countdown;
+    led1 = 1;
+    countdown_step(3);
+}
 
-    // CTRL_REG3
-    write_buffer[0] = CTRL_REG3;
-    write_buffer[1] = CTRL_REG3_CONFIG;
-    spi.transfer(write_buffer, 2, read_buffer, 2, spi_cb);
-    flags.wait_all(SPI_FLAG);
+// Draws the calibration crosshair for one target.
+void draw_cal_target(const TouchPoint &p) {
+    lcd.DrawHLine((uint16_t)(p.x - CAL_MARK_SIZE), (uint16_t)p.y, 2 * CAL_MARK_SIZE + 1);
+    lcd.DrawVLine((uint16_t)p.x, (uint16_t)(p.y - CAL_MARK_SIZE), 2 * CAL_MARK_SIZE + 1);
+    lcd.DrawCircle((uint16_t)p.x, (uint16_t)p.y, CAL_MARK_SIZE / 2);
+}
 
-    // CTRL_REG4
-    write_buffer[0] = CTRL_REG4;
-    write_buffer[1] = CTRL_REG4_CONFIG;
-    spi.transfer(write_buffer, 2, read_buffer, 2, spi_cb);
-    flags.wait_all(SPI_FLAG);
+// All three targets touched: solve, apply and store the new transform.
+void finish_calibration() {
+    TouchCalibration cal;
+    if (!touch_calibration_solve(cal_raw, CAL_TARGETS, cal)) {
+        // Targets touched in the wrong place or a bad contact: go again.
+        printf("Touch calibration rejected, retrying.\n");
+        calibration_step(0);
+        return;
+    }
 
-    /* END: Write configurations to control registers. */
+    touch.set_calibration(cal);
+    printf("Touch calibration: x = (%ld rx + %ld ry + %ld) >> %d, y = (%ld rx + %ld ry + %ld) >> %d.\n",
+           (long)cal.a, (long)cal.b, (long)cal.c, TOUCH_CAL_SHIFT,
+           (long)cal.d, (long)cal.e, (long)cal.f, TOUCH_CAL_SHIFT);
+    if (records_ok && !records.append(RECORD_TOUCH_CALIBRATION, cal)) {
+        printf("Failed to save touch calibration.\n");
+    }
+    enter_idle();
+}
 
-    // Reboot condition. Gyroscope has data-ready interrupt configured already
-    // on second run. Pin level may rise before interrupt handler configured.  
-    // Manually check the signal and set the flag for the first sample.
-    if(!(flags.get() & DATA_RDY_FLAG) && (int2.read() == 1)) {
-        flags.set(DATA_RDY_FLAG);
+// Shows target number step and waits for it to be touched.
+void calibration_step(int step) {
+    if (state != AppState::Calibrating) {
+        return;
+    }
+    if (step == 3) {
+        finish_calibration();
+        return;
     }
 
-    InterruptIn int_button(PA_0);
-    int_button.rise(&start_cb);
+    reset_screen();
+    snprintf(display_buf[2],60,"Touch the target");
+    snprintf(display_buf[3],60,"(%d of 3)", step + 1);
+    lcd.DisplayStringAt(0, LINE(8), (uint8_t *)display_buf[2], CENTER_MODE);
+    lcd.DisplayStringAt(0, LINE(9), (uint8_t *)display_buf[3], CENTER_MODE);
+    draw_cal_target(CAL_TARGETS[step]);
+
+    touch.capture_raw([step](TouchPoint raw) {
+        cal_raw[step] = raw;
+        calibration_step(step + 1);
+    });
+}
 
-    /* START: LCD-related */
+// Long press on the idle screen: three-point touch calibration.
+void start_calibration() {
+    disarm_motion_trigger();
+    state = AppState::Calibrating;
+    calibration_step(0);
+}
+
+// Short names of the application states, for the drop log.
+const char *state_name(uint8_t s) {
+    static const char *const names[] = {"idle", "count", "rec", "proc", "result", "cal", "diag"};
+    return (s < sizeof(names) / sizeof(names[0])) ? names[s] : "?";
+}
+
+// Sample loss counters of the last session and its latest loss events.
+void show_diagnostics() {
+    loop.cancel(result_timeout_id);
+    disarm_motion_trigger();
+    state = AppState::Diagnostics;
 
-    // Set up the initial screen display.
     reset_screen();
+    snprintf(display_buf[2],60,"Samples:  %lu", (unsigned long)drops.samples());
+    snprintf(display_buf[3],60,"Lost:     %lu", (unsigned long)drops.lost());
+    snprintf(display_buf[4],60,"Overrun:  %lu", (unsigned long)drops.count(DROP_SENSOR_OVERRUN));
+    snprintf(display_buf[5],60,"FIFO ovf: %lu", (unsigned long)drops.count(DROP_FIFO_OVERFLOW));
+    snprintf(display_buf[6],60,"Queue:    %lu", (unsigned long)drops.count(DROP_QUEUE_FULL));
+    snprintf(display_buf[7],60,"Late:     %lu", (unsigned long)drops.count(DROP_DEADLINE_MISS));
+    snprintf(display_buf[8],60,"Max lat:  %lu us", (unsigned long)drops.max_latency_us());
+    for (int i = 0; i < 7; i++) {
+        lcd.DisplayStringAt(0, LINE(3 + i), (uint8_t *)display_buf[2 + i], LEFT_MODE);
+    }
 
-    /* END: LCD-related */
+    // Latest events, newest at the bottom.
+    static const char *const causes[DROP_CAUSE_COUNT] = {"OVR", "FIFO", "QUE", "LATE"};
+    DropEvent events[DROP_LOG_SIZE];
+    size_t n = drops.events(events, DROP_LOG_SIZE);
+    for (size_t i = 0; i < n; i++) {
+        char line[32];
+        snprintf(line, sizeof(line), "%ss %-4s %u %s", FixedText(events[i].time_us * 1e-6f, 2, 6).c_str(),
+                 events[i].cause < DROP_CAUSE_COUNT ? causes[events[i].cause] : "?",
+                 (unsigned)events[i].lost, state_name(events[i].state));
+        lcd.DisplayStringAt(0, LINE(11 + i), (uint8_t *)line, LEFT_MODE);
+    }
+}
 
-    while(1) {
-        int16_t raw_gx, raw_gy, raw_gz;
-        float gx, gy, gz;
+// Touch gestures: a tap starts a session (like the button) or ends the
+// recording early, a horizontal swipe switches the live view, a swipe up
+// shows the diagnostics, a swipe down on the result screen marks the
+// walk as a stride calibration walk and a long press on the idle screen
+// calibrates the panel.
+void on_touch(GestureEvent event) {
+    switch (event.gesture) {
+    case Gesture::SwipeUp:
+        if (state == AppState::Idle || state == AppState::Result) {
+            show_diagnostics();
+        }
+        break;
 
-        if (button_pressed) {
+    case Gesture::SwipeDown:
+        if (state == AppState::Result) {
+            calibrate_stride();
+        }
+        break;
 
-            // Clear startup text instructions.
-            reset_screen();
+    case Gesture::LongPress:
+        if (state == AppState::Idle) {
+            start_calibration();
+        }
+        break;
 
-            // On initial button press, start countdown and display on LCD.
-            if (!countdown) {
-                countdown = true;
-                countdown_text();
-            }
+    case Gesture::Tap:
+        if (state == AppState::Recording) {
+            loop.cancel(record_end_id);
+            stop_recording();
+        } else {
+            on_button();
+        }
+        break;
+
+    case Gesture::SwipeLeft:
+    case Gesture::SwipeRight:
+        live_view = (live_view == LiveView::Rates) ? LiveView::Orientation : LiveView::Rates;
+        if (state == AppState::Recording) {
+            draw_live_labels();
+            ui_tick();
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+// Walking detected while armed: keep what the FIFO saw before the
+// trigger and go straight to recording.
+void on_motion() {
+    if (state != AppState::Idle || !motion_armed) {
+        return;
+    }
+
+    // A new session starts here; the armed FIFO is its first check.
+    drops.reset();
+    uint8_t fifo_src = L3GD20_GetFIFOStatus();
+    drops.on_fifo(fifo_src, Armed::config().fifo_mode, 0, (uint8_t)AppState::Idle);
+    int pretrigger = L3GD20_FIFOLevel(fifo_src);
+    if (pretrigger > 0) {
+        L3GD20_ReadXYZRaw(&pretrigger_raw[0][0], (uint8_t)pretrigger);
+    }
+    disarm_motion_trigger();
+
+    printf("Motion detected, %d pre-trigger samples.\n", pretrigger);
+    led1 = 1;
+    start_recording(pretrigger);
+}
 
-            // Wait for data to be ready.
-            flags.wait_all(DATA_RDY_FLAG);
-            write_buffer[0] = OUT_X_L | 0x80 | 0x40;
+// Summary of the session just processed.
+SessionSummary make_session_summary(float distance_traveled) {
+    SessionSummary summary;
+    summary.distance_m = distance_traveled;
+    summary.duration_s = record_duration_s;
+    SampleView samples = recording.view();
+    summary.samples = samples.size();
+    uint32_t max_raw = 0;
+    for (int axis = AXIS_X; axis <= AXIS_Z; axis++) {
+        uint32_t m = kernel_max_abs(samples.axis[axis]);
+        max_raw = (m > max_raw) ? m : max_raw;
+    }
+    summary.max_rate = max_raw * SCALING_FACTOR;
+    summary.yaw = quaternion_to_euler(pipeline.get<OrientationUpdate>().quaternion()).yaw;
+    summary.strides = pipeline.get<StrideSink>().detector.strides();
+    return summary;
+}
 
-            // Read in gyro values.
-            spi.transfer(write_buffer, 7, read_buffer, 7, spi_cb);
-            flags.wait_all(SPI_FLAG);
+// Appends a session summary to the EEPROM history.
+void save_session_summary(const SessionSummary &summary) {
+    if (!records_ok) {
+        return;
+    }
 
-            // Real-time pre-processing of raw data.
-            raw_gx = (((uint16_t)read_buffer[2]) << 8) | ((uint16_t)read_buffer[1]);
-            raw_gy = (((uint16_t)read_buffer[4]) << 8) | ((uint16_t)read_buffer[3]);
-            raw_gz = (((uint16_t)read_buffer[6]) << 8) | ((uint16_t)read_buffer[5]);
+    SessionEntry entry = session_entry_make(session_start_s, summary.duration_s, summary.distance_m,
+                                            summary.strides, summary.max_rate);
+    if (history.append(entry)) {
+        session_saved = eeprom_writer.last_write();
+    } else {
+        printf("Failed to save session summary.\n");
+    }
+}
 
-            // Store recorded RAW gyro z-axis values as that's our axis of interest.
-            recorded_gyro_values_z[value_index] = raw_gz;
-            
-            // Increment stored value index.
-            value_index++;
+// Tells the host a new session starts.
+void export_session_start() {
+    SessionStartFrame start;
+    start.odr_hz = GYRO_ODR;
+    start.scale = SCALING_FACTOR;
+    start.live = EXPORT_LIVE;
+    start.filtered = 1;
+    exporter.send(FRAME_SESSION_START, &start, sizeof(start));
+}
 
-            /* START: Display Live rad/s Readings from each Axis on LCD */
+// Sends the session's sample loss accounting (export thread).
+void export_diagnostics() {
+    DiagnosticsFrame diag;
+    diag.samples = drops.samples();
+    diag.lost = drops.lost();
+    diag.max_latency_us = drops.max_latency_us();
+    for (int i = 0; i < DROP_CAUSE_COUNT; i++) {
+        diag.counts[i] = drops.count((DropCause)i);
+    }
+    DropEvent events[DROP_LOG_SIZE] = {};
+    diag.events = (uint8_t)drops.events(events, DROP_LOG_SIZE);
+    memcpy(diag.log, events, sizeof(diag.log));
+    exporter.send(FRAME_DIAGNOSTICS, &diag, sizeof(diag));
+}
 
-            gx = ((float)raw_gx) * SCALING_FACTOR;
-            gy = ((float)raw_gy) * SCALING_FACTOR;
-            gz = ((float)raw_gz) * SCALING_FACTOR; 
+// Replays the recorded samples from index next on, one batch at a time,
+// backing off whenever the TX ring is too full. Ends with the summary.
+void export_replay(size_t next, SessionSummary summary) {
+    SampleView samples = recording.view();
+    while (next < samples.size()) {
+        if (!exporter.has_room_for_batch()) {
+            export_loop.post_in(EXPORT_RETRY_DELAY, [next, summary]() { export_replay(next, summary); });
+            return;
+        }
+        SampleView batch = samples.subview(next, FRAME_SAMPLES_PER_FRAME);
+        for (size_t k = 0; k < batch.size(); k++) {
+            int16_t raw[3] = {batch.axis[AXIS_X][k], batch.axis[AXIS_Y][k], batch.axis[AXIS_Z][k]};
+            exporter.add_sample(batch.timestamps_us[k], raw);
+        }
+        next += batch.size();
+        exporter.flush_samples();
+    }
+    export_diagnostics();
+    exporter.send(FRAME_SESSION_END, &summary, sizeof(summary));
+}
 
-            snprintf(display_buf[5],60,"X-AXIS: ");
-            snprintf(display_buf[6],60,"Y-AXIS: ");
-            snprintf(display_buf[7],60,"Z-AXIS: ");
+// Sends the rest of the session to the host (export thread).
+void export_session(const SessionSummary &summary) {
+#if EXPORT_LIVE
+    export_drain();
+    exporter.flush_samples();
+    export_diagnostics();
+    exporter.send(FRAME_SESSION_END, &summary, sizeof(summary));
+#else
+    export_session_start();
+    export_replay(0, summary);
+#endif
+}
 
-            lcd.DisplayStringAt(0, LINE(5), (uint8_t *)display_buf[5], LEFT_MODE);
-            lcd.DisplayStringAt(0, LINE(6), (uint8_t *)display_buf[6], LEFT_MODE);
-            lcd.DisplayStringAt(0, LINE(7), (uint8_t *)display_buf[7], LEFT_MODE);
+// Processes data (i.e., convert measured data to forward movement velocity and then distance).
+void processing() {
+    // The distance comes from the stride model, fed sample by sample by the
+    // processing pipeline while recording (see stride_model.h).
+    const StrideDetector &stride = pipeline.get<StrideSink>().detector;
+    float distance_traveled = stride.distance_m();
+    stride_cal_taken = false;
+
+    // Angle swept per SUMMARY_WINDOW, by the trapezoidal rule:
+    // theta = sum over samples of (delta_time_j / 2) * (z_j + z_j+1)
+    // Note, since we are attaching the gyroscope to one leg only and we have two legs,
+    // while the other leg is moving forward, the leg that has the gyroscope will be moving slightly
+    // backwards resulting in negative values. However, we need to count the absolute value of these
+    // negative values to account for the total distance traveled. Otherwise, we will only get half. 
+    //
+    // delta_time_j is the real spacing between the data-ready time-stamps of
+    // consecutive samples, so jitter in the sample times does not bias the result.
+    //
+    // The windows were aggregated by the processing pipeline as the samples
+    // came in (WindowSink). The window still open when capture ended is
+    // left out.
+    uint32_t windows = window_count.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < windows; i++) {
+        printf("Angle swept: %s rad\n", FixedText(window_angle[i], 6).c_str());
+    }
 
-            snprintf(display_buf[2],60,"%4.5f rad/s", gx);
-            snprintf(display_buf[3],60,"%4.5f rad/s", gy);
-            snprintf(display_buf[4],60,"%4.5f rad/s", gz);
+    // Spectrum of the last block analyzed while recording.
+    const SpectrumResult<SPECTRUM_SIZE, SPECTRUM_BANDS> &zs = spectrum_result[AXIS_Z];
+    printf("Spectrum (Z): peak %s Hz, bands %s%% / %s%% / %s%%; %lu avg, %lu max cycles per block.\n",
+           FixedText(zs.peak_hz, 2).c_str(), FixedText(100.0f * zs.band_share(0), 0).c_str(),
+           FixedText(100.0f * zs.band_share(1), 0).c_str(), FixedText(100.0f * zs.band_share(2), 0).c_str(),
+           (unsigned long)spectrum_cycles.average(), (unsigned long)spectrum_cycles.max);
+
+    printf("Strides: %lu at %s/s, %s rad swept; radius %s m, cadence gain %s m s.\n",
+           (unsigned long)stride.strides(), FixedText(stride.cadence(), 2).c_str(),
+           FixedText(stride.sum_theta(), 6).c_str(), FixedText(stride.parameters().radius_m, 3).c_str(),
+           FixedText(stride.parameters().cadence_gain, 3).c_str());
+
+    // The stride model's distance over the whole recording; the LCD shows it below.
+    printf("Total Distance Traveled: %s meters.\n", FixedText(distance_traveled, 6).c_str());
+
+    // Final 3D orientation relative to the start of the recording.
+    const OrientationUpdate &orientation = pipeline.get<OrientationUpdate>();
+    EulerAngles euler = quaternion_to_euler(orientation.quaternion());
+    printf("Orientation: roll %s, pitch %s, yaw %s rad.\n", FixedText(euler.roll, 6).c_str(),
+           FixedText(euler.pitch, 6).c_str(), FixedText(euler.yaw, 6).c_str());
+    printf("Orientation update: %lu avg, %lu max cycles over %lu samples.\n",
+           (unsigned long)orientation.cycles().average(),
+           (unsigned long)orientation.cycles().max,
+           (unsigned long)orientation.cycles().count);
+    const CycleStats &filter_cycles = pipeline.get<GaitFilterStage>().cycles();
+    printf("Gyro filter: %lu avg, %lu max cycles per sample.\n",
+           (unsigned long)filter_cycles.average(), (unsigned long)filter_cycles.max);
+    total_distance_traveled = distance_traveled;
+    SessionSummary summary = make_session_summary(distance_traveled);
+    save_session_summary(summary);
+    export_loop.post([summary]() { export_session(summary); });
+    reset_screen();
+    snprintf(display_buf[2],60,"Total Distance:");
+    snprintf(display_buf[4],60, "Strides: %lu", (unsigned long)stride.strides());
+    snprintf(display_buf[5],60, "Swipe down: %d m walk", (int)STRIDE_CAL_DISTANCE_M);
+    lcd.DisplayStringAt(0, LINE(5), (uint8_t *)display_buf[2], LEFT_MODE);
+    show_distance(distance_traveled);
+    lcd.DisplayStringAt(0, LINE(9), (uint8_t *)display_buf[4], LEFT_MODE);
+    lcd.DisplayStringAt(0, LINE(18), (uint8_t *)display_buf[5], LEFT_MODE);
+
+    state = AppState::Result;
+    result_timeout_id = loop.post_in(RESULT_HOLD_TIME, enter_idle);
+}
 
-            lcd.DisplayStringAt(0, LINE(5), (uint8_t *)display_buf[2], RIGHT_MODE);
-            lcd.DisplayStringAt(0, LINE(6), (uint8_t *)display_buf[3], RIGHT_MODE);
-            lcd.DisplayStringAt(0, LINE(7), (uint8_t *)display_buf[4], RIGHT_MODE);
+// Distance on the result screen: big digits from LINE(6), then the unit.
+void show_distance(float meters) {
+    format_fit(display_buf[3], DISTANCE_CELLS, meters, 2);
+    distance_readout.invalidate();
+    distance_readout.set(display_buf[3]);
+    lcd.DisplayStringAt(GRAPH_PADDING + distance_readout.width() + GRAPH_PADDING, LINE(6) + BIG_DIGIT_HEIGHT - LINE(1),
+                        (uint8_t *)"m", LEFT_MODE);
+}
+
+// The walk just recorded was STRIDE_CAL_DISTANCE_M long: add it to the
+// stride calibration, refit and store.
+void calibrate_stride() {
+    const StrideDetector &stride = pipeline.get<StrideSink>().detector;
+    if (stride_cal_taken) {
+        return;
+    }
+    if (stride.strides() < STRIDE_CAL_MIN_STRIDES) {
+        lcd.ClearStringLine(9);
+        lcd.DisplayStringAt(0, LINE(9), (uint8_t *)"Too few strides", LEFT_MODE);
+        return;
+    }
 
-            thread_sleep_for(100);
-            
-            snprintf(display_buf[8],60,"            ");
-            lcd.DisplayStringAt(0, LINE(5), (uint8_t *)display_buf[8], RIGHT_MODE);
-            lcd.DisplayStringAt(0, LINE(6), (uint8_t *)display_buf[8], RIGHT_MODE);
-            lcd.DisplayStringAt(0, LINE(7), (uint8_t *)display_buf[8], RIGHT_MODE);
+    stride_calibration_add(stride_cal, stride.sum_theta(), stride.sum_ftheta(), STRIDE_CAL_DISTANCE_M);
+    stride_cal_taken = true;
+    StrideParams params = stride_calibration_solve(stride_cal, STRIDE_DEFAULTS);
+    pipeline.get<StrideSink>().detector.set_params(params);
+    printf("Stride calibration (%lu walks): radius %s m, cadence gain %s m s.\n",
+           (unsigned long)stride_cal.walks, FixedText(params.radius_m, 3).c_str(),
+           FixedText(params.cadence_gain, 3).c_str());
+    if (records_ok && !records.append(RECORD_STRIDE_CALIBRATION, stride_cal)) {
+        printf("Failed to save stride calibration.\n");
+    }
 
-            /* END: Display Live rad/s Readings from each Axis on LCD */
-        
-        } else {
+    // Same walk, new model.
+    show_distance(stride.distance_m());
+    snprintf(display_buf[6],60, "Calibrated (%lu)", (unsigned long)stride_cal.walks);
+    lcd.ClearStringLine(9);
+    lcd.DisplayStringAt(0, LINE(9), (uint8_t *)display_buf[6], LEFT_MODE);
+}
+
+// Time limit reached: stop capturing and hand the samples to processing.
+void stop_recording() {
+    if (state != AppState::Recording) {
+        return;
+    }
+
+    state = AppState::Processing;
+    record_end_id = 0;
+    loop.cancel(ui_tick_id);
+
+    float time_elapsed = t.read();
+    t.stop();
+    record_duration_s = time_elapsed;
+    printf("Time Elapsed: %s seconds.\n", FixedText(time_elapsed, 6).c_str());
+
+    // Acquisition has to keep up whatever the UI and export are doing.
+    printf("Acquisition: %lu samples, max latency %lu us, %lu late, %lu lost "
+           "(%lu overruns, %lu FIFO overflows, %lu queue full).\n",
+           (unsigned long)drops.samples(), (unsigned long)drops.max_latency_us(),
+           (unsigned long)drops.count(DROP_DEADLINE_MISS), (unsigned long)drops.lost(),
+           (unsigned long)drops.count(DROP_SENSOR_OVERRUN), (unsigned long)drops.count(DROP_FIFO_OVERFLOW),
+           (unsigned long)drops.count(DROP_QUEUE_FULL));
+    printf("Queues (peak/size, drops): drdy %lu/%lu %lu, samples %lu/%lu %lu, export %lu/%lu %lu.\n",
+           (unsigned long)drdy_queue.peak(), (unsigned long)drdy_queue.capacity(), (unsigned long)drdy_queue.drops(),
+           (unsigned long)sample_queue.peak(), (unsigned long)sample_queue.capacity(), (unsigned long)sample_queue.drops(),
+           (unsigned long)export_queue.peak(), (unsigned long)export_queue.capacity(), (unsigned long)export_queue.drops());
+    threads.report();
+    led1 = 0;
+
+    reset_screen();
+    show_label(processing_label, 5, "Processing..");
+    loop.post_in(1s, processing);
+}
+
+int main() {
+    cycle_counter_init();
+
+    /* START: SPI Initialization and Setup */
 
-            // Keep displaying startup text.
-            startup_text();
-           
+    // Chip select, interrupt pins and SPI5 (shared with the LCD, so
+    // already running once the LCD is up).
+    GYRO_IO_Init();
+
+    /* END: SPI Initialization and Setup */
+
+    // Establish communicating device (read WHOAMI register).
+    uint8_t gyro_id = L3GD20_ReadID();
+    printf("Gyroscope Identifier (WHOAMI) = 0x%X\n", gyro_id);
+
+    /* START: Persistent Storage */
+
+    // Restore the last session and the sensor setup stored with it.
+    SensorProfile stored;
+    bool have_profile = false;
+    eeprom_writer.start();
+    records_ok = eeprom.init() && records.mount() && history.mount();
+    if (records_ok) {
+        SessionEntry last;
+        if (history.latest(&last, 1) == 1) {
+            total_distance_traveled = last.distance_dm * 0.1f;
+            printf("Last session: %s meters in %s seconds.\n", FixedText(last.distance_dm * 0.1f, 1).c_str(),
+                   FixedText(last.duration_ds * 0.1f, 1).c_str());
+        }
+
+        // Without a backup battery the RTC restarts from zero; carry on
+        // from the last session so the history stays in order.
+        if ((uint32_t)time(NULL) < history.last_end_s()) {
+            set_time(history.last_end_s());
         }
+        HistoryTotals all = history.totals();
+        HistoryTotals week = history.last_days((uint32_t)time(NULL) / HISTORY_SECONDS_PER_DAY, 7);
+        printf("History: %lu sessions, %s m, %lu strides; last 7 days %lu sessions, %s m.\n",
+               (unsigned long)all.sessions, FixedText(all.distance_m, 1).c_str(), (unsigned long)all.strides,
+               (unsigned long)week.sessions, FixedText(week.distance_m, 1).c_str());
+        have_profile = records.latest(RECORD_SENSOR_PROFILE, stored);
+        if (records.latest(RECORD_STRIDE_CALIBRATION, stride_cal)) {
+            pipeline.get<StrideSink>().detector.set_params(stride_calibration_solve(stride_cal, STRIDE_DEFAULTS));
+        }
+    } else {
+        printf("EEPROM not found, sessions will not be saved.\n");
+    }
 
-        // Record values until time limit has been reached. 
-        // Then, wait for user's button press again.
-        if (button_pressed) {
-            float time_elapsed = t.read();
+    /* END: Persistent Storage */
+
+    /* START: SPI Clock Tuning */
+
+    // Reuse the stored clock if it still checks out, else search again.
+    GyroSpiBus gyro_bus(gyro_id);
+    uint16_t default_div = GYRO_IO_GetClockDiv();
+    float read_us_before = GyroSpiBus::sample_read_us();
+    uint16_t spi_div;
+    if (have_profile && stored.spi_clock_div != 0 && spi_verify(gyro_bus, stored.spi_clock_div)) {
+        spi_div = stored.spi_clock_div;
+    } else {
+        SpiTuneResult tune = spi_tune(gyro_bus, GYRO_SPI_DIVS, sizeof(GYRO_SPI_DIVS) / sizeof(GYRO_SPI_DIVS[0]));
+        if (!tune.ok) {
+            // Not even the slowest clock passed: stay on the BSP default.
+            gyro_bus.set_clock_div(default_div);
+            tune.div = default_div;
+            printf("Gyro SPI self-test failed, keeping the default clock.\n");
+        }
+        spi_div = tune.div;
+    }
+    printf("Gyro SPI: %lu -> %lu Hz, sample read %s -> %s us.\n",
+           (unsigned long)GyroSpiBus::clock_hz(default_div), (unsigned long)GyroSpiBus::clock_hz(spi_div),
+           FixedText(read_us_before, 1).c_str(), FixedText(GyroSpiBus::sample_read_us(), 1).c_str());
 
-            // Obtain time-stamps for 0.5 second interval capture.
-            if (time_elapsed >= curr_interval) {
-                value_index_track[vit_count] = value_index - 1;
-                vit_count++;
-                curr_interval += 0.5;
-            }
+    /* END: SPI Clock Tuning */
 
-            // If 20 seconds have elapsed, process data and reset.
-            if (time_elapsed >= RECORD_TIME) {
-                printf("Time Elapsed: %f seconds.\n", time_elapsed);
-                button_pressed = false;
-                countdown = false;
-                led1 = 0;
-                value_index = 0;
-                vit_count = 0;
-                curr_interval = 0.5;
-                reset_screen();
-                t.stop();
-                t.reset();
-
-                processing();
-                reset_screen();
-            }
+    /* START: Write configurations to control registers. */
+
+    // Seed the driver's register copy, then write through it so later
+    // updates and sample decoding never have to read the registers back.
+    L3GD20_SyncState();
+    Acquisition::apply();
+    printf("Gyro high-pass cutoff: %s Hz.\n",
+           FixedText(gyro_hpf_cutoff_hz(Acquisition::config().odr,
+                                        gyro_hpf_select(Acquisition::config().odr,
+                                                        Acquisition::config().hpf_cutoff_hz)), 3).c_str());
+
+    /* END: Write configurations to control registers. */
+
+    // Record the sensor setup the sessions run with.
+    if (records_ok) {
+        SensorProfile profile = {};
+        memcpy(profile.ctrl_reg, L3GD20_GetState()->CtrlReg, sizeof(profile.ctrl_reg));
+        profile.spi_clock_div = (uint8_t)spi_div;
+        profile.scale = SCALING_FACTOR;
+        profile.odr_hz = GYRO_ODR;
+
+        if (!have_profile || memcmp(&stored, &profile, sizeof(profile)) != 0) {
+            records.append(RECORD_SENSOR_PROFILE, profile);
         }
     }
 
+    /* START: Touch Screen */
+
+    // Touch reads share I2C3 with the EEPROM, so they wait for queued
+    // record writes to land.
+    if (touch.init(on_touch)) {
+        touch.set_bus_busy([]() { return eeprom_writer.busy(); });
+
+        // Boards not calibrated yet keep the BSP mapping.
+        TouchCalibration cal;
+        if (records_ok && records.latest(RECORD_TOUCH_CALIBRATION, cal) && touch_calibration_valid(cal)) {
+            touch.set_calibration(cal);
+        }
+    } else {
+        printf("Touch screen not found.\n");
+    }
+
+    /* END: Touch Screen */
+
+    /* START: Threads */
+
+    // The UI event loop (this thread) runs below everything that handles
+    // samples, export below it.
+    osThreadSetPriority(ThisThread::get_id(), osPriorityBelowNormal);
+    acq_thread.start(acquisition_main);
+    proc_thread.start(processing_main);
+    export_thread.start(callback(&export_loop, &EventLoop::run));
+
+    threads.add("acq", acq_thread.get_id(), acq_load);
+    threads.add("proc", proc_thread.get_id(), proc_load);
+    threads.add("ui", ThisThread::get_id(), loop.load());
+    threads.add("export", export_thread.get_id(), export_loop.load());
+    loop.post_every(1s, []() { threads.sample(); });
+
+    /* END: Threads */
+
+    /* START: Interrupt Initialization and Setup */
+
+    // Set interrupt 2 to trigger routine on rising edge.
+    // (A data-ready line that is already high on reboot is
+    //  handled when recording starts.)
+    int2.rise(&data_rdy_cb);
+
+    int_button.rise(&start_cb);
+
+    int1.rise(&motion_cb);
+
+    /* END: Interrupt Initialization and Setup */
+
+    /* START: LCD-related */
+
+    // Set up the initial screen display.
+    setup_background_layer();
+    render_screen_assets();
+    enter_idle();
+
+    /* END: LCD-related */
+
+    // Sleep until the next event for the lifetime of the device.
+    loop.run();
+
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,178 @@
+/**
+ * @file number_format.cpp
+ *
+ * @brief Number to text without the printf float path.
+ *
+ */
+
+#include "number_format.h"
+#include <string.h>
+
+static const uint32_t POW10[FORMAT_MAX_DECIMALS + 1] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+
+// Digits of v, least significant first. Returns how many (at least one).
+static int reversed_digits(char *digits, uint32_t v) {
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+    return n;
+}
+
+// Copies text and a terminator if it fits in size. Returns the length or 0.
+static size_t copy_text(char *out, size_t size, const char *text) {
+    size_t len = strlen(text);
+    if (size < len + 1) {
+        return 0;
+    }
+    memcpy(out, text, len + 1);
+    return len;
+}
+
+size_t format_uint(char *out, size_t size, uint32_t value) {
+    char digits[10];
+    int n = reversed_digits(digits, value);
+    if (size < (size_t)n + 1) {
+        if (size > 0) {
+            out[0] = '\0';
+        }
+        return 0;
+    }
+    for (int k = 0; k < n; k++) {
+        out[k] = digits[n - 1 - k];
+    }
+    out[n] = '\0';
+    return (size_t)n;
+}
+
+size_t format_fixed(char *out, size_t size, float value, int decimals) {
+    if (size > 0) {
+        out[0] = '\0';
+    }
+    if (decimals < 0) {
+        decimals = 0;
+    } else if (decimals > FORMAT_MAX_DECIMALS) {
+        decimals = FORMAT_MAX_DECIMALS;
+    }
+
+    // value = mantissa * 2^-shift.
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    bool negative = (bits >> 31) != 0;
+    int exponent = (int)((bits >> 23) & 0xFF);
+    uint32_t mantissa = bits & 0x7FFFFF;
+    if (exponent == 0xFF) {
+        return copy_text(out, size, (mantissa != 0) ? (negative ? "-nan" : "nan") : (negative ? "-inf" : "inf"));
+    }
+    if (exponent != 0) {
+        mantissa |= 0x800000;
+    } else {
+        exponent = 1;                       // Subnormal.
+    }
+    int shift = 150 - exponent;
+    if (shift <= -9) {                      // 2^32 or more.
+        return 0;
+    }
+
+    // Integer part, and the fraction times 10^decimals: rem / 2^shift is
+    // below one and has at most 24 significant bits, so the product is
+    // exact in 64 bits. At 64 bits of shift or more it is below 2^-40,
+    // too small to round up to the last decimal.
+    uint32_t whole = 0;
+    uint32_t frac = 0;
+    bool round_up = false;
+    if (shift <= 0) {
+        whole = mantissa << -shift;
+    } else if (shift < 64) {
+        uint64_t rem = mantissa;
+        if (shift < 32) {
+            whole = mantissa >> shift;
+            rem = mantissa - ((uint64_t)whole << shift);
+        }
+        uint64_t scaled = rem * POW10[decimals];
+        uint64_t half = (uint64_t)1 << (shift - 1);
+        uint64_t below = scaled & ((half << 1) - 1);
+        frac = (uint32_t)(scaled >> shift);
+        uint32_t last = (decimals > 0) ? frac : whole;
+        round_up = below > half || (below == half && (last & 1) != 0);
+    }
+    if (round_up) {
+        frac++;
+        if (frac >= POW10[decimals]) {
+            frac = 0;
+            if (whole == UINT32_MAX) {
+                return 0;
+            }
+            whole++;
+        }
+    }
+
+    // Fraction digits (padded with zeros), then the integer part.
+    char digits[20];
+    int n = 0;
+    for (int k = 0; k < decimals; k++) {
+        digits[n++] = (char)('0' + frac % 10);
+        frac /= 10;
+    }
+    n += reversed_digits(digits + n, whole);
+
+    size_t len = (size_t)n + (negative ? 1 : 0) + (decimals > 0 ? 1 : 0);
+    if (size < len + 1) {
+        return 0;
+    }
+    char *p = out;
+    if (negative) {
+        *p++ = '-';
+    }
+    for (int k = n - 1; k >= 0; k--) {
+        *p++ = digits[k];
+        if (k == decimals && decimals > 0) {
+            *p++ = '.';
+        }
+    }
+    *p = '\0';
+    return len;
+}
+
+size_t format_field(char *out, size_t size, float value, int width, int decimals) {
+    bool left = width < 0;
+    size_t field = (size_t)(left ? -width : width);
+    size_t len = format_fixed(out, size, value, decimals);
+    if (len == 0 || len >= field) {
+        return len;
+    }
+    if (size < field + 1) {
+        out[0] = '\0';
+        return 0;
+    }
+    size_t pad = field - len;
+    if (left) {
+        memset(out + len, ' ', pad);
+    } else {
+        memmove(out + pad, out, len);
+        memset(out, ' ', pad);
+    }
+    out[field] = '\0';
+    return field;
+}
+
+void format_fit(char *out, int width, float value, int max_decimals) {
+    char text[16];
+    size_t len = 0;
+    for (int d = max_decimals; d >= 0 && len == 0; d--) {
+        len = format_fixed(text, sizeof(text), value, d);
+        if (len > (size_t)width) {
+            len = 0;
+        }
+    }
+
+    int pad = (len == 0) ? width : width - (int)len;
+    for (int k = 0; k < pad; k++) {
+        out[k] = (len == 0) ? '-' : ' ';
+    }
+    for (size_t k = 0; k < len; k++) {
+        out[pad + k] = text[k];
+    }
+    out[width] = '\0';
+}
@@ -0,0 +1,67 @@
+/**
+ * @file number_format.h
+ *
+ * @brief Number to text without the printf float path.
+ *
+ * Writes what printf's "%.*f" and "%*.*f" write for a float, character
+ * for character, so the image can be built without minimal-printf's
+ * floating point support. The float's mantissa and exponent are taken
+ * apart and the digits worked out with integer arithmetic: the integer
+ * part in 32 bits, the fraction as an exact 64-bit product rounded half
+ * to even like printf. No allocation, no locale, no vsnprintf pass.
+ *
+ * Magnitudes of 2^32 and over are reported as not fitting.
+ *
+ */
+
+#ifndef NUMBER_FORMAT_H
+#define NUMBER_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Most decimals format_fixed() writes.
+#define FORMAT_MAX_DECIMALS 6
+
+// Writes value with decimals (0 to FORMAT_MAX_DECIMALS) digits after the
+// point, and a terminator, as "%.*f" does: "-" for negative values
+// (-0 included), "inf" and "nan" for those. Returns the length, or 0 (out
+// left empty) if it needs more than size - 1 chars or the magnitude is
+// 2^32 or more.
+size_t format_fixed(char *out, size_t size, float value, int decimals);
+
+// The same padded with spaces to at least |width| chars, as "%*.*f":
+// right aligned, or left aligned for a negative width.
+size_t format_field(char *out, size_t size, float value, int width, int decimals);
+
+// Writes exactly width chars, right aligned, and a terminator: value with
+// as many decimals as fit, up to max_decimals. Dashes if even the
+// integer part does not fit.
+void format_fit(char *out, int width, float value, int max_decimals);
+
+// Writes value in decimal and a terminator. Returns the length, or 0 if
+// it does not fit.
+size_t format_uint(char *out, size_t size, uint32_t value);
+
+// A value as text for a "%s" in printf, in place of "%*.*f":
+//
+//     printf("%s m\n", FixedText(distance, 2).c_str());
+//
+// The text lives on the caller's stack until the end of the statement.
+// "?" if the value does not fit.
+class FixedText {
+public:
+    FixedText(float value, int decimals, int width = 0) {
+        if (format_field(text, sizeof(text), value, width, decimals) == 0) {
+            text[0] = '?';
+            text[1] = '\0';
+        }
+    }
+
+    const char *c_str() const { return text; }
+
+private:
+    char text[24];
+};
+
+#endif // NUMBER_FORMAT_H
@@ -0,0 +1,89 @@
+/**
+ * @file numeric_display.cpp
+ *
+ * @brief Numeric readouts drawn from a pre-expanded digit atlas.
+ *
+ */
+
+#include "numeric_display.h"
+#include <string.h>
+
+// Segments a to g (bits 0 to 6) lit for '0' to '9'.
+static const uint8_t SEGMENTS[10] = {0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F};
+
+#define SEGMENT_G 0x40
+
+const ScreenAsset &DigitAtlas::glyph(char c) const {
+    const char *p = (c != '\0') ? strchr(DIGIT_ATLAS_CHARS, c) : nullptr;
+    return glyphs[p ? p - DIGIT_ATLAS_CHARS : DIGIT_ATLAS_SIZE - 1];
+}
+
+void seven_segment_draw(LCD_DISCO_F429ZI &lcd, char c, uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+                        uint16_t thick) {
+    // The digit takes the cell less one segment width of spacing on the right.
+    uint16_t dw = (w > 3 * thick) ? w - thick : w;
+    uint16_t mid = y + (h - thick) / 2;
+    uint16_t bar = (dw > 2 * thick) ? dw - 2 * thick : 1;
+    uint16_t upper = (mid > y + thick) ? mid - y - thick : 1;
+    uint16_t lower = (y + h - thick > mid + thick) ? y + h - thick - (mid + thick) : 1;
+
+    uint8_t lit;
+    if (c >= '0' && c <= '9') {
+        lit = SEGMENTS[c - '0'];
+    } else if (c == '-') {
+        lit = SEGMENT_G;
+    } else {
+        if (c == '.') {
+            lcd.FillRect(x + (dw - thick) / 2, y + h - thick, thick, thick);
+        }
+        return;
+    }
+
+    // a to g: top, upper right, lower right, bottom, lower left, upper left, middle.
+    const uint16_t rect[7][4] = {
+        {(uint16_t)(x + thick), y, bar, thick},
+        {(uint16_t)(x + dw - thick), (uint16_t)(y + thick), thick, upper},
+        {(uint16_t)(x + dw - thick), (uint16_t)(mid + thick), thick, lower},
+        {(uint16_t)(x + thick), (uint16_t)(y + h - thick), bar, thick},
+        {x, (uint16_t)(mid + thick), thick, lower},
+        {x, (uint16_t)(y + thick), thick, upper},
+        {(uint16_t)(x + thick), mid, bar, thick},
+    };
+    for (int s = 0; s < 7; s++) {
+        if (lit & (1 << s)) {
+            lcd.FillRect(rect[s][0], rect[s][1], rect[s][2], rect[s][3]);
+        }
+    }
+}
+
+NumericReadout::NumericReadout(ScreenAssets &assets, const DigitAtlas &atlas, uint32_t layer, uint16_t x,
+                               uint16_t y, int cells)
+    : assets(assets), atlas(atlas), layer(layer), x(x), y(y),
+      count((cells > READOUT_MAX_CELLS) ? READOUT_MAX_CELLS : cells) {
+    invalidate();
+}
+
+void NumericReadout::invalidate() {
+    memset(shown, 0, sizeof(shown));
+}
+
+int NumericReadout::set(const char *text) {
+    if (!atlas.ready()) {
+        BSP_LCD_DisplayStringAt(x, y, (uint8_t *)text, LEFT_MODE);
+        return -1;
+    }
+    int drawn = 0;
+    bool ended = false;
+    for (int k = 0; k < count; k++) {
+        ended = ended || text[k] == '\0';
+        char c = ended ? ' ' : text[k];
+        if (c == shown[k]) {
+            continue;
+        }
+        if (assets.show(layer, atlas.glyph(c), x + k * atlas.glyph_width(), y)) {
+            shown[k] = c;
+            drawn++;
+        }
+    }
+    return drawn;
+}
@@ -0,0 +1,101 @@
+/**
+ * @file numeric_display.h
+ *
+ * @brief Numeric readouts drawn from a pre-expanded digit atlas.
+ *
+ * A DigitAtlas holds one ARGB8888 glyph per character of
+ * DIGIT_ATLAS_CHARS, all the same size, rendered once at boot into the
+ * screen asset cache (screen_assets.h): from an LCD font, or as seven-
+ * segment digits of any size built from filled rectangles. A
+ * NumericReadout is a fixed row of cells on screen showing text from one
+ * atlas. set() compares the new text with what the cells show and copies
+ * only the glyphs that changed, one DMA2D transfer each, so a rate that
+ * moves in its last digit costs one small copy instead of redrawing the
+ * line pixel by pixel.
+ *
+ * Characters outside the atlas show as blank cells.
+ *
+ */
+
+#ifndef NUMERIC_DISPLAY_H
+#define NUMERIC_DISPLAY_H
+
+#include <stdint.h>
+#include "screen_assets.h"
+
+#define DIGIT_ATLAS_CHARS "0123456789-. "
+#define DIGIT_ATLAS_SIZE 13
+
+// Longest readout, in cells.
+#define READOUT_MAX_CELLS 12
+
+class DigitAtlas {
+public:
+    // Renders and captures every glyph in a w x h cell at (x, y) of the
+    // frame being rendered (ScreenAssets::begin_render()), drawing each
+    // with draw(c, x, y) after clearing the cell to the back colour.
+    // Returns false if any glyph did not fit in the cache.
+    template <typename F>
+    bool render(ScreenAssets &assets, LCD_DISCO_F429ZI &lcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+                F draw) {
+        bool ok = true;
+        width = w;
+        height = h;
+        for (int k = 0; k < DIGIT_ATLAS_SIZE; k++) {
+            uint32_t text = lcd.GetTextColor();
+            lcd.SetTextColor(lcd.GetBackColor());
+            lcd.FillRect(x, y, w, h);
+            lcd.SetTextColor(text);
+            draw(DIGIT_ATLAS_CHARS[k], x, y);
+            ok = assets.capture(glyphs[k], x, y, w, h) && ok;
+        }
+        return ok;
+    }
+
+    // Glyph of c, or of a blank if c is not in the atlas.
+    const ScreenAsset &glyph(char c) const;
+
+    bool ready() const { return glyphs[DIGIT_ATLAS_SIZE - 1].valid(); }
+    uint16_t glyph_width() const { return width; }
+    uint16_t glyph_height() const { return height; }
+
+private:
+    ScreenAsset glyphs[DIGIT_ATLAS_SIZE];
+    uint16_t width = 0;
+    uint16_t height = 0;
+};
+
+// Draws c ('0' to '9', '-', '.'; anything else stays blank) as a seven-
+// segment digit in a w x h cell, segments thick pixels wide, in the text
+// colour.
+void seven_segment_draw(LCD_DISCO_F429ZI &lcd, char c, uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+                        uint16_t thick);
+
+class NumericReadout {
+public:
+    NumericReadout(ScreenAssets &assets, const DigitAtlas &atlas, uint32_t layer, uint16_t x, uint16_t y,
+                   int cells);
+
+    // The screen under the readout was redrawn: the next set() draws
+    // every cell.
+    void invalidate();
+
+    // Shows text, one char per cell (cut or padded with blanks on the
+    // right). Returns the cells drawn. Without an atlas the text is drawn
+    // in the current font instead, and -1 returned.
+    int set(const char *text);
+
+    int cells() const { return count; }
+    uint16_t width() const { return (uint16_t)(count * atlas.glyph_width()); }
+
+private:
+    ScreenAssets &assets;
+    const DigitAtlas &atlas;
+    uint32_t layer;
+    uint16_t x;
+    uint16_t y;
+    int count;
+    char shown[READOUT_MAX_CELLS];  // 0: unknown.
+};
+
+#endif // NUMERIC_DISPLAY_H
@@ -0,0 +1,158 @@
+/**
+ * @file orientation.cpp
+ *
+ * @brief Quaternion orientation integration of 3-axis gyroscope rates.
+ *
+ */
+
+#include "orientation.h"
+#include <math.h>
+
+// Significant bits of the fixed-point half-angle factor. raw * dt_us is
+// below 2^32 in magnitude (|raw| <= 2^15, dt_us <= ORIENTATION_MAX_DT_US <
+// 2^17), so multiplying it by a factor below 2^31 stays inside int64.
+#define HALF_SCALE_BITS 31
+
+#define Q30_ONE (1L << 30)
+
+EulerAngles quaternion_to_euler(const Quaternion &q) {
+    EulerAngles e;
+    e.roll = atan2f(2.0f * (q.w * q.x + q.y * q.z), 1.0f - 2.0f * (q.x * q.x + q.y * q.y));
+
+    float sinp = 2.0f * (q.w * q.y - q.z * q.x);
+    if (sinp >= 1.0f) {
+        e.pitch = (float)M_PI_2;
+    } else if (sinp <= -1.0f) {
+        e.pitch = -(float)M_PI_2;
+    } else {
+        e.pitch = asinf(sinp);
+    }
+
+    e.yaw = atan2f(2.0f * (q.w * q.z + q.x * q.y), 1.0f - 2.0f * (q.y * q.y + q.z * q.z));
+    return e;
+}
+
+float quaternion_angle(const Quaternion &q) {
+    float w = fabsf(q.w);
+    return 2.0f * acosf(w > 1.0f ? 1.0f : w);
+}
+
+/* START: Float Integrator */
+
+OrientationIntegrator::OrientationIntegrator(float scale)
+    : half_scale(0.5f * scale * 1e-6f) {
+    reset();
+}
+
+void OrientationIntegrator::reset() {
+    q.w = 1.0f;
+    q.x = 0.0f;
+    q.y = 0.0f;
+    q.z = 0.0f;
+}
+
+void OrientationIntegrator::update(const int16_t raw[3], uint32_t dt_us) {
+    if (dt_us > ORIENTATION_MAX_DT_US) {
+        dt_us = ORIENTATION_MAX_DT_US;
+    }
+
+    // Half of the angle swept about each axis during this sample.
+    float k = half_scale * (float)dt_us;
+    float hx = raw[0] * k;
+    float hy = raw[1] * k;
+    float hz = raw[2] * k;
+
+    // Rotation quaternion (cos|h|, sin|h| * h/|h|), to second order in |h|.
+    float hh = hx * hx + hy * hy + hz * hz;
+    float c = 1.0f - 0.5f * hh;
+    float s = 1.0f - hh * (1.0f / 6.0f);
+    hx *= s;
+    hy *= s;
+    hz *= s;
+
+    // q = q * (c, h)
+    float w = c * q.w - q.x * hx - q.y * hy - q.z * hz;
+    float x = c * q.x + q.w * hx + q.y * hz - q.z * hy;
+    float y = c * q.y + q.w * hy - q.x * hz + q.z * hx;
+    float z = c * q.z + q.w * hz + q.x * hy - q.y * hx;
+
+    // The norm only drifts by rounding error, so one Newton step of
+    // 1/sqrt(n) around 1 is enough to renormalize.
+    float n = w * w + x * x + y * y + z * z;
+    float r = 1.5f - 0.5f * n;
+    q.w = w * r;
+    q.x = x * r;
+    q.y = y * r;
+    q.z = z * r;
+}
+
+/* END: Float Integrator */
+
+/* START: Fixed-Point Integrator */
+
+// Q2.30 multiply.
+static inline int32_t q30_mul(int32_t a, int32_t b) {
+    return (int32_t)(((int64_t)a * b) >> 30);
+}
+
+OrientationIntegratorQ30::OrientationIntegratorQ30(float scale) {
+    // 0.5 * scale * 1e-6 = m * 2^e with m in [0.5, 1): keep the top
+    // HALF_SCALE_BITS bits of m, so the factor is good to ~1e-9 whatever
+    // the full scale, and shift the product back down to Q2.30.
+    int e;
+    double m = frexp(0.5 * (double)scale * 1e-6, &e);
+    half_scale = (int64_t)(m * (double)(1LL << HALF_SCALE_BITS) + 0.5);
+    half_shift = HALF_SCALE_BITS - 30 - e;
+    if (half_scale >= (1LL << HALF_SCALE_BITS)) {
+        half_scale >>= 1;
+        half_shift--;
+    }
+    reset();
+}
+
+void OrientationIntegratorQ30::reset() {
+    w = Q30_ONE;
+    x = 0;
+    y = 0;
+    z = 0;
+}
+
+void OrientationIntegratorQ30::update(const int16_t raw[3], uint32_t dt_us) {
+    if (dt_us > ORIENTATION_MAX_DT_US) {
+        dt_us = ORIENTATION_MAX_DT_US;
+    }
+
+    // Half angles in Q2.30, rounded: (raw * dt_us) * half_scale, in that
+    // order so neither product leaves int64.
+    int64_t round = 1LL << (half_shift - 1);
+    int32_t hx = (int32_t)(((int64_t)raw[0] * dt_us * half_scale + round) >> half_shift);
+    int32_t hy = (int32_t)(((int64_t)raw[1] * dt_us * half_scale + round) >> half_shift);
+    int32_t hz = (int32_t)(((int64_t)raw[2] * dt_us * half_scale + round) >> half_shift);
+
+    int32_t hh = q30_mul(hx, hx) + q30_mul(hy, hy) + q30_mul(hz, hz);
+    int32_t c = Q30_ONE - (hh >> 1);
+    int32_t s = Q30_ONE - hh / 6;
+    hx = q30_mul(hx, s);
+    hy = q30_mul(hy, s);
+    hz = q30_mul(hz, s);
+
+    int32_t nw = q30_mul(c, w) - q30_mul(x, hx) - q30_mul(y, hy) - q30_mul(z, hz);
+    int32_t nx = q30_mul(c, x) + q30_mul(w, hx) + q30_mul(y, hz) - q30_mul(z, hy);
+    int32_t ny = q30_mul(c, y) + q30_mul(w, hy) - q30_mul(x, hz) + q30_mul(z, hx);
+    int32_t nz = q30_mul(c, z) + q30_mul(w, hz) + q30_mul(x, hy) - q30_mul(y, hx);
+
+    int32_t n = q30_mul(nw, nw) + q30_mul(nx, nx) + q30_mul(ny, ny) + q30_mul(nz, nz);
+    int32_t r = Q30_ONE + ((Q30_ONE - n) >> 1);
+    w = q30_mul(nw, r);
+    x = q30_mul(nx, r);
+    y = q30_mul(ny, r);
+    z = q30_mul(nz, r);
+}
+
+Quaternion OrientationIntegratorQ30::quaternion() const {
+    const float unit = 1.0f / (float)Q30_ONE;
+    Quaternion q = { w * unit, x * unit, y * unit, z * unit };
+    return q;
+}
+
+/* END: Fixed-Point Integrator */
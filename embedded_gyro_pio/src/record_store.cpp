@@ -0,0 +1,273 @@
+/**
+ * @file record_store.cpp
+ *
+ * @brief Log-structured record store for the I2C EEPROM.
+ *
+ */
+
+#include "record_store.h"
+#include "crc.h"
+#include <string.h>
+
+// latest_slot[] markers.
+#define SLOT_UNKNOWN -1
+#define SLOT_NONE    -2
+
+// Type byte of the index slot, outside the record types.
+#define RECORD_INDEX_TYPE 0x7F
+
+static_assert(RECORD_TYPE_COUNT * sizeof(int16_t) <= RECORD_PAYLOAD_SIZE, "index does not fit in a slot");
+
+static uint16_t slot_crc(uint8_t type, const uint8_t *seq_and_payload, size_t len) {
+    return crc16_update(crc16(&type, 1), seq_and_payload, len);
+}
+
+RecordStore::RecordStore(EepromDevice &device, uint16_t base, uint16_t size)
+    : device(device), base_addr(base),
+      slot_count(size / RECORD_SLOT_SIZE > 1 ? (uint16_t)(size / RECORD_SLOT_SIZE - 1) : 0) {
+    for (int i = 0; i < RECORD_TYPE_COUNT; i++) {
+        latest_slot[i] = SLOT_UNKNOWN;
+    }
+}
+
+bool RecordStore::read_slot(uint16_t slot, Slot &out) {
+    if (!device.read(addr_of(slot), (uint8_t *)&out, RECORD_SLOT_SIZE)) {
+        return false;
+    }
+    if (out.magic != RECORD_MAGIC || out.type == 0 || out.type >= RECORD_TYPE_COUNT) {
+        return false;
+    }
+    return out.crc == slot_crc(out.type, (const uint8_t *)&out.seq, sizeof(out.seq) + sizeof(out.payload));
+}
+
+bool RecordStore::slot_has_seq(uint16_t slot, uint32_t seq) {
+    Slot s;
+    return read_slot(slot, s) && s.seq == seq;
+}
+
+bool RecordStore::read_index(Slot &out) {
+    if (!device.read(addr_of(slot_count), (uint8_t *)&out, RECORD_SLOT_SIZE)) {
+        return false;
+    }
+    if (out.magic != RECORD_MAGIC || out.type != RECORD_INDEX_TYPE) {
+        return false;
+    }
+    return out.crc == slot_crc(out.type, (const uint8_t *)&out.seq, sizeof(out.seq) + sizeof(out.payload));
+}
+
+bool RecordStore::mount_from_index(const Slot &index) {
+    // Only the slots written since the index was can disagree with it.
+    if (index.seq > next_seq || next_seq - index.seq > slot_count) {
+        return false;
+    }
+    int16_t indexed[RECORD_TYPE_COUNT];
+    memcpy(indexed, index.payload, sizeof(indexed));
+
+    uint16_t behind = (uint16_t)(next_seq - index.seq);
+    for (uint16_t k = 0; k < behind; k++) {
+        uint16_t slot = (uint16_t)((head_slot + slot_count - 1 - k) % slot_count);
+        Slot s;
+        if (!read_slot(slot, s) || s.seq != next_seq - 1 - k) {
+            return false;
+        }
+        if (latest_slot[s.type] == SLOT_UNKNOWN) {
+            latest_slot[s.type] = slot;
+        }
+    }
+
+    for (int i = 1; i < RECORD_TYPE_COUNT; i++) {
+        if (latest_slot[i] != SLOT_UNKNOWN) {
+            continue;
+        }
+        int16_t slot = indexed[i];
+        if (slot == SLOT_NONE) {
+            latest_slot[i] = SLOT_NONE;
+            continue;
+        }
+        if (slot < 0 || slot >= (int16_t)slot_count) {
+            return false;
+        }
+        // Overwritten since: had it been the last of its type, append()
+        // would have carried it forward into a slot walked above.
+        uint16_t age = (uint16_t)((head_slot + slot_count - 1 - slot) % slot_count);
+        latest_slot[i] = age < behind ? SLOT_NONE : slot;
+    }
+    return true;
+}
+
+bool RecordStore::mount() {
+    mounted = false;
+    for (int i = 0; i < RECORD_TYPE_COUNT; i++) {
+        latest_slot[i] = SLOT_UNKNOWN;
+    }
+    if (slot_count == 0) {
+        return false;
+    }
+
+    // Make sure the device answers at all before trusting "empty" slots.
+    uint8_t probe;
+    if (!device.read(base_addr, &probe, 1)) {
+        return false;
+    }
+
+    Slot first;
+    if (!read_slot(0, first)) {
+        // Either a blank store, or the append to slot 0 was torn right after a
+        // wrap, in which case the last slot holds the newest record.
+        Slot last;
+        head_slot = 0;
+        next_seq = read_slot(slot_count - 1, last) ? last.seq + 1 : 0;
+    } else {
+        // Slots [0, head) hold seq(0), seq(0)+1, ... Beyond the head a slot
+        // is either blank or left over from the previous lap (seq smaller by
+        // slot_count), so "slot i holds seq(0)+i" flips from true to false
+        // exactly once. Binary search for that point.
+        uint16_t lo = 1, hi = slot_count;
+        while (lo < hi) {
+            uint16_t mid = lo + (hi - lo) / 2;
+            if (slot_has_seq(mid, first.seq + mid)) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        head_slot = lo % slot_count;
+        next_seq = first.seq + lo;
+    }
+
+    // Newest slot of every type: from the index and the few slots written
+    // after it, or else walking backwards from the head and stopping once
+    // all types are found or the sequence breaks. A type not seen by then
+    // is not in the store, and latest() says so without another read.
+    Slot index;
+    bool indexed = read_index(index) && mount_from_index(index);
+    index_current = indexed && index.seq == next_seq;
+    index_seq = indexed ? index.seq : 0;
+    if (!indexed) {
+        for (int i = 0; i < RECORD_TYPE_COUNT; i++) {
+            latest_slot[i] = SLOT_UNKNOWN;
+        }
+        int missing = RECORD_TYPE_COUNT - 1;
+        for (uint16_t k = 0; k < slot_count && missing > 0; k++) {
+            uint16_t slot = (uint16_t)((head_slot + slot_count - 1 - k) % slot_count);
+            Slot s;
+            if (!read_slot(slot, s) || s.seq != next_seq - 1 - k) {
+                break;
+            }
+            if (latest_slot[s.type] == SLOT_UNKNOWN) {
+                latest_slot[s.type] = slot;
+                missing--;
+            }
+        }
+    }
+    for (int i = 0; i < RECORD_TYPE_COUNT; i++) {
+        if (latest_slot[i] == SLOT_UNKNOWN) {
+            latest_slot[i] = SLOT_NONE;
+        }
+    }
+
+    mounted = true;
+    return true;
+}
+
+bool RecordStore::latest(RecordType type, void *payload, size_t len) {
+    if (!mounted || type == 0 || type >= RECORD_TYPE_COUNT || len > RECORD_PAYLOAD_SIZE) {
+        return false;
+    }
+    device.sync();
+
+    if (latest_slot[type] < 0) {
+        return false;
+    }
+
+    Slot s;
+    if (!read_slot(latest_slot[type], s)) {
+        return false;
+    }
+    memcpy(payload, s.payload, len);
+    return true;
+}
+
+bool RecordStore::append(RecordType type, const void *payload, size_t len) {
+    if (!mounted || type == 0 || type >= RECORD_TYPE_COUNT || len > RECORD_PAYLOAD_SIZE) {
+        return false;
+    }
+
+    // Let any earlier append land (or fail) so the head is settled.
+    device.sync();
+
+    // The index goes first, so it is never ahead of the log. If it does
+    // not land, mount() walks back a little further.
+    if (!index_current || index_seq != next_seq) {
+        write_index();
+    }
+
+    // The slot about to be overwritten is the oldest one in the log. If it
+    // is the only remaining record of another type, carry it forward so a
+    // run of one kind of record cannot push out the others.
+    Slot victim;
+    bool carry = false;
+    if (read_slot(head_slot, victim) && victim.type != type && victim.seq + slot_count == next_seq) {
+        carry = latest_slot[victim.type] == (int16_t)head_slot;
+    }
+
+    Slot s;
+    memset(&s, 0xFF, sizeof(s));
+    s.magic = RECORD_MAGIC;
+    s.type = type;
+    s.seq = next_seq;
+    memcpy(s.payload, payload, len);
+    s.crc = slot_crc(s.type, (const uint8_t *)&s.seq, sizeof(s.seq) + sizeof(s.payload));
+
+    writing_type = type;
+    if (!device.write(addr_of(head_slot), (const uint8_t *)&s, RECORD_SLOT_SIZE, &RecordStore::write_done, this)) {
+        return false;
+    }
+
+    // The carried record goes in the next slot, once this one has landed.
+    if (carry) {
+        device.sync();
+        if (next_seq == s.seq) {
+            return false;
+        }
+        return append((RecordType)victim.type, victim.payload, RECORD_PAYLOAD_SIZE);
+    }
+    return true;
+}
+
+void RecordStore::write_done(void *context, bool ok) {
+    RecordStore &store = *(RecordStore *)context;
+    if (!ok) {
+        return;
+    }
+
+    // Anything cached as living in this slot is gone now.
+    for (int i = 0; i < RECORD_TYPE_COUNT; i++) {
+        if (store.latest_slot[i] == (int16_t)store.head_slot) {
+            store.latest_slot[i] = SLOT_NONE;
+        }
+    }
+    store.latest_slot[store.writing_type] = store.head_slot;
+    store.head_slot = (uint16_t)((store.head_slot + 1) % store.slot_count);
+    store.next_seq++;
+}
+
+bool RecordStore::write_index() {
+    Slot s;
+    memset(&s, 0xFF, sizeof(s));
+    s.magic = RECORD_MAGIC;
+    s.type = RECORD_INDEX_TYPE;
+    s.seq = next_seq;
+    memcpy(s.payload, latest_slot, sizeof(latest_slot));
+    s.crc = slot_crc(s.type, (const uint8_t *)&s.seq, sizeof(s.seq) + sizeof(s.payload));
+
+    index_current = false;
+    index_writing = next_seq;
+    return device.write(addr_of(slot_count), (const uint8_t *)&s, RECORD_SLOT_SIZE, &RecordStore::index_done, this);
+}
+
+void RecordStore::index_done(void *context, bool ok) {
+    RecordStore &store = *(RecordStore *)context;
+    store.index_current = ok;
+    store.index_seq = store.index_writing;
+}
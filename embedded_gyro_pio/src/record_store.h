@@ -0,0 +1,183 @@
+/**
+ * @file record_store.h
+ *
+ * @brief Log-structured record store for the I2C EEPROM.
+ *
+ * Records are fixed 32-byte slots (a whole number of EEPROM pages) that
+ * are only ever appended, round-robin, over a region of the EEPROM. That
+ * spreads the write cycles evenly over every page of the region instead
+ * of rewriting one hot location.
+ *
+ * Every slot carries a sequence number that grows by one per append, so
+ * the slots before the write head always hold seq(0), seq(0)+1, ... and
+ * the head can be found with a binary search over slot headers
+ * (log2(slots) reads) instead of a full scan.
+ *
+ * The last slot of the region is not part of the log: it holds an index,
+ * the newest slot of each type as of a sequence number. Each append
+ * rewrites it (describing the store before the new record) ahead of the
+ * record itself, so at mount it is at most a record or two behind, and
+ * mount() only walks back over the slots written since. Appends are rare
+ * (calibrations and profile changes; sessions go to SessionHistory), so
+ * the index slot's extra wear is small. A missing or torn index costs one
+ * walk back from the head instead, until every type is seen or the log
+ * starts. Either way latest() then reads the one slot it needs.
+ *
+ * The store talks to the memory through the EepromDevice interface so it
+ * can run against the BSP driver or any other backing store. Writes may
+ * complete in the background: the head, the sequence number and the
+ * newest slot of each type only move once a write has landed, so a
+ * failed write leaves the store as it was and the next append retries
+ * the same slot.
+ *
+ */
+
+#ifndef RECORD_STORE_H
+#define RECORD_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Size of one record slot in bytes (multiple of the EEPROM page size).
+#define RECORD_SLOT_SIZE 32
+
+// Bytes available for a record payload.
+#define RECORD_PAYLOAD_SIZE (RECORD_SLOT_SIZE - 8)
+
+// Marks a written slot.
+#define RECORD_MAGIC 0xA7
+
+// Kinds of persisted records.
+enum RecordType : uint8_t {
+    RECORD_SENSOR_PROFILE     = 1,  // SensorProfile.
+    RECORD_TOUCH_CALIBRATION  = 2,  // TouchCalibration (touch_calibration.h).
+    RECORD_STRIDE_CALIBRATION = 3,  // StrideCalibration (stride_model.h).
+    RECORD_TYPE_COUNT
+};
+
+// Summary of one recording session.
+struct SessionSummary {
+    float distance_m;           // Total distance traveled.
+    float duration_s;           // Recording length.
+    uint32_t samples;           // Samples captured.
+    float max_rate;             // Largest |rate| seen on any axis (rad/s).
+    float yaw;                  // Heading change over the session (rad).
+    uint32_t strides;           // Complete strides (stride_model.h).
+};
+
+// Sensor configuration a session was recorded with.
+struct SensorProfile {
+    uint8_t ctrl_reg[5];        // CTRL_REG1..CTRL_REG5.
+    uint8_t spi_clock_div;      // Tuned SPI clock divider (0: not tuned).
+    uint8_t reserved[2];
+    float scale;                // Raw LSB to rad/s.
+    uint32_t odr_hz;            // Output data rate.
+};
+
+// Told whether a write landed, once it has finished.
+typedef void (*EepromWriteDone)(void *context, bool ok);
+
+// Memory the store lives in. Addresses are absolute device addresses.
+class EepromDevice {
+public:
+    virtual ~EepromDevice() {}
+    virtual bool read(uint16_t addr, uint8_t *buf, uint16_t len) = 0;
+
+    // Starts a write; done (if not null) is called with the outcome when it
+    // finishes, which for a queued write is later and on another thread.
+    // Returns false, without calling done, if the write was not taken on.
+    virtual bool write(uint16_t addr, const uint8_t *buf, uint16_t len, EepromWriteDone done, void *context) = 0;
+
+    // Waits until every write taken on has finished and called back.
+    virtual void sync() {}
+};
+
+class RecordStore {
+public:
+    // base and size must be multiples of RECORD_SLOT_SIZE; the last slot
+    // of the region holds the index.
+    RecordStore(EepromDevice &device, uint16_t base, uint16_t size);
+
+    // Locates the write head and the newest record of each type.
+    // Returns false if the device could not be read.
+    bool mount();
+
+    // Appends a record. len must not exceed RECORD_PAYLOAD_SIZE. Returns
+    // whether the device took the write on; it lands in the background.
+    bool append(RecordType type, const void *payload, size_t len);
+
+    // Reads the newest record of the given type. Returns false if there is none.
+    bool latest(RecordType type, void *payload, size_t len);
+
+    template <typename T>
+    bool append(RecordType type, const T &record) {
+        static_assert(sizeof(T) <= RECORD_PAYLOAD_SIZE, "record does not fit in a slot");
+        return append(type, &record, sizeof(T));
+    }
+
+    template <typename T>
+    bool latest(RecordType type, T &record) {
+        static_assert(sizeof(T) <= RECORD_PAYLOAD_SIZE, "record does not fit in a slot");
+        return latest(type, &record, sizeof(T));
+    }
+
+    // Number of log slots and the slot the next append goes to.
+    uint16_t slots() const { return slot_count; }
+    uint16_t head() const { return head_slot; }
+
+    // Sequence number the next append will carry.
+    uint32_t next_sequence() const { return next_seq; }
+
+private:
+    struct Slot {
+        uint8_t magic;
+        uint8_t type;
+        uint16_t crc;           // Over seq and payload.
+        uint32_t seq;
+        uint8_t payload[RECORD_PAYLOAD_SIZE];
+    };
+
+    static_assert(sizeof(Slot) == RECORD_SLOT_SIZE, "slot layout must match RECORD_SLOT_SIZE");
+
+    // Reads a whole slot and checks it. Returns false if empty or corrupt.
+    bool read_slot(uint16_t slot, Slot &out);
+
+    // True if the slot holds a valid record with sequence number seq.
+    bool slot_has_seq(uint16_t slot, uint32_t seq);
+
+    // Write completion: moves the head past the slot written if it landed.
+    static void write_done(void *context, bool ok);
+
+    // Reads the index slot and checks it. Returns false if empty or corrupt.
+    bool read_index(Slot &out);
+
+    // Writes the newest slot of each type as of next_seq to the index slot.
+    bool write_index();
+
+    // Index write completion: notes which sequence number the index is at.
+    static void index_done(void *context, bool ok);
+
+    // Newest slot of each type from the index at seq, after walking back
+    // over the slots written since. Returns false if that fails.
+    bool mount_from_index(const Slot &index);
+
+    uint16_t addr_of(uint16_t slot) const {
+        return (uint16_t)(base_addr + slot * RECORD_SLOT_SIZE);
+    }
+
+    EepromDevice &device;
+    uint16_t base_addr;
+    uint16_t slot_count;
+    uint16_t head_slot = 0;
+    uint32_t next_seq = 0;
+    bool mounted = false;
+    uint8_t writing_type = 0;   // Type of the record being written at the head.
+    bool index_current = false; // The index slot holds index_seq.
+    uint32_t index_seq = 0;     // Sequence number the index was written at.
+    uint32_t index_writing = 0; // ... and the one being written.
+
+    // Slot of the newest record of each type (-1: not mounted, -2: none).
+    int16_t latest_slot[RECORD_TYPE_COUNT];
+};
+
+#endif // RECORD_STORE_H
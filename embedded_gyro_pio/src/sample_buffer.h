@@ -0,0 +1,124 @@
+/**
+ * @file sample_buffer.h
+ *
+ * @brief Recording buffer with read-only views for processing.
+ *
+ * The processing thread appends samples; everyone else reads them through
+ * a SampleView, a set of plain pointers into the buffer. Samples are
+ * append-only and published with a release store of the count, so a view
+ * taken at any time (acquire) covers a prefix that no longer changes:
+ * chunks while recording, the whole session once capture has ended. No
+ * copy is made and the data needs no volatile, so kernels running on a
+ * view get ordinary loads the compiler can unroll and combine.
+ *
+ * Each axis is stored contiguously (X..., Y..., Z...) rather than as
+ * X/Y/Z rows, so a kernel over one axis walks consecutive int16_t. Every
+ * array starts on a SAMPLE_BUFFER_ALIGN boundary.
+ *
+ */
+
+#ifndef SAMPLE_BUFFER_H
+#define SAMPLE_BUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// Alignment (bytes) of every array in the buffer: whole words and
+// halfword pairs, for LDRD/LDM and the dual 16-bit MACs.
+#define SAMPLE_BUFFER_ALIGN 8
+
+// Read-only view of count consecutive T.
+template <typename T>
+class Span {
+public:
+    Span() : ptr(nullptr), count(0) {}
+    Span(const T *ptr, size_t count) : ptr(ptr), count(count) {}
+
+    const T *data() const { return ptr; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const T &operator[](size_t i) const { return ptr[i]; }
+    const T *begin() const { return ptr; }
+    const T *end() const { return ptr + count; }
+
+    // Elements [first, first + n), clipped to the span.
+    Span subspan(size_t first, size_t n) const {
+        if (first > count) {
+            first = count;
+        }
+        if (n > count - first) {
+            n = count - first;
+        }
+        return Span(ptr + first, n);
+    }
+
+private:
+    const T *ptr;
+    size_t count;
+};
+
+// Samples [first, first + size()) of a recording.
+struct SampleView {
+    Span<int16_t> axis[3];          // Raw X, Y, Z.
+    Span<uint32_t> timestamps_us;   // Data-ready time-stamps.
+
+    size_t size() const { return timestamps_us.size(); }
+
+    SampleView subview(size_t first, size_t n) const {
+        SampleView v;
+        for (int a = 0; a < 3; a++) {
+            v.axis[a] = axis[a].subspan(first, n);
+        }
+        v.timestamps_us = timestamps_us.subspan(first, n);
+        return v;
+    }
+};
+
+// Room for N samples. One writer; any number of readers through views.
+template <size_t N>
+class SampleBuffer {
+public:
+    static constexpr size_t capacity() { return N; }
+
+    // Empties the buffer. No view taken before may be used afterwards.
+    void clear() { count.store(0, std::memory_order_relaxed); }
+
+    // Appends one sample. Returns false when full.
+    bool push(uint32_t timestamp_us, const int16_t raw[3]) {
+        uint32_t n = count.load(std::memory_order_relaxed);
+        if (n >= N) {
+            return false;
+        }
+        axes[0][n] = raw[0];
+        axes[1][n] = raw[1];
+        axes[2][n] = raw[2];
+        timestamps[n] = timestamp_us;
+        count.store(n + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Samples published so far.
+    size_t size() const { return count.load(std::memory_order_acquire); }
+
+    // The samples published so far. They stay valid and unchanged until clear().
+    SampleView view() const {
+        size_t n = size();
+        SampleView v;
+        for (int a = 0; a < 3; a++) {
+            v.axis[a] = Span<int16_t>(axes[a], n);
+        }
+        v.timestamps_us = Span<uint32_t>(timestamps, n);
+        return v;
+    }
+
+private:
+    // Axis arrays padded so each one starts aligned.
+    static constexpr size_t STRIDE = (N + SAMPLE_BUFFER_ALIGN / 2 - 1) & ~(size_t)(SAMPLE_BUFFER_ALIGN / 2 - 1);
+
+    alignas(SAMPLE_BUFFER_ALIGN) int16_t axes[3][STRIDE];
+    alignas(SAMPLE_BUFFER_ALIGN) uint32_t timestamps[N];
+    std::atomic<uint32_t> count{0};
+};
+
+#endif // SAMPLE_BUFFER_H
@@ -0,0 +1,39 @@
+/**
+ * @file sample_kernels.cpp
+ *
+ * @brief Post-recording computations over a SampleView.
+ *
+ */
+
+#include "sample_kernels.h"
+
+uint32_t kernel_max_abs(Span<int16_t> values) {
+    const int16_t *v = values.data();
+    size_t n = values.size();
+    uint32_t max = 0;
+    for (size_t i = 0; i < n; i++) {
+        int32_t x = v[i];
+        uint32_t a = (uint32_t)(x < 0 ? -x : x);
+        max = (a > max) ? a : max;
+    }
+    return max;
+}
+
+float kernel_swept_angle(Span<int16_t> rate, Span<uint32_t> timestamps_us, float scale) {
+    const int16_t *r = rate.data();
+    const uint32_t *t = timestamps_us.data();
+    size_t n = rate.size();
+    if (n < 2) {
+        return 0.0f;
+    }
+
+    // Sum of (|r_j| + |r_j+1|) * dt_j in LSB * us: exact, no float per sample.
+    uint64_t sum = 0;
+    int32_t prev = r[0] < 0 ? -r[0] : r[0];
+    for (size_t j = 1; j < n; j++) {
+        int32_t cur = r[j] < 0 ? -r[j] : r[j];
+        sum += (uint64_t)(uint32_t)(prev + cur) * (t[j] - t[j - 1]);
+        prev = cur;
+    }
+    return (float)sum * (scale * 0.5e-6f);
+}
@@ -0,0 +1,25 @@
+/**
+ * @file sample_kernels.h
+ *
+ * @brief Post-recording computations over a SampleView.
+ *
+ * They work on the raw integer samples and apply the scale factor once
+ * per result rather than once per sample.
+ *
+ */
+
+#ifndef SAMPLE_KERNELS_H
+#define SAMPLE_KERNELS_H
+
+#include <stdint.h>
+#include "sample_buffer.h"
+
+// Largest |value| in raw LSB (32768 for -32768).
+uint32_t kernel_max_abs(Span<int16_t> values);
+
+// Angle swept over the samples, the integral of |rate| by the trapezoidal
+// rule over the real sample spacing. rate and timestamps_us must be the
+// same length; scale converts raw LSB to rad/s.
+float kernel_swept_angle(Span<int16_t> rate, Span<uint32_t> timestamps_us, float scale);
+
+#endif // SAMPLE_KERNELS_H
@@ -0,0 +1,101 @@
+/**
+ * @file screen_assets.cpp
+ *
+ * @brief Static screen content rendered once into SDRAM and shown with a
+ *        single DMA2D copy.
+ *
+ */
+
+#include "screen_assets.h"
+
+#define PIXEL_SIZE 4
+
+// Memory-to-memory copy of a w x h ARGB8888 rectangle, each side with its
+// own gap between rows (pixels). Polls for the end: a full screen takes
+// a few milliseconds, about what the CPU would spend on the loop alone.
+// The DMA2D clock is on once the LCD is up.
+static bool dma2d_copy(uint32_t src, uint32_t src_gap, uint32_t dst, uint32_t dst_gap, uint16_t w, uint16_t h) {
+    DMA2D->CR = 0;                              // Memory to memory, no conversion.
+    DMA2D->FGMAR = src;
+    DMA2D->FGOR = src_gap;
+    DMA2D->FGPFCCR = 0;                         // ARGB8888
+    DMA2D->OMAR = dst;
+    DMA2D->OOR = dst_gap;
+    DMA2D->OPFCCR = 0;                          // ARGB8888
+    DMA2D->NLR = ((uint32_t)w << DMA2D_NLR_PL_Pos) | h;
+    DMA2D->IFCR = DMA2D_IFCR_CTCIF | DMA2D_IFCR_CTEIF | DMA2D_IFCR_CCEIF;
+    DMA2D->CR |= DMA2D_CR_START;
+    while (DMA2D->CR & DMA2D_CR_START) {
+    }
+    return (DMA2D->ISR & (DMA2D_ISR_TEIF | DMA2D_ISR_CEIF)) == 0;
+}
+
+ScreenAssets::ScreenAssets(LCD_DISCO_F429ZI &lcd, uint32_t base, uint32_t size)
+    : lcd(lcd), base(base), end(base + size), next(base) {}
+
+uint32_t ScreenAssets::frame_address(uint32_t layer) const {
+    if ((int)layer == render_layer) {
+        return render_saved;
+    }
+    return ((layer == 0) ? LTDC_Layer1 : LTDC_Layer2)->CFBAR;
+}
+
+bool ScreenAssets::begin_render(uint32_t layer, uint32_t color) {
+    if (render_layer >= 0) {
+        end_render();
+    }
+    if (scratch == 0) {
+        uint32_t frame = lcd.GetXSize() * lcd.GetYSize() * PIXEL_SIZE;
+        if (end - next < frame) {
+            return false;
+        }
+        scratch = next;
+        next += frame;
+    }
+
+    render_saved = frame_address(layer);
+    render_layer = (int)layer;
+    BSP_LCD_SetLayerAddress_NoReload(layer, scratch);
+    lcd.SelectLayer(layer);
+    lcd.Clear(color);
+    return true;
+}
+
+bool ScreenAssets::capture(ScreenAsset &out, uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+    uint32_t xsize = lcd.GetXSize();
+    uint32_t bytes = (uint32_t)w * h * PIXEL_SIZE;
+    if (render_layer < 0 || w == 0 || h == 0 || x + w > xsize || y + h > lcd.GetYSize() || end - next < bytes) {
+        return false;
+    }
+    if (!dma2d_copy(scratch + (y * xsize + x) * PIXEL_SIZE, xsize - w, next, 0, w, h)) {
+        return false;
+    }
+    out.addr = next;
+    out.x = x;
+    out.y = y;
+    out.w = w;
+    out.h = h;
+    next += bytes;
+    return true;
+}
+
+void ScreenAssets::end_render() {
+    if (render_layer < 0) {
+        return;
+    }
+    BSP_LCD_SetLayerAddress_NoReload(render_layer, render_saved);
+    render_layer = -1;
+}
+
+bool ScreenAssets::show(uint32_t layer, const ScreenAsset &asset) {
+    return show(layer, asset, asset.x, asset.y);
+}
+
+bool ScreenAssets::show(uint32_t layer, const ScreenAsset &asset, uint16_t x, uint16_t y) {
+    uint32_t xsize = lcd.GetXSize();
+    if (!asset.valid() || x + asset.w > xsize || y + asset.h > lcd.GetYSize()) {
+        return false;
+    }
+    return dma2d_copy(asset.addr, 0, frame_address(layer) + (y * xsize + x) * PIXEL_SIZE, xsize - asset.w,
+                      asset.w, asset.h);
+}
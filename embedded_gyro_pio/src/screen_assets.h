@@ -0,0 +1,79 @@
+/**
+ * @file screen_assets.h
+ *
+ * @brief Static screen content rendered once into SDRAM and shown with a
+ *        single DMA2D copy.
+ *
+ * The LCD layers are ARGB8888 frame buffers at the start of the 8 MB
+ * SDRAM; the rest of it holds the asset cache. At boot, begin_render()
+ * points a layer's drawing (not its display) at a scratch frame in the
+ * cache, so the usual LCD calls draw off-screen, and capture() saves a
+ * rectangle of that frame as an asset. show() copies an asset onto the
+ * layer's frame buffer with one DMA2D memory-to-memory transfer, instead
+ * of clearing and drawing the text glyph by glyph again.
+ *
+ * begin_render() changes the layer address without an LTDC reload, so
+ * the display keeps scanning the real frame buffer; end_render() puts the
+ * address back before anything reloads. All of it runs on the UI thread.
+ *
+ */
+
+#ifndef SCREEN_ASSETS_H
+#define SCREEN_ASSETS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "drivers/LCD_DISCO_F429ZI.h"
+
+// A rectangle of pixels (ARGB8888, w per row) and where it goes on screen.
+struct ScreenAsset {
+    uint32_t addr = 0;
+    uint16_t x = 0;
+    uint16_t y = 0;
+    uint16_t w = 0;
+    uint16_t h = 0;
+
+    bool valid() const { return addr != 0; }
+};
+
+class ScreenAssets {
+public:
+    // base and size: SDRAM not used by the layers, for the scratch frame
+    // and the assets.
+    ScreenAssets(LCD_DISCO_F429ZI &lcd, uint32_t base, uint32_t size);
+
+    // Selects the layer and redirects its drawing to the scratch frame,
+    // cleared to color. Returns false if the cache has no room for it.
+    bool begin_render(uint32_t layer, uint32_t color);
+
+    // Saves a rectangle of the scratch frame. Returns false if the cache
+    // is full or nothing is being rendered.
+    bool capture(ScreenAsset &out, uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+
+    // Points the layer back at its frame buffer.
+    void end_render();
+
+    // Copies an asset to its place on the layer. Returns false (and draws
+    // nothing) for an asset that was never captured.
+    bool show(uint32_t layer, const ScreenAsset &asset);
+
+    // The same, with the asset's top left corner at (x, y).
+    bool show(uint32_t layer, const ScreenAsset &asset, uint16_t x, uint16_t y);
+
+    // Cache bytes in use, the scratch frame included.
+    size_t used() const { return next - base; }
+
+private:
+    // Frame buffer the layer displays.
+    uint32_t frame_address(uint32_t layer) const;
+
+    LCD_DISCO_F429ZI &lcd;
+    uint32_t base;
+    uint32_t end;
+    uint32_t next;
+    uint32_t scratch = 0;
+    int render_layer = -1;
+    uint32_t render_saved = 0;      // Address of the layer being rendered.
+};
+
+#endif // SCREEN_ASSETS_H
@@ -0,0 +1,166 @@
+/**
+ * @file sensor_pipeline.h
+ *
+ * @brief Per-sample processing chain assembled at compile time.
+ *
+ * A pipeline is a sensor type plus a list of stage types:
+ *
+ *     SensorPipeline<Sensor, OrientationStage<Integrator, Sensor>, Sink...>
+ *
+ * The sensor is any type with a constexpr static config() returning its
+ * GyroConfig. SensorTraits derives the register image, data rate, sample
+ * period and LSB scale from it as constant expressions, so stages that
+ * need them get literals, not run-time variables.
+ *
+ * A stage is any type with reset() and process(PipelineSample &). Filters
+ * rewrite the raw values in place, integrators add their result, sinks
+ * consume the sample. process() calls the stages in order with no virtual
+ * calls or function pointers, so the compiler can inline the whole
+ * per-sample path into the loop that feeds it. Pipelines with different
+ * sensors or stages are distinct types and can be built side by side,
+ * e.g. to compare variants on the same recorded data.
+ *
+ */
+
+#ifndef SENSOR_PIPELINE_H
+#define SENSOR_PIPELINE_H
+
+#include <stdint.h>
+#include <tuple>
+#include <utility>
+#include "gyro_config.h"
+#include "orientation.h"
+#include "cycle_counter.h"
+
+// Everything a pipeline needs to know about a sensor setup, at compile time.
+template <typename Sensor>
+struct SensorTraits {
+    static constexpr GyroConfig config() { return Sensor::config(); }
+    static constexpr GyroRegisters registers() { return gyro_config_registers(Sensor::config()); }
+    static constexpr uint32_t odr_hz() { return gyro_odr_hz(Sensor::config().odr); }
+    static constexpr uint32_t period_us() { return 1000000 / odr_hz(); }
+    static constexpr float scale() { return gyro_scale_rad_s(Sensor::config().full_scale); }
+
+    // Programs the sensor with the precomputed register image.
+    static void apply() {
+        constexpr GyroRegisters regs = registers();
+        gyro_config_write(regs, Sensor::config().hpf_mode == GYRO_HPF_REFERENCE);
+    }
+};
+
+// One sample as it moves through the stages.
+struct PipelineSample {
+    uint32_t timestamp_us;      // Data-ready time-stamp.
+    uint32_t dt_us;             // Since the previous sample (0 for the first).
+    int16_t raw[3];             // X, Y, Z; filters update them in place.
+    Quaternion attitude;        // Set by an OrientationStage.
+};
+
+template <typename Sensor, typename... Stages>
+class SensorPipeline {
+public:
+    typedef SensorTraits<Sensor> traits;
+
+    // Starts a new run: the next sample is the first.
+    void reset() {
+        first = true;
+        for_each_stage([](auto &stage) { stage.reset(); }, std::index_sequence_for<Stages...>());
+    }
+
+    // Runs one sample through every stage, in order.
+    void process(uint32_t timestamp_us, const int16_t raw[3]) {
+        PipelineSample s;
+        s.timestamp_us = timestamp_us;
+        s.dt_us = first ? 0 : timestamp_us - last_timestamp_us;
+        s.raw[0] = raw[0];
+        s.raw[1] = raw[1];
+        s.raw[2] = raw[2];
+        s.attitude = Quaternion{1.0f, 0.0f, 0.0f, 0.0f};
+        first = false;
+        last_timestamp_us = timestamp_us;
+        for_each_stage([&s](auto &stage) { stage.process(s); }, std::index_sequence_for<Stages...>());
+    }
+
+    // Access to a stage by type (each stage type may appear only once).
+    template <typename Stage>
+    Stage &get() { return std::get<Stage>(stages); }
+
+    template <typename Stage>
+    const Stage &get() const { return std::get<Stage>(stages); }
+
+private:
+    template <typename F, size_t... I>
+    void for_each_stage(F f, std::index_sequence<I...>) {
+        // Braced initialisers are evaluated left to right.
+        int expand[] = {0, (f(std::get<I>(stages)), 0)...};
+        (void)expand;
+    }
+
+    std::tuple<Stages...> stages;
+    uint32_t last_timestamp_us = 0;
+    bool first = true;
+};
+
+// Filters the raw values in place with Filter (see digital_filter.h),
+// set up with the coefficients Design::design() yields at compile time.
+// Times each sample.
+template <typename Filter, typename Design>
+class FilterStage {
+public:
+    FilterStage() : filter(coefficients()) {}
+
+    void reset() {
+        filter.reset();
+        filter_cycles.reset();
+    }
+
+    void process(PipelineSample &s) {
+        CycleScope scope(filter_cycles);
+        filter.process(s.raw);
+    }
+
+    // Cycles spent per sample since reset().
+    const CycleStats &cycles() const { return filter_cycles; }
+
+private:
+    static auto coefficients() {
+        constexpr auto design = Design::design();
+        return design;
+    }
+
+    Filter filter;
+    CycleStats filter_cycles;
+};
+
+// Integrates the sample into a 3D orientation with Integrator
+// (OrientationIntegrator or OrientationIntegratorQ30) and stores the
+// result in PipelineSample::attitude. Times each update.
+template <typename Integrator, typename Sensor>
+class OrientationStage {
+public:
+    OrientationStage() : integrator(SensorTraits<Sensor>::scale()) {}
+
+    void reset() {
+        integrator.reset();
+        update_cycles.reset();
+    }
+
+    void process(PipelineSample &s) {
+        {
+            CycleScope scope(update_cycles);
+            integrator.update(s.raw, s.dt_us);
+        }
+        s.attitude = integrator.quaternion();
+    }
+
+    Quaternion quaternion() const { return integrator.quaternion(); }
+
+    // Cycles spent per orientation update since reset().
+    const CycleStats &cycles() const { return update_cycles; }
+
+private:
+    Integrator integrator;
+    CycleStats update_cycles;
+};
+
+#endif // SENSOR_PIPELINE_H
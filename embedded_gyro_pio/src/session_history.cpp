@@ -0,0 +1,220 @@
+/**
+ * @file session_history.cpp
+ *
+ * @brief Summaries of past sessions and totals over them.
+ *
+ */
+
+#include "session_history.h"
+#include "crc.h"
+#include <string.h>
+
+static uint16_t entry_crc(const SessionEntry &e) {
+    uint16_t crc = crc16(&e.seq, sizeof(e.seq));
+    return crc16_update(crc, &e.start_s, sizeof(e) - offsetof(SessionEntry, start_s));
+}
+
+// Rounds v * scale to the nearest uint16_t, clamped.
+static uint16_t to_u16(float v, float scale) {
+    float scaled = v * scale + 0.5f;
+    return (scaled <= 0.0f) ? 0 : (scaled >= 65535.0f) ? 65535 : (uint16_t)scaled;
+}
+
+SessionEntry session_entry_make(uint32_t start_s, float duration_s, float distance_m,
+                                uint32_t strides, float max_rate) {
+    SessionEntry e;
+    e.seq = 0;
+    e.crc = 0;
+    e.start_s = start_s;
+    e.duration_ds = to_u16(duration_s, 10.0f);
+    e.distance_dm = to_u16(distance_m, 10.0f);
+    e.strides = (strides > 65535) ? 65535 : (uint16_t)strides;
+    e.max_rate_crad = to_u16(max_rate, 100.0f);
+    return e;
+}
+
+SessionHistory::SessionHistory(EepromDevice &device, uint16_t base, uint16_t size)
+    : device(device), base_addr(base), slot_count(size / sizeof(SessionEntry)) {
+    memset(days, 0, sizeof(days));
+}
+
+bool SessionHistory::read_entry(uint16_t slot, SessionEntry &out) {
+    if (!device.read(addr_of(slot), (uint8_t *)&out, sizeof(out))) {
+        return false;
+    }
+    return out.crc == entry_crc(out);
+}
+
+bool SessionHistory::entry_has_seq(uint16_t slot, uint16_t seq) {
+    SessionEntry e;
+    return read_entry(slot, e) && e.seq == seq;
+}
+
+bool SessionHistory::mount() {
+    mounted = false;
+    held = 0;
+    total_strides = 0;
+    total_distance_dm = 0;
+    total_duration_ds = 0;
+    total_max_rate_crad = 0;
+    last_end = 0;
+    memset(days, 0, sizeof(days));
+    if (slot_count == 0) {
+        return false;
+    }
+
+    uint8_t probe;
+    if (!device.read(base_addr, &probe, 1)) {
+        return false;
+    }
+
+    // Same head search as RecordStore::mount(), on 16-bit sequence numbers.
+    SessionEntry first;
+    if (!read_entry(0, first)) {
+        SessionEntry last;
+        head_slot = 0;
+        next_seq = read_entry(slot_count - 1, last) ? (uint16_t)(last.seq + 1) : 0;
+    } else {
+        uint16_t lo = 1, hi = slot_count;
+        while (lo < hi) {
+            uint16_t mid = lo + (hi - lo) / 2;
+            if (entry_has_seq(mid, (uint16_t)(first.seq + mid))) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        head_slot = lo % slot_count;
+        next_seq = (uint16_t)(first.seq + lo);
+    }
+
+    // Count every entry of the current run, newest first.
+    for (uint16_t k = 0; k < slot_count; k++) {
+        uint16_t slot = (uint16_t)((head_slot + slot_count - 1 - k) % slot_count);
+        SessionEntry e;
+        if (!read_entry(slot, e) || e.seq != (uint16_t)(next_seq - 1 - k)) {
+            break;
+        }
+        if (k == 0) {
+            last_end = e.start_s + (e.duration_ds + 9) / 10;
+        }
+        count_entry(e, +1);
+    }
+
+    mounted = true;
+    return true;
+}
+
+void SessionHistory::count_entry(const SessionEntry &e, int sign) {
+    held += sign;
+    total_strides += sign * (int32_t)e.strides;
+    total_distance_dm += sign * (int32_t)e.distance_dm;
+    total_duration_ds += sign * (int32_t)e.duration_ds;
+    if (sign > 0 && e.max_rate_crad > total_max_rate_crad) {
+        total_max_rate_crad = e.max_rate_crad;
+    }
+
+    uint32_t d = e.start_s / HISTORY_SECONDS_PER_DAY;
+    Day &day = days[d % HISTORY_DAYS];
+    if (day.day != d) {
+        // The slot belongs to a newer day, or an older one it replaces.
+        if (sign < 0 || (day.sessions != 0 && d < day.day)) {
+            return;
+        }
+        memset(&day, 0, sizeof(day));
+        day.day = d;
+    }
+    day.sessions += sign;
+    day.strides += sign * (int32_t)e.strides;
+    day.distance_dm += sign * (int32_t)e.distance_dm;
+    day.duration_ds += sign * (int32_t)e.duration_ds;
+    if (sign > 0 && e.max_rate_crad > day.max_rate_crad) {
+        day.max_rate_crad = e.max_rate_crad;
+    }
+}
+
+bool SessionHistory::append(SessionEntry entry) {
+    if (!mounted) {
+        return false;
+    }
+
+    // Let any earlier append land (or fail) so the head is settled.
+    device.sync();
+
+    // The oldest session makes room once the region is full.
+    evict = held >= slot_count && read_entry(head_slot, victim) &&
+            victim.seq == (uint16_t)(next_seq - slot_count);
+
+    entry.seq = next_seq;
+    entry.crc = entry_crc(entry);
+    writing = entry;
+    return device.write(addr_of(head_slot), (const uint8_t *)&writing, sizeof(writing), &SessionHistory::write_done, this);
+}
+
+void SessionHistory::write_done(void *context, bool ok) {
+    SessionHistory &h = *(SessionHistory *)context;
+    if (!ok) {
+        return;
+    }
+    if (h.evict) {
+        h.count_entry(h.victim, -1);
+    }
+    h.count_entry(h.writing, +1);
+    h.last_end = h.writing.start_s + (h.writing.duration_ds + 9) / 10;
+    h.head_slot = (uint16_t)((h.head_slot + 1) % h.slot_count);
+    h.next_seq++;
+}
+
+size_t SessionHistory::latest(SessionEntry *out, size_t max) {
+    if (!mounted) {
+        return 0;
+    }
+    device.sync();
+    if (max > held) {
+        max = held;
+    }
+    size_t n = 0;
+    for (; n < max; n++) {
+        uint16_t slot = (uint16_t)((head_slot + slot_count - 1 - n) % slot_count);
+        if (!read_entry(slot, out[n]) || out[n].seq != (uint16_t)(next_seq - 1 - n)) {
+            break;
+        }
+    }
+    return n;
+}
+
+HistoryTotals SessionHistory::totals() const {
+    HistoryTotals t;
+    t.sessions = held;
+    t.strides = total_strides;
+    t.distance_m = total_distance_dm * 0.1f;
+    t.duration_s = total_duration_ds * 0.1f;
+    t.max_rate = total_max_rate_crad * 0.01f;
+    return t;
+}
+
+HistoryTotals SessionHistory::last_days(uint32_t day, int count) const {
+    HistoryTotals t = {};
+    uint32_t distance_dm = 0, duration_ds = 0;
+    uint16_t max_rate_crad = 0;
+    if (count > HISTORY_DAYS) {
+        count = HISTORY_DAYS;
+    }
+    for (int k = 0; k < count && (uint32_t)k <= day; k++) {
+        const Day &d = days[(day - k) % HISTORY_DAYS];
+        if (d.day != day - k || d.sessions == 0) {
+            continue;
+        }
+        t.sessions += d.sessions;
+        t.strides += d.strides;
+        distance_dm += d.distance_dm;
+        duration_ds += d.duration_ds;
+        if (d.max_rate_crad > max_rate_crad) {
+            max_rate_crad = d.max_rate_crad;
+        }
+    }
+    t.distance_m = distance_dm * 0.1f;
+    t.duration_s = duration_ds * 0.1f;
+    t.max_rate = max_rate_crad * 0.01f;
+    return t;
+}
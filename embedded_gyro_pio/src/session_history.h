@@ -0,0 +1,138 @@
+/**
+ * @file session_history.h
+ *
+ * @brief Summaries of past sessions and totals over them.
+ *
+ * Each session is one 16-byte SessionEntry, appended round-robin over its
+ * own EEPROM region like the record store (a sequence number per entry,
+ * head found by binary search), so the region holds the latest
+ * size / 16 sessions.
+ *
+ * mount() walks the stored entries once and builds, in RAM, the running
+ * totals over all of them and a per-day index of the last HISTORY_DAYS
+ * days. From then on append() keeps both up to date, taking out the
+ * entry it overwrites, and the queries are answered from RAM:
+ * totals() in O(1), totals over the last few days in O(days). Only the
+ * list of the latest sessions reads the EEPROM, one entry per session.
+ * As in the record store, an append only counts, and only moves the
+ * head, once its write has landed.
+ *
+ * Session start times are seconds on the device clock (time()); the day
+ * index groups them by start_s / 86400.
+ *
+ */
+
+#ifndef SESSION_HISTORY_H
+#define SESSION_HISTORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "record_store.h"
+
+// Days covered by the per-day index.
+#define HISTORY_DAYS 32
+
+#define HISTORY_SECONDS_PER_DAY 86400
+
+// One stored session. Fixed point keeps it at 16 bytes.
+struct SessionEntry {
+    uint16_t seq;               // Grows by one per session (wraps).
+    uint16_t crc;               // Over the rest of the entry.
+    uint32_t start_s;           // Device clock at the start of the session.
+    uint16_t duration_ds;       // Recording length (0.1 s).
+    uint16_t distance_dm;       // Distance traveled (0.1 m).
+    uint16_t strides;           // Complete strides.
+    uint16_t max_rate_crad;     // Largest |rate| on any axis (0.01 rad/s).
+};
+
+// Builds an entry from session results, rounding and clamping each field.
+SessionEntry session_entry_make(uint32_t start_s, float duration_s, float distance_m,
+                                uint32_t strides, float max_rate);
+
+// Totals over a set of sessions.
+struct HistoryTotals {
+    uint32_t sessions;
+    uint32_t strides;
+    float distance_m;
+    float duration_s;
+    float max_rate;             // Highest of the sessions' max_rate (rad/s).
+};
+
+class SessionHistory {
+public:
+    // base and size must be multiples of sizeof(SessionEntry).
+    SessionHistory(EepromDevice &device, uint16_t base, uint16_t size);
+
+    // Finds the write head and builds the totals and the day index.
+    // Returns false if the device could not be read.
+    bool mount();
+
+    // Stores one session (seq and crc are filled in). Returns whether the
+    // device took the write on; it lands in the background.
+    bool append(SessionEntry entry);
+
+    // Sessions held.
+    uint32_t count() const { return held; }
+
+    // Copies the newest sessions, newest first, up to max. Returns how many.
+    size_t latest(SessionEntry *out, size_t max);
+
+    // Over every session held.
+    HistoryTotals totals() const;
+
+    // Over sessions started on the given day and the count - 1 before it
+    // (count <= HISTORY_DAYS).
+    HistoryTotals last_days(uint32_t day, int count) const;
+
+    // Device clock time the newest session ended at (0: none).
+    uint32_t last_end_s() const { return last_end; }
+
+private:
+    struct Day {
+        uint32_t day;           // start_s / 86400 of the sessions counted.
+        uint32_t sessions;
+        uint32_t strides;
+        uint32_t distance_dm;
+        uint32_t duration_ds;
+        uint16_t max_rate_crad;
+    };
+
+    bool read_entry(uint16_t slot, SessionEntry &out);
+    bool entry_has_seq(uint16_t slot, uint16_t seq);
+
+    // Adds an entry to, or takes it out of, the totals and its day.
+    void count_entry(const SessionEntry &e, int sign);
+
+    // Write completion: counts the entry written if it landed.
+    static void write_done(void *context, bool ok);
+
+    uint16_t addr_of(uint16_t slot) const {
+        return (uint16_t)(base_addr + slot * sizeof(SessionEntry));
+    }
+
+    EepromDevice &device;
+    uint16_t base_addr;
+    uint16_t slot_count;
+    uint16_t head_slot = 0;
+    uint16_t next_seq = 0;
+    uint32_t held = 0;
+    bool mounted = false;
+
+    // Entry being written at the head, and the one it replaces.
+    SessionEntry writing;
+    SessionEntry victim;
+    bool evict = false;
+
+    // Running totals over the held sessions. The max rate can only grow;
+    // it is recomputed at mount.
+    uint32_t total_strides = 0;
+    uint32_t total_distance_dm = 0;
+    uint32_t total_duration_ds = 0;
+    uint16_t total_max_rate_crad = 0;
+    uint32_t last_end = 0;
+
+    // Indexed by day % HISTORY_DAYS.
+    Day days[HISTORY_DAYS];
+};
+
+#endif // SESSION_HISTORY_H
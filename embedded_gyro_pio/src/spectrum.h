@@ -0,0 +1,124 @@
+/**
+ * @file spectrum.h
+ *
+ * @brief Power spectrum of a block of samples: dominant frequency and
+ *        energy per band.
+ *
+ * SpectrumAnalyzer<N> takes N raw samples of one axis, removes their
+ * mean, applies a Hann window and runs RealFft<N> (fft.h). From the
+ * N / 2 + 1 bins it finds the strongest non-DC bin, refined by a
+ * parabola through its neighbours (the bins are fs / N apart, about
+ * 0.75 Hz at 190 Hz and N = 256), and adds up the power of the bins in
+ * each band. Powers are in raw LSB^2, only their ratios mean anything.
+ *
+ * The window is a constexpr table, like the FFT twiddles.
+ *
+ */
+
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+#include <stdint.h>
+#include "fft.h"
+
+template <int N>
+struct SpectrumWindow {
+    float w[N];
+};
+
+template <int N>
+constexpr SpectrumWindow<N> spectrum_hann() {
+    SpectrumWindow<N> t = {};
+    for (int i = 0; i < N; i++) {
+        t.w[i] = (float)(0.5 - 0.5 * filter_cos(2.0 * FILTER_PI * i / N));
+    }
+    return t;
+}
+
+template <int N, int Bands>
+struct SpectrumResult {
+    float peak_hz;                  // Dominant frequency (0: flat block).
+    float peak_power;
+    float total_power;              // All bins but DC.
+    float band_power[Bands];
+    float power[N / 2 + 1];         // Per bin, DC to Nyquist.
+
+    // Share of the total power in band b (0 to 1).
+    float band_share(int b) const { return (total_power > 0.0f) ? band_power[b] / total_power : 0.0f; }
+};
+
+template <int N, int Bands>
+class SpectrumAnalyzer {
+public:
+    static constexpr int BINS = RealFft<N>::BINS;
+
+    // fs_hz: sample rate. edges: Bands + 1 band edges (Hz), ascending;
+    // band b is [edges[b], edges[b + 1]).
+    SpectrumAnalyzer(float fs_hz, const float (&edges)[Bands + 1]) : bin_hz(fs_hz / N) {
+        for (int b = 0; b <= Bands; b++) {
+            edge[b] = edges[b];
+        }
+    }
+
+    float resolution_hz() const { return bin_hz; }
+
+    // x: N consecutive samples, oldest first.
+    void analyze(const int16_t *x, SpectrumResult<N, Bands> &out) {
+        int32_t sum = 0;
+        for (int i = 0; i < N; i++) {
+            sum += x[i];
+        }
+        float mean = (float)sum / N;
+        for (int i = 0; i < N / 2; i++) {
+            block[i].re = ((float)x[2 * i] - mean) * window.w[2 * i];
+            block[i].im = ((float)x[2 * i + 1] - mean) * window.w[2 * i + 1];
+        }
+        RealFft<N>::transform(block, bins);
+
+        out.total_power = 0.0f;
+        for (int b = 0; b < Bands; b++) {
+            out.band_power[b] = 0.0f;
+        }
+        int peak = 0;
+        out.power[0] = bins[0].re * bins[0].re;
+        for (int k = 1; k < BINS; k++) {
+            float p = bins[k].re * bins[k].re + bins[k].im * bins[k].im;
+            out.power[k] = p;
+            out.total_power += p;
+            if (peak == 0 || p > out.power[peak]) {
+                peak = k;
+            }
+            float f = k * bin_hz;
+            for (int b = 0; b < Bands; b++) {
+                if (f >= edge[b] && f < edge[b + 1]) {
+                    out.band_power[b] += p;
+                }
+            }
+        }
+
+        out.peak_power = out.power[peak];
+        out.peak_hz = 0.0f;
+        if (out.peak_power > 0.0f) {
+            float offset = 0.0f;
+            if (peak > 1 && peak < BINS - 1) {
+                float l = out.power[peak - 1], c = out.power[peak], r = out.power[peak + 1];
+                float d = l - 2.0f * c + r;
+                offset = (d < 0.0f) ? 0.5f * (l - r) / d : 0.0f;
+            }
+            out.peak_hz = (peak + offset) * bin_hz;
+        }
+    }
+
+private:
+    static constexpr SpectrumWindow<N> window = spectrum_hann<N>();
+
+    float bin_hz;
+    float edge[Bands + 1];
+    FftComplex block[N / 2];
+    FftComplex bins[BINS];
+};
+
+template <int N, int Bands>
+constexpr SpectrumWindow<N> SpectrumAnalyzer<N, Bands>::window;
+
+#endif // SPECTRUM_H
@@ -0,0 +1,39 @@
+/**
+ * @file spi_tune.cpp
+ *
+ * @brief Start-up search for the fastest reliable SPI clock of a device.
+ *
+ */
+
+#include "spi_tune.h"
+
+bool spi_verify(TunableBus &bus, uint16_t div, uint32_t rounds) {
+    if (!bus.set_clock_div(div)) {
+        return false;
+    }
+    for (uint32_t round = 0; round < rounds; round++) {
+        if (!bus.self_test(round)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+SpiTuneResult spi_tune(TunableBus &bus, const uint16_t *divs, size_t count, uint32_t rounds) {
+    SpiTuneResult result = {false, count ? divs[0] : (uint16_t)0, 0};
+
+    for (size_t i = 0; i < count; i++) {
+        if (!spi_verify(bus, divs[i], rounds)) {
+            result.failed_div = divs[i];
+            break;
+        }
+        result.ok = true;
+        result.div = divs[i];
+    }
+
+    // Leave the bus on the chosen clock, not on the step that failed.
+    if (count) {
+        bus.set_clock_div(result.div);
+    }
+    return result;
+}
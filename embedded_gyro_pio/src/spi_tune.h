@@ -0,0 +1,52 @@
+/**
+ * @file spi_tune.h
+ *
+ * @brief Start-up search for the fastest reliable SPI clock of a device.
+ *
+ * The datasheet limit is a worst case over temperature and wiring. The
+ * clock is stepped up from the slowest candidate and each step has to
+ * pass a number of link self-test rounds; the search stops at the first
+ * step that fails and keeps the last one that passed.
+ *
+ * The search talks to the device through the TunableBus interface, so it
+ * can run against the real link or a scripted fake.
+ *
+ */
+
+#ifndef SPI_TUNE_H
+#define SPI_TUNE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Self-test rounds a clock step has to pass.
+#define SPI_TUNE_ROUNDS 32
+
+// Link whose clock can be changed and checked.
+class TunableBus {
+public:
+    virtual ~TunableBus() {}
+
+    // Selects clock divider div. Returns false if not supported.
+    virtual bool set_clock_div(uint16_t div) = 0;
+
+    // Runs one round of link checks at the current clock; round varies
+    // the test patterns. Returns false on any mismatch.
+    virtual bool self_test(uint32_t round) = 0;
+};
+
+struct SpiTuneResult {
+    bool ok;                // At least the slowest candidate passed.
+    uint16_t div;           // Divider left selected.
+    uint16_t failed_div;    // First divider that failed (0: none did).
+};
+
+// True if div is supported and passes rounds self-tests.
+bool spi_verify(TunableBus &bus, uint16_t div, uint32_t rounds = SPI_TUNE_ROUNDS);
+
+// Steps through divs (slowest clock first) and leaves the bus on the
+// fastest divider that passed. If none passes, selects divs[0].
+SpiTuneResult spi_tune(TunableBus &bus, const uint16_t *divs, size_t count,
+                       uint32_t rounds = SPI_TUNE_ROUNDS);
+
+#endif // SPI_TUNE_H
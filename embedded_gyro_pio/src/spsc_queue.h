@@ -0,0 +1,79 @@
+/**
+ * @file spsc_queue.h
+ *
+ * @brief Bounded lock-free queue between one producer and one consumer.
+ *
+ * Hands items from one thread (or ISR) to another without a mutex or a
+ * critical section: the producer only ever writes head, the consumer
+ * only ever writes tail, and acquire/release ordering on those indices
+ * publishes the slot contents. The indices run freely and are masked
+ * with the power-of-two capacity, so full and empty are told apart
+ * without giving up a slot.
+ *
+ * At any time at most one context may push and one may pop.
+ *
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdint.h>
+#include <atomic>
+
+template <typename T, uint32_t N>
+class SpscQueue {
+    static_assert(N != 0 && (N & (N - 1)) == 0, "capacity must be a power of two");
+
+public:
+    // Producer side. Returns false (and counts the drop) if the queue is full.
+    bool push(const T &item) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        uint32_t used = h - tail.load(std::memory_order_acquire);
+        if (used == N) {
+            dropped++;
+            return false;
+        }
+        slots[h & (N - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        if (used + 1 > high_water) {
+            high_water = used + 1;
+        }
+        return true;
+    }
+
+    // Consumer side. Returns false if the queue is empty.
+    bool pop(T &item) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = slots[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Items waiting. Exact from either side, a snapshot from anywhere else.
+    uint32_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+
+    static constexpr uint32_t capacity() { return N; }
+
+    // Pushes rejected because the queue was full, and the deepest the
+    // queue has been, since boot.
+    uint32_t drops() const { return dropped; }
+    uint32_t peak() const { return high_water; }
+
+private:
+    T slots[N];
+    std::atomic<uint32_t> head{0};      // Next slot to write (producer).
+    std::atomic<uint32_t> tail{0};      // Next slot to read (consumer).
+
+    // Producer only.
+    volatile uint32_t dropped = 0;
+    volatile uint32_t high_water = 0;
+};
+
+#endif // SPSC_QUEUE_H
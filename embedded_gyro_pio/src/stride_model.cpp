@@ -0,0 +1,105 @@
+/**
+ * @file stride_model.cpp
+ *
+ * @brief Stride detection and per-user stride length model.
+ *
+ */
+
+#include "stride_model.h"
+#include <math.h>
+
+// Below this det / (s_tt * s_ff), the walks do not differ enough in
+// cadence to separate the two parameters.
+#define STRIDE_CAL_MIN_DET_RATIO 1e-3f
+
+// Fitted radius accepted (m per rad).
+#define STRIDE_RADIUS_MIN 0.05f
+#define STRIDE_RADIUS_MAX 1.5f
+
+void stride_calibration_add(StrideCalibration &cal, float sum_theta, float sum_ftheta, float distance_m) {
+    cal.s_tt += sum_theta * sum_theta;
+    cal.s_tf += sum_theta * sum_ftheta;
+    cal.s_ff += sum_ftheta * sum_ftheta;
+    cal.s_td += sum_theta * distance_m;
+    cal.s_fd += sum_ftheta * distance_m;
+    cal.walks++;
+}
+
+// Positive radius in range, and positive stride lengths over the whole
+// cadence range.
+static bool stride_params_plausible(const StrideParams &p) {
+    return p.radius_m >= STRIDE_RADIUS_MIN && p.radius_m <= STRIDE_RADIUS_MAX &&
+           p.radius_m + p.cadence_gain / STRIDE_MAX_TIME > 0.0f &&
+           p.radius_m + p.cadence_gain / STRIDE_MIN_TIME > 0.0f;
+}
+
+StrideParams stride_calibration_solve(const StrideCalibration &cal, const StrideParams &defaults) {
+    if (cal.walks == 0) {
+        return defaults;
+    }
+
+    float det = cal.s_tt * cal.s_ff - cal.s_tf * cal.s_tf;
+    if (cal.walks >= 2 && det > STRIDE_CAL_MIN_DET_RATIO * cal.s_tt * cal.s_ff) {
+        StrideParams p;
+        p.radius_m = (cal.s_td * cal.s_ff - cal.s_fd * cal.s_tf) / det;
+        p.cadence_gain = (cal.s_tt * cal.s_fd - cal.s_tf * cal.s_td) / det;
+        if (stride_params_plausible(p)) {
+            return p;
+        }
+    }
+
+    // Best gain k on the defaults: minimise sum (D - k * predicted)^2.
+    float r = defaults.radius_m;
+    float g = defaults.cadence_gain;
+    float pp = r * r * cal.s_tt + 2.0f * r * g * cal.s_tf + g * g * cal.s_ff;
+    if (pp <= 0.0f) {
+        return defaults;
+    }
+    float k = (r * cal.s_td + g * cal.s_fd) / pp;
+    StrideParams p = {k * r, k * g};
+    return stride_params_plausible(p) ? p : defaults;
+}
+
+void StrideDetector::reset() {
+    stride_count = 0;
+    theta_total = 0.0f;
+    ftheta_total = 0.0f;
+    stride_time = 0.0f;
+    open_theta = 0.0f;
+    open_time = 0.0f;
+    in_stride = false;
+    armed = false;
+    last_abs_rate = 0.0f;
+}
+
+void StrideDetector::update(float rate_z, float dt_s) {
+    // Trapezoidal rule, counting the backward swing too.
+    float abs_rate = fabsf(rate_z);
+    open_theta += (abs_rate + last_abs_rate) * 0.5f * dt_s;
+    open_time += dt_s;
+    last_abs_rate = abs_rate;
+
+    if (rate_z < -STRIDE_RATE_THRESHOLD) {
+        armed = true;
+    } else if (rate_z > STRIDE_RATE_THRESHOLD && armed) {
+        armed = false;
+        // A stride cut short by a stumble or a twitch carries on.
+        if (!in_stride || open_time >= STRIDE_MIN_TIME) {
+            end_segment();
+            in_stride = true;
+        }
+    }
+}
+
+void StrideDetector::end_segment() {
+    // A lead-in or a pause only adds to the angle.
+    theta_total += open_theta;
+    if (in_stride && open_time <= STRIDE_MAX_TIME) {
+        float f = 1.0f / open_time;
+        ftheta_total += f * open_theta;
+        stride_time += open_time;
+        stride_count++;
+    }
+    open_theta = 0.0f;
+    open_time = 0.0f;
+}
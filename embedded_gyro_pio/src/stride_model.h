@@ -0,0 +1,114 @@
+/**
+ * @file stride_model.h
+ *
+ * @brief Stride detection and per-user stride length model.
+ *
+ * The gyroscope sits on the thigh, so its Z rate swings positive and
+ * negative once per stride (one gait cycle of that leg). StrideDetector
+ * splits the rate into strides at its rising crossings through
+ * +STRIDE_RATE_THRESHOLD, after it has been below -STRIDE_RATE_THRESHOLD
+ * (hysteresis, so noise around zero does not split a stride).
+ *
+ * For each stride it has the angle swept (integral of |rate|, both
+ * swings) and the cadence f = 1 / stride time, and the length is
+ *
+ *     L = theta * (radius + cadence_gain * f)
+ *
+ * i.e. an effective leg radius that grows with walking speed. With
+ * cadence_gain = 0 this is the fixed-radius s = theta * r. Angle swept
+ * outside a complete stride of plausible duration (start, end, pauses)
+ * counts with the radius alone, so a whole walk comes to
+ *
+ *     D = radius * sum(theta) + cadence_gain * sum(f * theta)
+ *
+ * The parameters are learned from walks of known distance: every walk
+ * adds its two sums to the normal equations of a least-squares fit
+ * (StrideCalibration), which fits both parameters once walks at
+ * different cadences are in, and only a gain on the defaults before
+ * that. tools/fit_stride.py does the same fit on a host from exported
+ * sessions.
+ *
+ */
+
+#ifndef STRIDE_MODEL_H
+#define STRIDE_MODEL_H
+
+#include <stdint.h>
+
+// Z rate (rad/s) a swing has to exceed to count.
+#define STRIDE_RATE_THRESHOLD 0.6f
+
+// Shortest and longest stride time (s) taken as walking.
+#define STRIDE_MIN_TIME 0.5f
+#define STRIDE_MAX_TIME 2.5f
+
+// Length of a walk of known distance used for calibration (m).
+#define STRIDE_CAL_DISTANCE_M 20.0f
+
+struct StrideParams {
+    float radius_m;             // Effective radius (m per rad swept).
+    float cadence_gain;         // Added radius per stride/s of cadence (m s per rad).
+};
+
+// Normal equations of the least-squares fit of D over all calibration
+// walks. Persisted as is (RECORD_STRIDE_CALIBRATION); the parameters
+// follow from it.
+struct StrideCalibration {
+    float s_tt;                 // sum over walks of sum(theta)^2
+    float s_tf;                 // ... sum(theta) * sum(f theta)
+    float s_ff;                 // ... sum(f theta)^2
+    float s_td;                 // ... sum(theta) * distance
+    float s_fd;                 // ... sum(f theta) * distance
+    uint32_t walks;
+};
+
+// Adds one walk of known distance.
+void stride_calibration_add(StrideCalibration &cal, float sum_theta, float sum_ftheta, float distance_m);
+
+// Fitted parameters. With too few or too similar walks, the defaults
+// scaled to fit best; without walks, the defaults.
+StrideParams stride_calibration_solve(const StrideCalibration &cal, const StrideParams &defaults);
+
+class StrideDetector {
+public:
+    explicit StrideDetector(const StrideParams &params) : params(params) {}
+
+    void set_params(const StrideParams &p) { params = p; }
+    const StrideParams &parameters() const { return params; }
+
+    void reset();
+
+    // One Z rate sample (rad/s), dt_s after the previous one.
+    void update(float rate_z, float dt_s);
+
+    // Complete strides so far.
+    uint32_t strides() const { return stride_count; }
+
+    // Angle swept so far (rad), and the sum of f * theta over the
+    // complete strides. Both are what calibration needs of a walk.
+    float sum_theta() const { return theta_total + open_theta; }
+    float sum_ftheta() const { return ftheta_total; }
+
+    // Distance so far (m), including the stride in progress.
+    float distance_m() const { return params.radius_m * sum_theta() + params.cadence_gain * ftheta_total; }
+
+    // Mean cadence over the complete strides (strides/s).
+    float cadence() const { return stride_count ? stride_count / stride_time : 0.0f; }
+
+private:
+    void end_segment();
+
+    StrideParams params;
+    uint32_t stride_count = 0;
+    float theta_total = 0.0f;   // Of the closed segments.
+    float ftheta_total = 0.0f;
+    float stride_time = 0.0f;   // Total duration of the complete strides.
+
+    float open_theta = 0.0f;    // Segment since the last boundary.
+    float open_time = 0.0f;
+    bool in_stride = false;     // The open segment started at a boundary.
+    bool armed = false;         // Rate went below -threshold since the boundary.
+    float last_abs_rate = 0.0f;
+};
+
+#endif // STRIDE_MODEL_H
@@ -0,0 +1,64 @@
+/**
+ * @file thread_monitor.cpp
+ *
+ * @brief Per-thread stack and CPU usage reporting.
+ *
+ */
+
+#include "thread_monitor.h"
+#include "number_format.h"
+
+bool ThreadMonitor::add(const char *name, osThreadId_t id, const ThreadLoad &load) {
+    if (count >= THREAD_MONITOR_MAX) {
+        return false;
+    }
+    Entry &e = entries[count++];
+    e.name = name;
+    e.id = id;
+    e.load = &load;
+    e.busy_last = load.busy_cycles;
+    e.cpu_percent = 0.0f;
+    e.cpu_peak = 0.0f;
+    if (count == 1) {
+        cycles_last = cycle_counter_read();
+    }
+    return true;
+}
+
+void ThreadMonitor::sample() {
+    uint32_t now = cycle_counter_read();
+    uint32_t elapsed = now - cycles_last;
+    cycles_last = now;
+    if (elapsed == 0) {
+        return;
+    }
+
+    for (int i = 0; i < count; i++) {
+        Entry &e = entries[i];
+        uint32_t busy = e.load->busy_cycles;
+        e.cpu_percent = (100.0f * (uint32_t)(busy - e.busy_last)) / elapsed;
+        e.busy_last = busy;
+        if (e.cpu_percent > e.cpu_peak) {
+            e.cpu_peak = e.cpu_percent;
+        }
+    }
+}
+
+void ThreadMonitor::reset_peaks() {
+    for (int i = 0; i < count; i++) {
+        entries[i].cpu_peak = 0.0f;
+    }
+}
+
+void ThreadMonitor::report() const {
+    for (int i = 0; i < count; i++) {
+        const Entry &e = entries[i];
+        uint32_t size = osThreadGetStackSize(e.id);
+        uint32_t used = size - osThreadGetStackSpace(e.id);
+        bool tight = (size != 0) && (used * 100 >= size * THREAD_MONITOR_STACK_WARN);
+        printf("Thread %-7s prio %2d, stack %4lu/%4lu B%s, cpu %s%% (peak %s%%)\n",
+               e.name, (int)osThreadGetPriority(e.id),
+               (unsigned long)used, (unsigned long)size, tight ? " (!)" : "",
+               FixedText(e.cpu_percent, 2, 5).c_str(), FixedText(e.cpu_peak, 2, 5).c_str());
+    }
+}
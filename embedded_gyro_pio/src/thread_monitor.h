@@ -0,0 +1,77 @@
+/**
+ * @file thread_monitor.h
+ *
+ * @brief Per-thread stack and CPU usage reporting.
+ *
+ * Every monitored thread wraps its work in a BusyScope, which adds the
+ * DWT cycles spent to the thread's ThreadLoad. Once a second sample()
+ * turns the cycle counts into a CPU share per thread and keeps the peak,
+ * so a report taken after a recording shows the worst second rather than
+ * an average diluted by idle time.
+ *
+ * Stack usage is the RTX high-water mark (stack watermarking is enabled
+ * by platform.stack-stats-enabled in mbed_app.json): the deepest the
+ * stack has been since the thread started, against its allocated size.
+ *
+ */
+
+#ifndef THREAD_MONITOR_H
+#define THREAD_MONITOR_H
+
+#include <mbed.h>
+#include "cycle_counter.h"
+
+// Most threads that can be registered.
+#define THREAD_MONITOR_MAX 6
+
+// Stack use (percent of the allocation) flagged in the report.
+#define THREAD_MONITOR_STACK_WARN 75
+
+// Busy time of one thread. Only the thread itself adds to it.
+struct ThreadLoad {
+    volatile uint32_t busy_cycles = 0;  // Wraps; only differences are used.
+};
+
+// Counts the enclosing scope as busy time of a thread.
+class BusyScope {
+public:
+    explicit BusyScope(ThreadLoad &load) : load(load), start(cycle_counter_read()) {}
+    ~BusyScope() { load.busy_cycles += cycle_counter_read() - start; }
+
+private:
+    ThreadLoad &load;
+    uint32_t start;
+};
+
+class ThreadMonitor {
+public:
+    // Registers a thread. name must outlive the monitor.
+    // Returns false if THREAD_MONITOR_MAX threads are registered already.
+    bool add(const char *name, osThreadId_t id, const ThreadLoad &load);
+
+    // Updates the CPU shares. Call about once per second (the cycle
+    // counter wraps after ~23 s at 180 MHz).
+    void sample();
+
+    // Clears the CPU peaks.
+    void reset_peaks();
+
+    // Prints priority, stack high-water mark and CPU share of each thread.
+    void report() const;
+
+private:
+    struct Entry {
+        const char *name;
+        osThreadId_t id;
+        const ThreadLoad *load;
+        uint32_t busy_last;
+        float cpu_percent;          // During the last sample period.
+        float cpu_peak;             // Highest cpu_percent since reset_peaks().
+    };
+
+    Entry entries[THREAD_MONITOR_MAX];
+    int count = 0;
+    uint32_t cycles_last = 0;
+};
+
+#endif // THREAD_MONITOR_H
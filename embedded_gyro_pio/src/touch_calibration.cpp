@@ -0,0 +1,93 @@
+/**
+ * @file touch_calibration.cpp
+ *
+ * @brief Raw touch-panel readings to screen pixels.
+ *
+ */
+
+#include "touch_calibration.h"
+#include <math.h>
+
+// Bounds checked by touch_calibration_valid(). With |raw| <= 4095, two
+// terms of at most 2^28 plus an offset of at most 2^30 stay inside int32.
+#define TOUCH_CAL_MAX_GAIN   (1L << TOUCH_CAL_SHIFT)
+#define TOUCH_CAL_MAX_OFFSET (1L << 30)
+
+// Smallest |determinant| of the raw triangle (raw LSB^2) accepted by
+// touch_calibration_solve(): targets less than ~100 LSB apart are mostly noise.
+#define TOUCH_CAL_MIN_DET 10000.0
+
+// Half a pixel, folded into the offsets so the shift rounds to nearest.
+#define HALF_PIXEL (1L << (TOUCH_CAL_SHIFT - 1))
+
+static int32_t to_fixed(double v) {
+    return (int32_t)lround(v * (double)(1L << TOUCH_CAL_SHIFT));
+}
+
+TouchCalibration touch_calibration_default() {
+    // BSP_TS_GetState(): x = (3870 - raw_x) / 15, y = (raw_y - 360) / 11.
+    TouchCalibration cal;
+    cal.a = to_fixed(-1.0 / 15.0);
+    cal.b = 0;
+    cal.c = to_fixed(3870.0 / 15.0) + HALF_PIXEL;
+    cal.d = 0;
+    cal.e = to_fixed(1.0 / 11.0);
+    cal.f = to_fixed(-360.0 / 11.0) + HALF_PIXEL;
+    return cal;
+}
+
+bool touch_calibration_solve(const TouchPoint raw[3], const TouchPoint screen[3], TouchCalibration &out) {
+    // Cramer's rule on the differences to the third point, which keeps the
+    // products small and exact in double.
+    double x0 = raw[0].x - raw[2].x, y0 = raw[0].y - raw[2].y;
+    double x1 = raw[1].x - raw[2].x, y1 = raw[1].y - raw[2].y;
+    double det = x0 * y1 - x1 * y0;
+    if (fabs(det) < TOUCH_CAL_MIN_DET) {
+        return false;
+    }
+
+    double sx0 = screen[0].x - screen[2].x, sx1 = screen[1].x - screen[2].x;
+    double sy0 = screen[0].y - screen[2].y, sy1 = screen[1].y - screen[2].y;
+
+    double a = (sx0 * y1 - sx1 * y0) / det;
+    double b = (x0 * sx1 - x1 * sx0) / det;
+    double d = (sy0 * y1 - sy1 * y0) / det;
+    double e = (x0 * sy1 - x1 * sy0) / det;
+    double c = screen[2].x - a * raw[2].x - b * raw[2].y;
+    double f = screen[2].y - d * raw[2].x - e * raw[2].y;
+
+    // Range check in double first, to_fixed() would overflow on garbage.
+    if (fabs(a) > 1.0 || fabs(b) > 1.0 || fabs(d) > 1.0 || fabs(e) > 1.0 ||
+        fabs(c) > 8192.0 || fabs(f) > 8192.0) {
+        return false;
+    }
+
+    TouchCalibration cal;
+    cal.a = to_fixed(a);
+    cal.b = to_fixed(b);
+    cal.c = to_fixed(c) + HALF_PIXEL;
+    cal.d = to_fixed(d);
+    cal.e = to_fixed(e);
+    cal.f = to_fixed(f) + HALF_PIXEL;
+    if (!touch_calibration_valid(cal)) {
+        return false;
+    }
+    out = cal;
+    return true;
+}
+
+bool touch_calibration_valid(const TouchCalibration &cal) {
+    const int32_t gains[4] = {cal.a, cal.b, cal.d, cal.e};
+    for (int i = 0; i < 4; i++) {
+        if (gains[i] > TOUCH_CAL_MAX_GAIN || gains[i] < -TOUCH_CAL_MAX_GAIN) {
+            return false;
+        }
+    }
+    if (cal.c > TOUCH_CAL_MAX_OFFSET || cal.c < -TOUCH_CAL_MAX_OFFSET ||
+        cal.f > TOUCH_CAL_MAX_OFFSET || cal.f < -TOUCH_CAL_MAX_OFFSET) {
+        return false;
+    }
+
+    // The panel must not fold onto a line (all-zero EEPROM reads, say).
+    return (int64_t)cal.a * cal.e != (int64_t)cal.b * cal.d;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file touch_calibration.h
+ *
+ * @brief Raw touch-panel readings to screen pixels.
+ *
+ * The panel and the LCD are related by an affine map
+ *
+ *     x = a * raw_x + b * raw_y + c
+ *     y = d * raw_x + e * raw_y + f
+ *
+ * which covers offset, scale, a small rotation and a swapped or mirrored
+ * axis. The six coefficients are solved once from three touched targets
+ * (the slow part, in floating point) and kept in fixed point with
+ * TOUCH_CAL_SHIFT fractional bits, so mapping a sample costs four
+ * multiplies, a shift and a clamp, with no divide.
+ *
+ * The default transform reproduces the hard-coded mapping of
+ * BSP_TS_GetState() for boards that have not been calibrated.
+ *
+ */
+
+#ifndef TOUCH_CALIBRATION_H
+#define TOUCH_CALIBRATION_H
+
+#include <stdint.h>
+
+// Fractional bits of the transform coefficients.
+#define TOUCH_CAL_SHIFT 16
+
+// Screen the panel coordinates are mapped to (px).
+#define TOUCH_SCREEN_WIDTH  240
+#define TOUCH_SCREEN_HEIGHT 320
+
+// Largest raw panel reading (12-bit ADC).
+#define TOUCH_RAW_MAX 4095
+
+struct TouchPoint {
+    int16_t x, y;
+};
+
+// Fixed-point affine transform, coefficients in Q(TOUCH_CAL_SHIFT).
+// c and f carry an extra half pixel so the final shift rounds.
+struct TouchCalibration {
+    int32_t a, b, c;            // x = (a * raw_x + b * raw_y + c) >> TOUCH_CAL_SHIFT
+    int32_t d, e, f;            // y = (d * raw_x + e * raw_y + f) >> TOUCH_CAL_SHIFT
+};
+
+// Transform matching BSP_TS_GetState().
+TouchCalibration touch_calibration_default();
+
+// Solves the transform that takes each raw[i] to screen[i]. Returns false
+// if the raw points are (nearly) on one line or the result is not a
+// plausible panel mapping (see touch_calibration_valid()).
+bool touch_calibration_solve(const TouchPoint raw[3], const TouchPoint screen[3], TouchCalibration &out);
+
+// True if the coefficients are in the range a real panel produces, which
+// also keeps touch_calibration_apply() clear of 32-bit overflow. Used to
+// reject corrupt or degenerate stored calibrations.
+bool touch_calibration_valid(const TouchCalibration &cal);
+
+// Maps one raw reading to a screen position, clamped to the screen.
+inline TouchPoint touch_calibration_apply(const TouchCalibration &cal, uint16_t raw_x, uint16_t raw_y) {
+    int32_t x = (cal.a * (int32_t)raw_x + cal.b * (int32_t)raw_y + cal.c) >> TOUCH_CAL_SHIFT;
+    int32_t y = (cal.d * (int32_t)raw_x + cal.e * (int32_t)raw_y + cal.f) >> TOUCH_CAL_SHIFT;
+    TouchPoint p;
+    p.x = (int16_t)(x < 0 ? 0 : x >= TOUCH_SCREEN_WIDTH ? TOUCH_SCREEN_WIDTH - 1 : x);
+    p.y = (int16_t)(y < 0 ? 0 : y >= TOUCH_SCREEN_HEIGHT ? TOUCH_SCREEN_HEIGHT - 1 : y);
+    return p;
+}
+
+#endif // TOUCH_CALIBRATION_H
@@ -0,0 +1,197 @@
+/**
+ * @file touch_input.cpp
+ *
+ * @brief Interrupt-driven touch-screen input (STMPE811 on I2C3).
+ *
+ */
+
+#include "touch_input.h"
+#include "drivers/stm32f429i_discovery.h"
+#include "drivers/stmpe811.h"
+
+#define TS_ADDR TS_I2C_ADDRESS
+
+// Bytes per FIFO sample read from TSC_DATA_NON_INC: X (12 bits), Y (12 bits), Z (8 bits).
+#define TOUCH_SAMPLE_SIZE 4
+
+// SYS_CTRL1 soft reset.
+#define SYS_CTRL1_SOFT_RESET 0x02
+
+// ADC: 80 clock sample time, 12 bit; ADC clock 3.25 MHz.
+#define ADC_CTRL1_CONFIG 0x49
+#define ADC_CTRL2_CONFIG 0x01
+
+// TSC: 4 sample average, 500 us touch detect delay, 500 us settling.
+#define TSC_CFG_CONFIG 0x9A
+
+// FIFO_STA reset bit.
+#define FIFO_STA_RESET 0x01
+
+static uint32_t now_ms() {
+    return (uint32_t)Kernel::Clock::now().time_since_epoch().count();
+}
+
+TouchInput::TouchInput(EventLoop &loop, PinName int_pin)
+    : loop(loop), irq(int_pin, PullUp) {
+}
+
+bool TouchInput::init(Handler on_gesture) {
+    IOE_Init();
+
+    uint16_t id = (uint16_t)((IOE_Read(TS_ADDR, STMPE811_REG_CHP_ID_LSB) << 8) |
+                             IOE_Read(TS_ADDR, STMPE811_REG_CHP_ID_MSB));
+    if (id != STMPE811_ID) {
+        return false;
+    }
+    handler = on_gesture;
+
+    IOE_Write(TS_ADDR, STMPE811_REG_SYS_CTRL1, SYS_CTRL1_SOFT_RESET);
+    IOE_Delay(10);
+    IOE_Write(TS_ADDR, STMPE811_REG_SYS_CTRL1, 0);
+    IOE_Delay(2);
+
+    // SYS_CTRL2 holds clock *disable* bits: run GPIO, then hand the touch
+    // pins to the TSC and run TSC and ADC.
+    uint8_t clocks = IOE_Read(TS_ADDR, STMPE811_REG_SYS_CTRL2);
+    clocks &= ~STMPE811_IO_FCT;
+    IOE_Write(TS_ADDR, STMPE811_REG_SYS_CTRL2, clocks);
+    uint8_t af = IOE_Read(TS_ADDR, STMPE811_REG_IO_AF);
+    IOE_Write(TS_ADDR, STMPE811_REG_IO_AF, (uint8_t)(af & ~STMPE811_TOUCH_IO_ALL));
+    clocks &= ~(STMPE811_TS_FCT | STMPE811_ADC_FCT);
+    IOE_Write(TS_ADDR, STMPE811_REG_SYS_CTRL2, clocks);
+
+    IOE_Write(TS_ADDR, STMPE811_REG_ADC_CTRL1, ADC_CTRL1_CONFIG);
+    IOE_Delay(2);
+    IOE_Write(TS_ADDR, STMPE811_REG_ADC_CTRL2, ADC_CTRL2_CONFIG);
+    IOE_Write(TS_ADDR, STMPE811_REG_TSC_CFG, TSC_CFG_CONFIG);
+
+    IOE_Write(TS_ADDR, STMPE811_REG_FIFO_TH, TOUCH_FIFO_THRESHOLD);
+    IOE_Write(TS_ADDR, STMPE811_REG_FIFO_STA, FIFO_STA_RESET);
+    IOE_Write(TS_ADDR, STMPE811_REG_FIFO_STA, 0);
+
+    IOE_Write(TS_ADDR, STMPE811_REG_TSC_FRACT_XYZ, 0x01);
+    IOE_Write(TS_ADDR, STMPE811_REG_TSC_I_DRIVE, 0x01);
+    IOE_Write(TS_ADDR, STMPE811_REG_TSC_CTRL, STMPE811_TS_CTRL_ENABLE);
+
+    // Touch / release, FIFO threshold and overflow; active low, level.
+    IOE_Write(TS_ADDR, STMPE811_REG_INT_STA, 0xFF);
+    IOE_Write(TS_ADDR, STMPE811_REG_INT_EN, STMPE811_GIT_TOUCH | STMPE811_GIT_FTH | STMPE811_GIT_FOV);
+    IOE_Write(TS_ADDR, STMPE811_REG_INT_CTRL, STMPE811_GIT_EN);
+
+    irq.fall(callback(this, &TouchInput::on_irq));
+    ready = true;
+    return true;
+}
+
+void TouchInput::on_irq() {
+    schedule(0ms);
+}
+
+void TouchInput::schedule(std::chrono::milliseconds delay) {
+    if (service_queued) {
+        return;
+    }
+    service_queued = true;
+    int id = (delay.count() == 0) ? loop.post([this]() { service(); })
+                                  : loop.post_in(delay, [this]() { service(); });
+    if (id == 0) {
+        service_queued = false;
+    }
+}
+
+void TouchInput::dispatch(const GestureEvent &event) {
+    if (event.gesture != Gesture::None && handler) {
+        handler(event);
+    }
+}
+
+void TouchInput::capture_raw(CaptureHandler done) {
+    capture_done = done;
+    capture_sum_x = 0;
+    capture_sum_y = 0;
+    capture_count = 0;
+    capture_wait_release = gestures.active();
+}
+
+void TouchInput::finish_capture() {
+    if (capture_count < GESTURE_MIN_SAMPLES) {
+        // A brush or a bounce: wait for a proper contact.
+        capture_raw(capture_done);
+        return;
+    }
+    TouchPoint raw;
+    raw.x = (int16_t)(capture_sum_x / capture_count);
+    raw.y = (int16_t)(capture_sum_y / capture_count);
+    CaptureHandler done = capture_done;
+    capture_done = nullptr;
+    done(raw);
+}
+
+void TouchInput::service() {
+    service_queued = false;
+
+    if (bus_busy && bus_busy()) {
+        schedule(TOUCH_BUS_RETRY);
+        return;
+    }
+
+    uint8_t status = IOE_Read(TS_ADDR, STMPE811_REG_INT_STA);
+    uint32_t time_ms = now_ms();
+
+    if (status & STMPE811_GIT_FOV) {
+        // Readings were lost; the positions left are stale, start over.
+        IOE_Write(TS_ADDR, STMPE811_REG_FIFO_STA, FIFO_STA_RESET);
+        IOE_Write(TS_ADDR, STMPE811_REG_FIFO_STA, 0);
+    }
+
+    uint8_t level = IOE_Read(TS_ADDR, STMPE811_REG_FIFO_SIZE);
+    uint8_t buf[TOUCH_BURST * TOUCH_SAMPLE_SIZE];
+    while (level > 0) {
+        uint8_t n = (level > TOUCH_BURST) ? TOUCH_BURST : level;
+        if (IOE_ReadMultiple(TS_ADDR, STMPE811_REG_TSC_DATA_NON_INC, buf, n * TOUCH_SAMPLE_SIZE) != 0) {
+            break;
+        }
+        burst_count++;
+        sample_count += n;
+        for (uint8_t i = 0; i < n; i++) {
+            const uint8_t *s = &buf[i * TOUCH_SAMPLE_SIZE];
+            uint16_t raw_x = (uint16_t)((s[0] << 4) | (s[1] >> 4));
+            uint16_t raw_y = (uint16_t)(((s[1] & 0x0F) << 8) | s[2]);
+            if (capture_done) {
+                if (capture_wait_release) {
+                    continue;
+                }
+                capture_sum_x += raw_x;
+                capture_sum_y += raw_y;
+                capture_count++;
+                continue;
+            }
+            TouchPoint p;
+            {
+                CycleScope scope(map_stats);
+                p = touch_calibration_apply(transform, raw_x, raw_y);
+            }
+            dispatch(gestures.sample(p.x, p.y, time_ms));
+        }
+        level -= n;
+    }
+
+    IOE_Write(TS_ADDR, STMPE811_REG_INT_STA, status);
+
+    if (IOE_Read(TS_ADDR, STMPE811_REG_TSC_CTRL) & STMPE811_TS_CTRL_STATUS) {
+        // Still touched: come back for the release and long presses.
+        if (!capture_done) {
+            dispatch(gestures.poll(time_ms));
+        }
+        schedule(TOUCH_HOLD_CHECK);
+    } else if (capture_done) {
+        if (capture_wait_release) {
+            capture_wait_release = false;
+            gestures.release(time_ms);
+        } else if (capture_count > 0) {
+            finish_capture();
+        }
+    } else if (gestures.active()) {
+        dispatch(gestures.release(time_ms));
+    }
+}
@@ -0,0 +1,113 @@
+/**
+ * @file touch_input.h
+ *
+ * @brief Interrupt-driven touch-screen input (STMPE811 on I2C3).
+ *
+ * The STMPE811 samples the panel on its own and queues the readings in
+ * its FIFO. Its interrupt line (PA_15) fires on touch / release and
+ * whenever the FIFO reaches TOUCH_FIFO_THRESHOLD; only then is the FIFO
+ * drained, in bursts of up to TOUCH_BURST samples per I2C transaction,
+ * from the event loop. While a contact is held, a slow timer checks for
+ * the release and long presses. Nothing runs while the panel is idle.
+ *
+ * Raw readings are mapped to the screen through a TouchCalibration and go
+ * through a GestureDetector; the resulting gestures are handed to the
+ * application on the event loop thread. For calibration, a contact can
+ * instead be captured raw: its readings are averaged and reported once
+ * it is lifted.
+ *
+ * The BSP touch-screen driver (BSP_TS_*) depends on the stmpe811
+ * component driver, which is not part of this tree, so the controller is
+ * programmed here through the IOE_* link functions of the BSP.
+ *
+ */
+
+#ifndef TOUCH_INPUT_H
+#define TOUCH_INPUT_H
+
+#include <mbed.h>
+#include "event_loop.h"
+#include "gesture.h"
+#include "touch_calibration.h"
+#include "cycle_counter.h"
+
+// FIFO level that raises an interrupt while a contact is held.
+#define TOUCH_FIFO_THRESHOLD 16
+
+// Most samples read in one I2C burst.
+#define TOUCH_BURST 16
+
+// Release / long-press check period while a contact is held.
+#define TOUCH_HOLD_CHECK 30ms
+
+// Retry delay while the I2C bus is in use by someone else.
+#define TOUCH_BUS_RETRY 2ms
+
+class TouchInput {
+public:
+    typedef mbed::Callback<void(GestureEvent)> Handler;
+    typedef mbed::Callback<void(TouchPoint)> CaptureHandler;
+
+    explicit TouchInput(EventLoop &loop, PinName int_pin = PA_15);
+
+    // Probes and configures the controller and enables its interrupt.
+    // Returns false if no STMPE811 answers.
+    bool init(Handler handler);
+
+    // The I2C bus is shared (EEPROM). While busy() returns true, FIFO
+    // reads are postponed.
+    void set_bus_busy(mbed::Callback<bool()> busy) { bus_busy = busy; }
+
+    bool present() const { return ready; }
+
+    // Raw to screen mapping (touch_calibration_default() until set).
+    void set_calibration(const TouchCalibration &cal) { transform = cal; }
+    const TouchCalibration &calibration() const { return transform; }
+
+    // Reports the average raw reading of the next contact to done(), on
+    // release, instead of turning it into a gesture. A contact already in
+    // progress (e.g. the long press that asked for this) is ignored.
+    void capture_raw(CaptureHandler done);
+    void cancel_capture() { capture_done = nullptr; }
+
+    // Cycles spent mapping one raw reading to the screen.
+    const CycleStats &map_cycles() const { return map_stats; }
+
+    // Samples read and I2C bursts used since boot.
+    uint32_t samples_read() const { return sample_count; }
+    uint32_t bursts() const { return burst_count; }
+
+private:
+    // Interrupt line asserted.
+    void on_irq();
+
+    // Drains the FIFO and updates the gesture state (event loop thread).
+    void service();
+
+    // Queues service() unless it is already queued.
+    void schedule(std::chrono::milliseconds delay);
+
+    void dispatch(const GestureEvent &event);
+
+    // Contact lifted while capturing.
+    void finish_capture();
+
+    EventLoop &loop;
+    InterruptIn irq;
+    GestureDetector gestures;
+    Handler handler;
+    mbed::Callback<bool()> bus_busy;
+    TouchCalibration transform = touch_calibration_default();
+    CaptureHandler capture_done;
+    uint32_t capture_sum_x = 0, capture_sum_y = 0;
+    uint16_t capture_count = 0;
+    bool capture_wait_release = false;
+    CycleStats map_stats;
+    bool ready = false;
+    volatile bool service_queued = false;
+
+    uint32_t sample_count = 0;
+    uint32_t burst_count = 0;
+};
+
+#endif // TOUCH_INPUT_H
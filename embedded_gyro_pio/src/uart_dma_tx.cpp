@@ -0,0 +1,144 @@
+/**
+ * @file uart_dma_tx.cpp
+ *
+ * @brief DMA-driven UART transmit ring.
+ *
+ */
+
+#include "uart_dma_tx.h"
+#include <string.h>
+
+// UART5 TX request is on DMA1 stream 7, channel 4.
+#define TX_DMA          DMA1
+#define TX_DMA_STREAM   DMA1_Stream7
+#define TX_DMA_CHANNEL  4
+#define TX_DMA_IRQn     DMA1_Stream7_IRQn
+#define TX_DMA_FLAGS    (DMA_HIFCR_CTCIF7 | DMA_HIFCR_CHTIF7 | DMA_HIFCR_CTEIF7 | DMA_HIFCR_CDMEIF7 | DMA_HIFCR_CFEIF7)
+#define TX_UART         UART5
+
+// SerialBase brings the port up at this rate; set_baud() then sets the real one.
+#define TX_INIT_BAUD    115200
+
+// Below the gyroscope data-ready and I2C interrupts.
+#define TX_DMA_PRIORITY 0x0E
+
+#define RING_MASK (UART_DMA_TX_RING_SIZE - 1)
+
+static_assert((UART_DMA_TX_RING_SIZE & RING_MASK) == 0, "ring size must be a power of two");
+
+static UartDmaTx *active_tx = nullptr;
+
+static void tx_dma_irq_handler() {
+    if (active_tx) {
+        active_tx->on_dma_irq();
+    }
+}
+
+UartDmaTx::UartDmaTx(PinName tx, PinName rx, int baud) : SerialBase(tx, rx, TX_INIT_BAUD) {
+    active_tx = this;
+    set_baud(baud);
+
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    TX_DMA_STREAM->CR = 0;
+    while (TX_DMA_STREAM->CR & DMA_SxCR_EN) {
+    }
+    TX_DMA->HIFCR = TX_DMA_FLAGS;
+
+    // Memory to peripheral, byte wide, memory increment, complete interrupt.
+    TX_DMA_STREAM->PAR = (uint32_t)&TX_UART->DR;
+    TX_DMA_STREAM->CR = (TX_DMA_CHANNEL << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_DIR_0 |
+                        DMA_SxCR_MINC | DMA_SxCR_PL_0 | DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+    TX_DMA_STREAM->FCR = 0;
+
+    TX_UART->CR3 |= USART_CR3_DMAT;
+
+    NVIC_DisableIRQ(TX_DMA_IRQn);
+    NVIC_SetPriority(TX_DMA_IRQn, TX_DMA_PRIORITY);
+    NVIC_SetVector(TX_DMA_IRQn, (uint32_t)tx_dma_irq_handler);
+    NVIC_EnableIRQ(TX_DMA_IRQn);
+}
+
+void UartDmaTx::set_baud(int baud) {
+    // pclk / baud is USARTDIV times the oversampling. At 16x that is BRR
+    // as is; at 8x BRR keeps three fraction bits, with bit 3 left clear.
+    uint32_t pclk = HAL_RCC_GetPCLK1Freq();
+    uint32_t div = (pclk + (uint32_t)baud / 2) / (uint32_t)baud;
+    bool over8 = div < 16;
+
+    TX_UART->CR1 &= ~USART_CR1_UE;
+    if (over8) {
+        TX_UART->CR1 |= USART_CR1_OVER8;
+        TX_UART->BRR = ((div >> 3) << 4) | (div & 7);
+    } else {
+        TX_UART->CR1 &= ~USART_CR1_OVER8;
+        TX_UART->BRR = div;
+    }
+    TX_UART->CR1 |= USART_CR1_UE;
+}
+
+size_t UartDmaTx::space() const {
+    return UART_DMA_TX_RING_SIZE - (head - tail);
+}
+
+bool UartDmaTx::write(const uint8_t *data, size_t len) {
+    if (len > space()) {
+        dropped += len;
+        return false;
+    }
+
+    // Copy in at most two pieces, around the end of the ring.
+    uint32_t at = head & RING_MASK;
+    size_t first = UART_DMA_TX_RING_SIZE - at;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(&ring[at], data, first);
+    memcpy(&ring[0], data + first, len - first);
+
+    CriticalSectionLock lock;
+    head += len;
+    if (!active) {
+        start_dma();
+    }
+    return true;
+}
+
+void UartDmaTx::start_dma() {
+    uint32_t pending = head - tail;
+    if (pending == 0) {
+        active = false;
+        return;
+    }
+
+    // One contiguous run; a wrapped ring takes a second transfer.
+    uint32_t at = tail & RING_MASK;
+    chunk = UART_DMA_TX_RING_SIZE - at;
+    if (chunk > pending) {
+        chunk = pending;
+    }
+
+    active = true;
+    TX_DMA->HIFCR = TX_DMA_FLAGS;
+    TX_DMA_STREAM->M0AR = (uint32_t)&ring[at];
+    TX_DMA_STREAM->NDTR = chunk;
+    TX_DMA_STREAM->CR |= DMA_SxCR_EN;
+}
+
+void UartDmaTx::on_dma_irq() {
+    uint32_t status = TX_DMA->HISR;
+    TX_DMA->HIFCR = TX_DMA_FLAGS;
+
+    if (status & DMA_HISR_TEIF7) {
+        // Transfer error: skip the run rather than stall the ring.
+        dropped += chunk;
+    } else if (!(status & DMA_HISR_TCIF7)) {
+        return;
+    } else {
+        sent += chunk;
+    }
+
+    tail += chunk;
+    chunk = 0;
+    start_dma();
+}
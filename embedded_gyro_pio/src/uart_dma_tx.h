@@ -0,0 +1,66 @@
+/**
+ * @file uart_dma_tx.h
+ *
+ * @brief DMA-driven UART transmit ring.
+ *
+ * Bytes are copied into a RAM ring and drained to the UART by DMA, one
+ * contiguous run at a time, so the CPU never waits on the line. Only
+ * UART5 (TX on PC12, DMA1 stream 7 channel 4) is wired up: a port of its
+ * own, so nothing else writes between the DMA bytes. stdio stays on the
+ * STLink virtual COM port (USART1).
+ *
+ * UART5 runs off the 45 MHz APB1 clock; the baud rate is programmed with
+ * 8x oversampling when 16x cannot reach it, which allows up to 5.6 Mbaud
+ * (3 Mbaud, 300 kB/s, is exact).
+ *
+ */
+
+#ifndef UART_DMA_TX_H
+#define UART_DMA_TX_H
+
+#include <mbed.h>
+#include "export_frames.h"
+
+// Ring capacity in bytes (power of two).
+#define UART_DMA_TX_RING_SIZE 8192
+
+class UartDmaTx : public FrameSink, private SerialBase {
+public:
+    // Sets UART5 up on the given pins at the given baud rate and claims its
+    // TX DMA stream.
+    UartDmaTx(PinName tx, PinName rx, int baud);
+
+    // Queues len bytes. All or nothing: returns false (and counts the
+    // drop) if they do not fit. Call from one thread only.
+    bool write(const uint8_t *data, size_t len) override;
+
+    // Free space in the ring.
+    size_t space() const override;
+
+    // True while the DMA is still draining the ring.
+    bool busy() const { return active; }
+
+    uint32_t bytes_sent() const { return sent; }
+    uint32_t bytes_dropped() const { return dropped; }
+
+    // DMA stream interrupt.
+    void on_dma_irq();
+
+private:
+    // Programs the baud rate divider, with 8x oversampling if needed.
+    void set_baud(int baud);
+
+    // Starts the DMA on the next contiguous run. Interrupts must be off.
+    void start_dma();
+
+    uint8_t ring[UART_DMA_TX_RING_SIZE];
+    volatile uint32_t head = 0;         // Write index (producer).
+    volatile uint32_t tail = 0;         // Read index (DMA).
+    volatile uint32_t chunk = 0;        // Bytes in the running DMA transfer.
+    volatile bool active = false;
+
+    volatile uint32_t sent = 0;
+    uint32_t dropped = 0;
+};
+
+#endif // UART_DMA_TX_H
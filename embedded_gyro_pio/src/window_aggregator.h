@@ -0,0 +1,233 @@
+/**
+ * @file window_aggregator.h
+ *
+ * @brief Incremental aggregates over tumbling or sliding sample windows.
+ *
+ * A window is length long and a new one ends every hop, both counted in
+ * samples or in microseconds of sample time. hop == length gives
+ * tumbling windows, hop < length sliding ones (length must be a whole
+ * number of hops, at most MaxPanes).
+ *
+ * The stream is cut into panes of one hop each. Every sample updates
+ * only the pane in progress: count, sum, sum of squares, min, max and
+ * the trapezoidal integrals of the value and of its magnitude, all in
+ * integers, so O(1) per sample with no per-sample storage. When a pane
+ * closes, the window ending with it is merged from the last
+ * length / hop panes (exact, as the sums are integers) and handed to
+ * the caller.
+ *
+ * Time windows are aligned to multiples of hop on the sample clock; a
+ * gap longer than a hop closes empty panes. Sample windows close a pane
+ * on its hop-th sample. The integral segment between two samples counts
+ * in the pane of the later one, so consecutive windows cover the stream
+ * without gaps or overlap (tumbling case).
+ *
+ */
+
+#ifndef WINDOW_AGGREGATOR_H
+#define WINDOW_AGGREGATOR_H
+
+#include <math.h>
+#include <stdint.h>
+
+enum class WindowBasis : uint8_t {
+    Samples,        // length and hop in samples
+    Time            // length and hop in microseconds
+};
+
+struct WindowConfig {
+    WindowBasis basis;
+    uint32_t length;
+    uint32_t hop;
+};
+
+// Aggregates of one channel over a pane or a window, in raw units.
+struct ChannelStats {
+    int64_t sum;
+    uint64_t sum_sq;
+    int16_t min;
+    int16_t max;
+    int64_t integral2;          // Twice the integral of the value (LSB * us).
+    uint64_t abs_integral2;     // Twice the integral of |value| (LSB * us).
+
+    void clear() {
+        sum = 0;
+        sum_sq = 0;
+        min = INT16_MAX;
+        max = INT16_MIN;
+        integral2 = 0;
+        abs_integral2 = 0;
+    }
+
+    void merge(const ChannelStats &o) {
+        sum += o.sum;
+        sum_sq += o.sum_sq;
+        min = (o.min < min) ? o.min : min;
+        max = (o.max > max) ? o.max : max;
+        integral2 += o.integral2;
+        abs_integral2 += o.abs_integral2;
+    }
+};
+
+template <int Channels>
+struct WindowResult {
+    uint32_t first_us;          // Time-stamps of the first and last sample.
+    uint32_t last_us;
+    uint32_t count;             // Samples in the window.
+    ChannelStats ch[Channels];
+
+    float mean(int c) const { return count ? (float)ch[c].sum / count : 0.0f; }
+    float rms(int c) const { return count ? sqrtf((float)ch[c].sum_sq / count) : 0.0f; }
+
+    // Integrals over time, in LSB * s.
+    float integral(int c) const { return ch[c].integral2 * 0.5e-6f; }
+    float abs_integral(int c) const { return ch[c].abs_integral2 * 0.5e-6f; }
+};
+
+template <int Channels, int MaxPanes>
+class WindowAggregator {
+public:
+    WindowAggregator() { reset(); }
+
+    // Returns false, keeping the previous setup, if length is not 1 to
+    // MaxPanes whole hops. Resets the aggregator.
+    bool configure(const WindowConfig &c) {
+        if (c.hop == 0 || c.length % c.hop != 0 || c.length / c.hop < 1 || c.length / c.hop > MaxPanes) {
+            return false;
+        }
+        cfg = c;
+        panes_per_window = (int)(c.length / c.hop);
+        reset();
+        return true;
+    }
+
+    void reset() {
+        started = false;
+        panes_closed = 0;
+        newest = 0;
+        for (int p = 0; p < MaxPanes; p++) {
+            clear_pane(panes[p]);
+        }
+    }
+
+    // One sample. on_window(const WindowResult<Channels> &) is called for
+    // every window it completes.
+    template <typename F>
+    void update(uint32_t timestamp_us, const int16_t v[Channels], F on_window) {
+        if (!started) {
+            started = true;
+            pane_end = (cfg.basis == WindowBasis::Time) ? (timestamp_us / cfg.hop + 1) * cfg.hop : 0;
+            for (int c = 0; c < Channels; c++) {
+                prev[c] = v[c];
+            }
+            prev_us = timestamp_us;
+        }
+
+        if (cfg.basis == WindowBasis::Time) {
+            while ((int32_t)(timestamp_us - pane_end) >= 0) {
+                close_pane(on_window);
+                pane_end += cfg.hop;
+            }
+        }
+
+        Pane &pane = panes[newest];
+        if (pane.count == 0) {
+            pane.first_us = timestamp_us;
+        }
+        pane.last_us = timestamp_us;
+        pane.count++;
+        uint32_t dt = timestamp_us - prev_us;
+        for (int c = 0; c < Channels; c++) {
+            ChannelStats &s = pane.ch[c];
+            int32_t x = v[c];
+            s.sum += x;
+            s.sum_sq += (uint64_t)(x * x);
+            s.min = (v[c] < s.min) ? v[c] : s.min;
+            s.max = (v[c] > s.max) ? v[c] : s.max;
+            int32_t p = prev[c];
+            s.integral2 += (int64_t)(p + x) * dt;
+            s.abs_integral2 += (uint64_t)(uint32_t)((p < 0 ? -p : p) + (x < 0 ? -x : x)) * dt;
+            prev[c] = v[c];
+        }
+        prev_us = timestamp_us;
+
+        if (cfg.basis == WindowBasis::Samples && pane.count >= cfg.hop) {
+            close_pane(on_window);
+        }
+    }
+
+    // Ends the stream: closes the pane in progress, if it holds samples,
+    // and reports the (short) window ending with it, even if the stream
+    // was shorter than one window.
+    template <typename F>
+    void flush(F on_window) {
+        if (started && panes[newest].count > 0) {
+            close_pane(on_window, true);
+        }
+    }
+
+    const WindowConfig &config() const { return cfg; }
+
+private:
+    struct Pane {
+        uint32_t first_us;
+        uint32_t last_us;
+        uint32_t count;
+        ChannelStats ch[Channels];
+    };
+
+    static void clear_pane(Pane &p) {
+        p.first_us = 0;
+        p.last_us = 0;
+        p.count = 0;
+        for (int c = 0; c < Channels; c++) {
+            p.ch[c].clear();
+        }
+    }
+
+    template <typename F>
+    void close_pane(F &on_window, bool last = false) {
+        panes_closed++;
+        if (panes_closed >= (uint32_t)panes_per_window || last) {
+            WindowResult<Channels> w;
+            w.count = 0;
+            for (int c = 0; c < Channels; c++) {
+                w.ch[c].clear();
+            }
+            // Oldest pane first, so first_us comes from the earliest one
+            // holding samples.
+            for (int k = panes_per_window - 1; k >= 0; k--) {
+                const Pane &p = panes[(newest + MaxPanes - k) % MaxPanes];
+                if (p.count == 0) {
+                    continue;
+                }
+                if (w.count == 0) {
+                    w.first_us = p.first_us;
+                }
+                w.last_us = p.last_us;
+                w.count += p.count;
+                for (int c = 0; c < Channels; c++) {
+                    w.ch[c].merge(p.ch[c]);
+                }
+            }
+            if (w.count > 0) {
+                on_window(w);
+            }
+        }
+        newest = (newest + 1) % MaxPanes;
+        clear_pane(panes[newest]);
+    }
+
+    WindowConfig cfg = {WindowBasis::Samples, 1, 1};
+    int panes_per_window = 1;
+
+    Pane panes[MaxPanes];
+    int newest;                 // Pane in progress.
+    uint32_t panes_closed;
+    uint32_t pane_end;          // Time basis: end of the pane in progress.
+    bool started;
+    int16_t prev[Channels];
+    uint32_t prev_us;
+};
+
+#endif // WINDOW_AGGREGATOR_H
@@ -0,0 +1,112 @@
+/**
+ * @file file_eeprom.h
+ *
+ * @brief EepromDevice backed by a file, for the native tests.
+ *
+ * The file stands in for the 24LC EEPROM: blank bytes read as 0xFF and it
+ * keeps its contents between two instances, so a test can "power cycle"
+ * a store by mounting a new one over the same file. Reads and writes are
+ * counted, and writes can be made to fail or to stop part way (a torn
+ * write) to check how the stores recover. With deferred set, a write's
+ * completion is held back until sync(), as EepromWriter reports it
+ * later from its own thread.
+ *
+ */
+
+#ifndef FILE_EEPROM_H
+#define FILE_EEPROM_H
+
+#include "record_store.h"
+#include <stdio.h>
+#include <string.h>
+
+class FileEeprom : public EepromDevice {
+public:
+    // Opens path, creating it blank (all 0xFF) if it does not exist.
+    FileEeprom(const char *path, uint32_t size) : size(size) {
+        file = fopen(path, "r+b");
+        if (file == NULL) {
+            file = fopen(path, "w+b");
+            uint8_t blank[64];
+            memset(blank, 0xFF, sizeof(blank));
+            for (uint32_t done = 0; file != NULL && done < size; done += sizeof(blank)) {
+                fwrite(blank, 1, sizeof(blank), file);
+            }
+        }
+    }
+
+    ~FileEeprom() {
+        if (file != NULL) {
+            fclose(file);
+        }
+    }
+
+    // Deletes the file, so the next FileEeprom over it starts blank.
+    static void erase(const char *path) { remove(path); }
+
+    bool read(uint16_t addr, uint8_t *buf, uint16_t len) override {
+        reads++;
+        if (file == NULL || addr + len > size || fseek(file, addr, SEEK_SET) != 0) {
+            return false;
+        }
+        return fread(buf, 1, len, file) == len;
+    }
+
+    bool write(uint16_t addr, const uint8_t *buf, uint16_t len, EepromWriteDone done, void *context) override {
+        writes++;
+        if (file == NULL || addr + len > size || fseek(file, addr, SEEK_SET) != 0) {
+            return false;
+        }
+        sync();
+
+        bool ok;
+        if (pass_writes > 0 && (fail_writes > 0 || tear_after >= 0)) {
+            pass_writes--;
+            ok = fwrite(buf, 1, len, file) == len;
+        } else if (fail_writes > 0) {
+            fail_writes--;
+            ok = false;
+        } else if (tear_after >= 0 && tear_after < len) {
+            // Power lost part way: the bytes so far are written, the rest
+            // keep what was there.
+            fwrite(buf, 1, (size_t)tear_after, file);
+            tear_after = -1;
+            ok = false;
+        } else {
+            ok = fwrite(buf, 1, len, file) == len;
+        }
+        fflush(file);
+
+        pending_done = done;
+        pending_context = context;
+        pending_ok = ok;
+        if (!deferred) {
+            sync();
+        }
+        return true;
+    }
+
+    void sync() override {
+        EepromWriteDone done = pending_done;
+        pending_done = NULL;
+        if (done != NULL) {
+            done(pending_context, pending_ok);
+        }
+    }
+
+    uint32_t size;
+    uint32_t reads = 0;
+    uint32_t writes = 0;
+    int fail_writes = 0;        // Writes still to fail.
+    int tear_after = -1;        // Bytes the next write stops after (-1: none).
+    int pass_writes = 0;        // Writes that land before those two apply.
+    bool deferred = false;      // Hold completions back until sync().
+
+private:
+    FILE *file;
+    EepromWriteDone pending_done = NULL;
+    void *pending_context = NULL;
+    bool pending_ok = false;
+};
+
+#endif // FILE_EEPROM_H
@@ -0,0 +1,119 @@
+/**
+ * @file mock_gyro_bus.cpp
+ *
+ * @brief The GYRO_IO_* link of the L3GD20 register model (mock_gyro_bus.h).
+ *
+ */
+
+#include "mock_gyro_bus.h"
+
+MockGyro mock_gyro;
+
+// One register as the device would return it.
+static uint8_t mock_gyro_output_byte(const int16_t *sample, uint8_t addr) {
+    uint16_t v = (uint16_t)sample[(addr - L3GD20_OUT_X_L_ADDR) / 2];
+    bool high = ((addr - L3GD20_OUT_X_L_ADDR) & 1) != 0;
+    if (mock_gyro.regs[L3GD20_CTRL_REG4_ADDR] & L3GD20_BLE_MSB) {
+        high = !high;
+    }
+    return high ? (uint8_t)(v >> 8) : (uint8_t)v;
+}
+
+static void mock_gyro_transfer_in(uint8_t *buf, uint8_t addr, uint16_t len) {
+    bool fifo = (mock_gyro.regs[L3GD20_CTRL_REG5_ADDR] & L3GD20_FIFO_ENABLE) != 0;
+    for (uint16_t k = 0; k < len; k++) {
+        if (addr >= L3GD20_OUT_X_L_ADDR && addr <= L3GD20_OUT_Z_H_ADDR) {
+            const int16_t *sample = (fifo && mock_gyro.fifo_count > 0) ? mock_gyro.fifo[0] : mock_gyro.out;
+            buf[k] = mock_gyro_output_byte(sample, addr);
+            if (addr == L3GD20_OUT_Z_H_ADDR) {
+                mock_gyro.regs[L3GD20_STATUS_REG_ADDR] &= (uint8_t)~(L3GD20_STATUS_ZYXDA | L3GD20_STATUS_ZYXOR);
+                if (fifo) {
+                    if (mock_gyro.fifo_count > 0) {
+                        mock_gyro.fifo_ovrn = false;
+                        memmove(mock_gyro.fifo[0], mock_gyro.fifo[1], sizeof(mock_gyro.fifo[0]) * --mock_gyro.fifo_count);
+                    }
+                    addr = L3GD20_OUT_X_L_ADDR;
+                    continue;
+                }
+            }
+        } else if (addr == L3GD20_FIFO_SRC_REG_ADDR) {
+            buf[k] = (uint8_t)(mock_gyro.fifo_count == 0 ? L3GD20_FIFO_SRC_EMPTY : (mock_gyro.fifo_count & L3GD20_FIFO_SRC_FSS));
+            if (mock_gyro.fifo_ovrn) {
+                buf[k] |= L3GD20_FIFO_SRC_OVRN;
+            }
+        } else {
+            buf[k] = mock_gyro.regs[addr & 0x3F];
+        }
+        // A clock beyond what the wiring takes flips bits on the way in.
+        if (mock_gyro.max_div_ok != 0 && mock_gyro.clock_div < mock_gyro.max_div_ok) {
+            buf[k] ^= 0x01;
+        }
+        addr = (uint8_t)((addr + 1) & 0x3F);
+    }
+    mock_gyro.bytes_read += len;
+}
+
+extern "C" {
+
+void GYRO_IO_Init(void) {}
+
+void GYRO_IO_DeInit(void) {}
+
+void GYRO_IO_Write(uint8_t *pBuffer, uint8_t WriteAddr, uint16_t NumByteToWrite) {
+    mock_gyro_finish_dma();
+    mock_gyro.writes++;
+    mock_gyro.bytes_written += NumByteToWrite;
+    mock_gyro.last_addr = WriteAddr;
+    mock_gyro.last_len = NumByteToWrite;
+    for (uint16_t k = 0; k < NumByteToWrite; k++) {
+        uint8_t addr = (uint8_t)((WriteAddr + k) & 0x3F);
+        mock_gyro.regs[addr] = pBuffer[k];
+        if (mock_gyro.log_count < MOCK_GYRO_LOG_SIZE) {
+            mock_gyro.log_addr[mock_gyro.log_count] = addr;
+            mock_gyro.log_value[mock_gyro.log_count] = pBuffer[k];
+            mock_gyro.log_count++;
+        }
+    }
+}
+
+void GYRO_IO_Read(uint8_t *pBuffer, uint8_t ReadAddr, uint16_t NumByteToRead) {
+    mock_gyro_finish_dma();
+    mock_gyro.reads++;
+    mock_gyro.last_addr = ReadAddr;
+    mock_gyro.last_len = NumByteToRead;
+    mock_gyro_transfer_in(pBuffer, ReadAddr, NumByteToRead);
+}
+
+uint8_t GYRO_IO_ReadDMA(uint8_t *pBuffer, uint8_t ReadAddr, uint16_t NumByteToRead, GYRO_IO_CallbackTypeDef Callback) {
+    if (NumByteToRead == 0 || NumByteToRead > L3GD20_FIFO_DEPTH * L3GD20_SAMPLE_SIZE || mock_gyro.dma_busy) {
+        return 1;
+    }
+    mock_gyro.dma_reads++;
+    mock_gyro.last_addr = ReadAddr;
+    mock_gyro.last_len = NumByteToRead;
+    mock_gyro_transfer_in(pBuffer, ReadAddr, NumByteToRead);
+    mock_gyro.dma_busy = true;
+    mock_gyro.dma_callback = Callback;
+    if (!mock_gyro.defer_dma) {
+        mock_gyro_finish_dma();
+    }
+    return 0;
+}
+
+uint8_t GYRO_IO_IsBusy(void) {
+    return mock_gyro.dma_busy;
+}
+
+uint8_t GYRO_IO_SetClockDiv(uint16_t Div) {
+    if (Div < 2 || Div > 256 || (Div & (Div - 1)) != 0) {
+        return 1;
+    }
+    mock_gyro.clock_div = Div;
+    return 0;
+}
+
+uint16_t GYRO_IO_GetClockDiv(void) {
+    return mock_gyro.clock_div;
+}
+
+} // extern "C"
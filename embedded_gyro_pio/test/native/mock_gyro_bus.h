@@ -0,0 +1,123 @@
+/**
+ * @file mock_gyro_bus.h
+ *
+ * @brief Register model of the L3GD20 behind the BSP GYRO_IO_* link, for
+ *        the native tests.
+ *
+ * Stands in for the SPI layer of drivers/stm32f429i_discovery.c, so the
+ * L3GD20 driver and the code above it run unchanged on the host. The
+ * model keeps the device's register file, auto-increments through it on
+ * multi-byte transfers like the sensor does, and serves the output
+ * registers from a 32-sample FIFO when CTRL_REG5 FIFO_EN is set (a burst
+ * wraps from OUT_Z_H back to OUT_X_L and pops a sample). Overruns are
+ * flagged as the sensor flags them: STATUS_REG ZYXOR when a sample lands
+ * on an unread one, FIFO_SRC OVRN when the FIFO is full (stream mode
+ * then drops the oldest entry, FIFO mode the new sample). Every transfer
+ * is counted and every register write logged.
+ *
+ * DMA reads complete at once, or are held back with defer_dma until
+ * mock_gyro_finish_dma() runs the callback, as the DMA interrupt would.
+ * A blocking transfer meanwhile waits for the read to end, as the BSP's
+ * does, so the held-back callback runs first.
+ *
+ * The GYRO_IO_* functions and the model itself are in mock_gyro_bus.cpp,
+ * built with every native suite, as the L3GD20 driver is.
+ *
+ */
+
+#ifndef MOCK_GYRO_BUS_H
+#define MOCK_GYRO_BUS_H
+
+#include <string.h>
+#include "drivers/l3gd20.h"
+
+#define MOCK_GYRO_WHO_AM_I 0xD4
+#define MOCK_GYRO_LOG_SIZE 64
+
+struct MockGyro {
+    uint8_t regs[0x40];
+    int16_t out[3];                     // OUT_X..Z with the FIFO off.
+    int16_t fifo[L3GD20_FIFO_DEPTH][3];
+    int fifo_count;
+    bool fifo_ovrn;                     // FIFO_SRC OVRN, until a sample is read.
+
+    // Transfers, by kind, and the bytes they moved.
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t dma_reads;
+    uint32_t bytes_read;
+    uint32_t bytes_written;
+    uint8_t last_addr;
+    uint16_t last_len;
+
+    // Register writes in order.
+    uint8_t log_addr[MOCK_GYRO_LOG_SIZE];
+    uint8_t log_value[MOCK_GYRO_LOG_SIZE];
+    int log_count;
+
+    uint16_t clock_div;
+    uint16_t max_div_ok;                // Dividers below this corrupt reads (0: none do).
+
+    bool defer_dma;
+    bool dma_busy;
+    GYRO_IO_CallbackTypeDef dma_callback;
+};
+
+extern MockGyro mock_gyro;
+
+// Power-on state: WHO_AM_I set, CTRL_REG1 0x07 (axes on, powered down).
+static inline void mock_gyro_reset() {
+    memset(&mock_gyro, 0, sizeof(mock_gyro));
+    mock_gyro.regs[L3GD20_WHO_AM_I_ADDR] = MOCK_GYRO_WHO_AM_I;
+    mock_gyro.regs[L3GD20_CTRL_REG1_ADDR] = 0x07;
+    mock_gyro.clock_div = 16;
+}
+
+// Forgets the transfers and writes so far, keeping the device state.
+static inline void mock_gyro_clear_counts() {
+    mock_gyro.reads = 0;
+    mock_gyro.writes = 0;
+    mock_gyro.dma_reads = 0;
+    mock_gyro.bytes_read = 0;
+    mock_gyro.bytes_written = 0;
+    mock_gyro.log_count = 0;
+}
+
+// Latches a new sample: into the FIFO if it is on, else the output registers.
+static inline void mock_gyro_push_sample(int16_t x, int16_t y, int16_t z) {
+    if (mock_gyro.regs[L3GD20_CTRL_REG5_ADDR] & L3GD20_FIFO_ENABLE) {
+        if (mock_gyro.fifo_count == L3GD20_FIFO_DEPTH) {
+            mock_gyro.fifo_ovrn = true;
+            if ((mock_gyro.regs[L3GD20_FIFO_CTRL_REG_ADDR] & 0xE0) != L3GD20_FIFO_MODE_STREAM) {
+                return;
+            }
+            memmove(mock_gyro.fifo[0], mock_gyro.fifo[1], sizeof(mock_gyro.fifo[0]) * --mock_gyro.fifo_count);
+        }
+        int16_t *s = mock_gyro.fifo[mock_gyro.fifo_count++];
+        s[0] = x;
+        s[1] = y;
+        s[2] = z;
+    } else {
+        if (mock_gyro.regs[L3GD20_STATUS_REG_ADDR] & L3GD20_STATUS_ZYXDA) {
+            mock_gyro.regs[L3GD20_STATUS_REG_ADDR] |= L3GD20_STATUS_ZYXOR;
+        }
+        mock_gyro.out[0] = x;
+        mock_gyro.out[1] = y;
+        mock_gyro.out[2] = z;
+    }
+    mock_gyro.regs[L3GD20_STATUS_REG_ADDR] |= L3GD20_STATUS_ZYXDA;
+}
+
+// Runs the held-back DMA callback. Returns false if none was pending.
+static inline bool mock_gyro_finish_dma(uint8_t status = 0) {
+    if (!mock_gyro.dma_busy) {
+        return false;
+    }
+    mock_gyro.dma_busy = false;
+    if (mock_gyro.dma_callback != NULL) {
+        mock_gyro.dma_callback(status);
+    }
+    return true;
+}
+
+#endif // MOCK_GYRO_BUS_H
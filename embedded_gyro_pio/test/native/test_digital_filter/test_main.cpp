@@ -0,0 +1,234 @@
+/**
+ * @file test_main.cpp
+ *
+ * @brief Frequency response of the streaming filters: the gait low-pass
+ *        of main.cpp (float and Q15), the FIR and the notch, measured by
+ *        running sine waves through them, and their throughput on the
+ *        host.
+ *
+ */
+
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include "digital_filter.h"
+
+// The gait filter of main.cpp: 4th-order Butterworth at 15 Hz, 190 Hz.
+#define FS 190.0
+#define CUTOFF_HZ 15.0
+
+#define AMPLITUDE 10000.0
+
+static constexpr BiquadDesign<2> GAIT = biquad_butterworth_lowpass<2>(CUTOFF_HZ, FS);
+static constexpr BiquadDesignQ14<2> GAIT_Q14 = biquad_design_q14(GAIT);
+
+// Peak output over the last second of a four second sine at f Hz, as a
+// fraction of the input amplitude. Y gets the same sine negated and Z a
+// constant, to check the axes do not leak into each other.
+template <typename Filter>
+static double gain_at(Filter &filter, double f, double *y_gain = nullptr, int16_t *z_out = nullptr) {
+    filter.reset();
+    double peak_x = 0, peak_y = 0;
+    int n = (int)(4 * FS);
+    for (int i = 0; i < n; i++) {
+        int16_t v = (int16_t)lround(AMPLITUDE * sin(2 * FILTER_PI * f * i / FS));
+        int16_t xyz[3] = {v, (int16_t)-v, 1000};
+        filter.process(xyz);
+        if (i >= n - (int)FS) {
+            peak_x = fmax(peak_x, fabs((double)xyz[0]));
+            peak_y = fmax(peak_y, fabs((double)xyz[1]));
+        }
+        if (z_out) {
+            *z_out = xyz[2];
+        }
+    }
+    if (y_gain) {
+        *y_gain = peak_y / AMPLITUDE;
+    }
+    return peak_x / AMPLITUDE;
+}
+
+// |H| of an order 2N Butterworth low-pass at f.
+static double butterworth_gain(double f, int order) {
+    return 1.0 / sqrt(1.0 + pow(f / CUTOFF_HZ, 2 * order));
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_design_sin_cos() {
+    for (double x = -10.0; x <= 10.0; x += 0.01) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-12, sin(x), filter_sin(x));
+        TEST_ASSERT_FLOAT_WITHIN(1e-12, cos(x), filter_cos(x));
+    }
+}
+
+static void test_gait_lowpass_response() {
+    BiquadCascade<2> filter(GAIT);
+    // Walking passes, the cutoff is -3 dB, foot-strike vibration does not.
+    static const double freqs[] = {1.0, 3.0, 10.0, 15.0, 30.0, 60.0, 90.0};
+    for (unsigned k = 0; k < sizeof(freqs) / sizeof(freqs[0]); k++) {
+        double expected = butterworth_gain(freqs[k], 4);
+        // The bilinear transform compresses high frequencies a little,
+        // so the stop band comes out lower than the analog response.
+        double g = gain_at(filter, freqs[k]);
+        if (freqs[k] <= CUTOFF_HZ) {
+            TEST_ASSERT_FLOAT_WITHIN(0.01, expected, g);
+        } else {
+            TEST_ASSERT_TRUE(g <= expected * 1.01 + 1e-4);
+        }
+    }
+    TEST_ASSERT_TRUE(gain_at(filter, 60.0) < 0.005);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 0.7071, gain_at(filter, CUTOFF_HZ));
+}
+
+static void test_gait_lowpass_dc_and_axes() {
+    BiquadCascade<2> filter(GAIT);
+    double y_gain;
+    int16_t z;
+    double x_gain = gain_at(filter, 3.0, &y_gain, &z);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, x_gain, y_gain);
+    TEST_ASSERT_EQUAL_INT16(1000, z);           // Unity gain at DC.
+}
+
+static void test_q15_matches_float() {
+    BiquadCascade<2> ref(GAIT);
+    BiquadCascadeQ15<2> q15(GAIT_Q14);
+    int worst = 0;
+    for (int i = 0; i < (int)(4 * FS); i++) {
+        double t = i / FS;
+        int16_t v = (int16_t)lround(8000 * sin(2 * FILTER_PI * 2.0 * t) + 3000 * sin(2 * FILTER_PI * 40.0 * t));
+        int16_t a[3] = {v, (int16_t)(v / 2), (int16_t)-v};
+        int16_t b[3] = {v, (int16_t)(v / 2), (int16_t)-v};
+        ref.process(a);
+        q15.process(b);
+        for (int k = 0; k < 3; k++) {
+            int d = abs(a[k] - b[k]);
+            worst = d > worst ? d : worst;
+        }
+    }
+    // Coefficients rounded to 2^-14 and a rounded output per section.
+    TEST_ASSERT_LESS_OR_EQUAL(8, worst);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 0.7071, gain_at(q15, CUTOFF_HZ));
+}
+
+static void test_block_matches_single() {
+    BiquadCascade<2> single(GAIT);
+    BiquadCascade<2> block(GAIT);
+    int16_t a[64][3], b[64][3];
+    for (int i = 0; i < 64; i++) {
+        for (int k = 0; k < 3; k++) {
+            a[i][k] = b[i][k] = (int16_t)((i * 977 + k * 311) % 20000 - 10000);
+        }
+    }
+    for (int i = 0; i < 64; i++) {
+        single.process(a[i]);
+    }
+    block.process_block(b, 64);
+    TEST_ASSERT_EQUAL_MEMORY(a, b, sizeof(a));
+}
+
+static void test_saturates_instead_of_wrapping() {
+    // A step to full scale overshoots (Butterworth, order 4) and clips.
+    BiquadCascade<2> filter(GAIT);
+    int16_t xyz[3] = {0, 0, 0};
+    for (int i = 0; i < 200; i++) {
+        xyz[0] = 32767;
+        xyz[1] = -32768;
+        xyz[2] = 0;
+        filter.process(xyz);
+        TEST_ASSERT_TRUE(xyz[0] >= 0);
+        TEST_ASSERT_TRUE(xyz[1] <= 0);
+    }
+    TEST_ASSERT_EQUAL_INT16(32767, xyz[0]);
+}
+
+static void test_fir_lowpass_response() {
+    FirFilter<31> fir(fir_lowpass<31>(CUTOFF_HZ * 2, FS));
+    FirFilterQ15<31> fir_q15(fir_taps_q15(fir_lowpass<31>(CUTOFF_HZ * 2, FS)));
+    int16_t z;
+    TEST_ASSERT_TRUE(gain_at(fir, 2.0, nullptr, &z) > 0.98);
+    TEST_ASSERT_INT_WITHIN(1, 1000, z);
+    TEST_ASSERT_TRUE(gain_at(fir, 80.0) < 0.01);
+    TEST_ASSERT_FLOAT_WITHIN(0.002, gain_at(fir, 20.0), gain_at(fir_q15, 20.0));
+}
+
+static void test_notch_response() {
+    BiquadDesign<1> design = {{biquad_notch(50.0, 5.0, FS)}};
+    BiquadCascade<1> notch(design);
+    TEST_ASSERT_TRUE(gain_at(notch, 50.0) < 0.01);
+    TEST_ASSERT_TRUE(gain_at(notch, 5.0) > 0.99);
+    TEST_ASSERT_TRUE(gain_at(notch, 90.0) > 0.98);
+}
+
+// Samples per second (all three axes) through filter.process_block(),
+// over 10 s of noise at FS.
+template <typename Filter>
+static double samples_per_second(Filter &filter) {
+    static int16_t input[(int)(10 * FS)][3];
+    static int16_t block[(int)(10 * FS)][3];
+    const int n = (int)(10 * FS);
+    const int reps = 50;
+    uint32_t seed = 1;
+    for (int i = 0; i < n; i++) {
+        for (int k = 0; k < 3; k++) {
+            seed = seed * 1664525u + 1013904223u;
+            input[i][k] = (int16_t)(seed >> 18) - 8192;
+        }
+    }
+
+    typedef std::chrono::steady_clock clock;
+    double seconds = 0;
+    volatile int16_t sink = 0;
+    for (int rep = 0; rep < reps; rep++) {
+        memcpy(block, input, sizeof(block));
+        clock::time_point t0 = clock::now();
+        filter.process_block(block, n);
+        seconds += std::chrono::duration<double>(clock::now() - t0).count();
+        sink = sink + block[n - 1][0];
+    }
+    return (double)n * reps / seconds;
+}
+
+template <int Sections>
+static void report_biquad() {
+    constexpr BiquadDesign<Sections> design = biquad_butterworth_lowpass<Sections>(CUTOFF_HZ, FS);
+    BiquadCascade<Sections> single(design);
+    BiquadCascadeQ15<Sections> q15(biquad_design_q14(design));
+    printf("Biquad cascade, %d sections: float %.1f, Q15 %.1f Msamples/s\n", Sections,
+           samples_per_second(single) / 1e6, samples_per_second(q15) / 1e6);
+}
+
+template <int N>
+static void report_fir() {
+    FirFilter<N> fir(fir_lowpass<N>(CUTOFF_HZ * 2, FS));
+    printf("FIR, %d taps: %.1f Msamples/s\n", N, samples_per_second(fir) / 1e6);
+}
+
+// Not a pass/fail check (host timings vary): the throughput of each
+// filter per X/Y/Z sample, next to the FS samples/s it has to keep up with.
+static void test_report_throughput() {
+    report_biquad<1>();
+    report_biquad<2>();
+    report_biquad<4>();
+    report_fir<15>();
+    report_fir<31>();
+    report_fir<63>();
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_design_sin_cos);
+    RUN_TEST(test_gait_lowpass_response);
+    RUN_TEST(test_gait_lowpass_dc_and_axes);
+    RUN_TEST(test_q15_matches_float);
+    RUN_TEST(test_block_matches_single);
+    RUN_TEST(test_saturates_instead_of_wrapping);
+    RUN_TEST(test_fir_lowpass_response);
+    RUN_TEST(test_notch_response);
+    RUN_TEST(test_report_throughput);
+    return UNITY_END();
+}
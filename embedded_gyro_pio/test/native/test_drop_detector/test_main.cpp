@@ -0,0 +1,201 @@
+/**
+ * @file test_main.cpp
+ *
+ * @brief DropDetector accounting, with overruns injected through the
+ *        sensor's register model.
+ *
+ * A simulated acquisition loop latches one sample per period into the
+ * mock L3GD20 and reads it back, STATUS_REG first, with the driver's DMA
+ * burst as main.cpp does. Reads left out make the sensor raise ZYXOR on
+ * its own; the detector must count exactly the samples that were lost.
+ *
+ */
+
+#include <unity.h>
+#include "drop_detector.h"
+#include "../mock_gyro_bus.h"
+
+// 190 Hz data rate, as in main.cpp.
+#define PERIOD_US 5263
+
+// Application states passed through to the log (values of main.cpp's AppState).
+#define STATE_RECORDING 2
+#define STATE_DIAGNOSTICS 6
+
+static DropDetector drops(PERIOD_US);
+static uint8_t block[7];
+static uint32_t time_us;
+
+static void read_done(uint8_t) {}
+
+// One data-ready period: the sensor latches a sample; unless skipped,
+// acquisition reads it read_delay_us later and reports it.
+static void period(bool read, uint32_t read_delay_us = 100, uint8_t state = STATE_RECORDING) {
+    time_us += PERIOD_US;
+    mock_gyro_push_sample(1, 2, 3);
+    if (read) {
+        TEST_ASSERT_EQUAL_UINT8(0, L3GD20_ReadStatusXYZRawDMA(block, read_done));
+        drops.on_sample(block[0], time_us, time_us + read_delay_us, state);
+    }
+}
+
+void setUp() {
+    mock_gyro_reset();
+    drops.reset();
+    time_us = 0;
+}
+
+void tearDown() {}
+
+static void test_every_sample_read() {
+    for (int i = 0; i < 1000; i++) {
+        period(true);
+    }
+    TEST_ASSERT_EQUAL_UINT32(1000, drops.samples());
+    TEST_ASSERT_EQUAL_UINT32(0, drops.lost());
+    for (int c = 0; c < DROP_CAUSE_COUNT; c++) {
+        TEST_ASSERT_EQUAL_UINT32(0, drops.count((DropCause)c));
+    }
+    TEST_ASSERT_EQUAL_UINT32(100, drops.max_latency_us());
+    DropEvent e[DROP_LOG_SIZE];
+    TEST_ASSERT_EQUAL_UINT32(0, drops.events(e, DROP_LOG_SIZE));
+}
+
+static void test_skipped_reads_count_as_overruns() {
+    // One sample missed at 100, three in a row at 200.
+    for (int i = 0; i < 300; i++) {
+        bool skip = (i == 100) || (i >= 200 && i < 203);
+        period(!skip);
+    }
+    TEST_ASSERT_EQUAL_UINT32(296, drops.samples());
+    TEST_ASSERT_EQUAL_UINT32(2, drops.count(DROP_SENSOR_OVERRUN));
+    TEST_ASSERT_EQUAL_UINT32(4, drops.lost());
+    TEST_ASSERT_EQUAL_UINT32(0, drops.count(DROP_DEADLINE_MISS));
+
+    DropEvent e[DROP_LOG_SIZE];
+    TEST_ASSERT_EQUAL_UINT32(2, drops.events(e, DROP_LOG_SIZE));
+    TEST_ASSERT_EQUAL_UINT8(DROP_SENSOR_OVERRUN, e[0].cause);
+    TEST_ASSERT_EQUAL_UINT16(1, e[0].lost);
+    TEST_ASSERT_EQUAL_UINT32(102 * PERIOD_US, e[0].time_us);
+    TEST_ASSERT_EQUAL_UINT8(STATE_RECORDING, e[0].state);
+    TEST_ASSERT_EQUAL_UINT16(3, e[1].lost);
+    TEST_ASSERT_EQUAL_UINT32(204 * PERIOD_US, e[1].time_us);
+}
+
+static void test_overrun_gap_across_timer_wrap() {
+    time_us = 0xFFFFFFFFu - 2 * PERIOD_US;
+    period(true);
+    period(false);
+    period(false);
+    period(true);                       // Past the wrap.
+    TEST_ASSERT_EQUAL_UINT32(1, drops.count(DROP_SENSOR_OVERRUN));
+    TEST_ASSERT_EQUAL_UINT32(2, drops.lost());
+}
+
+static void test_overrun_without_history_counts_one() {
+    mock_gyro_push_sample(0, 0, 0);
+    period(true);
+    TEST_ASSERT_EQUAL_UINT32(1, drops.count(DROP_SENSOR_OVERRUN));
+    TEST_ASSERT_EQUAL_UINT32(1, drops.lost());
+}
+
+static void test_late_reads_are_deadline_misses() {
+    period(true, PERIOD_US);            // Due exactly as the next one lands: on time.
+    period(true, PERIOD_US + 1, STATE_DIAGNOSTICS);
+    period(true, 3 * PERIOD_US);
+    TEST_ASSERT_EQUAL_UINT32(2, drops.count(DROP_DEADLINE_MISS));
+    TEST_ASSERT_EQUAL_UINT32(0, drops.lost());
+    TEST_ASSERT_EQUAL_UINT32(3 * PERIOD_US, drops.max_latency_us());
+
+    DropEvent e[DROP_LOG_SIZE];
+    TEST_ASSERT_EQUAL_UINT32(2, drops.events(e, DROP_LOG_SIZE));
+    TEST_ASSERT_EQUAL_UINT8(DROP_DEADLINE_MISS, e[0].cause);
+    TEST_ASSERT_EQUAL_UINT8(STATE_DIAGNOSTICS, e[0].state);
+    TEST_ASSERT_EQUAL_UINT32(2 * PERIOD_US, e[0].time_us);
+}
+
+// Fills the FIFO past its depth in the given mode and reports FIFO_SRC.
+static void overflow_fifo(uint8_t mode) {
+    L3GD20_WriteReg(L3GD20_CTRL_REG5_ADDR, L3GD20_FIFO_ENABLE);
+    L3GD20_WriteReg(L3GD20_FIFO_CTRL_REG_ADDR, mode);
+    for (int i = 0; i < L3GD20_FIFO_DEPTH + 5; i++) {
+        mock_gyro_push_sample((int16_t)i, 0, 0);
+    }
+    uint8_t src = L3GD20_GetFIFOStatus();
+    TEST_ASSERT_TRUE(src & L3GD20_FIFO_SRC_OVRN);
+    drops.on_fifo(src, mode, 5000, STATE_RECORDING);
+}
+
+static void test_fifo_overflow_in_fifo_mode() {
+    overflow_fifo(L3GD20_FIFO_MODE_FIFO);
+    TEST_ASSERT_EQUAL_UINT32(1, drops.count(DROP_FIFO_OVERFLOW));
+    TEST_ASSERT_EQUAL_UINT32(1, drops.lost());
+}
+
+static void test_fifo_overflow_ignored_in_stream_mode() {
+    overflow_fifo(L3GD20_FIFO_MODE_STREAM);
+    TEST_ASSERT_EQUAL_UINT32(0, drops.count(DROP_FIFO_OVERFLOW));
+    TEST_ASSERT_EQUAL_UINT32(0, drops.lost());
+
+    // A FIFO_SRC with no overrun is not an event in any mode.
+    drops.on_fifo(L3GD20_FIFO_SRC_EMPTY, L3GD20_FIFO_MODE_FIFO, 0, STATE_RECORDING);
+    TEST_ASSERT_EQUAL_UINT32(0, drops.count(DROP_FIFO_OVERFLOW));
+}
+
+static void test_caller_reported_drops() {
+    drops.on_dropped(DROP_QUEUE_FULL, 3, 100, STATE_RECORDING);
+    drops.on_dropped(DROP_QUEUE_FULL, 0, 200, STATE_RECORDING);      // Nothing lost.
+    drops.on_dropped(DROP_CAUSE_COUNT, 5, 300, STATE_RECORDING);     // Not a cause.
+    TEST_ASSERT_EQUAL_UINT32(1, drops.count(DROP_QUEUE_FULL));
+    TEST_ASSERT_EQUAL_UINT32(3, drops.lost());
+}
+
+static void test_log_keeps_the_latest() {
+    for (int i = 0; i < DROP_LOG_SIZE + 4; i++) {
+        drops.on_dropped(DROP_QUEUE_FULL, 1, (uint32_t)i, STATE_RECORDING);
+    }
+    TEST_ASSERT_EQUAL_UINT32(DROP_LOG_SIZE + 4, drops.count(DROP_QUEUE_FULL));
+
+    DropEvent e[DROP_LOG_SIZE];
+    TEST_ASSERT_EQUAL_UINT32(DROP_LOG_SIZE, drops.events(e, DROP_LOG_SIZE));
+    for (int i = 0; i < DROP_LOG_SIZE; i++) {
+        TEST_ASSERT_EQUAL_UINT32(4 + i, e[i].time_us);
+    }
+
+    // Fewer asked for: the newest ones, still oldest first.
+    TEST_ASSERT_EQUAL_UINT32(2, drops.events(e, 2));
+    TEST_ASSERT_EQUAL_UINT32(DROP_LOG_SIZE + 2, e[0].time_us);
+    TEST_ASSERT_EQUAL_UINT32(DROP_LOG_SIZE + 3, e[1].time_us);
+}
+
+static void test_reset_starts_over() {
+    period(true);
+    period(false);
+    period(true, 2 * PERIOD_US);
+    drops.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, drops.samples());
+    TEST_ASSERT_EQUAL_UINT32(0, drops.lost());
+    TEST_ASSERT_EQUAL_UINT32(0, drops.max_latency_us());
+    DropEvent e[DROP_LOG_SIZE];
+    TEST_ASSERT_EQUAL_UINT32(0, drops.events(e, DROP_LOG_SIZE));
+
+    // The first sample after a reset has no previous time-stamp to measure from.
+    period(false);
+    period(true);
+    TEST_ASSERT_EQUAL_UINT32(1, drops.lost());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_every_sample_read);
+    RUN_TEST(test_skipped_reads_count_as_overruns);
+    RUN_TEST(test_overrun_gap_across_timer_wrap);
+    RUN_TEST(test_overrun_without_history_counts_one);
+    RUN_TEST(test_late_reads_are_deadline_misses);
+    RUN_TEST(test_fifo_overflow_in_fifo_mode);
+    RUN_TEST(test_fifo_overflow_ignored_in_stream_mode);
+    RUN_TEST(test_caller_reported_drops);
+    RUN_TEST(test_log_keeps_the_latest);
+    RUN_TEST(test_reset_starts_over);
+    return UNITY_END();
+}
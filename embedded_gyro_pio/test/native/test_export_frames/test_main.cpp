@@ -0,0 +1,250 @@
+/**
+ * @file test_main.cpp
+ *
+ * @brief Export frames: the CRC's check value, and every frame type
+ *        encoded, decoded as tools/decode_export.py does and compared
+ *        field for field, with line noise and a full ring in between.
+ *
+ */
+
+#include <unity.h>
+#include <string.h>
+#include <vector>
+#include "crc.h"
+#include "export_frames.h"
+#include "record_store.h"
+
+// FrameSink of a fixed capacity, drained only by the test.
+class BufferSink : public FrameSink {
+public:
+    explicit BufferSink(size_t capacity) : capacity(capacity) {}
+
+    bool write(const uint8_t *data, size_t len) override {
+        if (len > space()) {
+            return false;
+        }
+        bytes.insert(bytes.end(), data, data + len);
+        return true;
+    }
+
+    size_t space() const override { return capacity - bytes.size(); }
+
+    std::vector<uint8_t> bytes;
+    size_t capacity;
+};
+
+struct Decoded {
+    uint8_t type;
+    uint16_t seq;
+    std::vector<uint8_t> payload;
+};
+
+// FrameDecoder.feed() of tools/decode_export.py: find a SOF, check the
+// CRC, and on a mismatch skip that SOF byte and look again.
+static std::vector<Decoded> decode(const std::vector<uint8_t> &stream, int *rejected = NULL) {
+    std::vector<Decoded> frames;
+    size_t pos = 0;
+    while (pos < stream.size()) {
+        if (stream[pos] != FRAME_SOF) {
+            pos++;
+            continue;
+        }
+        if (pos + FRAME_HEADER_SIZE > stream.size()) {
+            break;
+        }
+        uint8_t len = stream[pos + 4];
+        size_t size = FRAME_HEADER_SIZE + len + FRAME_TRAILER_SIZE;
+        if (pos + size > stream.size()) {
+            break;
+        }
+        uint16_t crc = (uint16_t)(stream[pos + FRAME_HEADER_SIZE + len] |
+                                  (stream[pos + FRAME_HEADER_SIZE + len + 1] << 8));
+        if (crc16(&stream[pos + 1], FRAME_HEADER_SIZE - 1 + len) != crc) {
+            if (rejected != NULL) {
+                (*rejected)++;
+            }
+            pos++;
+            continue;
+        }
+        Decoded frame;
+        frame.type = stream[pos + 1];
+        frame.seq = (uint16_t)(stream[pos + 2] | (stream[pos + 3] << 8));
+        frame.payload.assign(stream.begin() + pos + FRAME_HEADER_SIZE,
+                             stream.begin() + pos + FRAME_HEADER_SIZE + len);
+        frames.push_back(frame);
+        pos += size;
+    }
+    return frames;
+}
+
+template <typename T>
+static void check_payload(const T &sent, const Decoded &frame, uint8_t type) {
+    TEST_ASSERT_EQUAL_UINT8(type, frame.type);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(T), frame.payload.size());
+    TEST_ASSERT_EQUAL_MEMORY(&sent, frame.payload.data(), sizeof(T));
+}
+
+static SessionStartFrame start_frame() {
+    SessionStartFrame start = {};
+    start.odr_hz = 190;
+    start.scale = 17.5e-3f * 0.017453292f;
+    start.live = 1;
+    start.filtered = 1;
+    return start;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_crc_check_value() {
+    // The catalogue check value of CRC-16/CCITT-FALSE.
+    TEST_ASSERT_EQUAL_HEX16(0x29B1, crc16("123456789", 9));
+    TEST_ASSERT_EQUAL_HEX16(0xFFFF, crc16("", 0));
+
+    // Piecewise gives the same as in one go.
+    uint16_t crc = crc16_update(CRC16_INIT, "1234", 4);
+    TEST_ASSERT_EQUAL_HEX16(0x29B1, crc16_update(crc, "56789", 5));
+}
+
+static void test_encode_layout() {
+    uint8_t payload[3] = {0x11, 0x22, 0x33};
+    uint8_t out[FRAME_MAX_SIZE];
+    TEST_ASSERT_EQUAL_UINT32(FRAME_HEADER_SIZE + 3 + FRAME_TRAILER_SIZE,
+                             frame_encode(out, FRAME_WINDOW, 0x1234, payload, sizeof(payload)));
+    static const uint8_t HEADER[] = {FRAME_SOF, FRAME_WINDOW, 0x34, 0x12, 3, 0x11, 0x22, 0x33};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(HEADER, out, sizeof(HEADER));
+    uint16_t crc = crc16(&out[1], 7);
+    TEST_ASSERT_EQUAL_UINT8(crc & 0xFF, out[8]);
+    TEST_ASSERT_EQUAL_UINT8(crc >> 8, out[9]);
+}
+
+static void test_every_frame_type_round_trips() {
+    BufferSink sink(8192);
+    FrameExporter exporter(sink);
+
+    SessionStartFrame start = start_frame();
+    TEST_ASSERT_TRUE(exporter.send(FRAME_SESSION_START, &start, sizeof(start)));
+
+    ExportSample samples[FRAME_SAMPLES_PER_FRAME + 3];
+    for (unsigned k = 0; k < sizeof(samples) / sizeof(samples[0]); k++) {
+        int16_t raw[3] = {(int16_t)(k * 7), (int16_t)(-32768 + k), (int16_t)(32767 - k)};
+        samples[k].timestamp_us = 5263 * k;
+        memcpy(samples[k].raw, raw, sizeof(raw));
+        TEST_ASSERT_TRUE(exporter.add_sample(samples[k].timestamp_us, raw));
+    }
+    TEST_ASSERT_TRUE(exporter.flush_samples());
+
+    WindowFrame window = {};
+    window.first_us = 1000;
+    window.last_us = 2000;
+    window.count = 64;
+    for (int axis = 0; axis < 3; axis++) {
+        window.mean[axis] = 1.5f * axis;
+        window.rms[axis] = 2.5f + axis;
+        window.min[axis] = (int16_t)(-100 * axis);
+        window.max[axis] = (int16_t)(100 * axis);
+        window.integral[axis] = -0.25f * axis;
+        window.swept[axis] = 0.75f * axis;
+    }
+    TEST_ASSERT_TRUE(exporter.send(FRAME_WINDOW, &window, sizeof(window)));
+
+    DiagnosticsFrame diagnostics = {};
+    diagnostics.samples = 100000;
+    diagnostics.lost = 3;
+    diagnostics.max_latency_us = 900;
+    for (int c = 0; c < DROP_CAUSE_COUNT; c++) {
+        diagnostics.counts[c] = (uint32_t)c + 1;
+    }
+    diagnostics.events = DROP_LOG_SIZE;
+    for (int k = 0; k < DROP_LOG_SIZE; k++) {
+        diagnostics.log[k].time_us = 1000u * k;
+        diagnostics.log[k].cause = (uint8_t)(k % DROP_CAUSE_COUNT);
+        diagnostics.log[k].state = 2;
+        diagnostics.log[k].lost = (uint16_t)k;
+    }
+    TEST_ASSERT_TRUE(exporter.send(FRAME_DIAGNOSTICS, &diagnostics, sizeof(diagnostics)));
+
+    SessionSummary summary = {12.5f, 60.0f, 11400, 4.2f, -1.57f, 17};
+    TEST_ASSERT_TRUE(exporter.send(FRAME_SESSION_END, &summary, sizeof(summary)));
+
+    std::vector<Decoded> frames = decode(sink.bytes);
+    TEST_ASSERT_EQUAL_UINT32(6, frames.size());
+    TEST_ASSERT_EQUAL_UINT32(6, exporter.frames_sent());
+    for (unsigned k = 0; k < frames.size(); k++) {
+        TEST_ASSERT_EQUAL_UINT16(k, frames[k].seq);
+    }
+
+    check_payload(start, frames[0], FRAME_SESSION_START);
+
+    // A full batch, then the rest.
+    TEST_ASSERT_EQUAL_UINT8(FRAME_SAMPLES, frames[1].type);
+    TEST_ASSERT_EQUAL_UINT32(FRAME_SAMPLES_PER_FRAME * sizeof(ExportSample), frames[1].payload.size());
+    TEST_ASSERT_EQUAL_MEMORY(samples, frames[1].payload.data(), frames[1].payload.size());
+    TEST_ASSERT_EQUAL_UINT8(FRAME_SAMPLES, frames[2].type);
+    TEST_ASSERT_EQUAL_UINT32(3 * sizeof(ExportSample), frames[2].payload.size());
+    TEST_ASSERT_EQUAL_MEMORY(&samples[FRAME_SAMPLES_PER_FRAME], frames[2].payload.data(),
+                             frames[2].payload.size());
+
+    check_payload(window, frames[3], FRAME_WINDOW);
+    check_payload(diagnostics, frames[4], FRAME_DIAGNOSTICS);
+    check_payload(summary, frames[5], FRAME_SESSION_END);
+}
+
+static void test_decoder_resyncs_after_noise() {
+    BufferSink sink(4096);
+    FrameExporter exporter(sink);
+    SessionStartFrame start = start_frame();
+
+    // Text and a stray SOF before, a damaged frame between.
+    static const char NOISE[] = "Recording...\n\xA5\x01";
+    sink.bytes.assign(NOISE, NOISE + sizeof(NOISE) - 1);
+    TEST_ASSERT_TRUE(exporter.send(FRAME_SESSION_START, &start, sizeof(start)));
+    size_t damaged = sink.bytes.size() + FRAME_HEADER_SIZE + 2;
+    TEST_ASSERT_TRUE(exporter.send(FRAME_SESSION_START, &start, sizeof(start)));
+    sink.bytes[damaged] ^= 0x40;
+    TEST_ASSERT_TRUE(exporter.send(FRAME_SESSION_START, &start, sizeof(start)));
+
+    int rejected = 0;
+    std::vector<Decoded> frames = decode(sink.bytes, &rejected);
+    TEST_ASSERT_EQUAL_UINT32(2, frames.size());
+    TEST_ASSERT_EQUAL_UINT16(0, frames[0].seq);
+    TEST_ASSERT_EQUAL_UINT16(2, frames[1].seq);
+    check_payload(start, frames[1], FRAME_SESSION_START);
+    TEST_ASSERT_TRUE(rejected >= 2);
+}
+
+static void test_full_ring_drops_whole_frames() {
+    SessionSummary summary = {1.0f, 2.0f, 3, 4.0f, 5.0f, 6};
+    size_t frame_size = FRAME_HEADER_SIZE + sizeof(summary) + FRAME_TRAILER_SIZE;
+    BufferSink sink(2 * frame_size + frame_size / 2);
+    FrameExporter exporter(sink);
+
+    TEST_ASSERT_TRUE(exporter.send(FRAME_SESSION_END, &summary, sizeof(summary)));
+    TEST_ASSERT_TRUE(exporter.send(FRAME_SESSION_END, &summary, sizeof(summary)));
+    TEST_ASSERT_FALSE(exporter.send(FRAME_SESSION_END, &summary, sizeof(summary)));
+    TEST_ASSERT_EQUAL_UINT32(2 * frame_size, sink.bytes.size());
+    TEST_ASSERT_EQUAL_UINT32(2, exporter.frames_sent());
+    TEST_ASSERT_EQUAL_UINT32(1, exporter.frames_dropped());
+    TEST_ASSERT_FALSE(exporter.has_room_for_batch());
+
+    // The dropped frame still used up its sequence number.
+    sink.bytes.clear();
+    TEST_ASSERT_TRUE(exporter.send(FRAME_SESSION_END, &summary, sizeof(summary)));
+    std::vector<Decoded> frames = decode(sink.bytes);
+    TEST_ASSERT_EQUAL_UINT32(1, frames.size());
+    TEST_ASSERT_EQUAL_UINT16(3, frames[0].seq);
+
+    uint8_t big[FRAME_MAX_PAYLOAD + 1] = {};
+    TEST_ASSERT_FALSE(exporter.send(FRAME_SAMPLES, big, sizeof(big)));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_crc_check_value);
+    RUN_TEST(test_encode_layout);
+    RUN_TEST(test_every_frame_type_round_trips);
+    RUN_TEST(test_decoder_resyncs_after_noise);
+    RUN_TEST(test_full_ring_drops_whole_frames);
+    return UNITY_END();
+}
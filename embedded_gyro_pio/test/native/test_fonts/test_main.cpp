@@ -0,0 +1,240 @@
+/**
+ * @file test_main.cpp
+ *
+ * @brief The packed fonts against the ST tables they were packed from:
+ *        the linked Font16 is tools/pack_fonts.py's packing of the padded
+ *        table, and the decoder draws every glyph of all five fonts as
+ *        the BSP's DrawChar draws the padded ones.
+ *
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <chrono>
+#include "drivers/fonts.h"
+
+// The ST tables, under other names than the linked fonts.
+#define Font8 Font8_Padded
+#define Font12 Font12_Padded
+#define Font16 Font16_Padded
+#define Font20 Font20_Padded
+#define Font24 Font24_Padded
+#include "../../../tools/fonts/font8.c"
+#include "../../../tools/fonts/font12.c"
+#include "../../../tools/fonts/font16.c"
+#include "../../../tools/fonts/font20.c"
+#include "../../../tools/fonts/font24.c"
+#undef Font8
+#undef Font12
+#undef Font16
+#undef Font20
+#undef Font24
+
+// The range of the ST tables.
+#define TABLE_FIRST 32
+#define TABLE_LAST 126
+
+// Frame the glyphs are drawn into, and where.
+#define FRAME_W 40
+#define FRAME_H 40
+#define GLYPH_X 3
+#define GLYPH_Y 5
+
+#define TEXT 0xFF00FF00u
+#define BACK 0xFF000000u
+#define UNTOUCHED 0x12345678u
+
+static const sFONT *const PADDED[] = {&Font8_Padded, &Font12_Padded, &Font16_Padded, &Font20_Padded,
+                                      &Font24_Padded};
+
+struct Frame {
+    uint32_t pixels[FRAME_W * FRAME_H];
+
+    Frame() {
+        for (int k = 0; k < FRAME_W * FRAME_H; k++) {
+            pixels[k] = UNTOUCHED;
+        }
+    }
+
+    uint32_t *glyph() { return &pixels[GLYPH_Y * FRAME_W + GLYPH_X]; }
+};
+
+// DrawChar() of stm32f429i_discovery_lcd.c on a padded table: rows of
+// whole bytes, the glyph's bits at the top of them.
+static void draw_padded(Frame &frame, const sFONT *font, uint8_t ascii) {
+    uint32_t width = font->Width;
+    uint32_t row_bytes = (width + 7) / 8;
+    uint32_t offset = 8 * row_bytes - width;
+    const uint8_t *c = &font->table[(ascii - ' ') * font->Height * row_bytes];
+    for (uint32_t i = 0; i < font->Height; i++) {
+        const uint8_t *pchar = c + row_bytes * i;
+        uint32_t line = 0;
+        for (uint32_t b = 0; b < row_bytes; b++) {
+            line = (line << 8) | pchar[b];
+        }
+        for (uint32_t j = 0; j < width; j++) {
+            frame.glyph()[i * FRAME_W + j] = (line & (1u << (width - j + offset - 1))) ? TEXT : BACK;
+        }
+    }
+}
+
+// pack() of tools/pack_fonts.py: glyphs first to last as rows of width
+// bits, MSB first, the last byte padded with zeros.
+static std::vector<uint8_t> pack(const sFONT *font, int first, int last) {
+    std::vector<uint8_t> packed;
+    uint32_t bit = 0;
+    Frame frame;
+    for (int code = first; code <= last; code++) {
+        draw_padded(frame, font, (uint8_t)code);
+        for (uint32_t i = 0; i < font->Height; i++) {
+            for (uint32_t j = 0; j < font->Width; j++, bit++) {
+                if (bit % 8 == 0) {
+                    packed.push_back(0);
+                }
+                if (frame.glyph()[i * FRAME_W + j] == TEXT) {
+                    packed.back() |= (uint8_t)(0x80 >> (bit % 8));
+                }
+            }
+        }
+    }
+    return packed;
+}
+
+static sFONT packed_font(const sFONT *padded, const std::vector<uint8_t> &packed, int first, int last) {
+    sFONT font = {NULL, padded->Width, padded->Height, packed.data(), (uint8_t)first, (uint8_t)last};
+    return font;
+}
+
+// Draws ascii both ways and compares the whole frame, so nothing outside
+// the glyph may be written either.
+static void check_glyph(const sFONT *padded, const sFONT *packed, uint8_t ascii) {
+    Frame expected;
+    Frame actual;
+    draw_padded(expected, padded, ascii);
+    Font_DrawPackedGlyph(packed, ascii, actual.glyph(), FRAME_W, TEXT, BACK);
+    if (memcmp(expected.pixels, actual.pixels, sizeof(expected.pixels)) != 0) {
+        char message[64];
+        snprintf(message, sizeof(message), "'%c' of the %ux%u font", ascii, padded->Width, padded->Height);
+        TEST_FAIL_MESSAGE(message);
+    }
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_linked_font16_is_the_st_table_packed() {
+    TEST_ASSERT_NULL(Font16.table);
+    TEST_ASSERT_EQUAL_UINT16(Font16_Padded.Width, Font16.Width);
+    TEST_ASSERT_EQUAL_UINT16(Font16_Padded.Height, Font16.Height);
+    TEST_ASSERT_TRUE(Font16.First >= TABLE_FIRST && Font16.First <= Font16.Last && Font16.Last <= TABLE_LAST);
+
+    std::vector<uint8_t> packed = pack(&Font16_Padded, Font16.First, Font16.Last);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(packed.data(), Font16.packed, packed.size());
+
+    size_t padded_bytes = (TABLE_LAST - TABLE_FIRST + 1) * Font16.Height * ((Font16.Width + 7) / 8);
+    printf("Font16: %u glyphs in %u bytes, %u padded\n", Font16.Last - Font16.First + 1,
+           (unsigned)packed.size(), (unsigned)padded_bytes);
+}
+
+static void test_linked_font16_draws_as_before() {
+    for (int c = Font16.First; c <= Font16.Last; c++) {
+        check_glyph(&Font16_Padded, &Font16, (uint8_t)c);
+    }
+}
+
+static void test_firmware_text_is_in_range() {
+    // Numbers (number_format.h) and the labels of main.cpp.
+    const char *const TEXT_USED[] = {"0123456789-. ", "The Embedded", "Gyrometer", "Rev_C_12222023",
+                                     "Press Blue Button", "To Start..", "Processing..", "GO!", "rad/s"};
+    for (unsigned k = 0; k < sizeof(TEXT_USED) / sizeof(TEXT_USED[0]); k++) {
+        for (const char *p = TEXT_USED[k]; *p; p++) {
+            TEST_ASSERT_TRUE((uint8_t)*p >= Font16.First && (uint8_t)*p <= Font16.Last);
+        }
+    }
+}
+
+static void test_decoder_draws_every_font() {
+    for (unsigned f = 0; f < sizeof(PADDED) / sizeof(PADDED[0]); f++) {
+        std::vector<uint8_t> packed = pack(PADDED[f], TABLE_FIRST, TABLE_LAST);
+        sFONT font = packed_font(PADDED[f], packed, TABLE_FIRST, TABLE_LAST);
+        for (int c = TABLE_FIRST; c <= TABLE_LAST; c++) {
+            check_glyph(PADDED[f], &font, (uint8_t)c);
+        }
+    }
+}
+
+static void test_decoder_handles_any_range() {
+    // Glyphs that start part way into a byte, for every starting bit.
+    for (unsigned f = 0; f < sizeof(PADDED) / sizeof(PADDED[0]); f++) {
+        for (int first = TABLE_FIRST; first < TABLE_FIRST + 8; first++) {
+            std::vector<uint8_t> packed = pack(PADDED[f], first, 'z');
+            sFONT font = packed_font(PADDED[f], packed, first, 'z');
+            for (int c = first; c <= 'z'; c++) {
+                check_glyph(PADDED[f], &font, (uint8_t)c);
+            }
+        }
+    }
+}
+
+static void test_outside_range_is_blank() {
+    static const uint8_t OUTSIDE[] = {0, 31, '{', '~', 127, 255};
+    Frame blank;
+    for (uint32_t i = 0; i < Font16.Height; i++) {
+        for (uint32_t j = 0; j < Font16.Width; j++) {
+            blank.glyph()[i * FRAME_W + j] = BACK;
+        }
+    }
+    for (unsigned k = 0; k < sizeof(OUTSIDE); k++) {
+        if (OUTSIDE[k] >= Font16.First && OUTSIDE[k] <= Font16.Last) {
+            continue;
+        }
+        Frame frame;
+        Font_DrawPackedGlyph(&Font16, OUTSIDE[k], frame.glyph(), FRAME_W, TEXT, BACK);
+        TEST_ASSERT_EQUAL_UINT32_ARRAY(blank.pixels, frame.pixels, FRAME_W * FRAME_H);
+    }
+}
+
+// Not a pass/fail check (host timings vary): every glyph of the linked
+// Font16 drawn by the packed decoder and by DrawChar's padded path, for
+// the record.
+static void test_report_draw_time() {
+    const int passes = 2000;
+    int glyphs = Font16.Last - Font16.First + 1;
+    Frame frame;
+
+    typedef std::chrono::steady_clock clock;
+    volatile uint32_t sink = 0;
+    clock::time_point t0 = clock::now();
+    for (int rep = 0; rep < passes; rep++) {
+        for (int c = Font16.First; c <= Font16.Last; c++) {
+            draw_padded(frame, &Font16_Padded, (uint8_t)c);
+        }
+        sink = sink + frame.glyph()[rep % Font16.Width];
+    }
+    clock::time_point t1 = clock::now();
+    for (int rep = 0; rep < passes; rep++) {
+        for (int c = Font16.First; c <= Font16.Last; c++) {
+            Font_DrawPackedGlyph(&Font16, (uint8_t)c, frame.glyph(), FRAME_W, TEXT, BACK);
+        }
+        sink = sink + frame.glyph()[rep % Font16.Width];
+    }
+    clock::time_point t2 = clock::now();
+    printf("Font16 glyph: padded %.1f ns, packed %.1f ns\n",
+           std::chrono::duration<double, std::nano>(t1 - t0).count() / (passes * glyphs),
+           std::chrono::duration<double, std::nano>(t2 - t1).count() / (passes * glyphs));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_linked_font16_is_the_st_table_packed);
+    RUN_TEST(test_linked_font16_draws_as_before);
+    RUN_TEST(test_firmware_text_is_in_range);
+    RUN_TEST(test_decoder_draws_every_font);
+    RUN_TEST(test_decoder_handles_any_range);
+    RUN_TEST(test_outside_range_is_blank);
+    RUN_TEST(test_report_draw_time);
+    return UNITY_END();
+}
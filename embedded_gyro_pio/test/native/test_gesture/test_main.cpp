@@ -0,0 +1,154 @@
+/**
+ * @file test_main.cpp
+ *
+ * @brief GestureDetector on synthetic contacts: debounce of stray
+ *        samples, taps, long presses and swipes, sampled every
+ *        TOUCH_HOLD_CHECK as touch_input feeds it.
+ *
+ */
+
+#include <unity.h>
+#include "gesture.h"
+
+// Time between two samples of a held contact (TOUCH_HOLD_CHECK).
+#define STEP_MS 30
+
+static GestureDetector detector;
+static int long_presses;
+
+// Feeds a contact moving in a straight line from (x0, y0) to (x1, y1)
+// over count samples, starting at t0, and lifts it one step after the
+// last. Returns what the release reports; long presses seen on the way
+// are counted in long_presses.
+static GestureEvent contact(int x0, int y0, int x1, int y1, int count, uint32_t t0 = 1000) {
+    uint32_t t = t0;
+    for (int k = 0; k < count; k++) {
+        int x = count > 1 ? x0 + (x1 - x0) * k / (count - 1) : x0;
+        int y = count > 1 ? y0 + (y1 - y0) * k / (count - 1) : y0;
+        GestureEvent e = detector.sample((int16_t)x, (int16_t)y, t);
+        if (e.gesture == Gesture::LongPress) {
+            long_presses++;
+        }
+        t += STEP_MS;
+    }
+    return detector.release(t);
+}
+
+void setUp() {
+    detector = GestureDetector();
+    long_presses = 0;
+}
+
+void tearDown() {}
+
+static void test_single_samples_are_ignored() {
+    // A brush or a bounce: one sample, then lifted, however it moved.
+    TEST_ASSERT_TRUE(contact(100, 100, 100, 100, 1).gesture == Gesture::None);
+    TEST_ASSERT_FALSE(detector.active());
+
+    // Held still past the long press time, but still only one sample.
+    detector.sample(50, 50, 0);
+    TEST_ASSERT_TRUE(detector.poll(GESTURE_LONG_PRESS_MS * 2).gesture == Gesture::None);
+    TEST_ASSERT_TRUE(detector.release(GESTURE_LONG_PRESS_MS * 2).gesture == Gesture::None);
+
+    // The next contact starts afresh.
+    GestureEvent e = contact(10, 20, 10, 20, GESTURE_MIN_SAMPLES);
+    TEST_ASSERT_TRUE(e.gesture == Gesture::Tap);
+    TEST_ASSERT_EQUAL_INT16(10, e.x);
+    TEST_ASSERT_EQUAL_INT16(20, e.y);
+}
+
+static void test_tap() {
+    TEST_ASSERT_TRUE(contact(120, 160, 120, 160, 3).gesture == Gesture::Tap);
+
+    // Jitter within the slop is still a tap.
+    detector.sample(120, 160, 0);
+    detector.sample(120 + GESTURE_MOVE_SLOP, 160 - GESTURE_MOVE_SLOP, STEP_MS);
+    detector.sample(120, 160, 2 * STEP_MS);
+    TEST_ASSERT_TRUE(detector.release(GESTURE_TAP_MAX_MS).gesture == Gesture::Tap);
+}
+
+static void test_slow_or_wandering_contact_is_no_tap() {
+    // Held too long for a tap, not long enough for a long press.
+    detector.sample(120, 160, 0);
+    detector.sample(120, 160, STEP_MS);
+    TEST_ASSERT_TRUE(detector.release(GESTURE_TAP_MAX_MS + 1).gesture == Gesture::None);
+
+    // Wandered beyond the slop and back: neither a tap nor a swipe.
+    detector.sample(120, 160, 0);
+    detector.sample(120 + GESTURE_MOVE_SLOP + 1, 160, STEP_MS);
+    detector.sample(120, 160, 2 * STEP_MS);
+    TEST_ASSERT_TRUE(detector.release(3 * STEP_MS).gesture == Gesture::None);
+}
+
+static void test_long_press_reported_once() {
+    int count = GESTURE_LONG_PRESS_MS / STEP_MS + 5;
+    TEST_ASSERT_TRUE(contact(60, 60, 60 + GESTURE_MOVE_SLOP, 60, count).gesture == Gesture::None);
+    TEST_ASSERT_EQUAL_INT(1, long_presses);
+}
+
+static void test_long_press_by_poll() {
+    // The panel reports no new samples while the finger rests.
+    TEST_ASSERT_TRUE(detector.sample(60, 60, 5000).gesture == Gesture::None);
+    TEST_ASSERT_TRUE(detector.sample(60, 60, 5000 + STEP_MS).gesture == Gesture::None);
+    TEST_ASSERT_TRUE(detector.poll(5000 + GESTURE_LONG_PRESS_MS - 1).gesture == Gesture::None);
+    GestureEvent e = detector.poll(5000 + GESTURE_LONG_PRESS_MS);
+    TEST_ASSERT_TRUE(e.gesture == Gesture::LongPress);
+    TEST_ASSERT_EQUAL_INT16(60, e.x);
+    TEST_ASSERT_TRUE(detector.poll(5000 + 2 * GESTURE_LONG_PRESS_MS).gesture == Gesture::None);
+    TEST_ASSERT_TRUE(detector.release(5000 + 2 * GESTURE_LONG_PRESS_MS).gesture == Gesture::None);
+}
+
+static void test_moving_contact_is_no_long_press() {
+    // Moved off its start early on, then held.
+    detector.sample(60, 60, 0);
+    detector.sample(60, 60 + GESTURE_MOVE_SLOP + 1, STEP_MS);
+    for (uint32_t t = 2 * STEP_MS; t <= 2 * GESTURE_LONG_PRESS_MS; t += STEP_MS) {
+        TEST_ASSERT_TRUE(detector.sample(60, 60 + GESTURE_MOVE_SLOP + 1, t).gesture == Gesture::None);
+    }
+    TEST_ASSERT_TRUE(detector.poll(3 * GESTURE_LONG_PRESS_MS).gesture == Gesture::None);
+}
+
+static void test_swipes() {
+    GestureEvent e = contact(200, 160, 200 - GESTURE_SWIPE_MIN, 160, 5);
+    TEST_ASSERT_TRUE(e.gesture == Gesture::SwipeLeft);
+    TEST_ASSERT_EQUAL_INT16(200, e.x);
+    TEST_ASSERT_EQUAL_INT16(160, e.y);
+    TEST_ASSERT_TRUE(contact(20, 160, 20 + GESTURE_SWIPE_MIN, 160, 5).gesture == Gesture::SwipeRight);
+    TEST_ASSERT_TRUE(contact(120, 300, 120, 300 - GESTURE_SWIPE_MIN, 5).gesture == Gesture::SwipeUp);
+    TEST_ASSERT_TRUE(contact(120, 20, 120, 20 + GESTURE_SWIPE_MIN, 5).gesture == Gesture::SwipeDown);
+
+    // Short of the swipe distance: nothing.
+    TEST_ASSERT_TRUE(contact(20, 160, 20 + GESTURE_SWIPE_MIN - 1, 160, 5).gesture == Gesture::None);
+
+    // Diagonal: the longer axis decides.
+    TEST_ASSERT_TRUE(contact(100, 100, 160, 140, 5).gesture == Gesture::SwipeRight);
+    TEST_ASSERT_TRUE(contact(100, 100, 70, 30, 5).gesture == Gesture::SwipeUp);
+
+    // A slow swipe is still a swipe, but not a long press.
+    int count = GESTURE_LONG_PRESS_MS / STEP_MS + 5;
+    TEST_ASSERT_TRUE(contact(20, 160, 200, 160, count).gesture == Gesture::SwipeRight);
+    TEST_ASSERT_EQUAL_INT(0, long_presses);
+}
+
+static void test_millisecond_counter_wraps() {
+    uint32_t t0 = 0xFFFFFFFFu - STEP_MS;
+    TEST_ASSERT_TRUE(contact(120, 160, 120, 160, 3, t0).gesture == Gesture::Tap);
+
+    int count = GESTURE_LONG_PRESS_MS / STEP_MS + 2;
+    contact(120, 160, 120, 160, count, t0);
+    TEST_ASSERT_EQUAL_INT(1, long_presses);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_single_samples_are_ignored);
+    RUN_TEST(test_tap);
+    RUN_TEST(test_slow_or_wandering_contact_is_no_tap);
+    RUN_TEST(test_long_press_reported_once);
+    RUN_TEST(test_long_press_by_poll);
+    RUN_TEST(test_moving_contact_is_no_long_press);
+    RUN_TEST(test_swipes);
+    RUN_TEST(test_millisecond_counter_wraps);
+    return UNITY_END();
+}
@@ -0,0 +1,167 @@
+/**
+ * @file test_main.cpp
+ *
+ * @brief GyroConfig register images, and how they are written to the
+ *        register model of the sensor.
+ *
+ */
+
+#include <unity.h>
+#include "gyro_config.h"
+#include "../mock_gyro_bus.h"
+
+static GyroConfig base_config() {
+    GyroConfig cfg = {};
+    cfg.odr = GYRO_ODR_760;
+    cfg.bandwidth = 1;
+    cfg.full_scale = GYRO_FS_250DPS;
+    cfg.hpf_mode = GYRO_HPF_OFF;
+    cfg.hpf_cutoff_hz = 0.5f;
+    cfg.fifo_mode = L3GD20_FIFO_MODE_BYPASS;
+    cfg.drdy_int2 = true;
+    return cfg;
+}
+
+// The image is usable as a compile-time constant.
+constexpr GyroConfig CONST_CONFIG = {GYRO_ODR_380, 0, GYRO_FS_500DPS, GYRO_HPF_NORMAL, 1.0f, 0,
+                                     L3GD20_FIFO_MODE_BYPASS, 0, true, false};
+static_assert(gyro_config_registers(CONST_CONFIG).ctrl[0] == 0x8F, "380 Hz, BW 0, active");
+static_assert(gyro_config_registers(CONST_CONFIG).ctrl[3] == 0x10, "500 dps");
+
+void setUp() {
+    mock_gyro_reset();
+    L3GD20_SyncState();
+    mock_gyro_clear_counts();
+}
+
+void tearDown() {}
+
+static void test_plain_image() {
+    GyroRegisters r = gyro_config_registers(base_config());
+    TEST_ASSERT_EQUAL_HEX8(0xDF, r.ctrl[0]);    // DR 11, BW 01, PD, Z, Y, X.
+    TEST_ASSERT_EQUAL_HEX8(0x00, r.ctrl[1]);
+    TEST_ASSERT_EQUAL_HEX8(GYRO_CTRL3_I2_DRDY, r.ctrl[2]);
+    TEST_ASSERT_EQUAL_HEX8(0x00, r.ctrl[3]);
+    TEST_ASSERT_EQUAL_HEX8(0x00, r.ctrl[4]);
+    TEST_ASSERT_EQUAL_HEX8(0x00, r.fifo_ctrl);
+}
+
+static void test_hpf_normal_image() {
+    GyroConfig cfg = base_config();
+    cfg.hpf_mode = GYRO_HPF_NORMAL;
+    GyroRegisters r = gyro_config_registers(cfg);
+    // 0.45 Hz (HPCF 7) is the nearest cutoff at 760 Hz.
+    TEST_ASSERT_EQUAL_HEX8(L3GD20_HPM_NORMAL_MODE | 7, r.ctrl[1]);
+    TEST_ASSERT_EQUAL_HEX8(L3GD20_HIGHPASSFILTER_ENABLE | GYRO_CTRL5_OUT_SEL_HPF, r.ctrl[4]);
+    TEST_ASSERT_EQUAL_HEX8(0, r.reference);
+}
+
+static void test_cutoff_kept_across_data_rates() {
+    static const GyroOdr rates[] = {GYRO_ODR_95, GYRO_ODR_190, GYRO_ODR_380, GYRO_ODR_760};
+    for (int i = 0; i < 4; i++) {
+        uint8_t hpcf = gyro_hpf_select(rates[i], 0.5f);
+        TEST_ASSERT_EQUAL_FLOAT(0.45f, gyro_hpf_cutoff_hz(rates[i], hpcf));
+        TEST_ASSERT_EQUAL_UINT8(7 - (GYRO_ODR_760 - rates[i]), hpcf);
+    }
+    // Out of range requests clamp to the ends of the table.
+    TEST_ASSERT_EQUAL_UINT8(0, gyro_hpf_select(GYRO_ODR_760, 1000.0f));
+    TEST_ASSERT_EQUAL_UINT8(GYRO_HPCF_COUNT - 1, gyro_hpf_select(GYRO_ODR_760, 0.0001f));
+}
+
+static void test_reference_and_autoreset_images() {
+    GyroConfig cfg = base_config();
+    cfg.hpf_mode = GYRO_HPF_REFERENCE;
+    cfg.hpf_reference = -12;
+    GyroRegisters r = gyro_config_registers(cfg);
+    TEST_ASSERT_EQUAL_HEX8(L3GD20_HPM_REF_SIGNAL, r.ctrl[1] & 0x30);
+    TEST_ASSERT_EQUAL_HEX8(0xF4, r.reference);
+
+    cfg.hpf_mode = GYRO_HPF_AUTORESET;
+    cfg.int1_enable = true;
+    r = gyro_config_registers(cfg);
+    TEST_ASSERT_EQUAL_HEX8(L3GD20_HPM_AUTORESET_INT, r.ctrl[1] & 0x30);
+    TEST_ASSERT_EQUAL_HEX8(L3GD20_INT1INTERRUPT_ENABLE | GYRO_CTRL3_I2_DRDY, r.ctrl[2]);
+    TEST_ASSERT_EQUAL_HEX8(0, r.reference);
+}
+
+static void test_fifo_and_full_scale_image() {
+    GyroConfig cfg = base_config();
+    cfg.full_scale = GYRO_FS_2000DPS;
+    cfg.fifo_mode = L3GD20_FIFO_MODE_STREAM;
+    cfg.fifo_watermark = 16;
+    GyroRegisters r = gyro_config_registers(cfg);
+    TEST_ASSERT_EQUAL_HEX8(L3GD20_FULLSCALE_2000, r.ctrl[3]);
+    TEST_ASSERT_EQUAL_HEX8(L3GD20_FIFO_MODE_STREAM | 16, r.fifo_ctrl);
+    TEST_ASSERT_EQUAL_HEX8(L3GD20_FIFO_ENABLE, r.ctrl[4]);
+}
+
+static void test_scale_and_rate() {
+    TEST_ASSERT_EQUAL_UINT32(760, gyro_odr_hz(GYRO_ODR_760));
+    TEST_ASSERT_EQUAL_UINT32(95, gyro_odr_hz(GYRO_ODR_95));
+    TEST_ASSERT_FLOAT_WITHIN(1e-9f, 8.75e-3f * 0.0174532925f, gyro_scale_rad_s(GYRO_FS_250DPS));
+    TEST_ASSERT_FLOAT_WITHIN(1e-9f, 70e-3f * 0.0174532925f, gyro_scale_rad_s(GYRO_FS_2000DPS));
+}
+
+static void test_apply_programs_the_sensor() {
+    GyroConfig cfg = base_config();
+    cfg.hpf_mode = GYRO_HPF_NORMAL;
+    cfg.fifo_mode = L3GD20_FIFO_MODE_STREAM;
+    gyro_config_apply(cfg);
+
+    GyroRegisters r = gyro_config_registers(cfg);
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_HEX8(r.ctrl[i], mock_gyro.regs[L3GD20_CTRL_REG1_ADDR + i]);
+    }
+    TEST_ASSERT_EQUAL_HEX8(r.fifo_ctrl, mock_gyro.regs[L3GD20_FIFO_CTRL_REG_ADDR]);
+
+    // CTRL_REG1 last, so the data rate starts with the rest in place; the
+    // driver's copy matches without reading anything back.
+    TEST_ASSERT_EQUAL_HEX8(L3GD20_CTRL_REG1_ADDR, mock_gyro.log_addr[mock_gyro.log_count - 1]);
+    TEST_ASSERT_EQUAL_UINT32(0, mock_gyro.reads);
+    TEST_ASSERT_EQUAL_HEX8(r.ctrl[4], L3GD20_GetState()->CtrlReg[4]);
+}
+
+static void test_apply_writes_only_changes() {
+    GyroConfig cfg = base_config();
+    gyro_config_apply(cfg);
+    mock_gyro_clear_counts();
+    gyro_config_apply(cfg);
+    TEST_ASSERT_EQUAL_UINT32(0, mock_gyro.writes);
+
+    // A new full scale is one register.
+    cfg.full_scale = GYRO_FS_500DPS;
+    gyro_config_apply(cfg);
+    TEST_ASSERT_EQUAL_INT(1, mock_gyro.log_count);
+    TEST_ASSERT_EQUAL_HEX8(L3GD20_CTRL_REG4_ADDR, mock_gyro.log_addr[0]);
+    TEST_ASSERT_EQUAL_FLOAT(L3GD20_SENSITIVITY_500DPS, L3GD20_GetState()->Sensitivity);
+}
+
+static void test_reference_written_in_reference_mode_only() {
+    GyroConfig cfg = base_config();
+    cfg.hpf_mode = GYRO_HPF_NORMAL;
+    gyro_config_apply(cfg);
+    for (int i = 0; i < mock_gyro.log_count; i++) {
+        TEST_ASSERT_NOT_EQUAL(L3GD20_REFERENCE_REG_ADDR, mock_gyro.log_addr[i]);
+    }
+
+    mock_gyro_clear_counts();
+    cfg.hpf_mode = GYRO_HPF_REFERENCE;
+    cfg.hpf_reference = 5;
+    gyro_config_apply(cfg);
+    TEST_ASSERT_EQUAL_HEX8(L3GD20_REFERENCE_REG_ADDR, mock_gyro.log_addr[0]);
+    TEST_ASSERT_EQUAL_HEX8(5, mock_gyro.regs[L3GD20_REFERENCE_REG_ADDR]);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_plain_image);
+    RUN_TEST(test_hpf_normal_image);
+    RUN_TEST(test_cutoff_kept_across_data_rates);
+    RUN_TEST(test_reference_and_autoreset_images);
+    RUN_TEST(test_fifo_and_full_scale_image);
+    RUN_TEST(test_scale_and_rate);
+    RUN_TEST(test_apply_programs_the_sensor);
+    RUN_TEST(test_apply_writes_only_changes);
+    RUN_TEST(test_reference_written_in_reference_mode_only);
+    return UNITY_END();
+}
@@ -0,0 +1,202 @@
+/**
+ * @file test_main.cpp
+ *
+ * @brief L3GD20 driver block reads against the mock SPI link: one
+ *        transfer per sample or FIFO burst, and the register copy the
+ *        driver keeps.
+ *
+ */
+
+#include <unity.h>
+#include "../mock_gyro_bus.h"
+
+static uint8_t dma_status;
+static int dma_calls;
+
+static void on_dma(uint8_t status) {
+    dma_status = status;
+    dma_calls++;
+}
+
+void setUp() {
+    mock_gyro_reset();
+    L3GD20_SyncState();
+    mock_gyro_clear_counts();
+    dma_calls = 0;
+    dma_status = 0xFF;
+}
+
+void tearDown() {}
+
+static void test_read_id_is_one_transfer() {
+    TEST_ASSERT_EQUAL_HEX8(MOCK_GYRO_WHO_AM_I, L3GD20_ReadID());
+    TEST_ASSERT_EQUAL_UINT32(1, mock_gyro.reads);
+    TEST_ASSERT_EQUAL_UINT32(1, mock_gyro.bytes_read);
+}
+
+static void test_sample_read_is_one_burst() {
+    mock_gyro_push_sample(100, -200, 300);
+    float rate[3];
+    L3GD20_ReadXYZAngRate(rate);
+
+    // One six-byte transfer from OUT_X_L, not one per register.
+    TEST_ASSERT_EQUAL_UINT32(1, mock_gyro.reads);
+    TEST_ASSERT_EQUAL_HEX8(L3GD20_OUT_X_L_ADDR, mock_gyro.last_addr);
+    TEST_ASSERT_EQUAL_UINT16(6, mock_gyro.last_len);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 100 * L3GD20_SENSITIVITY_250DPS, rate[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, -200 * L3GD20_SENSITIVITY_250DPS, rate[1]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 300 * L3GD20_SENSITIVITY_250DPS, rate[2]);
+}
+
+static void test_status_and_sample_in_one_dma() {
+    mock_gyro.defer_dma = true;
+    mock_gyro_push_sample(-1, 2, -32768);
+    uint8_t buf[7];
+    TEST_ASSERT_EQUAL_UINT8(0, L3GD20_ReadStatusXYZRawDMA(buf, on_dma));
+    TEST_ASSERT_EQUAL_UINT32(1, mock_gyro.dma_reads);
+    TEST_ASSERT_EQUAL_HEX8(L3GD20_STATUS_REG_ADDR, mock_gyro.last_addr);
+    TEST_ASSERT_EQUAL_UINT16(7, mock_gyro.last_len);
+
+    // Nothing reported until the transfer completes.
+    TEST_ASSERT_EQUAL_INT(0, dma_calls);
+    TEST_ASSERT_TRUE(mock_gyro_finish_dma());
+    TEST_ASSERT_EQUAL_INT(1, dma_calls);
+    TEST_ASSERT_EQUAL_UINT8(0, dma_status);
+
+    TEST_ASSERT_TRUE((buf[0] & 0x08) != 0);
+    int16_t raw[3];
+    L3GD20_DecodeXYZ(buf + 1, raw, 1);
+    TEST_ASSERT_EQUAL_INT16(-1, raw[0]);
+    TEST_ASSERT_EQUAL_INT16(2, raw[1]);
+    TEST_ASSERT_EQUAL_INT16(-32768, raw[2]);
+}
+
+static void test_dma_refused_while_busy() {
+    mock_gyro.defer_dma = true;
+    uint8_t a[6], b[6];
+    TEST_ASSERT_EQUAL_UINT8(0, L3GD20_ReadXYZRawDMA(a, on_dma));
+    TEST_ASSERT_EQUAL_UINT8(1, L3GD20_ReadXYZRawDMA(b, on_dma));
+    TEST_ASSERT_EQUAL_UINT32(1, mock_gyro.dma_reads);
+    TEST_ASSERT_TRUE(mock_gyro_finish_dma());
+    TEST_ASSERT_EQUAL_UINT8(0, L3GD20_ReadXYZRawDMA(b, on_dma));
+}
+
+static void test_blocking_transfers_wait_for_dma() {
+    mock_gyro.defer_dma = true;
+    uint8_t block[6];
+    TEST_ASSERT_EQUAL_UINT8(0, L3GD20_ReadXYZRawDMA(block, on_dma));
+
+    // The DMA read ends before the bus is used again.
+    L3GD20_ReadID();
+    TEST_ASSERT_EQUAL_INT(1, dma_calls);
+    TEST_ASSERT_FALSE(GYRO_IO_IsBusy());
+
+    TEST_ASSERT_EQUAL_UINT8(0, L3GD20_ReadXYZRawDMA(block, on_dma));
+    L3GD20_WriteReg(L3GD20_CTRL_REG1_ADDR, 0x0F);
+    TEST_ASSERT_EQUAL_INT(2, dma_calls);
+}
+
+static void test_fifo_drained_in_one_dma() {
+    L3GD20_WriteReg(L3GD20_CTRL_REG5_ADDR, L3GD20_FIFO_ENABLE);
+    for (int i = 0; i < 10; i++) {
+        mock_gyro_push_sample((int16_t)i, (int16_t)(100 + i), (int16_t)(-i));
+    }
+
+    uint8_t buf[10 * L3GD20_SAMPLE_SIZE];
+    TEST_ASSERT_EQUAL_UINT8(0, L3GD20_ReadFIFODMA(buf, 10, on_dma));
+    TEST_ASSERT_EQUAL_UINT32(1, mock_gyro.dma_reads);
+    TEST_ASSERT_EQUAL_UINT16(sizeof(buf), mock_gyro.last_len);
+    TEST_ASSERT_EQUAL_INT(1, dma_calls);
+    TEST_ASSERT_EQUAL_INT(0, mock_gyro.fifo_count);
+
+    int16_t raw[10 * 3];
+    L3GD20_DecodeXYZ(buf, raw, 10);
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL_INT16(i, raw[3 * i]);
+        TEST_ASSERT_EQUAL_INT16(100 + i, raw[3 * i + 1]);
+        TEST_ASSERT_EQUAL_INT16(-i, raw[3 * i + 2]);
+    }
+}
+
+static void test_fifo_burst_limits() {
+    uint8_t buf[33 * L3GD20_SAMPLE_SIZE];
+    TEST_ASSERT_EQUAL_UINT8(1, L3GD20_ReadFIFODMA(buf, 0, on_dma));
+    TEST_ASSERT_EQUAL_UINT8(1, L3GD20_ReadFIFODMA(buf, 33, on_dma));
+    TEST_ASSERT_EQUAL_UINT32(0, mock_gyro.dma_reads);
+    TEST_ASSERT_EQUAL_UINT8(0, L3GD20_ReadFIFODMA(buf, 32, on_dma));
+}
+
+static void test_batch_read_is_one_transfer() {
+    L3GD20_WriteReg(L3GD20_CTRL_REG5_ADDR, L3GD20_FIFO_ENABLE);
+    for (int i = 0; i < 4; i++) {
+        mock_gyro_push_sample((int16_t)(10 * i), 0, 0);
+    }
+    int16_t raw[4 * 3];
+    L3GD20_ReadXYZRaw(raw, 4);
+    TEST_ASSERT_EQUAL_UINT32(1, mock_gyro.reads);
+    TEST_ASSERT_EQUAL_UINT16(24, mock_gyro.last_len);
+    TEST_ASSERT_EQUAL_INT16(30, raw[9]);
+}
+
+static void test_register_copy_follows_writes() {
+    // Full scale and endianness come from the copy, with no reads.
+    L3GD20_WriteReg(L3GD20_CTRL_REG4_ADDR, L3GD20_FULLSCALE_2000 | L3GD20_BLE_MSB);
+    const L3GD20_StateTypeDef *state = L3GD20_GetState();
+    TEST_ASSERT_EQUAL_HEX8(L3GD20_FULLSCALE_2000 | L3GD20_BLE_MSB, state->CtrlReg[3]);
+    TEST_ASSERT_EQUAL_FLOAT(L3GD20_SENSITIVITY_2000DPS, state->Sensitivity);
+
+    mock_gyro_push_sample(1000, -1000, 7);
+    float rate[3];
+    L3GD20_ReadXYZAngRate(rate);
+    TEST_ASSERT_EQUAL_UINT32(1, mock_gyro.reads);
+    TEST_ASSERT_FLOAT_WITHIN(1e-2f, 1000 * L3GD20_SENSITIVITY_2000DPS, rate[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-2f, -1000 * L3GD20_SENSITIVITY_2000DPS, rate[1]);
+}
+
+static void test_init_reads_config_once() {
+    mock_gyro.regs[L3GD20_CTRL_REG5_ADDR] = L3GD20_FIFO_ENABLE;
+    mock_gyro.regs[L3GD20_FIFO_CTRL_REG_ADDR] = L3GD20_FIFO_MODE_STREAM;
+    L3GD20_Init(0x00FF);
+
+    // Sync (CTRL_REG1..5, FIFO_CTRL, INT1_CFG), then CTRL_REG1 and 4.
+    TEST_ASSERT_EQUAL_UINT32(3, mock_gyro.reads);
+    TEST_ASSERT_EQUAL_INT(2, mock_gyro.log_count);
+    TEST_ASSERT_EQUAL_HEX8(L3GD20_CTRL_REG1_ADDR, mock_gyro.log_addr[0]);
+    TEST_ASSERT_EQUAL_HEX8(L3GD20_CTRL_REG4_ADDR, mock_gyro.log_addr[1]);
+
+    const L3GD20_StateTypeDef *state = L3GD20_GetState();
+    TEST_ASSERT_EQUAL_HEX8(L3GD20_FIFO_ENABLE, state->CtrlReg[4]);
+    TEST_ASSERT_EQUAL_HEX8(L3GD20_FIFO_MODE_STREAM, state->FifoCtrl);
+    TEST_ASSERT_EQUAL_UINT32(3, mock_gyro.reads);
+}
+
+static void test_mdps_decode_matches_float() {
+    static const uint8_t scales[] = {L3GD20_FULLSCALE_250, L3GD20_FULLSCALE_500, L3GD20_FULLSCALE_2000};
+    uint8_t buf[2 * L3GD20_SAMPLE_SIZE] = {0x01, 0x80, 0xFF, 0x7F, 0x00, 0x00, 0x34, 0x12, 0xCC, 0xED, 0x01, 0x00};
+    for (int i = 0; i < 3; i++) {
+        L3GD20_WriteReg(L3GD20_CTRL_REG4_ADDR, scales[i]);
+        int32_t mdps[6];
+        float rate[6];
+        L3GD20_DecodeXYZmdps(buf, mdps, 2);
+        L3GD20_DecodeXYZAngRate(buf, rate, 2);
+        for (int k = 0; k < 6; k++) {
+            TEST_ASSERT_INT32_WITHIN(1, (int32_t)rate[k], mdps[k]);
+        }
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_read_id_is_one_transfer);
+    RUN_TEST(test_sample_read_is_one_burst);
+    RUN_TEST(test_status_and_sample_in_one_dma);
+    RUN_TEST(test_dma_refused_while_busy);
+    RUN_TEST(test_blocking_transfers_wait_for_dma);
+    RUN_TEST(test_fifo_drained_in_one_dma);
+    RUN_TEST(test_fifo_burst_limits);
+    RUN_TEST(test_batch_read_is_one_transfer);
+    RUN_TEST(test_register_copy_follows_writes);
+    RUN_TEST(test_init_reads_config_once);
+    RUN_TEST(test_mdps_decode_matches_float);
+    return UNITY_END();
+}
@@ -0,0 +1,306 @@
+/**
+ * @file test_main.cpp
+ *
+ * @brief number_format against the host's printf, character for
+ *        character: random float bit patterns, halfway cases,
+ *        subnormals, signed zero, inf and nan, and every precision.
+ *
+ */
+
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include "number_format.h"
+
+// Random floats tried at each precision.
+#define RANDOM_VALUES 200000
+
+static uint32_t rng_state = 12345;
+
+static uint32_t next_random() {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state;
+}
+
+static float from_bits(uint32_t bits) {
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+// format_fixed() against "%.*f", which promotes to double exactly.
+static void check_fixed(float value, int decimals) {
+    char expected[64];
+    char actual[64];
+    int n = snprintf(expected, sizeof(expected), "%.*f", decimals, (double)value);
+    size_t len = format_fixed(actual, sizeof(actual), value, decimals);
+    if (len != (size_t)n || strcmp(expected, actual) != 0) {
+        char message[192];
+        snprintf(message, sizeof(message), "%a at %d decimals: \"%s\", printf \"%s\"", (double)value, decimals,
+                 actual, expected);
+        TEST_FAIL_MESSAGE(message);
+    }
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_random_floats_match_printf() {
+    for (int i = 0; i < RANDOM_VALUES; i++) {
+        float v = from_bits(next_random());
+        // The whole range under 2^32 that formats; larger is checked below.
+        if (!(fabsf(v) < 4294967296.0f)) {
+            continue;
+        }
+        for (int d = 0; d <= FORMAT_MAX_DECIMALS; d++) {
+            check_fixed(v, d);
+        }
+    }
+}
+
+static void test_readings_match_printf() {
+    // Rates and distances as main.cpp shows them: small magnitudes at
+    // steps a sensor reading can take.
+    for (int i = -40000; i <= 40000; i++) {
+        float v = i * 17.5e-3f * 0.017453292f;
+        for (int d = 0; d <= FORMAT_MAX_DECIMALS; d++) {
+            check_fixed(v, d);
+        }
+        check_fixed(i * 0.01f, 2);
+    }
+}
+
+static void test_halfway_cases_round_to_even() {
+    // Exactly representable halves at each precision: printf rounds them
+    // to even, as the value is exact.
+    for (int d = 0; d <= FORMAT_MAX_DECIMALS; d++) {
+        for (int k = 0; k < 2000; k++) {
+            float v = ((float)k + 0.5f) / (float)(1 << d);
+            check_fixed(v, d);
+            check_fixed(-v, d);
+        }
+    }
+    char text[16];
+    format_fixed(text, sizeof(text), 0.125f, 2);
+    TEST_ASSERT_EQUAL_STRING("0.12", text);
+    format_fixed(text, sizeof(text), 0.375f, 2);
+    TEST_ASSERT_EQUAL_STRING("0.38", text);
+    format_fixed(text, sizeof(text), 2.5f, 0);
+    TEST_ASSERT_EQUAL_STRING("2", text);
+    format_fixed(text, sizeof(text), 3.5f, 0);
+    TEST_ASSERT_EQUAL_STRING("4", text);
+    // Not a half: 0.15f is a little over 0.15.
+    format_fixed(text, sizeof(text), 0.15f, 1);
+    TEST_ASSERT_EQUAL_STRING("0.2", text);
+}
+
+static void test_special_values_match_printf() {
+    static const uint32_t SPECIAL[] = {
+        0x00000000, 0x80000000,             // +0, -0
+        0x00000001, 0x80000001,             // Smallest subnormals.
+        0x007FFFFF, 0x00800000,             // Largest subnormal, smallest normal.
+        0x3F7FFFFF, 0x3F800000,             // Just under one, one.
+        0x4F7FFFFF, 0xCF7FFFFF,             // Largest under 2^32.
+        0x33D6BF95,                         // 1e-7, rounds to zero.
+    };
+    for (unsigned k = 0; k < sizeof(SPECIAL) / sizeof(SPECIAL[0]); k++) {
+        for (int d = 0; d <= FORMAT_MAX_DECIMALS; d++) {
+            check_fixed(from_bits(SPECIAL[k]), d);
+        }
+    }
+    for (int d = 0; d <= FORMAT_MAX_DECIMALS; d++) {
+        check_fixed(INFINITY, d);
+        check_fixed(-INFINITY, d);
+        check_fixed(NAN, d);
+        check_fixed(-NAN, d);
+    }
+    // Just under the next decimal: 0.9999999f carries into the integer.
+    for (uint32_t bits = 0x3F7FFF00; bits <= 0x3F7FFFFF; bits++) {
+        for (int d = 0; d <= FORMAT_MAX_DECIMALS; d++) {
+            check_fixed(from_bits(bits), d);
+        }
+    }
+}
+
+static void test_large_values_do_not_fit() {
+    char text[64] = "x";
+    TEST_ASSERT_EQUAL_UINT32(0, format_fixed(text, sizeof(text), 4294967296.0f, 2));
+    TEST_ASSERT_EQUAL_STRING("", text);
+    TEST_ASSERT_EQUAL_UINT32(0, format_fixed(text, sizeof(text), -1e30f, 0));
+    TEST_ASSERT_EQUAL_UINT32(10, format_fixed(text, sizeof(text), 4294967040.0f, 0));
+    TEST_ASSERT_EQUAL_STRING("4294967040", text);
+}
+
+static void test_buffer_size_limits() {
+    char expected[64];
+    char text[64];
+    for (int i = 0; i < 2000; i++) {
+        float v = from_bits(next_random() & 0xC7FFFFFF);   // Under 2^17.
+        int d = i % (FORMAT_MAX_DECIMALS + 1);
+        int n = snprintf(expected, sizeof(expected), "%.*f", d, (double)v);
+        // Exactly enough room, then one char short.
+        memset(text, 'x', sizeof(text));
+        TEST_ASSERT_EQUAL_UINT32(n, format_fixed(text, n + 1, v, d));
+        TEST_ASSERT_EQUAL_STRING(expected, text);
+        memset(text, 'x', sizeof(text));
+        TEST_ASSERT_EQUAL_UINT32(0, format_fixed(text, n, v, d));
+        TEST_ASSERT_EQUAL_INT('\0', text[0]);
+        TEST_ASSERT_EQUAL_INT('x', text[n]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, format_fixed(text, 0, 1.0f, 0));
+    TEST_ASSERT_EQUAL_UINT32(0, format_fixed(text, 4, -INFINITY, 0));
+    TEST_ASSERT_EQUAL_UINT32(4, format_fixed(text, 5, -INFINITY, 0));
+}
+
+static void test_fields_match_printf() {
+    char expected[64];
+    char actual[64];
+    for (int i = 0; i < 20000; i++) {
+        float v = from_bits(next_random() & 0xCBFFFFFF);   // Under 2^25.
+        int d = i % (FORMAT_MAX_DECIMALS + 1);
+        int width = (int)(next_random() % 41) - 20;
+        int n = snprintf(expected, sizeof(expected), "%*.*f", width, d, (double)v);
+        TEST_ASSERT_EQUAL_UINT32(n, format_field(actual, sizeof(actual), v, width, d));
+        TEST_ASSERT_EQUAL_STRING(expected, actual);
+    }
+    // The padding counts against the buffer too.
+    TEST_ASSERT_EQUAL_UINT32(0, format_field(actual, 8, 1.5f, 8, 1));
+    TEST_ASSERT_EQUAL_UINT32(8, format_field(actual, 9, 1.5f, 8, 1));
+    TEST_ASSERT_EQUAL_STRING("     1.5", actual);
+}
+
+// What format_fit() writes, worked out with printf.
+static void reference_fit(char *out, int width, float value, int max_decimals) {
+    char text[64];
+    for (int d = max_decimals; d >= 0; d--) {
+        int n = snprintf(text, sizeof(text), "%.*f", d, (double)value);
+        if (n <= width && fabsf(value) < 4294967296.0f) {
+            memset(out, ' ', (size_t)(width - n));
+            memcpy(out + width - n, text, (size_t)n + 1);
+            return;
+        }
+    }
+    memset(out, '-', (size_t)width);
+    out[width] = '\0';
+}
+
+static void test_fit_matches_printf() {
+    char expected[64];
+    char actual[64];
+    for (int i = 0; i < 20000; i++) {
+        float v = from_bits(next_random() & 0xCBFFFFFF);
+        int width = 1 + (int)(next_random() % 12);
+        int d = (int)(next_random() % (FORMAT_MAX_DECIMALS + 1));
+        reference_fit(expected, width, v, d);
+        format_fit(actual, width, v, d);
+        TEST_ASSERT_EQUAL_STRING(expected, actual);
+    }
+    format_fit(actual, 6, -1.23456f, 4);
+    TEST_ASSERT_EQUAL_STRING("-1.235", actual);
+    format_fit(actual, 3, 12345.0f, 2);
+    TEST_ASSERT_EQUAL_STRING("---", actual);
+}
+
+static void test_uint_matches_printf() {
+    char expected[16];
+    char actual[16];
+    static const uint32_t EDGES[] = {0, 9, 10, 99, 100, 999999999, 1000000000, 4294967295u};
+    for (unsigned k = 0; k < sizeof(EDGES) / sizeof(EDGES[0]); k++) {
+        snprintf(expected, sizeof(expected), "%lu", (unsigned long)EDGES[k]);
+        TEST_ASSERT_EQUAL_UINT32(strlen(expected), format_uint(actual, sizeof(actual), EDGES[k]));
+        TEST_ASSERT_EQUAL_STRING(expected, actual);
+    }
+    for (int i = 0; i < 100000; i++) {
+        uint32_t v = next_random() >> (next_random() % 32);
+        int n = snprintf(expected, sizeof(expected), "%lu", (unsigned long)v);
+        TEST_ASSERT_EQUAL_UINT32(n, format_uint(actual, sizeof(actual), v));
+        TEST_ASSERT_EQUAL_STRING(expected, actual);
+        TEST_ASSERT_EQUAL_UINT32(0, format_uint(actual, n, v));
+    }
+}
+
+static void test_fixed_text() {
+    char expected[32];
+    snprintf(expected, sizeof(expected), "%7.2f", 123.456);
+    TEST_ASSERT_EQUAL_STRING(expected, FixedText(123.456f, 2, 7).c_str());
+    TEST_ASSERT_EQUAL_STRING("?", FixedText(1e20f, 2).c_str());
+}
+
+// Not a pass/fail check (host timings vary): format_fixed() against
+// printf's "%f" (six decimals) over random floats under 2^25, for the
+// record.
+static void test_report_format_time() {
+    const int values = 200000;
+    char text[64];
+    float v[256];
+    for (int i = 0; i < 256; i++) {
+        v[i] = from_bits(next_random() & 0xCBFFFFFF);
+    }
+
+    typedef std::chrono::steady_clock clock;
+    volatile char sink = 0;
+    clock::time_point t0 = clock::now();
+    for (int i = 0; i < values; i++) {
+        snprintf(text, sizeof(text), "%f", (double)v[i % 256]);
+        sink = sink + text[0];
+    }
+    clock::time_point t1 = clock::now();
+    for (int i = 0; i < values; i++) {
+        format_fixed(text, sizeof(text), v[i % 256], FORMAT_MAX_DECIMALS);
+        sink = sink + text[0];
+    }
+    clock::time_point t2 = clock::now();
+    printf("Six decimals: printf %.1f ns, format_fixed %.1f ns\n",
+           std::chrono::duration<double, std::nano>(t1 - t0).count() / values,
+           std::chrono::duration<double, std::nano>(t2 - t1).count() / values);
+}
+
+// Not a pass/fail check (host timings vary): a live rate reading of
+// main.cpp (8 cells, 5 decimals, within the 500 dps range) through
+// format_fit() and through printf, for the record. The drawing side is
+// timed on the board (test/target/test_numeric_readout).
+static void test_report_reading_time() {
+    const int readings = 200000;
+    char text[16];
+    float rates[256];
+    for (int i = 0; i < 256; i++) {
+        rates[i] = (float)((int)(next_random() % 17453) - 8726) * 1e-3f;
+    }
+
+    typedef std::chrono::steady_clock clock;
+    volatile char sink = 0;
+    clock::time_point t0 = clock::now();
+    for (int i = 0; i < readings; i++) {
+        snprintf(text, sizeof(text), "%*.*f", 8, 5, (double)rates[i % 256]);
+        sink = sink + text[7];
+    }
+    clock::time_point t1 = clock::now();
+    for (int i = 0; i < readings; i++) {
+        format_fit(text, 8, rates[i % 256], 5);
+        sink = sink + text[7];
+    }
+    clock::time_point t2 = clock::now();
+    printf("Rate reading: printf %.1f ns, format_fit %.1f ns\n",
+           std::chrono::duration<double, std::nano>(t1 - t0).count() / readings,
+           std::chrono::duration<double, std::nano>(t2 - t1).count() / readings);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_random_floats_match_printf);
+    RUN_TEST(test_readings_match_printf);
+    RUN_TEST(test_halfway_cases_round_to_even);
+    RUN_TEST(test_special_values_match_printf);
+    RUN_TEST(test_large_values_do_not_fit);
+    RUN_TEST(test_buffer_size_limits);
+    RUN_TEST(test_fields_match_printf);
+    RUN_TEST(test_fit_matches_printf);
+    RUN_TEST(test_uint_matches_printf);
+    RUN_TEST(test_fixed_text);
+    RUN_TEST(test_report_format_time);
+    RUN_TEST(test_report_reading_time);
+    return UNITY_END();
+}
@@ -0,0 +1,201 @@
+/**
+ * @file test_main.cpp
+ *
+ * @brief Orientation integrators on known rotations, the Q2.30
+ *        integrator against the float one, and the time per update.
+ *
+ */
+
+#include <unity.h>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "orientation.h"
+
+// L3GD20 at 245 dps full scale: 8.75 mdps per LSB, in rad/s.
+#define SCALE (8.75e-3f * (float)M_PI / 180.0f)
+
+// Sample spacing at 760 Hz.
+#define DT_US 1316
+
+void setUp() {}
+
+void tearDown() {}
+
+// Integrates rate (rad/s) about one axis for the given number of samples.
+template <typename Integrator>
+static void spin(Integrator &integrator, int axis, float rate, int samples) {
+    int16_t raw[3] = {0, 0, 0};
+    raw[axis] = (int16_t)lroundf(rate / SCALE);
+    for (int i = 0; i < samples; i++) {
+        integrator.update(raw, DT_US);
+    }
+}
+
+// Angle (rad) of the rotation between two unit quaternions.
+static float angle_between(const Quaternion &a, const Quaternion &b) {
+    float dot = a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z;
+    dot = fabsf(dot);
+    return 2.0f * acosf(dot > 1.0f ? 1.0f : dot);
+}
+
+// Angle a held raw rate really sweeps (the raw value is rounded).
+static double swept(float rate, int samples) {
+    return lroundf(rate / SCALE) * (double)SCALE * DT_US * 1e-6 * samples;
+}
+
+template <typename Integrator>
+static void check_yaw_turn() {
+    Integrator integrator(SCALE);
+    spin(integrator, 2, 1.0f, 760);
+    double expected = swept(1.0f, 760);
+
+    EulerAngles e = quaternion_to_euler(integrator.quaternion());
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, (float)expected, e.yaw);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.0f, e.roll);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.0f, e.pitch);
+}
+
+static void test_float_yaw_turn() {
+    check_yaw_turn<OrientationIntegrator>();
+}
+
+static void test_q30_yaw_turn() {
+    check_yaw_turn<OrientationIntegratorQ30>();
+}
+
+// 90 degrees about x, then 90 about the new y: the composite rotation is
+// q = (1/2, 1/2, 1/2, 1/2) (body-frame order: q = qx * qy).
+template <typename Integrator>
+static void check_two_quarter_turns() {
+    Integrator integrator(SCALE);
+    const float rate = 2.0f;
+    const int samples = (int)lround((M_PI / 2) / (lroundf(rate / SCALE) * (double)SCALE * DT_US * 1e-6));
+    spin(integrator, 0, rate, samples);
+    spin(integrator, 1, rate, samples);
+
+    Quaternion expected = {0.5f, 0.5f, 0.5f, 0.5f};
+    TEST_ASSERT_FLOAT_WITHIN(2e-3f, 0.0f, angle_between(expected, integrator.quaternion()));
+}
+
+static void test_float_two_quarter_turns() {
+    check_two_quarter_turns<OrientationIntegrator>();
+}
+
+static void test_q30_two_quarter_turns() {
+    check_two_quarter_turns<OrientationIntegratorQ30>();
+}
+
+// The fixed-point half-angle factor carries the full scale to better than
+// 1 ppm: a long one-axis turn lands where the exact product says.
+static void test_q30_scale_is_exact() {
+    OrientationIntegratorQ30 integrator(SCALE);
+    const float rate = 0.3f;
+    const int samples = 7600;
+    spin(integrator, 0, rate, samples);
+
+    double expected = swept(rate, samples);
+    float angle = quaternion_angle(integrator.quaternion());
+    // Wrap into [0, 2 pi) the same way.
+    double wrapped = fmod(expected, 4.0 * M_PI);
+    if (wrapped > 2.0 * M_PI) {
+        wrapped = 4.0 * M_PI - wrapped;
+    }
+    TEST_ASSERT_FLOAT_WITHIN((float)(expected * 1e-6) + 2e-5f, (float)wrapped, angle);
+}
+
+static void test_q30_tracks_float() {
+    OrientationIntegrator reference(SCALE);
+    OrientationIntegratorQ30 fixed(SCALE);
+    srand(1);
+    int16_t raw[3];
+    for (int i = 0; i < 20000; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            raw[axis] = (int16_t)(rand() % 20001 - 10000);
+        }
+        uint32_t dt_us = DT_US - 50 + (uint32_t)(rand() % 101);
+        reference.update(raw, dt_us);
+        fixed.update(raw, dt_us);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.0f, angle_between(reference.quaternion(), fixed.quaternion()));
+
+    Quaternion q = fixed.quaternion();
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 1.0f, q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+}
+
+template <typename Integrator>
+static void check_long_gap_is_clamped() {
+    Integrator clamped(SCALE);
+    Integrator limit(SCALE);
+    int16_t raw[3] = {1000, -2000, 3000};
+    clamped.update(raw, 5 * ORIENTATION_MAX_DT_US);
+    limit.update(raw, ORIENTATION_MAX_DT_US);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f, angle_between(clamped.quaternion(), limit.quaternion()));
+}
+
+static void test_long_gap_is_clamped() {
+    check_long_gap_is_clamped<OrientationIntegrator>();
+    check_long_gap_is_clamped<OrientationIntegratorQ30>();
+}
+
+static void test_reset_returns_identity() {
+    OrientationIntegratorQ30 integrator(SCALE);
+    spin(integrator, 1, 1.0f, 100);
+    integrator.reset();
+    Quaternion q = integrator.quaternion();
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, q.w);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, q.x);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, q.y);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, q.z);
+}
+
+// Nanoseconds per update over a random trace, averaged over reps runs.
+template <typename Integrator>
+static double time_updates(const int16_t (*raw)[3], const uint32_t *dt_us, int n, int reps) {
+    typedef std::chrono::steady_clock clock;
+    Integrator integrator(SCALE);
+    volatile float sink = 0;
+    clock::time_point t0 = clock::now();
+    for (int rep = 0; rep < reps; rep++) {
+        for (int i = 0; i < n; i++) {
+            integrator.update(raw[i], dt_us[i]);
+        }
+        sink = sink + integrator.quaternion().w;
+    }
+    clock::time_point t1 = clock::now();
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / ((double)n * reps);
+}
+
+// Not a pass/fail check (host timings vary): the cost of one update step,
+// float against Q2.30, for the record. On the board OrientationStage
+// counts cycles per update, on the processing thread (not in the
+// acquisition handler), and reports them after each session.
+static void test_report_update_time() {
+    static int16_t raw[4096][3];
+    static uint32_t dt_us[4096];
+    srand(2);
+    for (int i = 0; i < 4096; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            raw[i][axis] = (int16_t)(rand() % 20001 - 10000);
+        }
+        dt_us[i] = DT_US - 50 + (uint32_t)(rand() % 101);
+    }
+    double float_ns = time_updates<OrientationIntegrator>(raw, dt_us, 4096, 200);
+    double q30_ns = time_updates<OrientationIntegratorQ30>(raw, dt_us, 4096, 200);
+    printf("Orientation update: float %.1f ns, Q2.30 %.1f ns\n", float_ns, q30_ns);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_float_yaw_turn);
+    RUN_TEST(test_q30_yaw_turn);
+    RUN_TEST(test_float_two_quarter_turns);
+    RUN_TEST(test_q30_two_quarter_turns);
+    RUN_TEST(test_q30_scale_is_exact);
+    RUN_TEST(test_q30_tracks_float);
+    RUN_TEST(test_long_gap_is_clamped);
+    RUN_TEST(test_reset_returns_identity);
+    RUN_TEST(test_report_update_time);
+    return UNITY_END();
+}
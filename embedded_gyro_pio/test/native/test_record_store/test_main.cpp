@@ -0,0 +1,352 @@
+/**
+ * @file test_main.cpp
+ *
+ * @brief RecordStore against a file-backed EEPROM: mounting, wrapping,
+ *        carry-forward, the index, commit on completion and recovery
+ *        from failed and torn writes.
+ *
+ */
+
+#include <unity.h>
+#include "record_store.h"
+#include "../file_eeprom.h"
+
+#define IMAGE       "test_record_store.bin"
+#define BASE        0x0100
+#define SLOTS       16
+#define LOG_SLOTS   (SLOTS - 1)     // The last slot holds the index.
+#define IMAGE_SIZE  (BASE + SLOTS * RECORD_SLOT_SIZE)
+
+static SensorProfile profile(uint32_t odr) {
+    SensorProfile p = {};
+    p.ctrl_reg[0] = 0x0F;
+    p.scale = 0.00026f;
+    p.odr_hz = odr;
+    return p;
+}
+
+// A record of another type, to fill the log with.
+struct Stride {
+    float length_m;
+    uint32_t strides;
+};
+
+static Stride stride(float length) {
+    Stride s = {};
+    s.length_m = length;
+    s.strides = 1000;
+    return s;
+}
+
+void setUp() {
+    FileEeprom::erase(IMAGE);
+}
+
+void tearDown() {
+    FileEeprom::erase(IMAGE);
+}
+
+static void test_blank_store_mounts_empty() {
+    FileEeprom eeprom(IMAGE, IMAGE_SIZE);
+    RecordStore store(eeprom, BASE, SLOTS * RECORD_SLOT_SIZE);
+    TEST_ASSERT_TRUE(store.mount());
+    TEST_ASSERT_EQUAL_UINT16(LOG_SLOTS, store.slots());
+    TEST_ASSERT_EQUAL_UINT16(0, store.head());
+    TEST_ASSERT_EQUAL_UINT32(0, store.next_sequence());
+
+    SensorProfile p;
+    TEST_ASSERT_FALSE(store.latest(RECORD_SENSOR_PROFILE, p));
+}
+
+static void test_latest_survives_remount() {
+    {
+        FileEeprom eeprom(IMAGE, IMAGE_SIZE);
+        RecordStore store(eeprom, BASE, SLOTS * RECORD_SLOT_SIZE);
+        TEST_ASSERT_TRUE(store.mount());
+        TEST_ASSERT_TRUE(store.append(RECORD_SENSOR_PROFILE, profile(100)));
+        TEST_ASSERT_TRUE(store.append(RECORD_STRIDE_CALIBRATION, stride(1.5f)));
+        TEST_ASSERT_TRUE(store.append(RECORD_SENSOR_PROFILE, profile(200)));
+    }
+
+    FileEeprom eeprom(IMAGE, IMAGE_SIZE);
+    RecordStore store(eeprom, BASE, SLOTS * RECORD_SLOT_SIZE);
+    TEST_ASSERT_TRUE(store.mount());
+    TEST_ASSERT_EQUAL_UINT16(3, store.head());
+    TEST_ASSERT_EQUAL_UINT32(3, store.next_sequence());
+
+    SensorProfile p;
+    TEST_ASSERT_TRUE(store.latest(RECORD_SENSOR_PROFILE, p));
+    TEST_ASSERT_EQUAL_UINT32(200, p.odr_hz);
+    Stride s;
+    TEST_ASSERT_TRUE(store.latest(RECORD_STRIDE_CALIBRATION, s));
+    TEST_ASSERT_EQUAL_FLOAT(1.5f, s.length_m);
+}
+
+static void test_head_found_after_several_laps() {
+    const int appends = LOG_SLOTS * 3 + 5;
+    {
+        FileEeprom eeprom(IMAGE, IMAGE_SIZE);
+        RecordStore store(eeprom, BASE, SLOTS * RECORD_SLOT_SIZE);
+        TEST_ASSERT_TRUE(store.mount());
+        for (int i = 0; i < appends; i++) {
+            TEST_ASSERT_TRUE(store.append(RECORD_STRIDE_CALIBRATION, stride((float)i)));
+        }
+    }
+
+    FileEeprom eeprom(IMAGE, IMAGE_SIZE);
+    RecordStore store(eeprom, BASE, SLOTS * RECORD_SLOT_SIZE);
+    TEST_ASSERT_TRUE(store.mount());
+    TEST_ASSERT_EQUAL_UINT16(appends % LOG_SLOTS, store.head());
+    TEST_ASSERT_EQUAL_UINT32(appends, store.next_sequence());
+    Stride s;
+    TEST_ASSERT_TRUE(store.latest(RECORD_STRIDE_CALIBRATION, s));
+    TEST_ASSERT_EQUAL_FLOAT((float)(appends - 1), s.length_m);
+}
+
+static void test_missing_type_costs_no_reads() {
+    FileEeprom eeprom(IMAGE, IMAGE_SIZE);
+    RecordStore store(eeprom, BASE, SLOTS * RECORD_SLOT_SIZE);
+    TEST_ASSERT_TRUE(store.mount());
+    for (int i = 0; i < LOG_SLOTS * 2; i++) {
+        TEST_ASSERT_TRUE(store.append(RECORD_STRIDE_CALIBRATION, stride((float)i)));
+    }
+    TEST_ASSERT_TRUE(store.mount());
+
+    // The mount walk has already settled that there is no profile.
+    uint32_t reads = eeprom.reads;
+    SensorProfile p;
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_FALSE(store.latest(RECORD_SENSOR_PROFILE, p));
+    }
+    TEST_ASSERT_EQUAL_UINT32(reads, eeprom.reads);
+}
+
+static void test_mount_reads_the_index_not_the_log() {
+    FileEeprom eeprom(IMAGE, IMAGE_SIZE);
+    RecordStore store(eeprom, BASE, SLOTS * RECORD_SLOT_SIZE);
+    TEST_ASSERT_TRUE(store.mount());
+    TEST_ASSERT_TRUE(store.append(RECORD_SENSOR_PROFILE, profile(100)));
+    for (int i = 0; i < LOG_SLOTS - 3; i++) {
+        TEST_ASSERT_TRUE(store.append(RECORD_STRIDE_CALIBRATION, stride((float)i)));
+    }
+
+    // Probe, slot 0, the head search, the index and the newest slot; no
+    // walk back to the profile, and none for the touch calibration that
+    // was never written.
+    RecordStore remounted(eeprom, BASE, SLOTS * RECORD_SLOT_SIZE);
+    eeprom.reads = 0;
+    TEST_ASSERT_TRUE(remounted.mount());
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(8, eeprom.reads);
+
+    SensorProfile p;
+    TEST_ASSERT_TRUE(remounted.latest(RECORD_SENSOR_PROFILE, p));
+    TEST_ASSERT_EQUAL_UINT32(100, p.odr_hz);
+    Stride s;
+    TEST_ASSERT_TRUE(remounted.latest(RECORD_STRIDE_CALIBRATION, s));
+    TEST_ASSERT_EQUAL_FLOAT((float)(LOG_SLOTS - 4), s.length_m);
+    uint8_t touch[8];
+    TEST_ASSERT_FALSE(remounted.latest(RECORD_TOUCH_CALIBRATION, touch, sizeof(touch)));
+}
+
+static void test_index_behind_walks_the_slots_since() {
+    FileEeprom eeprom(IMAGE, IMAGE_SIZE);
+    RecordStore store(eeprom, BASE, SLOTS * RECORD_SLOT_SIZE);
+    TEST_ASSERT_TRUE(store.mount());
+    TEST_ASSERT_TRUE(store.append(RECORD_STRIDE_CALIBRATION, stride(1.0f)));
+    TEST_ASSERT_TRUE(store.append(RECORD_SENSOR_PROFILE, profile(100)));
+
+    // The index writes fail, the records land.
+    uint8_t touch[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    eeprom.fail_writes = 1;
+    TEST_ASSERT_TRUE(store.append(RECORD_TOUCH_CALIBRATION, touch, sizeof(touch)));
+    eeprom.fail_writes = 1;
+    TEST_ASSERT_TRUE(store.append(RECORD_SENSOR_PROFILE, profile(200)));
+    TEST_ASSERT_EQUAL_UINT32(4, store.next_sequence());
+
+    // The index was last written before the profile: three slots since.
+    RecordStore remounted(eeprom, BASE, SLOTS * RECORD_SLOT_SIZE);
+    eeprom.reads = 0;
+    TEST_ASSERT_TRUE(remounted.mount());
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(10, eeprom.reads);
+    SensorProfile p;
+    TEST_ASSERT_TRUE(remounted.latest(RECORD_SENSOR_PROFILE, p));
+    TEST_ASSERT_EQUAL_UINT32(200, p.odr_hz);
+    uint8_t read_back[8];
+    TEST_ASSERT_TRUE(remounted.latest(RECORD_TOUCH_CALIBRATION, read_back, sizeof(read_back)));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(touch, read_back, sizeof(touch));
+    Stride s;
+    TEST_ASSERT_TRUE(remounted.latest(RECORD_STRIDE_CALIBRATION, s));
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, s.length_m);
+}
+
+static void test_torn_index_falls_back_to_walk() {
+    {
+        FileEeprom eeprom(IMAGE, IMAGE_SIZE);
+        RecordStore store(eeprom, BASE, SLOTS * RECORD_SLOT_SIZE);
+        TEST_ASSERT_TRUE(store.mount());
+        TEST_ASSERT_TRUE(store.append(RECORD_SENSOR_PROFILE, profile(100)));
+        for (int i = 0; i < LOG_SLOTS + 4; i++) {
+            TEST_ASSERT_TRUE(store.append(RECORD_STRIDE_CALIBRATION, stride((float)i)));
+        }
+        eeprom.tear_after = 10;
+        TEST_ASSERT_TRUE(store.append(RECORD_STRIDE_CALIBRATION, stride(99.0f)));
+    }
+
+    FileEeprom eeprom(IMAGE, IMAGE_SIZE);
+    RecordStore store(eeprom, BASE, SLOTS * RECORD_SLOT_SIZE);
+    TEST_ASSERT_TRUE(store.mount());
+    SensorProfile p;
+    TEST_ASSERT_TRUE(store.latest(RECORD_SENSOR_PROFILE, p));
+    TEST_ASSERT_EQUAL_UINT32(100, p.odr_hz);
+    Stride s;
+    TEST_ASSERT_TRUE(store.latest(RECORD_STRIDE_CALIBRATION, s));
+    TEST_ASSERT_EQUAL_FLOAT(99.0f, s.length_m);
+    uint8_t touch[8];
+    TEST_ASSERT_FALSE(store.latest(RECORD_TOUCH_CALIBRATION, touch, sizeof(touch)));
+
+    // The next append rewrites the index, and mounts are short again.
+    TEST_ASSERT_TRUE(store.append(RECORD_SENSOR_PROFILE, profile(200)));
+    RecordStore remounted(eeprom, BASE, SLOTS * RECORD_SLOT_SIZE);
+    eeprom.reads = 0;
+    TEST_ASSERT_TRUE(remounted.mount());
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(8, eeprom.reads);
+    TEST_ASSERT_TRUE(remounted.latest(RECORD_SENSOR_PROFILE, p));
+    TEST_ASSERT_EQUAL_UINT32(200, p.odr_hz);
+}
+
+static void test_carry_forward_keeps_profile() {
+    FileEeprom eeprom(IMAGE, IMAGE_SIZE);
+    RecordStore store(eeprom, BASE, SLOTS * RECORD_SLOT_SIZE);
+    TEST_ASSERT_TRUE(store.mount());
+    TEST_ASSERT_TRUE(store.append(RECORD_SENSOR_PROFILE, profile(800)));
+    for (int i = 0; i < LOG_SLOTS * 4; i++) {
+        TEST_ASSERT_TRUE(store.append(RECORD_STRIDE_CALIBRATION, stride((float)i)));
+    }
+
+    SensorProfile p;
+    TEST_ASSERT_TRUE(store.latest(RECORD_SENSOR_PROFILE, p));
+    TEST_ASSERT_EQUAL_UINT32(800, p.odr_hz);
+
+    RecordStore remounted(eeprom, BASE, SLOTS * RECORD_SLOT_SIZE);
+    TEST_ASSERT_TRUE(remounted.mount());
+    TEST_ASSERT_TRUE(remounted.latest(RECORD_SENSOR_PROFILE, p));
+    TEST_ASSERT_EQUAL_UINT32(800, p.odr_hz);
+}
+
+static void test_failed_write_leaves_head() {
+    FileEeprom eeprom(IMAGE, IMAGE_SIZE);
+    RecordStore store(eeprom, BASE, SLOTS * RECORD_SLOT_SIZE);
+    TEST_ASSERT_TRUE(store.mount());
+    TEST_ASSERT_TRUE(store.append(RECORD_SENSOR_PROFILE, profile(100)));
+
+    // The index lands, the record does not.
+    eeprom.pass_writes = 1;
+    eeprom.fail_writes = 1;
+    TEST_ASSERT_TRUE(store.append(RECORD_SENSOR_PROFILE, profile(200)));
+    TEST_ASSERT_EQUAL_UINT16(1, store.head());
+    TEST_ASSERT_EQUAL_UINT32(1, store.next_sequence());
+    SensorProfile p;
+    TEST_ASSERT_TRUE(store.latest(RECORD_SENSOR_PROFILE, p));
+    TEST_ASSERT_EQUAL_UINT32(100, p.odr_hz);
+
+    // The retry goes to the same slot.
+    TEST_ASSERT_TRUE(store.append(RECORD_SENSOR_PROFILE, profile(300)));
+    TEST_ASSERT_EQUAL_UINT16(2, store.head());
+    TEST_ASSERT_TRUE(store.latest(RECORD_SENSOR_PROFILE, p));
+    TEST_ASSERT_EQUAL_UINT32(300, p.odr_hz);
+}
+
+static void test_head_moves_when_write_lands() {
+    FileEeprom eeprom(IMAGE, IMAGE_SIZE);
+    RecordStore store(eeprom, BASE, SLOTS * RECORD_SLOT_SIZE);
+    TEST_ASSERT_TRUE(store.mount());
+    eeprom.deferred = true;
+
+    TEST_ASSERT_TRUE(store.append(RECORD_SENSOR_PROFILE, profile(100)));
+    TEST_ASSERT_EQUAL_UINT16(0, store.head());
+    TEST_ASSERT_EQUAL_UINT32(0, store.next_sequence());
+    eeprom.sync();
+    TEST_ASSERT_EQUAL_UINT16(1, store.head());
+    TEST_ASSERT_EQUAL_UINT32(1, store.next_sequence());
+
+    // A second append settles the first before it picks its slot.
+    TEST_ASSERT_TRUE(store.append(RECORD_SENSOR_PROFILE, profile(200)));
+    TEST_ASSERT_TRUE(store.append(RECORD_SENSOR_PROFILE, profile(300)));
+    SensorProfile p;
+    TEST_ASSERT_TRUE(store.latest(RECORD_SENSOR_PROFILE, p));
+    TEST_ASSERT_EQUAL_UINT32(300, p.odr_hz);
+    TEST_ASSERT_EQUAL_UINT16(3, store.head());
+}
+
+static void test_failed_deferred_write_is_retried() {
+    FileEeprom eeprom(IMAGE, IMAGE_SIZE);
+    RecordStore store(eeprom, BASE, SLOTS * RECORD_SLOT_SIZE);
+    TEST_ASSERT_TRUE(store.mount());
+    eeprom.deferred = true;
+
+    eeprom.pass_writes = 1;
+    eeprom.fail_writes = 1;
+    TEST_ASSERT_TRUE(store.append(RECORD_SENSOR_PROFILE, profile(100)));
+    SensorProfile p;
+    TEST_ASSERT_FALSE(store.latest(RECORD_SENSOR_PROFILE, p));
+    TEST_ASSERT_EQUAL_UINT16(0, store.head());
+
+    TEST_ASSERT_TRUE(store.append(RECORD_SENSOR_PROFILE, profile(200)));
+    TEST_ASSERT_TRUE(store.latest(RECORD_SENSOR_PROFILE, p));
+    TEST_ASSERT_EQUAL_UINT32(200, p.odr_hz);
+    TEST_ASSERT_EQUAL_UINT16(1, store.head());
+}
+
+static void test_torn_write_recovers_on_mount() {
+    {
+        FileEeprom eeprom(IMAGE, IMAGE_SIZE);
+        RecordStore store(eeprom, BASE, SLOTS * RECORD_SLOT_SIZE);
+        TEST_ASSERT_TRUE(store.mount());
+        for (int i = 0; i < LOG_SLOTS + 3; i++) {
+            TEST_ASSERT_TRUE(store.append(RECORD_SENSOR_PROFILE, profile((uint32_t)i)));
+        }
+        eeprom.pass_writes = 1;
+        eeprom.tear_after = 10;
+        TEST_ASSERT_TRUE(store.append(RECORD_SENSOR_PROFILE, profile(999)));
+        TEST_ASSERT_EQUAL_UINT16(3, store.head());
+    }
+
+    FileEeprom eeprom(IMAGE, IMAGE_SIZE);
+    RecordStore store(eeprom, BASE, SLOTS * RECORD_SLOT_SIZE);
+    TEST_ASSERT_TRUE(store.mount());
+    TEST_ASSERT_EQUAL_UINT16(3, store.head());
+    TEST_ASSERT_EQUAL_UINT32(LOG_SLOTS + 3, store.next_sequence());
+    SensorProfile p;
+    TEST_ASSERT_TRUE(store.latest(RECORD_SENSOR_PROFILE, p));
+    TEST_ASSERT_EQUAL_UINT32(LOG_SLOTS + 2, p.odr_hz);
+}
+
+static void test_rejects_bad_arguments() {
+    FileEeprom eeprom(IMAGE, IMAGE_SIZE);
+    RecordStore store(eeprom, BASE, SLOTS * RECORD_SLOT_SIZE);
+    uint8_t payload[RECORD_PAYLOAD_SIZE + 1] = {};
+    TEST_ASSERT_FALSE(store.append(RECORD_SENSOR_PROFILE, payload, 4));     // Not mounted.
+    TEST_ASSERT_TRUE(store.mount());
+    TEST_ASSERT_FALSE(store.append((RecordType)0, payload, 4));
+    TEST_ASSERT_FALSE(store.append(RECORD_TYPE_COUNT, payload, 4));
+    TEST_ASSERT_FALSE(store.append(RECORD_SENSOR_PROFILE, payload, sizeof(payload)));
+    TEST_ASSERT_EQUAL_UINT32(0, eeprom.writes);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_blank_store_mounts_empty);
+    RUN_TEST(test_latest_survives_remount);
+    RUN_TEST(test_head_found_after_several_laps);
+    RUN_TEST(test_missing_type_costs_no_reads);
+    RUN_TEST(test_mount_reads_the_index_not_the_log);
+    RUN_TEST(test_index_behind_walks_the_slots_since);
+    RUN_TEST(test_torn_index_falls_back_to_walk);
+    RUN_TEST(test_carry_forward_keeps_profile);
+    RUN_TEST(test_failed_write_leaves_head);
+    RUN_TEST(test_head_moves_when_write_lands);
+    RUN_TEST(test_failed_deferred_write_is_retried);
+    RUN_TEST(test_torn_write_recovers_on_mount);
+    RUN_TEST(test_rejects_bad_arguments);
+    return UNITY_END();
+}
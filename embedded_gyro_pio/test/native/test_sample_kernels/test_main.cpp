@@ -0,0 +1,246 @@
+/**
+ * @file test_main.cpp
+ *
+ * @brief The post-recording kernels against the per-sample float loops
+ *        processing() ran over the volatile arrays before, and the views
+ *        they run on.
+ *
+ */
+
+#include <unity.h>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include "sample_buffer.h"
+#include "sample_kernels.h"
+
+// main.cpp's recording: 190 Hz, 500 dps full scale, 20 s.
+#define ODR_HZ        190
+#define PERIOD_US     5263
+#define SCALE         (17.5e-3f * 0.0174532925f)
+#define SAMPLES       (20 * ODR_HZ)
+
+// Intervals processing() integrates separately.
+#define INTERVAL_US   500000
+
+static SampleBuffer<SAMPLES> recording;
+
+// The arrays processing() read before the views.
+static volatile int16_t old_values[SAMPLES][3];
+static volatile uint32_t old_timestamps_us[SAMPLES];
+
+static uint32_t lcg_state;
+
+static uint32_t lcg() {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return lcg_state >> 8;
+}
+
+// A walk: a 1.8 Hz swing on Z with noise, time-stamps with a few
+// microseconds of jitter. Fills the buffer and the old arrays alike.
+static void record(size_t n) {
+    recording.clear();
+    lcg_state = 777;
+    uint32_t t = 0;
+    for (size_t i = 0; i < n; i++) {
+        double phase = 2 * 3.14159265358979 * 1.8 * t * 1e-6;
+        int16_t raw[3] = {(int16_t)(lcg() % 2001 - 1000), (int16_t)(3000 * cos(phase)),
+                          (int16_t)(20000 * sin(phase) + (int)(lcg() % 401) - 200)};
+        TEST_ASSERT_TRUE(recording.push(t, raw));
+        for (int a = 0; a < 3; a++) {
+            old_values[i][a] = raw[a];
+        }
+        old_timestamps_us[i] = t;
+        t += PERIOD_US - 4 + lcg() % 9;
+    }
+}
+
+// processing()'s interval loop before the kernel: samples first..last.
+static float old_swept_angle(int first, int last) {
+    float change_in_angle = 0.0;
+    for (int j = first; j < last; j++) {
+        float delta_time = (old_timestamps_us[j + 1] - old_timestamps_us[j]) * 1e-6f;
+        change_in_angle += (fabs(old_values[j][2] * SCALE) + fabs(old_values[j + 1][2] * SCALE)) * (delta_time / 2);
+    }
+    return change_in_angle;
+}
+
+// The same in double: the exact answer to within the scale factor.
+static double exact_swept_angle(int first, int last) {
+    double sum = 0;
+    for (int j = first; j < last; j++) {
+        double dt = (double)(old_timestamps_us[j + 1] - old_timestamps_us[j]);
+        sum += (fabs((double)old_values[j][2]) + fabs((double)old_values[j + 1][2])) * dt;
+    }
+    return sum * (double)SCALE * 0.5e-6;
+}
+
+// make_session_summary()'s peak search before the kernel.
+static float old_max_rate(int n) {
+    float max_rate = 0.0f;
+    for (int i = 0; i < n; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            float rate = fabsf(old_values[i][axis] * SCALE);
+            if (rate > max_rate) {
+                max_rate = rate;
+            }
+        }
+    }
+    return max_rate;
+}
+
+// Last sample of each interval, as RecordSink marks them.
+static int interval_ends(int *ends, int max) {
+    SampleView v = recording.view();
+    int n = 0;
+    uint32_t next = INTERVAL_US;
+    for (size_t i = 0; i < v.size() && n < max; i++) {
+        if (v.timestamps_us[i] >= next) {
+            ends[n++] = (int)i;
+            next += INTERVAL_US;
+        }
+    }
+    return n;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_swept_angle_matches_old_loop() {
+    record(SAMPLES);
+    SampleView samples = recording.view();
+    int ends[45];
+    int n = interval_ends(ends, 45);
+    TEST_ASSERT_EQUAL_INT(39, n);          // 0.5 s to 19.5 s; the last sample is just short of 20 s.
+
+    int lower = 0;
+    for (int i = 0; i < n; i++) {
+        SampleView interval = samples.subview(lower, ends[i] - lower + 1);
+        float angle = kernel_swept_angle(interval.axis[2], interval.timestamps_us, SCALE);
+        double exact = exact_swept_angle(lower, ends[i]);
+        // One rounding to float of an exact sum, against hundreds of float
+        // additions in the old loop.
+        TEST_ASSERT_FLOAT_WITHIN(exact * 1e-6, exact, angle);
+        TEST_ASSERT_FLOAT_WITHIN(exact * 1e-4, old_swept_angle(lower, ends[i]), angle);
+        lower = ends[i] + 1;
+    }
+}
+
+static void test_swept_angle_whole_recording() {
+    record(SAMPLES);
+    SampleView samples = recording.view();
+    float angle = kernel_swept_angle(samples.axis[2], samples.timestamps_us, SCALE);
+    double exact = exact_swept_angle(0, SAMPLES - 1);
+    TEST_ASSERT_FLOAT_WITHIN(exact * 1e-6, exact, angle);
+}
+
+static void test_swept_angle_edges() {
+    record(4);
+    SampleView v = recording.view();
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, kernel_swept_angle(v.axis[2].subspan(0, 0), v.timestamps_us.subspan(0, 0), SCALE));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, kernel_swept_angle(v.axis[2].subspan(0, 1), v.timestamps_us.subspan(0, 1), SCALE));
+
+    // Full scale both ways for a whole second: no overflow, no sign trouble.
+    recording.clear();
+    int16_t low[3] = {0, 0, -32768};
+    int16_t high[3] = {0, 0, 32767};
+    recording.push(0, low);
+    recording.push(1000000, high);
+    v = recording.view();
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 65535.0 * 0.5 * SCALE, kernel_swept_angle(v.axis[2], v.timestamps_us, SCALE));
+}
+
+static void test_max_abs_matches_old_search() {
+    record(SAMPLES);
+    SampleView v = recording.view();
+    uint32_t max_raw = 0;
+    for (int a = 0; a < 3; a++) {
+        uint32_t m = kernel_max_abs(v.axis[a]);
+        max_raw = m > max_raw ? m : max_raw;
+    }
+    TEST_ASSERT_EQUAL_FLOAT(old_max_rate(SAMPLES), max_raw * SCALE);
+
+    int16_t edge[3] = {-32768, 32767, 0};
+    recording.clear();
+    recording.push(0, edge);
+    v = recording.view();
+    TEST_ASSERT_EQUAL_UINT32(32768, kernel_max_abs(v.axis[0]));
+    TEST_ASSERT_EQUAL_UINT32(32767, kernel_max_abs(v.axis[1]));
+    TEST_ASSERT_EQUAL_UINT32(0, kernel_max_abs(v.axis[2]));
+    TEST_ASSERT_EQUAL_UINT32(0, kernel_max_abs(Span<int16_t>()));
+}
+
+static void test_views_are_aligned_prefixes() {
+    record(100);
+    SampleView v = recording.view();
+    TEST_ASSERT_EQUAL_UINT32(100, v.size());
+    for (int a = 0; a < 3; a++) {
+        TEST_ASSERT_EQUAL_UINT32(0, (uintptr_t)v.axis[a].data() % SAMPLE_BUFFER_ALIGN);
+        TEST_ASSERT_EQUAL_UINT32(100, v.axis[a].size());
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, (uintptr_t)v.timestamps_us.data() % SAMPLE_BUFFER_ALIGN);
+
+    // A view taken earlier keeps its length as more samples arrive.
+    int16_t raw[3] = {1, 2, 3};
+    recording.push(999999, raw);
+    TEST_ASSERT_EQUAL_UINT32(100, v.size());
+    TEST_ASSERT_EQUAL_UINT32(101, recording.view().size());
+
+    // Subviews clip to the view.
+    TEST_ASSERT_EQUAL_UINT32(10, v.subview(90, 50).size());
+    TEST_ASSERT_EQUAL_UINT32(0, v.subview(200, 5).size());
+    TEST_ASSERT_EQUAL_INT16(old_values[95][1], v.subview(90, 50).axis[1][5]);
+}
+
+static void test_buffer_full() {
+    record(SAMPLES);
+    int16_t raw[3] = {0, 0, 0};
+    TEST_ASSERT_FALSE(recording.push(0, raw));
+    TEST_ASSERT_EQUAL_UINT32(SAMPLES, recording.size());
+}
+
+// Not a pass/fail check (host timings vary): the interval pass over a
+// full recording, old loop against kernel, for the record.
+static void test_report_processing_time() {
+    record(SAMPLES);
+    int ends[45];
+    int n = interval_ends(ends, 45);
+    SampleView samples = recording.view();
+
+    typedef std::chrono::steady_clock clock;
+    volatile float sink = 0;
+    clock::time_point t0 = clock::now();
+    for (int rep = 0; rep < 20; rep++) {
+        int lower = 0;
+        for (int i = 0; i < n; i++) {
+            sink = sink + old_swept_angle(lower, ends[i]);
+            lower = ends[i] + 1;
+        }
+    }
+    clock::time_point t1 = clock::now();
+    for (int rep = 0; rep < 20; rep++) {
+        int lower = 0;
+        for (int i = 0; i < n; i++) {
+            SampleView interval = samples.subview(lower, ends[i] - lower + 1);
+            sink = sink + kernel_swept_angle(interval.axis[2], interval.timestamps_us, SCALE);
+            lower = ends[i] + 1;
+        }
+    }
+    clock::time_point t2 = clock::now();
+    printf("Interval pass over %d samples: old loop %.1f us, kernel %.1f us\n", SAMPLES,
+           std::chrono::duration<double, std::micro>(t1 - t0).count() / 20,
+           std::chrono::duration<double, std::micro>(t2 - t1).count() / 20);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_swept_angle_matches_old_loop);
+    RUN_TEST(test_swept_angle_whole_recording);
+    RUN_TEST(test_swept_angle_edges);
+    RUN_TEST(test_max_abs_matches_old_search);
+    RUN_TEST(test_views_are_aligned_prefixes);
+    RUN_TEST(test_buffer_full);
+    RUN_TEST(test_report_processing_time);
+    return UNITY_END();
+}
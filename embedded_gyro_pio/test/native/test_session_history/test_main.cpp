@@ -0,0 +1,217 @@
+/**
+ * @file test_main.cpp
+ *
+ * @brief SessionHistory over thousands of sessions: the region wraps many
+ *        times over, and the totals, the day index and the latest list
+ *        must still match a plain recount of the sessions it holds, in
+ *        RAM and after a remount.
+ *
+ */
+
+#include <unity.h>
+#include <deque>
+#include "session_history.h"
+#include "../file_eeprom.h"
+
+#define IMAGE       "test_session_history.bin"
+
+// The region main.cpp gives the history: 256 sessions.
+#define BASE        0x1000
+#define REGION_SIZE 0x1000
+#define SLOTS       (REGION_SIZE / sizeof(SessionEntry))
+#define IMAGE_SIZE  (BASE + REGION_SIZE)
+
+#define SESSIONS    5000
+
+// First day of the simulated use (2024-01-01).
+#define FIRST_DAY   19723
+
+static uint32_t lcg_state;
+
+static uint32_t lcg() {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return lcg_state >> 8;
+}
+
+// Sessions appended so far, oldest first; the history holds the last SLOTS.
+static std::deque<SessionEntry> appended;
+static uint32_t clock_s;
+
+// Appends one session a few hours (sometimes days) after the last one.
+static void add_session(SessionHistory &history) {
+    clock_s += 600 + lcg() % (3 * HISTORY_SECONDS_PER_DAY / 2);
+    float duration = 30.0f + (float)(lcg() % 3000) / 10.0f;
+    SessionEntry e = session_entry_make(clock_s, duration, duration * 1.3f, (uint32_t)(duration * 0.9f),
+                                        (float)(lcg() % 800) / 100.0f);
+    clock_s += (uint32_t)duration;
+    TEST_ASSERT_TRUE(history.append(e));
+    appended.push_back(e);
+}
+
+// Recount over the sessions the history should hold.
+static HistoryTotals recount(uint32_t first_day, uint32_t last_day) {
+    HistoryTotals t = {};
+    uint32_t distance_dm = 0, duration_ds = 0;
+    uint16_t max_rate_crad = 0;
+    size_t held = appended.size() < SLOTS ? appended.size() : SLOTS;
+    for (size_t k = appended.size() - held; k < appended.size(); k++) {
+        const SessionEntry &e = appended[k];
+        uint32_t day = e.start_s / HISTORY_SECONDS_PER_DAY;
+        if (day < first_day || day > last_day) {
+            continue;
+        }
+        t.sessions++;
+        t.strides += e.strides;
+        distance_dm += e.distance_dm;
+        duration_ds += e.duration_ds;
+        max_rate_crad = e.max_rate_crad > max_rate_crad ? e.max_rate_crad : max_rate_crad;
+    }
+    t.distance_m = distance_dm * 0.1f;
+    t.duration_s = duration_ds * 0.1f;
+    t.max_rate = max_rate_crad * 0.01f;
+    return t;
+}
+
+static void assert_totals(const HistoryTotals &expected, const HistoryTotals &actual) {
+    TEST_ASSERT_EQUAL_UINT32(expected.sessions, actual.sessions);
+    TEST_ASSERT_EQUAL_UINT32(expected.strides, actual.strides);
+    TEST_ASSERT_EQUAL_FLOAT(expected.distance_m, actual.distance_m);
+    TEST_ASSERT_EQUAL_FLOAT(expected.duration_s, actual.duration_s);
+}
+
+// Everything the UI asks for, against the recount.
+static void check_queries(SessionHistory &history, bool fresh_mount) {
+    TEST_ASSERT_EQUAL_UINT32(SLOTS, history.count());
+
+    HistoryTotals all = history.totals();
+    HistoryTotals expected = recount(0, UINT32_MAX);
+    assert_totals(expected, all);
+    // The max rate is recomputed at mount; in between it only grows.
+    if (fresh_mount) {
+        TEST_ASSERT_EQUAL_FLOAT(expected.max_rate, all.max_rate);
+    } else {
+        TEST_ASSERT_TRUE(all.max_rate >= expected.max_rate);
+    }
+
+    uint32_t today = clock_s / HISTORY_SECONDS_PER_DAY;
+    static const int spans[] = {1, 7, 30, HISTORY_DAYS};
+    for (unsigned k = 0; k < sizeof(spans) / sizeof(spans[0]); k++) {
+        HistoryTotals days = history.last_days(today, spans[k]);
+        HistoryTotals want = recount(today - (spans[k] - 1), today);
+        assert_totals(want, days);
+        TEST_ASSERT_EQUAL_FLOAT(want.max_rate, days.max_rate);
+    }
+
+    SessionEntry latest[10];
+    TEST_ASSERT_EQUAL_UINT32(10, history.latest(latest, 10));
+    for (int k = 0; k < 10; k++) {
+        const SessionEntry &e = appended[appended.size() - 1 - k];
+        TEST_ASSERT_EQUAL_UINT32(e.start_s, latest[k].start_s);
+        TEST_ASSERT_EQUAL_UINT16(e.distance_dm, latest[k].distance_dm);
+    }
+    const SessionEntry &last = appended.back();
+    TEST_ASSERT_EQUAL_UINT32(last.start_s + (last.duration_ds + 9) / 10, history.last_end_s());
+}
+
+void setUp() {
+    FileEeprom::erase(IMAGE);
+    appended.clear();
+    lcg_state = 12345;
+    clock_s = FIRST_DAY * HISTORY_SECONDS_PER_DAY;
+}
+
+void tearDown() {
+    FileEeprom::erase(IMAGE);
+}
+
+static void test_thousands_of_sessions() {
+    FileEeprom eeprom(IMAGE, IMAGE_SIZE);
+    SessionHistory history(eeprom, BASE, REGION_SIZE);
+    TEST_ASSERT_TRUE(history.mount());
+    TEST_ASSERT_EQUAL_UINT32(0, history.count());
+
+    for (int i = 0; i < SESSIONS; i++) {
+        add_session(history);
+        if (i % 997 == 996) {
+            check_queries(history, false);
+        }
+    }
+    check_queries(history, false);
+
+    // One write per session.
+    TEST_ASSERT_EQUAL_UINT32(SESSIONS, eeprom.writes);
+}
+
+static void test_queries_come_from_ram() {
+    FileEeprom eeprom(IMAGE, IMAGE_SIZE);
+    SessionHistory history(eeprom, BASE, REGION_SIZE);
+    TEST_ASSERT_TRUE(history.mount());
+    for (int i = 0; i < 3 * (int)SLOTS; i++) {
+        add_session(history);
+    }
+
+    uint32_t reads = eeprom.reads;
+    uint32_t today = clock_s / HISTORY_SECONDS_PER_DAY;
+    for (int i = 0; i < 1000; i++) {
+        history.totals();
+        history.last_days(today, 7);
+    }
+    TEST_ASSERT_EQUAL_UINT32(reads, eeprom.reads);
+
+    // The latest list reads one entry per session asked for.
+    SessionEntry latest[5];
+    history.latest(latest, 5);
+    TEST_ASSERT_EQUAL_UINT32(reads + 5, eeprom.reads);
+}
+
+static void test_remount_after_thousands() {
+    {
+        FileEeprom eeprom(IMAGE, IMAGE_SIZE);
+        SessionHistory history(eeprom, BASE, REGION_SIZE);
+        TEST_ASSERT_TRUE(history.mount());
+        for (int i = 0; i < SESSIONS; i++) {
+            add_session(history);
+        }
+    }
+
+    // Power cycle: the head search plus one pass over the region.
+    FileEeprom eeprom(IMAGE, IMAGE_SIZE);
+    SessionHistory history(eeprom, BASE, REGION_SIZE);
+    TEST_ASSERT_TRUE(history.mount());
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(SLOTS + 16, eeprom.reads);
+    check_queries(history, true);
+
+    // And it carries on from where it was.
+    for (int i = 0; i < 300; i++) {
+        add_session(history);
+    }
+    check_queries(history, false);
+}
+
+static void test_sequence_wrap() {
+    // More sessions than the 16-bit sequence numbers count: the head search
+    // has to work across the wrap.
+    FileEeprom eeprom(IMAGE, IMAGE_SIZE);
+    SessionHistory history(eeprom, BASE, REGION_SIZE);
+    TEST_ASSERT_TRUE(history.mount());
+    for (int i = 0; i < 65536 + 100; i++) {
+        add_session(history);
+        if (appended.size() > 2 * SLOTS) {
+            appended.pop_front();
+        }
+        if (i >= 65536 - 200 && i % 37 == 0) {
+            SessionHistory remounted(eeprom, BASE, REGION_SIZE);
+            TEST_ASSERT_TRUE(remounted.mount());
+            check_queries(remounted, true);
+        }
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_thousands_of_sessions);
+    RUN_TEST(test_queries_come_from_ram);
+    RUN_TEST(test_remount_after_thousands);
+    RUN_TEST(test_sequence_wrap);
+    return UNITY_END();
+}
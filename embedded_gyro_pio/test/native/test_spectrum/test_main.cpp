@@ -0,0 +1,247 @@
+/**
+ * @file test_main.cpp
+ *
+ * @brief RealFft against a direct DFT, and the spectrum analyzer on
+ *        signals of known frequency content.
+ *
+ */
+
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <chrono>
+#include "fft.h"
+#include "spectrum.h"
+
+// main.cpp's analysis: 256 samples, three bands.
+#define SIZE 256
+#define BANDS 3
+#define FS 190.0f
+
+static const float EDGES[BANDS + 1] = {0.3f, 3.0f, 12.0f, FS / 2.0f};
+
+static uint32_t lcg_state;
+
+static uint32_t lcg() {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return lcg_state >> 8;
+}
+
+// Checks RealFft<N> against the DFT of random samples, computed directly
+// in double. Errors are relative to the largest bin.
+template <int N>
+static void check_fft() {
+    float x[N];
+    lcg_state = N;
+    for (int i = 0; i < N; i++) {
+        x[i] = (float)((int)(lcg() % 65536) - 32768);
+    }
+    FftComplex z[N / 2];
+    for (int i = 0; i < N / 2; i++) {
+        z[i].re = x[2 * i];
+        z[i].im = x[2 * i + 1];
+    }
+    FftComplex out[RealFft<N>::BINS];
+    RealFft<N>::transform(z, out);
+
+    double worst = 0, largest = 0;
+    for (int k = 0; k < RealFft<N>::BINS; k++) {
+        double re = 0, im = 0;
+        for (int i = 0; i < N; i++) {
+            double a = 2.0 * 3.14159265358979323846 * (double)k * i / N;
+            re += x[i] * cos(a);
+            im -= x[i] * sin(a);
+        }
+        worst = fmax(worst, fmax(fabs(re - out[k].re), fabs(im - out[k].im)));
+        largest = fmax(largest, hypot(re, im));
+    }
+    // Float rounding grows with log2(N) stages.
+    TEST_ASSERT_TRUE(worst <= largest * 1e-6 * fft_log2(N));
+}
+
+// One sine (amplitude in LSB) at f Hz, plus an offset.
+static void sine(int16_t *x, float f, float amplitude, int offset) {
+    for (int i = 0; i < SIZE; i++) {
+        x[i] = (int16_t)lround(offset + amplitude * sin(2 * 3.14159265358979 * f * i / FS));
+    }
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+// Both radix-4 paths: log2(N / 2) even, and odd with a radix-2 stage first.
+static void test_fft_matches_dft() {
+    check_fft<8>();
+    check_fft<16>();
+    check_fft<32>();
+    check_fft<64>();
+    check_fft<128>();
+    check_fft<256>();
+    check_fft<512>();
+}
+
+static void test_fft_impulse_and_dc() {
+    FftComplex z[SIZE / 2] = {};
+    FftComplex out[RealFft<SIZE>::BINS];
+    z[0].re = 1.0f;                             // Impulse: flat spectrum.
+    RealFft<SIZE>::transform(z, out);
+    for (int k = 0; k < RealFft<SIZE>::BINS; k++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-6, 1.0f, out[k].re);
+        TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0f, out[k].im);
+    }
+
+    for (int i = 0; i < SIZE / 2; i++) {        // Constant: DC only.
+        z[i].re = z[i].im = 3.0f;
+    }
+    RealFft<SIZE>::transform(z, out);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 3.0f * SIZE, out[0].re);
+    for (int k = 1; k < RealFft<SIZE>::BINS; k++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-3, 0.0f, hypotf(out[k].re, out[k].im));
+    }
+}
+
+static void test_peak_on_and_between_bins() {
+    SpectrumAnalyzer<SIZE, BANDS> analyzer(FS, EDGES);
+    SpectrumResult<SIZE, BANDS> r;
+    int16_t x[SIZE];
+    float bin = analyzer.resolution_hz();
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, FS / SIZE, bin);
+
+    // On bin 5, and a third of the way from 7 to 8: the parabola gets
+    // within a fifth of a bin (Hann window).
+    sine(x, 5 * bin, 8000, 0);
+    analyzer.analyze(x, r);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f * bin, 5 * bin, r.peak_hz);
+
+    sine(x, 7.33f * bin, 8000, 0);
+    analyzer.analyze(x, r);
+    TEST_ASSERT_FLOAT_WITHIN(0.2f * bin, 7.33f * bin, r.peak_hz);
+}
+
+static void test_mean_removed() {
+    SpectrumAnalyzer<SIZE, BANDS> analyzer(FS, EDGES);
+    SpectrumResult<SIZE, BANDS> a, b;
+    int16_t x[SIZE];
+    sine(x, 10 * analyzer.resolution_hz(), 5000, 0);
+    analyzer.analyze(x, a);
+    sine(x, 10 * analyzer.resolution_hz(), 5000, 12000);
+    analyzer.analyze(x, b);
+    TEST_ASSERT_FLOAT_WITHIN(a.total_power * 1e-4f, a.total_power, b.total_power);
+    TEST_ASSERT_EQUAL_FLOAT(a.peak_hz, b.peak_hz);
+    TEST_ASSERT_TRUE(b.power[0] < 1e-3f * b.peak_power);
+}
+
+static void test_flat_block() {
+    SpectrumAnalyzer<SIZE, BANDS> analyzer(FS, EDGES);
+    SpectrumResult<SIZE, BANDS> r;
+    int16_t x[SIZE];
+    sine(x, 0, 0, -300);
+    analyzer.analyze(x, r);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, r.peak_hz);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, r.total_power);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, r.band_share(0));
+}
+
+static void test_band_energy() {
+    SpectrumAnalyzer<SIZE, BANDS> analyzer(FS, EDGES);
+    SpectrumResult<SIZE, BANDS> r;
+    int16_t x[SIZE];
+
+    // Gait at ~1.8 Hz with a strong 40 Hz buzz: the buzz carries most of
+    // the power (4x the amplitude, 16x the power) and lands in the top band.
+    for (int i = 0; i < SIZE; i++) {
+        double t = i / (double)FS;
+        x[i] = (int16_t)lround(2000 * sin(2 * 3.14159265358979 * 1.8 * t) + 8000 * sin(2 * 3.14159265358979 * 40 * t));
+    }
+    analyzer.analyze(x, r);
+    TEST_ASSERT_FLOAT_WITHIN(0.2f * analyzer.resolution_hz(), 40.0f, r.peak_hz);
+    TEST_ASSERT_TRUE(r.band_share(2) > 0.9f);
+    TEST_ASSERT_TRUE(r.band_share(0) > 0.03f);
+
+    // Every non-DC bin is counted once: bands cover 0.3 Hz to Nyquist,
+    // which leaves out no bin but DC here (bin 1 is 2.97 Hz).
+    float sum = 0;
+    for (int b = 0; b < BANDS; b++) {
+        sum += r.band_power[b];
+    }
+    TEST_ASSERT_FLOAT_WITHIN(r.total_power * 1e-5f, r.total_power - r.power[SIZE / 2], sum);
+}
+
+static void test_parseval() {
+    // Sum of |X|^2 over the full spectrum is N times the windowed energy.
+    SpectrumAnalyzer<SIZE, BANDS> analyzer(FS, EDGES);
+    SpectrumResult<SIZE, BANDS> r;
+    int16_t x[SIZE];
+    lcg_state = 99;
+    int32_t sum = 0;
+    for (int i = 0; i < SIZE; i++) {
+        x[i] = (int16_t)((int)(lcg() % 20001) - 10000);
+        sum += x[i];
+    }
+    analyzer.analyze(x, r);
+
+    SpectrumWindow<SIZE> w = spectrum_hann<SIZE>();
+    double mean = (double)sum / SIZE, energy = 0;
+    for (int i = 0; i < SIZE; i++) {
+        double v = (x[i] - mean) * w.w[i];
+        energy += v * v;
+    }
+    // Bins 1..N/2-1 stand for two bins each of the full spectrum.
+    double spectrum = r.power[0] + r.power[SIZE / 2];
+    for (int k = 1; k < SIZE / 2; k++) {
+        spectrum += 2.0 * r.power[k];
+    }
+    TEST_ASSERT_FLOAT_WITHIN(energy * SIZE * 1e-5, energy * SIZE, spectrum);
+}
+
+// Not a pass/fail check (host timings vary): RealFft<SIZE> with its input
+// packing, and the whole analysis of one block as main.cpp runs it every
+// HOP samples.
+static void test_report_transform_time() {
+    SpectrumAnalyzer<SIZE, BANDS> analyzer(FS, EDGES);
+    SpectrumResult<SIZE, BANDS> r;
+    FftComplex z[SIZE / 2];
+    FftComplex out[RealFft<SIZE>::BINS];
+    int16_t x[SIZE];
+    lcg_state = 5;
+    for (int i = 0; i < SIZE; i++) {
+        x[i] = (int16_t)((int)(lcg() % 20001) - 10000);
+    }
+
+    typedef std::chrono::steady_clock clock;
+    const int reps = 2000;
+    volatile float sink = 0;
+    clock::time_point t0 = clock::now();
+    for (int rep = 0; rep < reps; rep++) {
+        for (int i = 0; i < SIZE / 2; i++) {
+            z[i].re = x[2 * i];
+            z[i].im = x[(2 * i + 1 + rep) % SIZE];
+        }
+        RealFft<SIZE>::transform(z, out);
+        sink = sink + out[rep % RealFft<SIZE>::BINS].re;
+    }
+    clock::time_point t1 = clock::now();
+    for (int rep = 0; rep < reps; rep++) {
+        x[rep % SIZE] ^= 1;
+        analyzer.analyze(x, r);
+        sink = sink + r.peak_hz;
+    }
+    clock::time_point t2 = clock::now();
+    printf("RealFft<%d>: %.2f us per transform, analyze(): %.2f us per block\n", SIZE,
+           std::chrono::duration<double, std::micro>(t1 - t0).count() / reps,
+           std::chrono::duration<double, std::micro>(t2 - t1).count() / reps);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_fft_matches_dft);
+    RUN_TEST(test_fft_impulse_and_dc);
+    RUN_TEST(test_peak_on_and_between_bins);
+    RUN_TEST(test_mean_removed);
+    RUN_TEST(test_flat_block);
+    RUN_TEST(test_band_energy);
+    RUN_TEST(test_parseval);
+    RUN_TEST(test_report_transform_time);
+    return UNITY_END();
+}
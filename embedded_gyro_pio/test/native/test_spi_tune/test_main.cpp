@@ -0,0 +1,133 @@
+/**
+ * @file test_main.cpp
+ *
+ * @brief SPI clock search against a scripted bus: where it stops, what
+ *        it leaves selected, and how marginal clocks are caught.
+ *
+ */
+
+#include <unity.h>
+#include "spi_tune.h"
+
+// Slowest clock first, as main.cpp passes them.
+static const uint16_t DIVS[] = {16, 8, 4, 2};
+#define DIV_COUNT (sizeof(DIVS) / sizeof(DIVS[0]))
+
+// Bus whose self-test fails from a given round on at dividers below a
+// limit, and which records what it was asked to do.
+class ScriptedBus : public TunableBus {
+public:
+    uint16_t fastest_ok = 2;        // Smallest divider that passes every round.
+    uint32_t marginal_round = 0;    // At fastest_ok / 2: rounds that still pass.
+    uint16_t unsupported = 0;       // Divider set_clock_div() refuses.
+
+    uint16_t div = 0;
+    int sets = 0;
+    uint32_t tests = 0;
+    uint32_t last_round = 0;
+
+    bool set_clock_div(uint16_t d) override {
+        sets++;
+        if (d == unsupported) {
+            return false;
+        }
+        div = d;
+        return true;
+    }
+
+    bool self_test(uint32_t round) override {
+        tests++;
+        last_round = round;
+        if (div >= fastest_ok) {
+            return true;
+        }
+        return div == fastest_ok / 2 && round < marginal_round;
+    }
+};
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_all_pass_picks_fastest() {
+    ScriptedBus bus;
+    SpiTuneResult r = spi_tune(bus, DIVS, DIV_COUNT);
+    TEST_ASSERT_TRUE(r.ok);
+    TEST_ASSERT_EQUAL_UINT16(2, r.div);
+    TEST_ASSERT_EQUAL_UINT16(0, r.failed_div);
+    TEST_ASSERT_EQUAL_UINT16(2, bus.div);
+    TEST_ASSERT_EQUAL_UINT32(DIV_COUNT * SPI_TUNE_ROUNDS, bus.tests);
+}
+
+static void test_stops_at_first_failure() {
+    ScriptedBus bus;
+    bus.fastest_ok = 8;
+    SpiTuneResult r = spi_tune(bus, DIVS, DIV_COUNT);
+    TEST_ASSERT_TRUE(r.ok);
+    TEST_ASSERT_EQUAL_UINT16(8, r.div);
+    TEST_ASSERT_EQUAL_UINT16(4, r.failed_div);
+
+    // Left on the last good clock, not the one that failed; 2 never tried.
+    TEST_ASSERT_EQUAL_UINT16(8, bus.div);
+    TEST_ASSERT_EQUAL_INT(4, bus.sets);
+    TEST_ASSERT_EQUAL_UINT32(2 * SPI_TUNE_ROUNDS + 1, bus.tests);
+}
+
+static void test_marginal_clock_is_rejected() {
+    // Passes the first rounds at divider 4, then flips a bit.
+    ScriptedBus bus;
+    bus.fastest_ok = 8;
+    bus.marginal_round = SPI_TUNE_ROUNDS - 1;
+    SpiTuneResult r = spi_tune(bus, DIVS, DIV_COUNT);
+    TEST_ASSERT_EQUAL_UINT16(8, r.div);
+    TEST_ASSERT_EQUAL_UINT16(4, r.failed_div);
+    TEST_ASSERT_EQUAL_UINT32(SPI_TUNE_ROUNDS - 1, bus.last_round);
+}
+
+static void test_unsupported_divider_counts_as_failure() {
+    ScriptedBus bus;
+    bus.unsupported = 4;
+    SpiTuneResult r = spi_tune(bus, DIVS, DIV_COUNT);
+    TEST_ASSERT_EQUAL_UINT16(8, r.div);
+    TEST_ASSERT_EQUAL_UINT16(4, r.failed_div);
+    TEST_ASSERT_EQUAL_UINT16(8, bus.div);
+}
+
+static void test_nothing_passes() {
+    ScriptedBus bus;
+    bus.fastest_ok = 32;
+    SpiTuneResult r = spi_tune(bus, DIVS, DIV_COUNT);
+    TEST_ASSERT_FALSE(r.ok);
+    TEST_ASSERT_EQUAL_UINT16(16, r.div);
+    TEST_ASSERT_EQUAL_UINT16(16, r.failed_div);
+    TEST_ASSERT_EQUAL_UINT16(16, bus.div);
+}
+
+static void test_no_candidates() {
+    ScriptedBus bus;
+    SpiTuneResult r = spi_tune(bus, DIVS, 0);
+    TEST_ASSERT_FALSE(r.ok);
+    TEST_ASSERT_EQUAL_INT(0, bus.sets);
+    TEST_ASSERT_EQUAL_UINT32(0, bus.tests);
+}
+
+static void test_verify_stored_divider() {
+    ScriptedBus bus;
+    bus.fastest_ok = 4;
+    TEST_ASSERT_TRUE(spi_verify(bus, 4));
+    TEST_ASSERT_EQUAL_UINT32(SPI_TUNE_ROUNDS, bus.tests);
+    TEST_ASSERT_FALSE(spi_verify(bus, 2, 3));
+    TEST_ASSERT_EQUAL_UINT16(2, bus.div);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_all_pass_picks_fastest);
+    RUN_TEST(test_stops_at_first_failure);
+    RUN_TEST(test_marginal_clock_is_rejected);
+    RUN_TEST(test_unsupported_divider_counts_as_failure);
+    RUN_TEST(test_nothing_passes);
+    RUN_TEST(test_no_candidates);
+    RUN_TEST(test_verify_stored_divider);
+    return UNITY_END();
+}
@@ -0,0 +1,189 @@
+/**
+ * @file test_main.cpp
+ *
+ * @brief StrideDetector on synthetic thigh Z-rate traces with a known
+ *        number of strides and known stride lengths, and the
+ *        least-squares stride length fit over walks at several cadences.
+ *
+ */
+
+#include <unity.h>
+#include <math.h>
+#include "stride_model.h"
+
+// Sample rate of main.cpp.
+#define FS 190.0f
+#define DT (1.0f / FS)
+
+#define PI_F 3.14159265f
+
+// Peak thigh rate of the synthetic gait (rad/s).
+#define PEAK_RATE 3.0f
+
+static const StrideParams TRUE_PARAMS = {0.45f, 0.12f};
+static const StrideParams DEFAULTS = {0.40f, 0.0f};
+
+// Angle swept (rad) over one stride of the synthetic gait: the integral
+// of |PEAK_RATE sin| over one period.
+static float stride_theta(float cadence) {
+    return 2.0f * PEAK_RATE / (PI_F * cadence);
+}
+
+// Feeds cycles periods of a sine at cadence Hz, starting on the rising
+// zero crossing. The first rising crossing comes before the rate has
+// been below the threshold, so cycles periods make cycles - 2 complete
+// strides, the tail staying open. Adds noise of +-noise rad/s, and a
+// twitch below the threshold at sample twitch_at, if not negative.
+static void walk(StrideDetector &d, int cycles, float cadence, float noise = 0.0f, int twitch_at = -1) {
+    int n = (int)lroundf(cycles * FS / cadence);
+    uint32_t seed = 7;
+    for (int i = 0; i < n; i++) {
+        float rate = PEAK_RATE * sinf(2.0f * PI_F * cadence * i * DT);
+        seed = seed * 1664525u + 1013904223u;
+        rate += noise * ((float)(seed >> 8) / 8388608.0f - 1.0f);
+        if (twitch_at >= 0 && (i == twitch_at || i == twitch_at + 1)) {
+            rate = -1.0f;
+        }
+        d.update(rate, DT);
+    }
+}
+
+static void stand(StrideDetector &d, float seconds) {
+    for (int i = 0; i < (int)(seconds * FS); i++) {
+        d.update(0.0f, DT);
+    }
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_counts_strides() {
+    StrideDetector d(TRUE_PARAMS);
+    walk(d, 22, 1.0f);
+    TEST_ASSERT_EQUAL_UINT32(20, d.strides());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.0f, d.cadence());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f * 22 * stride_theta(1.0f), 22 * stride_theta(1.0f), d.sum_theta());
+
+    d.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, d.strides());
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, d.sum_theta());
+    walk(d, 12, 1.6f);
+    TEST_ASSERT_EQUAL_UINT32(10, d.strides());
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 1.6f, d.cadence());
+}
+
+static void test_stride_length_follows_the_model() {
+    // L = theta * (radius + cadence_gain * f) per stride; the open
+    // lead-in and tail count with the radius alone.
+    static const float CADENCES[] = {0.7f, 1.0f, 1.5f};
+    for (unsigned k = 0; k < sizeof(CADENCES) / sizeof(CADENCES[0]); k++) {
+        float f = CADENCES[k];
+        StrideDetector d(TRUE_PARAMS);
+        walk(d, 22, f);
+        float theta = stride_theta(f);
+        float expected = 20 * theta * (TRUE_PARAMS.radius_m + TRUE_PARAMS.cadence_gain * f) +
+                         2 * theta * TRUE_PARAMS.radius_m;
+        TEST_ASSERT_FLOAT_WITHIN(0.01f * expected, expected, d.distance_m());
+        TEST_ASSERT_FLOAT_WITHIN(0.01f * 20 * f * theta, 20 * f * theta, d.sum_ftheta());
+    }
+}
+
+static void test_noise_and_twitches_do_not_split_strides() {
+    StrideDetector d(TRUE_PARAMS);
+    walk(d, 22, 1.0f, 0.5f);
+    TEST_ASSERT_EQUAL_UINT32(20, d.strides());
+
+    // A twitch down through the threshold in the middle of a forward
+    // swing, a quarter of a stride after its boundary.
+    StrideDetector t(TRUE_PARAMS);
+    walk(t, 22, 1.0f, 0.0f, (int)(10.25f * FS));
+    TEST_ASSERT_EQUAL_UINT32(20, t.strides());
+}
+
+static void test_pause_is_not_a_stride() {
+    StrideDetector d(TRUE_PARAMS);
+    walk(d, 12, 1.0f);
+    stand(d, 5.0f);
+    walk(d, 12, 1.0f);
+    // The stride interrupted by the pause is too long to count; the
+    // second walk's first crossing is already a boundary.
+    TEST_ASSERT_EQUAL_UINT32(10 + 11, d.strides());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.0f, d.cadence());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f * 24 * stride_theta(1.0f), 24 * stride_theta(1.0f), d.sum_theta());
+}
+
+static void test_fit_recovers_parameters() {
+    // Walks of the distance the true model gives, at three cadences.
+    StrideCalibration cal = {};
+    static const float CADENCES[] = {0.8f, 1.0f, 1.4f};
+    for (unsigned k = 0; k < sizeof(CADENCES) / sizeof(CADENCES[0]); k++) {
+        StrideDetector d(DEFAULTS);
+        walk(d, 25, CADENCES[k]);
+        float distance = TRUE_PARAMS.radius_m * d.sum_theta() + TRUE_PARAMS.cadence_gain * d.sum_ftheta();
+        stride_calibration_add(cal, d.sum_theta(), d.sum_ftheta(), distance);
+    }
+    TEST_ASSERT_EQUAL_UINT32(3, cal.walks);
+
+    StrideParams p = stride_calibration_solve(cal, DEFAULTS);
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, TRUE_PARAMS.radius_m, p.radius_m);
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, TRUE_PARAMS.cadence_gain, p.cadence_gain);
+
+    // The fitted model on a walk at a cadence it has not seen.
+    StrideDetector fitted(p);
+    StrideDetector truth(TRUE_PARAMS);
+    walk(fitted, 30, 1.2f);
+    walk(truth, 30, 1.2f);
+    TEST_ASSERT_FLOAT_WITHIN(0.005f * truth.distance_m(), truth.distance_m(), fitted.distance_m());
+}
+
+static void test_one_cadence_scales_the_defaults() {
+    // Walks at one cadence cannot separate radius and gain: the defaults
+    // are scaled to fit instead.
+    StrideCalibration cal = {};
+    for (int k = 0; k < 3; k++) {
+        StrideDetector d(DEFAULTS);
+        walk(d, 25, 1.0f);
+        stride_calibration_add(cal, d.sum_theta(), d.sum_ftheta(), 1.2f * d.distance_m());
+    }
+    StrideParams p = stride_calibration_solve(cal, DEFAULTS);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 1.2f * DEFAULTS.radius_m, p.radius_m);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f, p.cadence_gain);
+
+    // A single walk does the same.
+    StrideCalibration one = {};
+    StrideDetector d(DEFAULTS);
+    walk(d, 25, 1.3f);
+    stride_calibration_add(one, d.sum_theta(), d.sum_ftheta(), 0.9f * d.distance_m());
+    p = stride_calibration_solve(one, DEFAULTS);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.9f * DEFAULTS.radius_m, p.radius_m);
+}
+
+static void test_implausible_fits_keep_the_defaults() {
+    StrideCalibration none = {};
+    StrideParams p = stride_calibration_solve(none, DEFAULTS);
+    TEST_ASSERT_EQUAL_FLOAT(DEFAULTS.radius_m, p.radius_m);
+    TEST_ASSERT_EQUAL_FLOAT(DEFAULTS.cadence_gain, p.cadence_gain);
+
+    // Walks claimed ten times too long: neither the fit nor the scaled
+    // defaults give a radius in range.
+    StrideCalibration cal = {};
+    StrideDetector d(DEFAULTS);
+    walk(d, 25, 1.0f);
+    stride_calibration_add(cal, d.sum_theta(), d.sum_ftheta(), 10.0f * d.distance_m());
+    p = stride_calibration_solve(cal, DEFAULTS);
+    TEST_ASSERT_EQUAL_FLOAT(DEFAULTS.radius_m, p.radius_m);
+    TEST_ASSERT_EQUAL_FLOAT(DEFAULTS.cadence_gain, p.cadence_gain);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_counts_strides);
+    RUN_TEST(test_stride_length_follows_the_model);
+    RUN_TEST(test_noise_and_twitches_do_not_split_strides);
+    RUN_TEST(test_pause_is_not_a_stride);
+    RUN_TEST(test_fit_recovers_parameters);
+    RUN_TEST(test_one_cadence_scales_the_defaults);
+    RUN_TEST(test_implausible_fits_keep_the_defaults);
+    return UNITY_END();
+}
@@ -0,0 +1,162 @@
+/**
+ * @file test_main.cpp
+ *
+ * @brief Touch calibration against synthetic panels: the transform solved
+ *        from three targets maps every raw reading to within half a pixel
+ *        of the exact panel mapping.
+ *
+ */
+
+#include <unity.h>
+#include <math.h>
+#include <string.h>
+#include "touch_calibration.h"
+
+// Largest error tolerated on an unclamped point, in pixels: rounding to
+// the nearest pixel plus the fixed-point coefficients (2^-17 each over
+// 4095 LSB, two terms).
+#define MAX_ERROR_PX (0.5 + 2 * 4095.0 / (1 << (TOUCH_CAL_SHIFT + 1)))
+
+// Further error allowed on a solved transform: the targets' raw readings
+// are rounded to whole LSB, which tilts the solution by a fraction of an
+// LSB, a few hundredths of a pixel across the panel.
+#define SOLVE_ERROR_PX 0.1
+
+// Screen targets of the three-point procedure in main.cpp.
+static const TouchPoint TARGETS[3] = {{24, 32}, {216, 160}, {120, 288}};
+
+// A synthetic panel: raw = inverse of the exact affine map below.
+struct Panel {
+    double a, b, c, d, e, f;    // Screen from raw, in pixels.
+};
+
+static double exact_x(const Panel &p, int rx, int ry) { return p.a * rx + p.b * ry + p.c; }
+static double exact_y(const Panel &p, int rx, int ry) { return p.d * rx + p.e * ry + p.f; }
+
+// The raw reading that lands on a screen point, to the nearest LSB.
+static TouchPoint raw_for(const Panel &p, TouchPoint s) {
+    double det = p.a * p.e - p.b * p.d;
+    double sx = s.x - p.c, sy = s.y - p.f;
+    TouchPoint r;
+    r.x = (int16_t)lround((p.e * sx - p.b * sy) / det);
+    r.y = (int16_t)lround((p.a * sy - p.d * sx) / det);
+    return r;
+}
+
+// Largest error over a grid of raw readings that land inside the screen.
+static double max_error(const TouchCalibration &cal, const Panel &p, int *checked) {
+    double worst = 0;
+    *checked = 0;
+    for (int rx = 0; rx <= TOUCH_RAW_MAX; rx += 13) {
+        for (int ry = 0; ry <= TOUCH_RAW_MAX; ry += 17) {
+            double x = exact_x(p, rx, ry), y = exact_y(p, rx, ry);
+            if (x < 0 || x >= TOUCH_SCREEN_WIDTH - 1 || y < 0 || y >= TOUCH_SCREEN_HEIGHT - 1) {
+                continue;
+            }
+            TouchPoint q = touch_calibration_apply(cal, (uint16_t)rx, (uint16_t)ry);
+            worst = fmax(worst, fmax(fabs(q.x - x), fabs(q.y - y)));
+            (*checked)++;
+        }
+    }
+    return worst;
+}
+
+// Solves from the three targets of a panel (raw readings rounded as the
+// ADC would) and checks the whole screen, not just the targets.
+static void check_panel(const Panel &p) {
+    TouchPoint raw[3];
+    for (int i = 0; i < 3; i++) {
+        raw[i] = raw_for(p, TARGETS[i]);
+    }
+    TouchCalibration cal;
+    TEST_ASSERT_TRUE(touch_calibration_solve(raw, TARGETS, cal));
+    TEST_ASSERT_TRUE(touch_calibration_valid(cal));
+    for (int i = 0; i < 3; i++) {
+        TouchPoint q = touch_calibration_apply(cal, (uint16_t)raw[i].x, (uint16_t)raw[i].y);
+        TEST_ASSERT_INT_WITHIN(1, TARGETS[i].x, q.x);
+        TEST_ASSERT_INT_WITHIN(1, TARGETS[i].y, q.y);
+    }
+
+    int checked;
+    double err = max_error(cal, p, &checked);
+    TEST_ASSERT_GREATER_THAN(1000, checked);
+    TEST_ASSERT_TRUE(err <= MAX_ERROR_PX + SOLVE_ERROR_PX);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_default_matches_bsp() {
+    // BSP_TS_GetState(): x = (3870 - raw_x) / 15, y = (raw_y - 360) / 11.
+    Panel bsp = {-1.0 / 15, 0, 3870.0 / 15, 0, 1.0 / 11, -360.0 / 11};
+    int checked;
+    double err = max_error(touch_calibration_default(), bsp, &checked);
+    TEST_ASSERT_GREATER_THAN(1000, checked);
+    TEST_ASSERT_TRUE(err <= MAX_ERROR_PX);
+    TEST_ASSERT_TRUE(touch_calibration_valid(touch_calibration_default()));
+}
+
+static void test_solve_straight_panel() {
+    check_panel({-1.0 / 14.2, 0, 262.0, 0, 1.0 / 11.3, -30.5});
+}
+
+static void test_solve_rotated_panel() {
+    // Two degrees of rotation between the panel and the glass.
+    double r = 2.0 * 3.14159265358979 / 180;
+    check_panel({-cos(r) / 15, sin(r) / 11, 250.0, sin(r) / 15, cos(r) / 11, -40.0});
+}
+
+static void test_solve_swapped_axes() {
+    // Panel fitted a quarter turn round: raw x runs down the screen.
+    check_panel({0, 1.0 / 16, -20.0, 1.0 / 12, 0, -25.0});
+}
+
+static void test_clamps_to_screen() {
+    TouchCalibration cal = touch_calibration_default();
+    TouchPoint p = touch_calibration_apply(cal, TOUCH_RAW_MAX, 0);
+    TEST_ASSERT_EQUAL_INT(0, p.x);
+    TEST_ASSERT_EQUAL_INT(0, p.y);
+    p = touch_calibration_apply(cal, 0, TOUCH_RAW_MAX);
+    TEST_ASSERT_EQUAL_INT(TOUCH_SCREEN_WIDTH - 1, p.x);
+    TEST_ASSERT_EQUAL_INT(TOUCH_SCREEN_HEIGHT - 1, p.y);
+}
+
+static void test_rejects_points_on_a_line() {
+    const TouchPoint line[3] = {{400, 400}, {2000, 2000}, {3600, 3600}};
+    const TouchPoint close[3] = {{2000, 2000}, {2040, 2000}, {2000, 2040}};
+    TouchCalibration cal = touch_calibration_default();
+    TouchCalibration before = cal;
+    TEST_ASSERT_FALSE(touch_calibration_solve(line, TARGETS, cal));
+    TEST_ASSERT_FALSE(touch_calibration_solve(close, TARGETS, cal));
+    TEST_ASSERT_EQUAL_MEMORY(&before, &cal, sizeof(cal));
+}
+
+static void test_rejects_implausible_stored_values() {
+    TouchCalibration zero = {0, 0, 0, 0, 0, 0};
+    TEST_ASSERT_FALSE(touch_calibration_valid(zero));
+
+    TouchCalibration blank;
+    memset(&blank, 0xFF, sizeof(blank));        // Erased EEPROM: all -1.
+    TEST_ASSERT_FALSE(touch_calibration_valid(blank));
+
+    TouchCalibration gain = touch_calibration_default();
+    gain.a = 2 << TOUCH_CAL_SHIFT;
+    TEST_ASSERT_FALSE(touch_calibration_valid(gain));
+
+    TouchCalibration offset = touch_calibration_default();
+    offset.f = INT32_MIN;
+    TEST_ASSERT_FALSE(touch_calibration_valid(offset));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_default_matches_bsp);
+    RUN_TEST(test_solve_straight_panel);
+    RUN_TEST(test_solve_rotated_panel);
+    RUN_TEST(test_solve_swapped_axes);
+    RUN_TEST(test_clamps_to_screen);
+    RUN_TEST(test_rejects_points_on_a_line);
+    RUN_TEST(test_rejects_implausible_stored_values);
+    return UNITY_END();
+}
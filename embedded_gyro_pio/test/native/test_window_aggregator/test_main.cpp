@@ -0,0 +1,288 @@
+/**
+ * @file test_main.cpp
+ *
+ * @brief WindowAggregator against a brute-force pass over the samples:
+ *        tumbling and sliding windows, by samples and by time, gaps in
+ *        the stream, flush(), and window integrals that add up to
+ *        kernel_swept_angle over the whole stream.
+ *
+ */
+
+#include <unity.h>
+#include <vector>
+#include "sample_kernels.h"
+#include "window_aggregator.h"
+
+// 190 Hz, as in main.cpp.
+#define PERIOD_US 5263
+
+// 500 dps full scale: raw LSB to rad/s.
+#define SCALE (17.5e-3f * 0.017453292f)
+
+#define MAX_PANES 8
+
+typedef WindowResult<3> Window;
+typedef WindowAggregator<3, MAX_PANES> Aggregator;
+
+static std::vector<uint32_t> times;
+static std::vector<int16_t> axis[3];
+static uint32_t pending_gap_us;
+
+// n samples after the last one, PERIOD_US apart with some jitter, then
+// a gap of gap_us before the next call's first sample.
+static void add_samples(int n, uint32_t gap_us = 0) {
+    static uint32_t seed = 99;
+    uint32_t t = times.empty() ? 1000 : times.back() + PERIOD_US + pending_gap_us;
+    for (int i = 0; i < n; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        times.push_back(t);
+        int k = (int)times.size();
+        axis[0].push_back((int16_t)((k * 37) % 2001 - 1000));
+        axis[1].push_back((int16_t)((seed >> 16) - 32768));
+        axis[2].push_back((int16_t)(12000 * ((k / 40) % 2 ? 1 : -1) + (int)(seed >> 24)));
+        t += PERIOD_US + (seed >> 29) * 7 - 14;
+    }
+    pending_gap_us = gap_us;
+}
+
+static std::vector<Window> run(Aggregator &agg, bool flush = true) {
+    std::vector<Window> windows;
+    auto collect = [&windows](const Window &w) { windows.push_back(w); };
+    for (size_t i = 0; i < times.size(); i++) {
+        int16_t v[3] = {axis[0][i], axis[1][i], axis[2][i]};
+        agg.update(times[i], v, collect);
+    }
+    if (flush) {
+        agg.flush(collect);
+    }
+    return windows;
+}
+
+// The window over samples [first, last], computed directly. The
+// integral segment leading to a sample counts with that sample.
+static void check_window(const Window &w, size_t first, size_t last) {
+    TEST_ASSERT_EQUAL_UINT32(last - first + 1, w.count);
+    TEST_ASSERT_EQUAL_UINT32(times[first], w.first_us);
+    TEST_ASSERT_EQUAL_UINT32(times[last], w.last_us);
+    for (int c = 0; c < 3; c++) {
+        int64_t sum = 0, integral2 = 0;
+        uint64_t sum_sq = 0, abs_integral2 = 0;
+        int16_t lo = INT16_MAX, hi = INT16_MIN;
+        for (size_t i = first; i <= last; i++) {
+            int32_t x = axis[c][i];
+            sum += x;
+            sum_sq += (uint64_t)((int64_t)x * x);
+            lo = x < lo ? (int16_t)x : lo;
+            hi = x > hi ? (int16_t)x : hi;
+            if (i > 0) {
+                int32_t p = axis[c][i - 1];
+                uint32_t dt = times[i] - times[i - 1];
+                integral2 += (int64_t)(p + x) * dt;
+                abs_integral2 += (uint64_t)(abs(p) + abs(x)) * dt;
+            }
+        }
+        TEST_ASSERT_TRUE(sum == w.ch[c].sum);
+        TEST_ASSERT_TRUE(sum_sq == w.ch[c].sum_sq);
+        TEST_ASSERT_EQUAL_INT16(lo, w.ch[c].min);
+        TEST_ASSERT_EQUAL_INT16(hi, w.ch[c].max);
+        TEST_ASSERT_TRUE(integral2 == w.ch[c].integral2);
+        TEST_ASSERT_TRUE(abs_integral2 == w.ch[c].abs_integral2);
+    }
+}
+
+// Indices of the first and last sample time-stamped in [from, to).
+static bool samples_between(uint32_t from, uint32_t to, size_t &first, size_t &last) {
+    bool any = false;
+    for (size_t i = 0; i < times.size(); i++) {
+        if (times[i] >= from && times[i] < to) {
+            if (!any) {
+                first = i;
+            }
+            last = i;
+            any = true;
+        }
+    }
+    return any;
+}
+
+// Every time window of length ending at a multiple of hop, up to the one
+// holding the last sample, brute force, against what the aggregator
+// reported.
+static void check_time_windows(const std::vector<Window> &windows, uint32_t length, uint32_t hop) {
+    size_t k = 0;
+    uint32_t end = (times.front() / hop + 1) * hop + (length - hop);
+    for (; end <= (times.back() / hop + 1) * hop; end += hop) {
+        size_t first = 0, last = 0;
+        if (!samples_between(end - length, end, first, last)) {
+            continue;
+        }
+        TEST_ASSERT_TRUE(k < windows.size());
+        check_window(windows[k++], first, last);
+    }
+    TEST_ASSERT_EQUAL_UINT32(k, windows.size());
+}
+
+void setUp() {
+    pending_gap_us = 0;
+    times.clear();
+    for (int c = 0; c < 3; c++) {
+        axis[c].clear();
+    }
+}
+
+void tearDown() {}
+
+static void test_configure_checks_length() {
+    Aggregator agg;
+    TEST_ASSERT_TRUE(agg.configure({WindowBasis::Samples, 40, 10}));
+    TEST_ASSERT_FALSE(agg.configure({WindowBasis::Samples, 40, 0}));
+    TEST_ASSERT_FALSE(agg.configure({WindowBasis::Samples, 45, 10}));
+    TEST_ASSERT_FALSE(agg.configure({WindowBasis::Time, 90000, 10000}));    // Nine panes.
+    TEST_ASSERT_FALSE(agg.configure({WindowBasis::Samples, 5, 10}));
+    TEST_ASSERT_EQUAL_UINT32(40, agg.config().length);
+    TEST_ASSERT_EQUAL_UINT32(10, agg.config().hop);
+}
+
+static void test_tumbling_by_samples() {
+    add_samples(205);
+    Aggregator agg;
+    TEST_ASSERT_TRUE(agg.configure({WindowBasis::Samples, 40, 40}));
+    std::vector<Window> windows = run(agg);
+
+    // Five whole windows, then flush() reports the last five samples.
+    TEST_ASSERT_EQUAL_UINT32(6, windows.size());
+    for (size_t k = 0; k < 5; k++) {
+        check_window(windows[k], 40 * k, 40 * k + 39);
+    }
+    check_window(windows[5], 200, 204);
+}
+
+static void test_sliding_by_samples() {
+    add_samples(203);
+    Aggregator agg;
+    TEST_ASSERT_TRUE(agg.configure({WindowBasis::Samples, 40, 10}));
+    std::vector<Window> windows = run(agg, false);
+
+    // A window of the last 40 samples every 10, from the 40th on.
+    TEST_ASSERT_EQUAL_UINT32(17, windows.size());
+    for (size_t k = 0; k < windows.size(); k++) {
+        check_window(windows[k], 10 * k, 10 * k + 39);
+    }
+    TEST_ASSERT_EQUAL_FLOAT((float)windows[3].ch[0].sum / 40, windows[3].mean(0));
+}
+
+static void test_tumbling_by_time() {
+    add_samples(300);
+    Aggregator agg;
+    TEST_ASSERT_TRUE(agg.configure({WindowBasis::Time, 100000, 100000}));
+    check_time_windows(run(agg), 100000, 100000);
+}
+
+static void test_sliding_by_time() {
+    add_samples(300);
+    Aggregator agg;
+    TEST_ASSERT_TRUE(agg.configure({WindowBasis::Time, 250000, 50000}));
+    check_time_windows(run(agg), 250000, 50000);
+}
+
+static void test_gaps_longer_than_a_hop() {
+    // Gaps of 3.5 hops and of more than a whole window.
+    add_samples(50, 350000);
+    add_samples(50, 900000);
+    add_samples(50);
+
+    Aggregator tumbling;
+    TEST_ASSERT_TRUE(tumbling.configure({WindowBasis::Time, 100000, 100000}));
+    std::vector<Window> windows = run(tumbling);
+    check_time_windows(windows, 100000, 100000);
+
+    // No empty windows, and the segment across a gap counts in the window
+    // of the sample after it.
+    for (size_t k = 0; k < windows.size(); k++) {
+        TEST_ASSERT_TRUE(windows[k].count > 0);
+    }
+
+    Aggregator sliding;
+    TEST_ASSERT_TRUE(sliding.configure({WindowBasis::Time, 300000, 100000}));
+    check_time_windows(run(sliding), 300000, 100000);
+}
+
+static void test_integrals_add_up_to_swept_angle() {
+    add_samples(150, 250000);
+    add_samples(157);
+    Span<uint32_t> t(times.data(), times.size());
+
+    static const WindowConfig TUMBLING[] = {
+        {WindowBasis::Samples, 32, 32},
+        {WindowBasis::Samples, 7, 7},
+        {WindowBasis::Time, 100000, 100000},
+        {WindowBasis::Time, 1000000, 1000000},
+    };
+    for (unsigned k = 0; k < sizeof(TUMBLING) / sizeof(TUMBLING[0]); k++) {
+        Aggregator agg;
+        TEST_ASSERT_TRUE(agg.configure(TUMBLING[k]));
+        std::vector<Window> windows = run(agg);
+        for (int c = 0; c < 3; c++) {
+            uint64_t abs_integral2 = 0;
+            float swept = 0.0f;
+            uint32_t count = 0;
+            for (size_t w = 0; w < windows.size(); w++) {
+                abs_integral2 += windows[w].ch[c].abs_integral2;
+                swept += windows[w].abs_integral(c) * SCALE;
+                count += windows[w].count;
+            }
+            float expected = kernel_swept_angle(Span<int16_t>(axis[c].data(), axis[c].size()), t, SCALE);
+            TEST_ASSERT_EQUAL_UINT32(times.size(), count);
+            TEST_ASSERT_FLOAT_WITHIN(1e-5f * expected, expected, (float)abs_integral2 * (SCALE * 0.5e-6f));
+            TEST_ASSERT_FLOAT_WITHIN(1e-4f * expected, expected, swept);
+        }
+    }
+}
+
+static void test_flush() {
+    Aggregator agg;
+    TEST_ASSERT_TRUE(agg.configure({WindowBasis::Samples, 40, 10}));
+    std::vector<Window> windows;
+    auto collect = [&windows](const Window &w) { windows.push_back(w); };
+
+    // Nothing before the first sample.
+    agg.flush(collect);
+    TEST_ASSERT_EQUAL_UINT32(0, windows.size());
+
+    // Fewer samples than a window: the short window so far.
+    add_samples(25);
+    windows = run(agg);
+    TEST_ASSERT_EQUAL_UINT32(1, windows.size());
+    check_window(windows[0], 0, 24);
+
+    // Ending on a pane boundary leaves nothing to flush.
+    agg.reset();
+    windows.clear();
+    setUp();
+    add_samples(50);
+    windows = run(agg, false);
+    size_t reported = windows.size();
+    agg.flush(collect);
+    TEST_ASSERT_EQUAL_UINT32(reported, windows.size());
+
+    // After a flush, reset() starts a new stream.
+    agg.reset();
+    setUp();
+    add_samples(40);
+    windows = run(agg, false);
+    TEST_ASSERT_EQUAL_UINT32(1, windows.size());
+    check_window(windows[0], 0, 39);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_configure_checks_length);
+    RUN_TEST(test_tumbling_by_samples);
+    RUN_TEST(test_sliding_by_samples);
+    RUN_TEST(test_tumbling_by_time);
+    RUN_TEST(test_sliding_by_time);
+    RUN_TEST(test_gaps_longer_than_a_hop);
+    RUN_TEST(test_integrals_add_up_to_swept_angle);
+    RUN_TEST(test_flush);
+    return UNITY_END();
+}
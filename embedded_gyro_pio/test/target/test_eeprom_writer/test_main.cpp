@@ -0,0 +1,163 @@
+/**
+ * @file test_main.cpp
+ *
+ * @brief EepromWriter on the board: writes land, and a 1 kHz sampler
+ *        keeps its timing while they do.
+ *
+ * A Ticker stands in for the gyro's data-ready interrupt and wakes a
+ * Realtime thread, as acquisition is woken in main.cpp. While a run of
+ * record-sized writes goes through the writer, the test records how late
+ * the tick interrupt and the thread ran. Needs the EEPROM daughter board;
+ * the scratch region it writes is read first and put back at the end.
+ *
+ */
+
+#include <mbed.h>
+#include <unity.h>
+#include "eeprom_bsp.h"
+#include "eeprom_writer.h"
+
+using namespace std::chrono_literals;
+
+// Top of the session history region; restored after the test.
+#define SCRATCH_BASE 0x1F00
+#define SCRATCH_SIZE 0x0100
+
+// Record-sized writes queued while sampling (40 ms or so each).
+#define WRITES 24
+
+#define SAMPLE_PERIOD 1000us
+
+// Largest lateness tolerated, in microseconds, for the tick interrupt and
+// for the thread it wakes.
+#define TICK_LATE_LIMIT_US 25
+#define WAKE_LATE_LIMIT_US 60
+
+BspEeprom eeprom;
+EepromWriter writer(eeprom);
+
+Ticker tick;
+Thread sampler(osPriorityRealtime, 1024, nullptr, "sampler");
+
+volatile uint32_t tick_us = 0;
+volatile uint32_t tick_count = 0;
+volatile uint32_t tick_late_max = 0;
+volatile uint32_t wake_late_max = 0;
+volatile bool sampling = false;
+
+void on_tick() {
+    uint32_t now = us_ticker_read();
+    if (tick_count != 0) {
+        uint32_t late = now - tick_us - (uint32_t)SAMPLE_PERIOD.count();
+        if ((int32_t)late > 0 && late > tick_late_max) {
+            tick_late_max = late;
+        }
+    }
+    tick_us = now;
+    tick_count++;
+    sampler.flags_set(1);
+}
+
+void sampler_main() {
+    for (;;) {
+        ThisThread::flags_wait_any(1);
+        uint32_t late = us_ticker_read() - tick_us;
+        if (sampling && late > wake_late_max) {
+            wake_late_max = late;
+        }
+    }
+}
+
+static uint8_t saved[SCRATCH_SIZE];
+
+static void fill(uint8_t *buf, int n, int index) {
+    for (int k = 0; k < n; k++) {
+        buf[k] = (uint8_t)(index * 31 + k);
+    }
+}
+
+// Queues one slot-sized write, waiting for room in the writer queue.
+static EepromFuture queue_write(uint16_t addr, const uint8_t *data) {
+    EepromFuture future = writer.write_async(addr, data, EEPROM_WRITER_MAX_LEN);
+    while (!future.valid()) {
+        ThisThread::sleep_for(1ms);
+        future = writer.write_async(addr, data, EEPROM_WRITER_MAX_LEN);
+    }
+    return future;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_writes_land_and_read_back() {
+    uint8_t data[EEPROM_WRITER_MAX_LEN];
+    EepromFuture futures[SCRATCH_SIZE / EEPROM_WRITER_MAX_LEN];
+    for (int i = 0; i < SCRATCH_SIZE / EEPROM_WRITER_MAX_LEN; i++) {
+        fill(data, sizeof(data), i);
+        futures[i] = queue_write(SCRATCH_BASE + i * EEPROM_WRITER_MAX_LEN, data);
+    }
+    for (int i = 0; i < SCRATCH_SIZE / EEPROM_WRITER_MAX_LEN; i++) {
+        TEST_ASSERT_TRUE(futures[i].wait());
+    }
+
+    uint8_t back[EEPROM_WRITER_MAX_LEN];
+    for (int i = 0; i < SCRATCH_SIZE / EEPROM_WRITER_MAX_LEN; i++) {
+        fill(data, sizeof(data), i);
+        TEST_ASSERT_TRUE(writer.read(SCRATCH_BASE + i * EEPROM_WRITER_MAX_LEN, back, sizeof(back)));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(data, back, sizeof(back));
+    }
+}
+
+static void test_sampling_continues_during_writes() {
+    tick_late_max = 0;
+    wake_late_max = 0;
+    sampling = true;
+
+    uint32_t ticks_before = tick_count;
+    Timer elapsed;
+    elapsed.start();
+    uint8_t data[EEPROM_WRITER_MAX_LEN];
+    for (int i = 0; i < WRITES; i++) {
+        fill(data, sizeof(data), i + 100);
+        uint16_t addr = SCRATCH_BASE + (i % (SCRATCH_SIZE / EEPROM_WRITER_MAX_LEN)) * EEPROM_WRITER_MAX_LEN;
+        queue_write(addr, data);
+    }
+    TEST_ASSERT_TRUE(writer.last_write().wait());
+    elapsed.stop();
+    sampling = false;
+
+    // Every period had its tick, and none ran late by more than the limits.
+    uint32_t expected = (uint32_t)(elapsed.elapsed_time() / SAMPLE_PERIOD);
+    uint32_t ticks = tick_count - ticks_before;
+    printf("%lu writes in %lu ms: %lu ticks, tick late <= %lu us, wake late <= %lu us\n",
+           (unsigned long)WRITES, (unsigned long)(elapsed.elapsed_time().count() / 1000),
+           (unsigned long)ticks, (unsigned long)tick_late_max, (unsigned long)wake_late_max);
+    TEST_ASSERT_UINT32_WITHIN(2, expected, ticks);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(TICK_LATE_LIMIT_US, tick_late_max);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(WAKE_LATE_LIMIT_US, wake_late_max);
+}
+
+int main() {
+    // Give the host time to open the serial port.
+    ThisThread::sleep_for(2s);
+
+    UNITY_BEGIN();
+    if (!eeprom.init() || !eeprom.read(SCRATCH_BASE, saved, sizeof(saved))) {
+        printf("No EEPROM fitted; nothing to test.\n");
+        return UNITY_END();
+    }
+    writer.start();
+    sampler.start(sampler_main);
+    tick.attach(&on_tick, SAMPLE_PERIOD);
+
+    RUN_TEST(test_writes_land_and_read_back);
+    RUN_TEST(test_sampling_continues_during_writes);
+
+    tick.detach();
+    for (int i = 0; i < SCRATCH_SIZE / EEPROM_WRITER_MAX_LEN; i++) {
+        queue_write(SCRATCH_BASE + i * EEPROM_WRITER_MAX_LEN, saved + i * EEPROM_WRITER_MAX_LEN);
+    }
+    writer.sync();
+    return UNITY_END();
+}
@@ -0,0 +1,139 @@
+/**
+ * @file test_main.cpp
+ *
+ * @brief A live rate reading on the board: the whole line drawn with
+ *        DisplayStringAt, as the readings were drawn before, against a
+ *        NumericReadout in which one digit changes.
+ *
+ * The readout must leave the same pixels as the text drawn in place, and
+ * one changed digit must cost less than the line. Times are DWT cycles,
+ * printed along with the assertions. Formatting the reading is timed on
+ * the host (test/native/test_number_format).
+ *
+ */
+
+#include <mbed.h>
+#include <unity.h>
+#include <stdio.h>
+#include "cycle_counter.h"
+#include "drivers/LCD_DISCO_F429ZI.h"
+#include "numeric_display.h"
+#include "number_format.h"
+#include "screen_assets.h"
+
+using namespace std::chrono_literals;
+
+#define FOREGROUND 0
+
+// The cache of main.cpp: SDRAM past the layers and the BSP's bitmap
+// conversion buffer.
+#define SCREEN_ASSET_BASE (LCD_FRAME_BUFFER + 0x300000)
+#define SCREEN_ASSET_SIZE (0x800000 - 0x300000)
+
+// A rate reading of main.cpp: RATE_CELLS cells on LINE(5), left of the
+// unit.
+#define RATE_CELLS 8
+#define RATE_DECIMALS 5
+#define RATE_X (lcd.GetXSize() - (RATE_CELLS + 6) * Font16.Width)
+
+// Readings timed each way.
+#define READINGS 16
+
+LCD_DISCO_F429ZI lcd;
+ScreenAssets assets(lcd, SCREEN_ASSET_BASE, SCREEN_ASSET_SIZE);
+DigitAtlas small_digits;
+NumericReadout readout(assets, small_digits, FOREGROUND, RATE_X, LINE(5), RATE_CELLS);
+
+// A reading as main.cpp shows it, -1.2345k rad/s: consecutive readings
+// differ in the last digit only.
+static void reading(char *text, int k) {
+    format_fit(text, RATE_CELLS, -1.2345f - (k % 10) * 1e-5f, RATE_DECIMALS);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_atlas_renders() {
+    lcd.SetBackColor(LCD_COLOR_BLACK);
+    lcd.SetTextColor(LCD_COLOR_LIGHTGREEN);
+    TEST_ASSERT_TRUE(assets.begin_render(FOREGROUND, LCD_COLOR_BLACK));
+    bool ok = small_digits.render(assets, lcd, 0, LINE(10), Font16.Width, Font16.Height,
+                                  [](char c, uint16_t x, uint16_t y) { lcd.DisplayChar(x, y, c); });
+    assets.end_render();
+    lcd.SelectLayer(FOREGROUND);
+    TEST_ASSERT_TRUE(ok);
+    TEST_ASSERT_TRUE(small_digits.ready());
+    TEST_ASSERT_EQUAL_UINT16(RATE_CELLS * Font16.Width, readout.width());
+}
+
+static void test_readout_matches_drawn_text() {
+    char text[RATE_CELLS + 1];
+    reading(text, 0);
+    lcd.Clear(LCD_COLOR_BLACK);
+    lcd.DisplayStringAt(RATE_X, LINE(5), (uint8_t *)text, LEFT_MODE);
+    // Font16 glyphs are 11 x 16.
+    static uint32_t drawn[RATE_CELLS * 11][16];
+    TEST_ASSERT_TRUE(Font16.Width == 11 && Font16.Height == 16);
+    for (uint16_t dx = 0; dx < readout.width(); dx++) {
+        for (uint16_t dy = 0; dy < Font16.Height; dy++) {
+            drawn[dx][dy] = lcd.ReadPixel(RATE_X + dx, LINE(5) + dy);
+        }
+    }
+
+    lcd.Clear(LCD_COLOR_BLUE);
+    readout.invalidate();
+    TEST_ASSERT_EQUAL_INT(RATE_CELLS, readout.set(text));
+    for (uint16_t dx = 0; dx < readout.width(); dx++) {
+        for (uint16_t dy = 0; dy < Font16.Height; dy++) {
+            TEST_ASSERT_EQUAL_HEX32(drawn[dx][dy], lcd.ReadPixel(RATE_X + dx, LINE(5) + dy));
+        }
+    }
+
+    // The same text again draws nothing.
+    TEST_ASSERT_EQUAL_INT(0, readout.set(text));
+}
+
+static void test_one_digit_is_faster_than_the_line() {
+    char text[RATE_CELLS + 1];
+    char line[RATE_CELLS + 8];
+    CycleStats drawn;
+    CycleStats changed;
+    lcd.Clear(LCD_COLOR_BLACK);
+    readout.invalidate();
+    reading(text, 0);
+    readout.set(text);
+
+    for (int k = 1; k <= READINGS; k++) {
+        reading(text, k);
+        snprintf(line, sizeof(line), "%s rad/s", text);
+        {
+            CycleScope scope(drawn);
+            lcd.DisplayStringAt(0, LINE(6), (uint8_t *)line, RIGHT_MODE);
+        }
+        int cells;
+        {
+            CycleScope scope(changed);
+            cells = readout.set(text);
+        }
+        TEST_ASSERT_EQUAL_INT(1, cells);
+    }
+
+    printf("Rate reading, cycles: DisplayStringAt %lu (max %lu, %lu per glyph), one readout digit %lu (max %lu)\n",
+           (unsigned long)drawn.average(), (unsigned long)drawn.max,
+           (unsigned long)(drawn.average() / strlen(line)), (unsigned long)changed.average(),
+           (unsigned long)changed.max);
+    TEST_ASSERT_LESS_THAN_UINT32(drawn.average(), changed.max);
+}
+
+int main() {
+    // Give the host time to open the serial port.
+    ThisThread::sleep_for(2s);
+
+    cycle_counter_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_atlas_renders);
+    RUN_TEST(test_readout_matches_drawn_text);
+    RUN_TEST(test_one_digit_is_faster_than_the_line);
+    return UNITY_END();
+}
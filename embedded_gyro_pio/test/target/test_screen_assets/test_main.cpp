@@ -0,0 +1,129 @@
+/**
+ * @file test_main.cpp
+ *
+ * @brief Screen switch on the board: the title screen drawn glyph by
+ *        glyph, as reset_screen() did, against one copy from the SDRAM
+ *        asset cache.
+ *
+ * Both ways must leave the same pixels in the foreground frame buffer,
+ * and the copy must be the faster. Times are DWT cycles, printed along
+ * with the assertions. The LCD shows the screens as they are drawn.
+ *
+ */
+
+#include <mbed.h>
+#include <unity.h>
+#include <string.h>
+#include "cycle_counter.h"
+#include "drivers/LCD_DISCO_F429ZI.h"
+#include "screen_assets.h"
+
+using namespace std::chrono_literals;
+
+#define BACKGROUND 1
+#define FOREGROUND 0
+
+// The cache of main.cpp: SDRAM past the layers and the BSP's bitmap
+// conversion buffer.
+#define SCREEN_ASSET_BASE (LCD_FRAME_BUFFER + 0x300000)
+#define SCREEN_ASSET_SIZE (0x800000 - 0x300000)
+
+// Switches timed each way.
+#define SWITCHES 8
+
+LCD_DISCO_F429ZI lcd;
+ScreenAssets assets(lcd, SCREEN_ASSET_BASE, SCREEN_ASSET_SIZE);
+ScreenAsset title_screen;
+
+// The title screen of main.cpp, drawn on the selected layer.
+static void draw_title() {
+    lcd.Clear(LCD_COLOR_BLACK);
+    lcd.SetBackColor(LCD_COLOR_BLACK);
+    lcd.SetTextColor(LCD_COLOR_LIGHTGREEN);
+    lcd.DisplayStringAt(0, LINE(0), (uint8_t *)"The Embedded", LEFT_MODE);
+    lcd.DisplayStringAt(0, LINE(1), (uint8_t *)"Gyrometer", LEFT_MODE);
+    lcd.DisplayStringAt(0, LINE(19), (uint8_t *)"Rev_C_12222023", RIGHT_MODE);
+}
+
+// reset_screen() before the cache: both layers cleared, the title drawn.
+static void switch_drawn() {
+    lcd.SelectLayer(BACKGROUND);
+    lcd.Clear(LCD_COLOR_BLACK);
+    lcd.SelectLayer(FOREGROUND);
+    draw_title();
+}
+
+static const uint8_t *foreground() {
+    return (const uint8_t *)(uintptr_t)LTDC_Layer1->CFBAR;
+}
+
+static uint32_t screen_bytes() {
+    return lcd.GetXSize() * lcd.GetYSize() * 4;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_title_renders_into_cache() {
+    uint32_t displayed = LTDC_Layer1->CFBAR;
+    TEST_ASSERT_TRUE(assets.begin_render(FOREGROUND, LCD_COLOR_BLACK));
+    draw_title();
+    TEST_ASSERT_TRUE(assets.capture(title_screen, 0, 0, lcd.GetXSize(), lcd.GetYSize()));
+    assets.end_render();
+    lcd.SelectLayer(FOREGROUND);
+
+    // Rendering left the displayed frame alone.
+    TEST_ASSERT_EQUAL_UINT32(displayed, LTDC_Layer1->CFBAR);
+    TEST_ASSERT_TRUE(assets.used() >= 2 * screen_bytes());
+}
+
+static void test_cached_screen_matches_drawn() {
+    switch_drawn();
+    TEST_ASSERT_EQUAL_MEMORY((const void *)(uintptr_t)title_screen.addr, foreground(), screen_bytes());
+
+    // Something else on screen, then the copy.
+    lcd.Clear(LCD_COLOR_BLUE);
+    TEST_ASSERT_TRUE(assets.show(FOREGROUND, title_screen));
+    TEST_ASSERT_EQUAL_MEMORY((const void *)(uintptr_t)title_screen.addr, foreground(), screen_bytes());
+}
+
+static void test_cached_switch_is_faster() {
+    CycleStats drawn;
+    CycleStats cached;
+    for (int i = 0; i < SWITCHES; i++) {
+        {
+            CycleScope scope(drawn);
+            switch_drawn();
+        }
+        {
+            CycleScope scope(cached);
+            assets.show(FOREGROUND, title_screen);
+        }
+    }
+
+    printf("Screen switch, cycles: drawn %lu (max %lu), from the cache %lu (max %lu)\n",
+           (unsigned long)drawn.average(), (unsigned long)drawn.max,
+           (unsigned long)cached.average(), (unsigned long)cached.max);
+    TEST_ASSERT_LESS_THAN_UINT32(drawn.average(), cached.max);
+}
+
+static void test_missing_asset_draws_nothing() {
+    ScreenAsset none;
+    lcd.Clear(LCD_COLOR_BLUE);
+    TEST_ASSERT_FALSE(assets.show(FOREGROUND, none));
+    TEST_ASSERT_EQUAL_UINT32(LCD_COLOR_BLUE, lcd.ReadPixel(0, 0));
+}
+
+int main() {
+    // Give the host time to open the serial port.
+    ThisThread::sleep_for(2s);
+
+    cycle_counter_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_title_renders_into_cache);
+    RUN_TEST(test_cached_screen_matches_drawn);
+    RUN_TEST(test_cached_switch_is_faster);
+    RUN_TEST(test_missing_asset_draws_nothing);
+    return UNITY_END();
+}
@@ -0,0 +1,88 @@
+/**
+ * @file test_main.cpp
+ *
+ * @brief Cycles per touch reading on the board: the calibrated transform
+ *        against the divides of BSP_TS_GetState().
+ *
+ * Accuracy is covered on the host (test/native/test_touch_calibration);
+ * this only times the mapping, with the DWT cycle counter, over a sweep
+ * of synthetic raw readings.
+ *
+ */
+
+#include <mbed.h>
+#include <unity.h>
+#include "cycle_counter.h"
+#include "touch_calibration.h"
+
+using namespace std::chrono_literals;
+
+// Raw readings timed, stepped across the panel.
+#define READINGS 4096
+
+// Most cycles one mapped reading may take, on average and at worst
+// (timer reads and loop included).
+#define APPLY_AVERAGE_LIMIT 40
+#define APPLY_MAX_LIMIT     80
+
+// Stops the compiler folding the mapping into the loop.
+volatile uint16_t raw_in[2];
+volatile int16_t sink;
+
+// BSP_TS_GetState()'s mapping, without the I2C read and filtering.
+static TouchPoint bsp_map(uint16_t x, uint16_t y) {
+    uint16_t yr = (uint16_t)(y - 360) / 11;
+    if (yr > TOUCH_SCREEN_HEIGHT) {
+        yr = TOUCH_SCREEN_HEIGHT - 1;
+    }
+    x = (x <= 3000) ? (uint16_t)(3870 - x) : (uint16_t)(3800 - x);
+    uint16_t xr = x / 15;
+    if (xr > TOUCH_SCREEN_WIDTH) {
+        xr = TOUCH_SCREEN_WIDTH - 1;
+    }
+    TouchPoint p = {(int16_t)xr, (int16_t)yr};
+    return p;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_cycles_per_reading() {
+    TouchCalibration cal = touch_calibration_default();
+    CycleStats apply_stats;
+    CycleStats bsp_stats;
+
+    for (int i = 0; i < READINGS; i++) {
+        raw_in[0] = (uint16_t)(400 + (i * 7) % 3400);
+        raw_in[1] = (uint16_t)(400 + (i * 13) % 3400);
+        uint16_t x = raw_in[0], y = raw_in[1];
+        {
+            CycleScope scope(apply_stats);
+            TouchPoint p = touch_calibration_apply(cal, x, y);
+            sink = p.x + p.y;
+        }
+        {
+            CycleScope scope(bsp_stats);
+            TouchPoint p = bsp_map(x, y);
+            sink = p.x + p.y;
+        }
+    }
+
+    printf("Touch mapping, cycles per reading: transform %lu (max %lu), BSP divides %lu (max %lu)\n",
+           (unsigned long)apply_stats.average(), (unsigned long)apply_stats.max,
+           (unsigned long)bsp_stats.average(), (unsigned long)bsp_stats.max);
+    TEST_ASSERT_EQUAL_UINT32(READINGS, apply_stats.count);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(APPLY_AVERAGE_LIMIT, apply_stats.average());
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(APPLY_MAX_LIMIT, apply_stats.max);
+}
+
+int main() {
+    // Give the host time to open the serial port.
+    ThisThread::sleep_for(2s);
+
+    cycle_counter_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_cycles_per_reading);
+    return UNITY_END();
+}
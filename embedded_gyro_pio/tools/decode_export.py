@@ -0,0 +1,248 @@
+#!/usr/bin/env python3
+"""Decode the gyrometer's binary session export.
+
+Reads the framed stream sent over the export UART (UART5, TX on PC12,
+through a USB-serial adapter; see src/export_frames.h) from a capture
+file or straight from the port, and
+writes one set of files per session:
+
+    session_<n>_samples.csv   timestamp_us, x, y, z (raw LSB) and rad/s columns,
+                              and whether the samples were low-pass filtered
+    session_<n>_summary.csv   the end-of-session summary
+    session_<n>_drops.csv     sample loss counters and the latest loss events
+    session_<n>_windows.csv   per-window aggregates (live export only)
+    session_<n>_samples.parquet  (with --parquet, needs pyarrow)
+
+Bytes that are not part of a valid frame (line noise, a capture started
+mid-frame) are skipped; pass --text to echo them.
+
+Usage:
+    decode_export.py capture.bin -o out/
+    decode_export.py --port /dev/ttyUSB0 -o out/      (needs pyserial)
+"""
+
+import argparse
+import csv
+import os
+import struct
+import sys
+
+FRAME_SOF = 0xA5
+HEADER_SIZE = 5
+TRAILER_SIZE = 2
+
+FRAME_SESSION_START = 1
+FRAME_SAMPLES = 2
+FRAME_SESSION_END = 3
+FRAME_DIAGNOSTICS = 4
+FRAME_WINDOW = 5
+
+SESSION_START = struct.Struct("<IfBB")
+SAMPLE = struct.Struct("<Ihhh")
+SUMMARY = struct.Struct("<ffIffI")
+DIAGNOSTICS = struct.Struct("<III4IB")
+DROP_EVENT = struct.Struct("<IBBH")
+WINDOW = struct.Struct("<IIH3f3f3h3h3f3f")
+
+# DropCause and AppState names (src/drop_detector.h, src/main.cpp).
+DROP_CAUSES = ["sensor_overrun", "fifo_overflow", "queue_full", "deadline_miss"]
+APP_STATES = ["idle", "countdown", "recording", "processing", "result", "calibrating", "diagnostics"]
+
+BAUD = 3000000
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE, matching src/crc.cpp."""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+class FrameDecoder:
+    """Incremental frame parser that resynchronises on bad data."""
+
+    def __init__(self, on_frame, on_text=None):
+        self.buf = bytearray()
+        self.on_frame = on_frame
+        self.on_text = on_text
+        self.last_seq = None
+        self.lost = 0
+        self.bad_crc = 0
+
+    def feed(self, data):
+        self.buf += data
+        while True:
+            start = self.buf.find(FRAME_SOF)
+            if start < 0:
+                self._text(self.buf)
+                self.buf.clear()
+                return
+            if start:
+                self._text(self.buf[:start])
+                del self.buf[:start]
+            if len(self.buf) < HEADER_SIZE:
+                return
+            length = self.buf[4]
+            size = HEADER_SIZE + length + TRAILER_SIZE
+            if len(self.buf) < size:
+                return
+            body = bytes(self.buf[1:HEADER_SIZE + length])
+            (crc,) = struct.unpack_from("<H", self.buf, HEADER_SIZE + length)
+            if crc16(body) != crc:
+                # Not a frame (or a damaged one): skip this SOF byte.
+                self.bad_crc += 1
+                self._text(self.buf[:1])
+                del self.buf[:1]
+                continue
+            frame_type, seq = body[0], body[1] | (body[2] << 8)
+            if self.last_seq is not None:
+                self.lost += (seq - self.last_seq - 1) & 0xFFFF
+            self.last_seq = seq
+            self.on_frame(frame_type, seq, body[HEADER_SIZE - 1:])
+            del self.buf[:size]
+
+    def _text(self, data):
+        if self.on_text and data:
+            self.on_text(bytes(data))
+
+
+class SessionWriter:
+    """Collects frames into per-session columns and writes them out."""
+
+    def __init__(self, out_dir, parquet):
+        self.out_dir = out_dir
+        self.parquet = parquet
+        self.index = 0
+        self.reset()
+
+    def reset(self):
+        self.scale = None
+        self.filtered = 0
+        self.diagnostics = None
+        self.windows = []
+        self.columns = {"timestamp_us": [], "x": [], "y": [], "z": []}
+
+    def on_frame(self, frame_type, seq, payload):
+        if frame_type == FRAME_SESSION_START:
+            odr_hz, self.scale, live, self.filtered = SESSION_START.unpack_from(payload)
+            self.columns = {"timestamp_us": [], "x": [], "y": [], "z": []}
+            self.windows = []
+            print("session %d: %d Hz, %s, %s" % (self.index, odr_hz, "live" if live else "replayed",
+                                                 "filtered" if self.filtered else "unfiltered"))
+        elif frame_type == FRAME_SAMPLES:
+            for offset in range(0, len(payload) - SAMPLE.size + 1, SAMPLE.size):
+                t, x, y, z = SAMPLE.unpack_from(payload, offset)
+                self.columns["timestamp_us"].append(t)
+                self.columns["x"].append(x)
+                self.columns["y"].append(y)
+                self.columns["z"].append(z)
+        elif frame_type == FRAME_DIAGNOSTICS:
+            fields = DIAGNOSTICS.unpack_from(payload)
+            events = [DROP_EVENT.unpack_from(payload, DIAGNOSTICS.size + k * DROP_EVENT.size)
+                      for k in range(fields[-1])]
+            self.diagnostics = (fields[:-1], events)
+        elif frame_type == FRAME_WINDOW:
+            self.windows.append(WINDOW.unpack_from(payload))
+        elif frame_type == FRAME_SESSION_END:
+            self.finish(SUMMARY.unpack_from(payload))
+
+    def finish(self, summary):
+        base = os.path.join(self.out_dir, "session_%d" % self.index)
+        cols = self.columns
+        scale = self.scale or 0.0
+        names = ["timestamp_us", "x", "y", "z"]
+
+        with open(base + "_samples.csv", "w", newline="") as f:
+            w = csv.writer(f)
+            w.writerow(names + ["x_rad_s", "y_rad_s", "z_rad_s", "filtered"])
+            filtered = int(bool(self.filtered))
+            for row in zip(*(cols[n] for n in names)):
+                w.writerow(list(row) + ["%.6f" % (v * scale) for v in row[1:]] + [filtered])
+
+        with open(base + "_summary.csv", "w", newline="") as f:
+            w = csv.writer(f)
+            w.writerow(["distance_m", "duration_s", "samples", "max_rate", "yaw", "strides"])
+            w.writerow(summary)
+
+        if self.diagnostics:
+            (samples, lost, max_latency_us, *counts), events = self.diagnostics
+            with open(base + "_drops.csv", "w", newline="") as f:
+                w = csv.writer(f)
+                w.writerow(["samples", "lost", "max_latency_us"] + DROP_CAUSES)
+                w.writerow([samples, lost, max_latency_us] + counts)
+                w.writerow([])
+                w.writerow(["time_us", "cause", "state", "lost"])
+                for time_us, cause, state, n in events:
+                    w.writerow([time_us, _name(DROP_CAUSES, cause), _name(APP_STATES, state), n])
+            if lost:
+                print("session %d: %d samples lost" % (self.index, lost))
+
+        if self.windows:
+            with open(base + "_windows.csv", "w", newline="") as f:
+                w = csv.writer(f)
+                w.writerow(["first_us", "last_us", "count"] +
+                           ["%s_%s" % (stat, axis) for stat in ("mean", "rms", "min", "max", "integral", "swept")
+                            for axis in "xyz"])
+                for fields in self.windows:
+                    w.writerow(fields)
+
+        if self.parquet:
+            import pyarrow as pa
+            import pyarrow.parquet as pq
+            table = pa.table({
+                "timestamp_us": pa.array(cols["timestamp_us"], pa.uint32()),
+                "x": pa.array(cols["x"], pa.int16()),
+                "y": pa.array(cols["y"], pa.int16()),
+                "z": pa.array(cols["z"], pa.int16()),
+                "filtered": pa.array([bool(self.filtered)] * len(cols["x"]), pa.bool_()),
+            })
+            pq.write_table(table, base + "_samples.parquet")
+
+        print("session %d: %d samples, %.2f m -> %s_*" % (self.index, len(cols["x"]), summary[0], base))
+        self.index += 1
+        self.reset()
+
+
+def _name(names, index):
+    return names[index] if index < len(names) else str(index)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("capture", nargs="?", help="raw capture file (default: read --port)")
+    parser.add_argument("--port", help="serial port to read live")
+    parser.add_argument("--baud", type=int, default=BAUD)
+    parser.add_argument("-o", "--out", default=".", help="output directory")
+    parser.add_argument("--parquet", action="store_true", help="also write Parquet (needs pyarrow)")
+    parser.add_argument("--text", action="store_true", help="echo non-frame bytes (printf output)")
+    args = parser.parse_args()
+
+    if not args.capture and not args.port:
+        parser.error("give a capture file or --port")
+
+    os.makedirs(args.out, exist_ok=True)
+    sessions = SessionWriter(args.out, args.parquet)
+    echo = (lambda b: sys.stdout.write(b.decode("ascii", "replace"))) if args.text else None
+    decoder = FrameDecoder(sessions.on_frame, echo)
+
+    try:
+        if args.capture:
+            with open(args.capture, "rb") as f:
+                for chunk in iter(lambda: f.read(65536), b""):
+                    decoder.feed(chunk)
+        else:
+            import serial
+            with serial.Serial(args.port, args.baud, timeout=0.1) as port:
+                while True:
+                    decoder.feed(port.read(4096))
+    except KeyboardInterrupt:
+        pass
+
+    print("frames lost: %d, rejected: %d" % (decoder.lost, decoder.bad_crc), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
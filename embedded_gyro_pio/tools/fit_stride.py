@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+"""Fit the stride length model to walks of known distance.
+
+Takes session sample files written by decode_export.py, each with the
+distance actually walked, runs them through the same low-pass filter
+(unless the file says they already went through it) and stride
+detection as the firmware (src/main.cpp, src/stride_model.cpp) and fits
+
+    D = radius * sum(theta) + cadence_gain * sum(f * theta)
+
+by least squares over all walks. Walks at different paces are needed to
+separate the two parameters; with one pace only the radius is fitted.
+Prints the fit, the error per walk and a STRIDE_DEFAULTS line for
+src/main.cpp.
+
+Usage:
+    fit_stride.py out/session_0_samples.csv:20 out/session_1_samples.csv:40
+"""
+
+import argparse
+import csv
+import math
+import sys
+
+# Must match src/stride_model.h.
+STRIDE_RATE_THRESHOLD = 0.6
+STRIDE_MIN_TIME = 0.5
+STRIDE_MAX_TIME = 2.5
+
+# Must match GAIT_FILTER_CUTOFF_HZ in src/main.cpp.
+GAIT_FILTER_CUTOFF_HZ = 15.0
+GAIT_FILTER_SECTIONS = 2
+
+
+def butterworth_lowpass(f0, fs, sections):
+    """Biquad sections (b0, b1, b2, a1, a2), as biquad_butterworth_lowpass()."""
+    out = []
+    w0 = 2.0 * math.pi * f0 / fs
+    c = math.cos(w0)
+    for k in range(sections):
+        q = 1.0 / (2.0 * math.cos(math.pi * (2 * k + 1) / (4.0 * sections)))
+        alpha = math.sin(w0) / (2.0 * q)
+        a0 = 1.0 + alpha
+        out.append(((1.0 - c) / 2.0 / a0, (1.0 - c) / a0, (1.0 - c) / 2.0 / a0,
+                    -2.0 * c / a0, (1.0 - alpha) / a0))
+    return out
+
+
+def lowpass(values, sections):
+    """Runs the cascade over values, rounding to raw LSB like the firmware."""
+    state = [[0.0, 0.0] for _ in sections]
+    out = []
+    for x in values:
+        v = float(x)
+        for (b0, b1, b2, a1, a2), s in zip(sections, state):
+            y = b0 * v + s[0]
+            s[0] = b1 * v - a1 * y + s[1]
+            s[1] = b2 * v - a2 * y
+            v = y
+        v = int(v + 0.5) if v >= 0.0 else int(v - 0.5)
+        out.append(max(-32768, min(32767, v)))
+    return out
+
+
+def stride_sums(timestamps_us, rates):
+    """sum(theta), sum(f * theta) and the stride count, as StrideDetector."""
+    theta_total = ftheta_total = 0.0
+    strides = 0
+    open_theta = open_time = 0.0
+    in_stride = armed = False
+    last_abs = 0.0
+    last_t = None
+
+    for t, rate in zip(timestamps_us, rates):
+        dt = 0.0 if last_t is None else (t - last_t) * 1e-6
+        last_t = t
+        open_theta += (abs(rate) + last_abs) * 0.5 * dt
+        open_time += dt
+        last_abs = abs(rate)
+
+        if rate < -STRIDE_RATE_THRESHOLD:
+            armed = True
+        elif rate > STRIDE_RATE_THRESHOLD and armed:
+            armed = False
+            if not in_stride or open_time >= STRIDE_MIN_TIME:
+                theta_total += open_theta
+                if in_stride and open_time <= STRIDE_MAX_TIME:
+                    ftheta_total += open_theta / open_time
+                    strides += 1
+                open_theta = open_time = 0.0
+                in_stride = True
+
+    return theta_total + open_theta, ftheta_total, strides
+
+
+def load_walk(path):
+    """Time-stamps, raw z, LSB scale, data rate, and whether the samples
+    were filtered on the board (None if the file does not say)."""
+    timestamps, raw_z, scale, filtered = [], [], None, None
+    with open(path, newline="") as f:
+        for row in csv.DictReader(f):
+            timestamps.append(int(row["timestamp_us"]))
+            raw_z.append(int(row["z"]))
+            if scale is None and int(row["z"]) != 0:
+                scale = float(row["z_rad_s"]) / int(row["z"])
+            if filtered is None and row.get("filtered") is not None:
+                filtered = row["filtered"] == "1"
+    if len(timestamps) < 2 or scale is None:
+        raise ValueError("%s: no samples" % path)
+    fs = 1e6 * (len(timestamps) - 1) / (timestamps[-1] - timestamps[0])
+    return timestamps, raw_z, scale, fs, filtered
+
+
+def fit(walks):
+    """Least squares of D = r * T + g * F; radius only if degenerate."""
+    s_tt = sum(t * t for t, _, _ in walks)
+    s_tf = sum(t * f for t, f, _ in walks)
+    s_ff = sum(f * f for _, f, _ in walks)
+    s_td = sum(t * d for t, _, d in walks)
+    s_fd = sum(f * d for _, f, d in walks)
+    det = s_tt * s_ff - s_tf * s_tf
+    if len(walks) >= 2 and det > 1e-3 * s_tt * s_ff:
+        return (s_td * s_ff - s_fd * s_tf) / det, (s_tt * s_fd - s_tf * s_td) / det
+    return s_td / s_tt, 0.0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("walks", nargs="+", metavar="SAMPLES_CSV:METERS",
+                        help="decoded session samples and the distance walked")
+    parser.add_argument("--no-filter", action="store_true",
+                        help="skip the low-pass for files that do not say whether they are filtered")
+    args = parser.parse_args()
+
+    walks = []
+    for spec in args.walks:
+        path, _, meters = spec.rpartition(":")
+        if not path:
+            parser.error("%s: expected SAMPLES_CSV:METERS" % spec)
+        timestamps, raw_z, scale, fs, filtered = load_walk(path)
+        if not (filtered if filtered is not None else args.no_filter):
+            raw_z = lowpass(raw_z, butterworth_lowpass(GAIT_FILTER_CUTOFF_HZ, fs, GAIT_FILTER_SECTIONS))
+        theta, ftheta, strides = stride_sums(timestamps, [v * scale for v in raw_z])
+        print("%s: %d strides, %.2f rad, %.2f m" % (path, strides, theta, float(meters)))
+        walks.append((theta, ftheta, float(meters)))
+
+    if sum(t for t, _, _ in walks) <= 0.0:
+        sys.exit("no motion in the walks given")
+
+    radius, gain = fit(walks)
+    print()
+    for (theta, ftheta, meters), spec in zip(walks, args.walks):
+        est = radius * theta + gain * ftheta
+        print("%-40s %7.2f m walked, %7.2f m estimated (%+.1f%%)"
+              % (spec, meters, est, 100.0 * (est - meters) / meters))
+    print()
+    print("radius %.4f m, cadence gain %.4f m s" % (radius, gain))
+    print("constexpr StrideParams STRIDE_DEFAULTS = {%.4ff, %.4ff};" % (radius, gain))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,159 @@
+#!/usr/bin/env python3
+"""Pack the LCD fonts the firmware uses into bit tables.
+
+Reads the ST font tables in tools/fonts/ (rows padded to whole bytes,
+all 95 printable characters) and writes src/drivers/font_packed.c and
+font_packed.h with only the fonts asked for, each cut down to the range
+of characters the firmware's string literals use. Rows are stored as
+Width bits back to back, with no padding; Font_DrawPackedGlyph()
+(src/drivers/font_draw.c) draws them a byte at a time. The native test
+test/native/test_fonts checks both against the tables in tools/fonts/.
+
+Prints the flash the tables take before and after. Run it again after
+adding a font, or text with characters outside the packed range (it
+warns about those).
+
+Usage:
+    pack_fonts.py                 (Font16, range from the sources)
+    pack_fonts.py Font16 Font24:32-126
+"""
+
+import argparse
+import os
+import re
+import sys
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+FONT_DIR = os.path.join(ROOT, "tools", "fonts")
+SRC_DIR = os.path.join(ROOT, "src")
+OUT_DIR = os.path.join(ROOT, "src", "drivers")
+
+# The ST tables start at ' ' and end at '~'.
+TABLE_FIRST = 32
+TABLE_LAST = 126
+
+# Fonts linked before packing: Font16 (LCD_DISCO_F429ZI) and Font24
+# (the BSP's default font).
+LINKED_BEFORE = ["Font16", "Font24"]
+
+# Text drawn from numbers (printf, number_format.h) rather than literals.
+NUMBER_CHARS = "0123456789-. "
+
+
+def load_font(name):
+    """Returns (width, height, padded table bytes) of an ST font file."""
+    path = os.path.join(FONT_DIR, name.lower() + ".c")
+    with open(path) as f:
+        text = f.read()
+    table = re.search(r"%s_Table\s*\[\]\s*=\s*\{(.*?)\};" % name, text, re.S)
+    size = re.search(r"sFONT\s+%s\s*=\s*\{\s*%s_Table\s*,\s*(\d+)\s*,(?:\s|/\*.*?\*/)*(\d+)" % (name, name), text)
+    if not table or not size:
+        sys.exit("%s: no %s table" % (path, name))
+    body = re.sub(r"//[^\n]*", "", table.group(1))
+    data = [int(v, 16) for v in re.findall(r"0x[0-9A-Fa-f]{2}", body)]
+    width, height = int(size.group(1)), int(size.group(2))
+    if len(data) != (TABLE_LAST - TABLE_FIRST + 1) * height * ((width + 7) // 8):
+        sys.exit("%s: %d bytes, not a %dx%d font" % (path, len(data), width, height))
+    return width, height, data
+
+
+def used_chars():
+    """Printable characters in the firmware's string and char literals."""
+    chars = set(NUMBER_CHARS)
+    literal = re.compile(r'"((?:[^"\\\n]|\\.)*)"|\'((?:[^\'\\\n]|\\.))\'')
+    for name in sorted(os.listdir(SRC_DIR)):
+        if not name.endswith((".cpp", ".h")):
+            continue
+        with open(os.path.join(SRC_DIR, name)) as f:
+            text = f.read()
+        text = re.sub(r"//[^\n]*|/\*.*?\*/", "", text, flags=re.S)
+        for m in literal.finditer(text):
+            if text[:m.start()].rstrip().endswith("#include"):
+                continue
+            body = re.sub(r"\\.", "", m.group(1) if m.group(1) is not None else m.group(2))
+            chars.update(c for c in body if TABLE_FIRST <= ord(c) <= TABLE_LAST)
+    return chars
+
+
+def pack(width, height, data, first, last):
+    """Glyphs first to last as rows of width bits, MSB first."""
+    row_bytes = (width + 7) // 8
+    bits = []
+    for code in range(first, last + 1):
+        glyph = (code - TABLE_FIRST) * height * row_bytes
+        for row in range(height):
+            line = 0
+            for b in range(row_bytes):
+                line = (line << 8) | data[glyph + row * row_bytes + b]
+            line >>= row_bytes * 8 - width
+            bits.extend((line >> (width - 1 - k)) & 1 for k in range(width))
+    bits.extend([0] * (-len(bits) % 8))
+    return [int("".join(map(str, bits[i:i + 8])), 2) for i in range(0, len(bits), 8)]
+
+
+def write_sources(fonts, report):
+    header = os.path.join(OUT_DIR, "font_packed.h")
+    source = os.path.join(OUT_DIR, "font_packed.c")
+    banner = "/* Generated by tools/pack_fonts.py, do not edit.\n *\n%s */\n" % "".join(
+        " * %s\n" % line for line in report)
+
+    with open(header, "w") as f:
+        f.write(banner)
+        f.write("\n#ifndef __FONT_PACKED_H\n#define __FONT_PACKED_H\n\n")
+        for name, _, _, _, _, _ in fonts:
+            f.write("extern sFONT %s;\n" % name)
+        f.write("\n#endif /* __FONT_PACKED_H */\n")
+
+    with open(source, "w") as f:
+        f.write(banner)
+        f.write('\n#include <stddef.h>\n#include "fonts.h"\n')
+        for name, width, height, first, last, packed in fonts:
+            f.write("\n/* '%s' to '%s', %d x %d bits each. */\n" % (chr(first), chr(last), width, height))
+            f.write("static const uint8_t %s_Packed[%d] = {\n" % (name, len(packed)))
+            for i in range(0, len(packed), 16):
+                f.write("  %s,\n" % ", ".join("0x%02X" % b for b in packed[i:i + 16]))
+            f.write("};\n\n")
+            f.write("sFONT %s = {\n  NULL,\n  %d, /* Width */\n  %d, /* Height */\n" % (name, width, height))
+            f.write("  %s_Packed,\n  %d, /* First */\n  %d, /* Last */\n};\n" % (name, first, last))
+    return header, source
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("fonts", nargs="*", default=["Font16"], metavar="FONT[:FIRST-LAST]",
+                        help="fonts to pack, with a character range to override the one found in src/")
+    args = parser.parse_args()
+
+    chars = used_chars()
+    codes = sorted(ord(c) for c in chars)
+    fonts = []
+    report = []
+    packed_total = 0
+    for spec in args.fonts:
+        name, _, span = spec.partition(":")
+        width, height, data = load_font(name)
+        if span:
+            first, last = (int(v) for v in span.split("-"))
+        else:
+            first, last = codes[0], codes[-1]
+        if not TABLE_FIRST <= first <= last <= TABLE_LAST:
+            sys.exit("%s: range %d-%d outside %d-%d" % (spec, first, last, TABLE_FIRST, TABLE_LAST))
+        missing = "".join(sorted(c for c in chars if not first <= ord(c) <= last))
+        if missing:
+            print("warning: %s leaves out %r, used in src/" % (name, missing), file=sys.stderr)
+        packed = pack(width, height, data, first, last)
+        packed_total += len(packed)
+        fonts.append((name, width, height, first, last, packed))
+        report.append("%s: %d glyphs, %d bytes (%d padded, all 95)" % (name, last - first + 1, len(packed), len(data)))
+
+    before = sum(len(load_font(name)[2]) for name in LINKED_BEFORE)
+    report.append("Tables linked: %d bytes, %d before packing (%s); %d saved."
+                  % (packed_total, before, ", ".join(LINKED_BEFORE), before - packed_total))
+    for path in write_sources(fonts, report):
+        print("wrote %s" % os.path.relpath(path, ROOT))
+    for line in report:
+        print(line)
+
+
+if __name__ == "__main__":
+    main()